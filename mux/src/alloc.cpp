@@ -74,7 +74,6 @@ static const UTF8 *poolnames[] =
     T("Mbufs"),
     T("Bools"),
     T("Descs"),
-    T("Qentries"),
     T("Pcaches"),
     T("Lbufrefs"),
     T("Regrefs"),
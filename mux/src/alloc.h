@@ -11,12 +11,11 @@
 #define POOL_MBUF    2
 #define POOL_BOOL    3
 #define POOL_DESC    4
-#define POOL_QENTRY  5
-#define POOL_PCACHE  6
-#define POOL_LBUFREF 7
-#define POOL_REGREF  8
-#define POOL_STRING  9
-#define NUM_POOLS    10
+#define POOL_PCACHE  5
+#define POOL_LBUFREF 6
+#define POOL_REGREF  7
+#define POOL_STRING  8
+#define NUM_POOLS    9
 
 #ifdef FIRANMUX
 #define LBUF_SIZE   24000   // Large
@@ -55,8 +54,6 @@ extern void pool_reset(void);
 #define free_sbuf(b)     pool_free(POOL_SBUF,(UTF8 *)(b), (UTF8 *)__FILE__, __LINE__)
 #define alloc_bool(s)    (struct boolexp *)pool_alloc(POOL_BOOL, (UTF8 *)s, (UTF8 *)__FILE__, __LINE__)
 #define free_bool(b)     pool_free(POOL_BOOL,(UTF8 *)(b), (UTF8 *)__FILE__, __LINE__)
-#define alloc_qentry(s)  (BQUE *)pool_alloc(POOL_QENTRY, (UTF8 *)s, (UTF8 *)__FILE__, __LINE__)
-#define free_qentry(b)   pool_free(POOL_QENTRY,(UTF8 *)(b), (UTF8 *)__FILE__, __LINE__)
 #define alloc_pcache(s)  (PCACHE *)pool_alloc(POOL_PCACHE, (UTF8 *)s, (UTF8 *)__FILE__, __LINE__)
 #define free_pcache(b)   pool_free(POOL_PCACHE,(UTF8 *)(b), (UTF8 *)__FILE__, __LINE__)
 #define alloc_lbufref(s) (lbuf_ref *)pool_alloc(POOL_LBUFREF, (UTF8 *)s, (UTF8 *)__FILE__, __LINE__)
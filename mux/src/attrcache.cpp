@@ -5,9 +5,9 @@
  * disk-based mode. It's not used in memory-based builds. The lower-level
  * cache is managed in svdhash.cpp
  *
- * The upper-level cache is organized by a CHashTable and a linked list. The
- * former allows random access while the linked list helps find the
- * least-recently-used attribute.
+ * The upper-level cache is organized by a CHashTable and three linked lists.
+ * The former allows random access while the linked lists implement the 2Q
+ * replacement policy described below.
  */
 
 #include "copyright.h"
@@ -15,6 +15,8 @@
 #include "config.h"
 #include "externs.h"
 
+#include "mathutil.h"
+
 #if !defined(MEMORY_BASED)
 
 static CHashFile hfAttributeFile;
@@ -36,27 +38,119 @@ typedef struct tagAttrRecord
 
 static ATTR_RECORD TempRecord;
 
+// Write-ahead log.
+//
+// Each cache_put() and cache_del() is appended to the log before the page is
+// changed.  Appends collect in a WAL_BLOCK, and every wal_commit_period, the
+// block is written and fsync()ed (group commit), so a crash loses at most one
+// period of changes which had not reached the page file.  A checkpoint
+// (cache_sync) hands the pages to the OS, waits for them to reach the disk,
+// and then empties the log.  At startup, a log left behind by a crash is
+// replayed against the page file.
+//
+// With threads, the game only fills blocks.  A writer thread takes them in
+// order and does the writing, the fsync()s, and the checkpoint wait, so the
+// game does not stop for the disk.  Because the writer handles a checkpoint
+// before it writes anything appended after it, emptying the log never loses
+// a later record.  Without threads, the game does the same work itself.
+//
+// Each record is a WAL_HEADER followed by nText bytes of attribute text.
+// nCheck covers everything after itself, so a record torn by the crash is
+// recognized and replay stops there.
+//
+#define WAL_OP_PUT  1
+#define WAL_OP_DEL  2
+
+#pragma pack(1)
+typedef struct
+{
+    UINT32 nCheck;
+    UINT32 iOp;
+    Aname  attrKey;
+    UINT32 nText;
+} WAL_HEADER;
+#pragma pack()
+
+typedef struct wal_block
+{
+    struct wal_block *pNext;
+    size_t nData;
+    bool   bCommit;         // fsync() the log after writing the block.
+    bool   bCheckpoint;     // Then wait for the pages and empty the log.
+    UTF8   aData[65536];
+} WAL_BLOCK;
+
+static int        hWalFile = MUX_OPEN_INVALID_HANDLE_VALUE;
+static bool       bWalLogging = false;
+static bool       bWalStarted = false;
+static bool       bWalUnsynced = false;
+static WAL_BLOCK *pWalBlock = nullptr;  // Block being filled by the game.
+static WAL_BLOCK *pWalFree  = nullptr;  // Blocks ready for reuse.
+static bool       bWalPending = false;  // Blocks handed over since the last commit.
+static std::atomic<bool> bWalFailed(false);  // The log could not be written.
+
+#if defined(UNIX_THREADS)
+static pthread_t       wal_thread;
+static pthread_mutex_t wal_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  wal_cvWork = PTHREAD_COND_INITIALIZER;
+static bool            bWalThread = false;
+
+// Protected by wal_mutex.
+//
+static WAL_BLOCK      *pWalHead = nullptr;  // Blocks waiting for the writer.
+static WAL_BLOCK      *pWalTail = nullptr;
+static bool            bWalStop = false;
+#endif // UNIX_THREADS
+
+int wal_records = 0;
+int wal_commits = 0;
+int wal_checkpoints = 0;
+
+// The upper-level cache uses the 2Q replacement policy. Every cached
+// attribute is on one of three queues:
+//
+//   Recent   (A1in)  - Resident. Seen once since it entered the cache. FIFO.
+//   Frequent (Am)    - Resident. Referenced again while cached or while
+//                      remembered as a ghost. LRU.
+//   Ghost    (A1out) - Keys recently pushed out of Recent, without their
+//                      values. FIFO.
+//
+// A sweep through the database (@search, lattr(), @dbck) touches each
+// attribute once, so it only cycles through Recent and Ghost and leaves the
+// Frequent working set of softcode attributes alone. Recent is limited to a
+// quarter of max_cache_size bytes, and Ghost keeps no more keys than there
+// are resident entries.
+//
 typedef struct tagCacheEntryHeader
 {
     struct tagCacheEntryHeader *pPrevEntry;
     struct tagCacheEntryHeader *pNextEntry;
     Aname attrKey;
     size_t nSize;
+    int    iQueue;
 } CENT_HDR, *PCENT_HDR;
 
-static PCENT_HDR pCacheHead = 0;
-static PCENT_HDR pCacheTail = 0;
+typedef struct
+{
+    PCENT_HDR pHead;
+    PCENT_HDR pTail;
+} CACHE_QUEUE;
+
+static CACHE_QUEUE CacheQueue[ACACHE_QUEUES];
 static size_t CacheSize = 0;
 
+ACACHE_STATS acache_stats[ACACHE_QUEUES];
+int acache_misses = 0;
+
 int cache_init(const UTF8 *game_dir_file, const UTF8 *game_pag_file,
-    int nCachePages)
+    int nCachePages, bool bMapped)
 {
     if (cache_initted)
     {
         return HF_OPEN_STATUS_ERROR;
     }
 
-    int cc = hfAttributeFile.Open(game_dir_file, game_pag_file, nCachePages);
+    int cc = hfAttributeFile.Open(game_dir_file, game_pag_file, nCachePages, bMapped);
     if (cc != HF_OPEN_STATUS_ERROR)
     {
         // Mark caching system live
@@ -129,10 +223,29 @@ void cache_cleanup(void)
     }
 }
 
+static void WalStop(void);
+
 void cache_close(void)
 {
+    if (MUX_OPEN_INVALID_HANDLE_VALUE != hWalFile)
+    {
+        cache_wal_commit();
+        WalStop();
+        mux_close(hWalFile);
+        hWalFile = MUX_OPEN_INVALID_HANDLE_VALUE;
+    }
+    bWalLogging = false;
+    bWalStarted = false;
+
     hfAttributeFile.CloseAll();
     cache_initted = false;
+
+    while (nullptr != pWalFree)
+    {
+        WAL_BLOCK *p = pWalFree;
+        pWalFree = p->pNext;
+        MEMFREE(p);
+    }
 }
 
 void cache_tick(void)
@@ -140,13 +253,368 @@ void cache_tick(void)
     hfAttributeFile.Tick();
 }
 
+// Empty the log. Everything in it is already in the page file.
+//
+static void WalTruncate(void)
+{
+    bWalUnsynced = false;
+#if defined(WINDOWS_FILES)
+    _chsize(hWalFile, 0);
+#elif defined(UNIX_FILES)
+    if (0 != ftruncate(hWalFile, 0))
+    {
+        bWalFailed.store(true, std::memory_order_release);
+    }
+#endif // UNIX_FILES
+    mux_lseek(hWalFile, 0, SEEK_SET);
+}
+
+// Write one block and do what it asks for.  This runs on the writer thread
+// when there is one, so it only touches the log, the page file handles,
+// bWalUnsynced, which the game never reads, and bWalFailed, which is atomic
+// because the game polls it while the writer runs.
+//
+// A log which is missing records would roll newer values back to older ones
+// if it were replayed, so after a failed write, the log is emptied and the
+// rest of the blocks are dropped.
+//
+static void WalRun(WAL_BLOCK *pBlock)
+{
+    if (bWalFailed.load(std::memory_order_acquire))
+    {
+        return;
+    }
+
+    size_t nDone = 0;
+    while (nDone < pBlock->nData)
+    {
+        int cc = mux_write(hWalFile, pBlock->aData + nDone,
+            static_cast<unsigned int>(pBlock->nData - nDone));
+        if (cc <= 0)
+        {
+            bWalFailed.store(true, std::memory_order_release);
+            WalTruncate();
+            return;
+        }
+        nDone += cc;
+        bWalUnsynced = true;
+    }
+
+    if (  bWalUnsynced
+       && pBlock->bCommit)
+    {
+#if defined(WINDOWS_FILES)
+        _commit(hWalFile);
+#elif defined(UNIX_FILES)
+        fsync(hWalFile);
+#endif // UNIX_FILES
+        bWalUnsynced = false;
+    }
+
+    if (pBlock->bCheckpoint)
+    {
+        // The game handed the pages to the OS before it asked for the
+        // checkpoint.  Once they are on the disk, the log is not needed.
+        //
+        hfAttributeFile.Commit();
+        WalTruncate();
+    }
+}
+
+#if defined(UNIX_THREADS)
+static void *wal_writer(void *pUnused)
+{
+    UNUSED_PARAMETER(pUnused);
+
+    pthread_mutex_lock(&wal_mutex);
+    for (;;)
+    {
+        while (  nullptr == pWalHead
+              && !bWalStop)
+        {
+            pthread_cond_wait(&wal_cvWork, &wal_mutex);
+        }
+        if (nullptr == pWalHead)
+        {
+            break;
+        }
+        WAL_BLOCK *pBlock = pWalHead;
+        pWalHead = pBlock->pNext;
+        if (nullptr == pWalHead)
+        {
+            pWalTail = nullptr;
+        }
+        pthread_mutex_unlock(&wal_mutex);
+
+        WalRun(pBlock);
+
+        pthread_mutex_lock(&wal_mutex);
+        pBlock->pNext = pWalFree;
+        pWalFree = pBlock;
+    }
+    pthread_mutex_unlock(&wal_mutex);
+    return nullptr;
+}
+#endif // UNIX_THREADS
+
+// Wait for the writer to finish every block it has been given, and stop it.
+//
+static void WalStop(void)
+{
+#if defined(UNIX_THREADS)
+    if (bWalThread)
+    {
+        pthread_mutex_lock(&wal_mutex);
+        bWalStop = true;
+        pthread_cond_signal(&wal_cvWork);
+        pthread_mutex_unlock(&wal_mutex);
+        pthread_join(wal_thread, nullptr);
+        bWalThread = false;
+        bWalStop = false;
+    }
+#endif // UNIX_THREADS
+}
+
+// Report a failed write once and stop logging.  The log has already been
+// emptied, and the page file is left to the checkpoints alone, as it is
+// without a log.
+//
+static void WalCheck(void)
+{
+    if (  bWalLogging
+       && bWalFailed.load(std::memory_order_acquire))
+    {
+        bWalLogging = false;
+        STARTLOG(LOG_PROBLEMS, "WAL", "WRITE");
+        log_text(T("Could not write the write-ahead log. It is off until restart."));
+        ENDLOG;
+    }
+}
+
+static WAL_BLOCK *WalNewBlock(void)
+{
+#if defined(UNIX_THREADS)
+    pthread_mutex_lock(&wal_mutex);
+#endif // UNIX_THREADS
+    WAL_BLOCK *pBlock = pWalFree;
+    if (nullptr != pBlock)
+    {
+        pWalFree = pBlock->pNext;
+    }
+#if defined(UNIX_THREADS)
+    pthread_mutex_unlock(&wal_mutex);
+#endif // UNIX_THREADS
+
+    if (nullptr == pBlock)
+    {
+        pBlock = reinterpret_cast<WAL_BLOCK *>(MEMALLOC(sizeof(WAL_BLOCK)));
+        ISOUTOFMEMORY(pBlock);
+    }
+    pBlock->nData = 0;
+    return pBlock;
+}
+
+// Hand the block being filled to the writer, or write it here if there is
+// no writer.
+//
+static void WalSubmit(bool bCommit, bool bCheckpoint)
+{
+    WAL_BLOCK *pBlock = pWalBlock;
+    if (nullptr == pBlock)
+    {
+        pBlock = WalNewBlock();
+    }
+    pWalBlock = nullptr;
+    bWalPending = !(bCommit || bCheckpoint);
+    pBlock->pNext = nullptr;
+    pBlock->bCommit = bCommit;
+    pBlock->bCheckpoint = bCheckpoint;
+
+#if defined(UNIX_THREADS)
+    if (bWalThread)
+    {
+        pthread_mutex_lock(&wal_mutex);
+        if (nullptr == pWalTail)
+        {
+            pWalHead = pBlock;
+        }
+        else
+        {
+            pWalTail->pNext = pBlock;
+        }
+        pWalTail = pBlock;
+        pthread_cond_signal(&wal_cvWork);
+        pthread_mutex_unlock(&wal_mutex);
+        return;
+    }
+#endif // UNIX_THREADS
+
+    WalRun(pBlock);
+    pBlock->pNext = pWalFree;
+    pWalFree = pBlock;
+}
+
+static void WalAppend(UINT32 iOp, Aname *nam, const UTF8 *pText, size_t nText)
+{
+    WalCheck();
+    if (!bWalLogging)
+    {
+        return;
+    }
+
+    WAL_HEADER hdr;
+    hdr.iOp     = iOp;
+    hdr.attrKey = *nam;
+    hdr.nText   = static_cast<UINT32>(nText);
+    hdr.nCheck  = CRC32_ProcessBuffer(0, &hdr.iOp, sizeof(hdr) - sizeof(hdr.nCheck));
+    hdr.nCheck  = CRC32_ProcessBuffer(hdr.nCheck, pText, nText);
+
+    if (  nullptr != pWalBlock
+       && sizeof(pWalBlock->aData) < pWalBlock->nData + sizeof(hdr) + nText)
+    {
+        WalSubmit(false, false);
+    }
+    if (nullptr == pWalBlock)
+    {
+        pWalBlock = WalNewBlock();
+    }
+
+    // A record is never larger than a header and an LBUF, so it always fits
+    // in an empty block.
+    //
+    memcpy(pWalBlock->aData + pWalBlock->nData, &hdr, sizeof(hdr));
+    pWalBlock->nData += sizeof(hdr);
+    memcpy(pWalBlock->aData + pWalBlock->nData, pText, nText);
+    pWalBlock->nData += nText;
+    wal_records++;
+}
+
+/*! \brief Open the write-ahead log.
+ *
+ * Nothing is logged, replayed, or discarded until cache_wal_start() decides
+ * whether the log still applies to the page file.
+ *
+ * \param wal_file  Name of the log file.
+ * \return          true if the log is open.
+ */
+
+bool cache_wal_open(const UTF8 *wal_file)
+{
+    if (  !cache_initted
+       || MUX_OPEN_INVALID_HANDLE_VALUE != hWalFile)
+    {
+        return false;
+    }
+    return mux_open(&hWalFile, wal_file, O_RDWR|O_BINARY|O_CREAT|O_APPEND);
+}
+
+/*! \brief Replay or discard the write-ahead log, and then begin logging.
+ *
+ * The log only applies to the page file it was written against, so it is
+ * replayed only when the game loaded a structure database on top of an
+ * existing page file.  Otherwise, it is discarded.  Either way, the result
+ * is checkpointed.  Only the first call does anything.
+ *
+ * \param bReplay  Whether the log should be applied.
+ */
+
+void cache_wal_start(bool bReplay)
+{
+    if (  bWalStarted
+       || MUX_OPEN_INVALID_HANDLE_VALUE == hWalFile)
+    {
+        return;
+    }
+    bWalStarted = true;
+
+    int nApplied = 0;
+    long nLog = mux_lseek(hWalFile, 0, SEEK_END);
+    if (  bReplay
+       && 0 < nLog)
+    {
+        mux_lseek(hWalFile, 0, SEEK_SET);
+        static UTF8 Text[LBUF_SIZE];
+        WAL_HEADER hdr;
+        while (static_cast<int>(sizeof(hdr)) == mux_read(hWalFile, &hdr, sizeof(hdr)))
+        {
+            if (  (  WAL_OP_PUT != hdr.iOp
+                  && WAL_OP_DEL != hdr.iOp)
+               || sizeof(Text) < hdr.nText
+               || hdr.nText != static_cast<UINT32>(mux_read(hWalFile, Text, hdr.nText)))
+            {
+                break;
+            }
+            UINT32 nCheck = CRC32_ProcessBuffer(0, &hdr.iOp, sizeof(hdr) - sizeof(hdr.nCheck));
+            nCheck = CRC32_ProcessBuffer(nCheck, Text, hdr.nText);
+            if (nCheck != hdr.nCheck)
+            {
+                break;
+            }
+
+            if (WAL_OP_PUT == hdr.iOp)
+            {
+                cache_put(&hdr.attrKey, Text, hdr.nText);
+            }
+            else
+            {
+                cache_del(&hdr.attrKey);
+            }
+            nApplied++;
+        }
+    }
+
+    if (0 < nLog)
+    {
+        STARTLOG(LOG_STARTUP, "INI", "LOAD");
+        if (bReplay)
+        {
+            Log.tinyprintf(T("Replayed %d attribute changes from the write-ahead log."), nApplied);
+        }
+        else
+        {
+            log_text(T("Discarded a write-ahead log which does not apply to the attribute database."));
+        }
+        ENDLOG;
+    }
+
+#if defined(UNIX_THREADS)
+    if (0 == pthread_create(&wal_thread, nullptr, wal_writer, nullptr))
+    {
+        bWalThread = true;
+    }
+#endif // UNIX_THREADS
+
+    bWalLogging = true;
+    cache_sync();
+}
+
+/*! \brief Group commit.
+ *
+ * Hands the log records gathered since the last commit to the writer, which
+ * writes them and waits for them to reach the disk with a single fsync().
+ */
+
+void cache_wal_commit(void)
+{
+    WalCheck();
+    if (  bWalLogging
+       && (  nullptr != pWalBlock
+          || bWalPending))
+    {
+        WalSubmit(true, false);
+        wal_commits++;
+    }
+}
+
 static void REMOVE_ENTRY(PCENT_HDR pEntry)
 {
+    CACHE_QUEUE *pQueue = &CacheQueue[pEntry->iQueue];
+
     // How is X positioned?
     //
-    if (pEntry == pCacheHead)
+    if (pEntry == pQueue->pHead)
     {
-        if (pEntry == pCacheTail)
+        if (pEntry == pQueue->pTail)
         {
             // HEAD --> X --> 0
             //    0 <--  <-- TAIL
@@ -154,7 +622,7 @@ static void REMOVE_ENTRY(PCENT_HDR pEntry)
             // ASSERT: pEntry->pNextEntry == 0;
             // ASSERT: pEntry->pPrevEntry == 0;
             //
-            pCacheHead = pCacheTail = 0;
+            pQueue->pHead = pQueue->pTail = 0;
         }
         else
         {
@@ -164,12 +632,12 @@ static void REMOVE_ENTRY(PCENT_HDR pEntry)
             // ASSERT: pEntry->pNextEntry != 0;
             // ASSERT: pEntry->pPrevEntry == 0;
             //
-            pCacheHead = pEntry->pNextEntry;
-            pCacheHead->pPrevEntry = 0;
+            pQueue->pHead = pEntry->pNextEntry;
+            pQueue->pHead->pPrevEntry = 0;
             pEntry->pNextEntry = 0;
         }
     }
-    else if (pEntry == pCacheTail)
+    else if (pEntry == pQueue->pTail)
     {
         // HEAD  --> Y --> X --> 0
         //    0 <--   <--   <-- TAIL
@@ -177,8 +645,8 @@ static void REMOVE_ENTRY(PCENT_HDR pEntry)
         // ASSERT: pEntry->pNextEntry == 0;
         // ASSERT: pEntry->pPrevEntry != 0;
         //
-        pCacheTail = pEntry->pPrevEntry;
-        pCacheTail->pNextEntry = 0;
+        pQueue->pTail = pEntry->pPrevEntry;
+        pQueue->pTail->pNextEntry = 0;
         pEntry->pPrevEntry = 0;
     }
     else
@@ -194,44 +662,133 @@ static void REMOVE_ENTRY(PCENT_HDR pEntry)
         pEntry->pNextEntry = 0;
         pEntry->pPrevEntry = 0;
     }
+
+    acache_stats[pEntry->iQueue].nEntries--;
+    acache_stats[pEntry->iQueue].nBytes -= pEntry->nSize;
+    if (ACACHE_GHOST != pEntry->iQueue)
+    {
+        CacheSize -= pEntry->nSize;
+    }
 }
 
-static void ADD_ENTRY(PCENT_HDR pEntry)
+static void ADD_ENTRY(PCENT_HDR pEntry, int iQueue)
 {
-    if (pCacheHead)
+    CACHE_QUEUE *pQueue = &CacheQueue[iQueue];
+    if (pQueue->pHead)
     {
-        pCacheHead->pPrevEntry = pEntry;
+        pQueue->pHead->pPrevEntry = pEntry;
     }
-    pEntry->pNextEntry = pCacheHead;
+    pEntry->pNextEntry = pQueue->pHead;
     pEntry->pPrevEntry = 0;
-    pCacheHead = pEntry;
-    if (!pCacheTail)
+    pEntry->iQueue = iQueue;
+    pQueue->pHead = pEntry;
+    if (!pQueue->pTail)
+    {
+        pQueue->pTail = pQueue->pHead;
+    }
+
+    acache_stats[iQueue].nEntries++;
+    acache_stats[iQueue].nBytes += pEntry->nSize;
+    if (ACACHE_GHOST != iQueue)
     {
-        pCacheTail = pCacheHead;
+        CacheSize += pEntry->nSize;
     }
 }
 
+// Remove an entry from the cache entirely.
+//
+static void DELETE_ENTRY(PCENT_HDR pEntry)
+{
+    REMOVE_ENTRY(pEntry);
+    hashdeleteLEN(&(pEntry->attrKey), sizeof(Aname), &mudstate.acache_htab);
+    MEMFREE(pEntry);
+}
+
 static void TrimCache(void)
 {
     // Check to see if the cache needs to be trimmed.
     //
+    size_t nRecentMax = mudconf.max_cache_size/4;
     while (CacheSize > mudconf.max_cache_size)
     {
+        PCENT_HDR pCacheEntry = CacheQueue[ACACHE_RECENT].pTail;
+        if (  pCacheEntry
+           && (  nRecentMax < acache_stats[ACACHE_RECENT].nBytes
+              || !CacheQueue[ACACHE_FREQUENT].pTail))
+        {
+            // Push the oldest Recent entry out, but remember its key as a
+            // ghost.
+            //
+            acache_stats[ACACHE_RECENT].nEvictions++;
+            Aname attrKey = pCacheEntry->attrKey;
+            DELETE_ENTRY(pCacheEntry);
+
+            PCENT_HDR pGhost = (PCENT_HDR)MEMALLOC(sizeof(CENT_HDR));
+            if (pGhost)
+            {
+                pGhost->attrKey = attrKey;
+                pGhost->nSize = sizeof(CENT_HDR);
+                ADD_ENTRY(pGhost, ACACHE_GHOST);
+                hashaddLEN(&attrKey, sizeof(Aname), pGhost,
+                    &mudstate.acache_htab);
+            }
+            continue;
+        }
+
         // Blow something away.
         //
-        PCENT_HDR pCacheEntry = pCacheTail;
+        pCacheEntry = CacheQueue[ACACHE_FREQUENT].pTail;
         if (!pCacheEntry)
         {
             CacheSize = 0;
             break;
         }
+        acache_stats[ACACHE_FREQUENT].nEvictions++;
+        DELETE_ENTRY(pCacheEntry);
+    }
 
-        REMOVE_ENTRY(pCacheEntry);
-        CacheSize -= pCacheEntry->nSize;
-        hashdeleteLEN(&(pCacheEntry->attrKey), sizeof(Aname),
-            &mudstate.acache_htab);
-        MEMFREE(pCacheEntry);
-        pCacheEntry = nullptr;
+    // Forget the oldest ghosts.
+    //
+    while (  CacheQueue[ACACHE_GHOST].pTail
+          &&   acache_stats[ACACHE_RECENT].nEntries
+             + acache_stats[ACACHE_FREQUENT].nEntries
+             < acache_stats[ACACHE_GHOST].nEntries)
+    {
+        acache_stats[ACACHE_GHOST].nEvictions++;
+        DELETE_ENTRY(CacheQueue[ACACHE_GHOST].pTail);
+    }
+}
+
+// Add a value to the cache. Keys which were cached before, either as values
+// or as ghosts, go to the Frequent queue.
+//
+static void CacheAdd(Aname *nam, const UTF8 *pValue, size_t nValue)
+{
+    int iQueue = ACACHE_RECENT;
+    PCENT_HDR pCacheEntry = (PCENT_HDR)hashfindLEN(nam, sizeof(Aname),
+        &mudstate.acache_htab);
+    if (pCacheEntry)
+    {
+        if (ACACHE_RECENT != pCacheEntry->iQueue)
+        {
+            iQueue = ACACHE_FREQUENT;
+        }
+        DELETE_ENTRY(pCacheEntry);
+    }
+
+    pCacheEntry = (PCENT_HDR)MEMALLOC(sizeof(CENT_HDR) + nValue);
+    if (pCacheEntry)
+    {
+        pCacheEntry->attrKey = *nam;
+        pCacheEntry->nSize = sizeof(CENT_HDR) + nValue;
+        if (0 < nValue)
+        {
+            memcpy((char *)(pCacheEntry+1), pValue, nValue);
+        }
+        ADD_ENTRY(pCacheEntry, iQueue);
+        hashaddLEN(nam, sizeof(Aname), pCacheEntry, &mudstate.acache_htab);
+
+        TrimCache();
     }
 }
 
@@ -251,13 +808,25 @@ const UTF8 *cache_get(Aname *nam, size_t *pLen)
         //
         pCacheEntry = (PCENT_HDR)hashfindLEN(nam, sizeof(Aname),
             &mudstate.acache_htab);
-        if (pCacheEntry)
+        if (  pCacheEntry
+           && ACACHE_GHOST == pCacheEntry->iQueue)
         {
-            // It was in the cache, so move this entry to the head of the queue.
-            // and return a pointer to it.
+            // Only the key is remembered. CacheAdd() will promote it.
             //
-            REMOVE_ENTRY(pCacheEntry);
-            ADD_ENTRY(pCacheEntry);
+            acache_stats[ACACHE_GHOST].nHits++;
+        }
+        else if (pCacheEntry)
+        {
+            // It was in the cache. Frequent entries move to the head of their
+            // queue. Recent entries stay where they are.
+            //
+            acache_stats[pCacheEntry->iQueue].nHits++;
+            if (ACACHE_FREQUENT == pCacheEntry->iQueue)
+            {
+                REMOVE_ENTRY(pCacheEntry);
+                ADD_ENTRY(pCacheEntry, ACACHE_FREQUENT);
+            }
+
             if (sizeof(CENT_HDR) < pCacheEntry->nSize)
             {
                 *pLen = pCacheEntry->nSize - sizeof(CENT_HDR);
@@ -269,6 +838,10 @@ const UTF8 *cache_get(Aname *nam, size_t *pLen)
                 return nullptr;
             }
         }
+        else
+        {
+            acache_misses++;
+        }
     }
 
     UINT32 nHash = CRC32_ProcessInteger2(nam->object, nam->attrnum);
@@ -288,19 +861,7 @@ const UTF8 *cache_get(Aname *nam, size_t *pLen)
             {
                 // Add this information to the cache.
                 //
-                pCacheEntry = (PCENT_HDR)MEMALLOC(sizeof(CENT_HDR)+nLength);
-                if (pCacheEntry)
-                {
-                    pCacheEntry->attrKey = *nam;
-                    pCacheEntry->nSize = nLength + sizeof(CENT_HDR);
-                    CacheSize += pCacheEntry->nSize;
-                    memcpy((char *)(pCacheEntry+1), TempRecord.attrText, nLength);
-                    ADD_ENTRY(pCacheEntry);
-                    hashaddLEN(nam, sizeof(Aname), pCacheEntry,
-                        &mudstate.acache_htab);
-
-                    TrimCache();
-                }
+                CacheAdd(nam, TempRecord.attrText, nLength);
             }
             return TempRecord.attrText;
         }
@@ -313,18 +874,7 @@ const UTF8 *cache_get(Aname *nam, size_t *pLen)
     {
         // Add this information to the cache.
         //
-        pCacheEntry = (PCENT_HDR)MEMALLOC(sizeof(CENT_HDR));
-        if (pCacheEntry)
-        {
-            pCacheEntry->attrKey = *nam;
-            pCacheEntry->nSize = sizeof(CENT_HDR);
-            CacheSize += pCacheEntry->nSize;
-            ADD_ENTRY(pCacheEntry);
-            hashaddLEN(nam, sizeof(Aname), pCacheEntry,
-                &mudstate.acache_htab);
-
-            TrimCache();
-        }
+        CacheAdd(nam, nullptr, 0);
     }
 
     *pLen = 0;
@@ -374,6 +924,11 @@ bool cache_put(Aname *nam, const UTF8 *value, size_t len)
         return true;
     }
 
+    if (bWalLogging)
+    {
+        WalAppend(WAL_OP_PUT, nam, value, len);
+    }
+
     UINT32 iDir = hfAttributeFile.FindFirstKey(nHash);
     while (iDir != HF_FIND_END)
     {
@@ -402,44 +957,29 @@ bool cache_put(Aname *nam, const UTF8 *value, size_t len)
 
     if (!mudstate.bStandAlone)
     {
-        // Update cache.
+        // Replace any cached copy with the new value.
         //
-        PCENT_HDR pCacheEntry = (PCENT_HDR)hashfindLEN(nam, sizeof(Aname),
-            &mudstate.acache_htab);
-        if (pCacheEntry)
-        {
-            // It was in the cache, so delete it.
-            //
-            REMOVE_ENTRY(pCacheEntry);
-            CacheSize -= pCacheEntry->nSize;
-            hashdeleteLEN((char *)nam, sizeof(Aname), &mudstate.acache_htab);
-            MEMFREE(pCacheEntry);
-            pCacheEntry = nullptr;
-        }
-
-        // Add information about the new entry back into the cache.
-        //
-        size_t nSizeOfEntry = sizeof(CENT_HDR) + len;
-        pCacheEntry = (PCENT_HDR)MEMALLOC(nSizeOfEntry);
-        if (pCacheEntry)
-        {
-            pCacheEntry->attrKey = *nam;
-            pCacheEntry->nSize = nSizeOfEntry;
-            CacheSize += pCacheEntry->nSize;
-            memcpy((char *)(pCacheEntry+1), TempRecord.attrText, len);
-            ADD_ENTRY(pCacheEntry);
-            hashaddLEN(nam, sizeof(Aname), pCacheEntry,
-                &mudstate.acache_htab);
-
-            TrimCache();
-        }
+        CacheAdd(nam, TempRecord.attrText, len);
     }
     return true;
 }
 
 bool cache_sync(void)
 {
-    hfAttributeFile.Sync();
+    WalCheck();
+    if (bWalLogging)
+    {
+        // Checkpoint.  The log covers the pages until the writer has waited
+        // for them, so the game only hands them to the OS.
+        //
+        hfAttributeFile.Flush(false);
+        WalSubmit(false, true);
+        wal_checkpoints++;
+    }
+    else
+    {
+        hfAttributeFile.Sync();
+    }
     return true;
 }
 
@@ -462,6 +1002,11 @@ void cache_del(Aname *nam)
     }
 #endif // HAVE_WORKING_FORK
 
+    if (bWalLogging)
+    {
+        WalAppend(WAL_OP_DEL, nam, nullptr, 0);
+    }
+
     UINT32 nHash = CRC32_ProcessInteger2(nam->object, nam->attrnum);
     UINT32 iDir = hfAttributeFile.FindFirstKey(nHash);
 
@@ -488,13 +1033,131 @@ void cache_del(Aname *nam)
         {
             // It was in the cache, so delete it.
             //
-            REMOVE_ENTRY(pCacheEntry);
-            CacheSize -= pCacheEntry->nSize;;
-            hashdeleteLEN((char *)nam, sizeof(Aname), &mudstate.acache_htab);
-            MEMFREE(pCacheEntry);
+            DELETE_ENTRY(pCacheEntry);
             pCacheEntry = nullptr;
         }
     }
 }
 
+// Parse the next unsigned number on a trace line.
+//
+static unsigned int ReplayNumber(const UTF8 **pp)
+{
+    const UTF8 *p = *pp;
+    while (mux_isspace(*p))
+    {
+        p++;
+    }
+    unsigned int n = static_cast<unsigned int>(mux_atol(p));
+    while (mux_isdigit(*p))
+    {
+        p++;
+    }
+    *pp = p;
+    return n;
+}
+
+/*! \brief Replay an attribute access trace against the cache.
+ *
+ * Used by dbconvert -b to measure the attribute cache. Each line of the
+ * trace is one of:
+ *
+ *   g <object> <attrnum>           cache_get()
+ *   p <object> <attrnum> <length>  cache_put() of <length> bytes
+ *   d <object> <attrnum>           cache_del()
+ *   s <bytes>                      Set max_cache_size.
+ *
+ * Blank lines and lines starting with '#' are ignored. Puts and deletes
+ * modify the database, so the trace should be replayed against a copy.
+ *
+ * \param fp        Trace file.
+ * \return          None.
+ */
+
+void cache_replay(FILE *fp)
+{
+    // The cache is normally bypassed in standalone mode.
+    //
+    bool bStandAloneSave = mudstate.bStandAlone;
+    mudstate.bStandAlone = false;
+
+    UTF8 *pValue = alloc_lbuf("cache_replay");
+    memset(pValue, 'x', LBUF_SIZE-1);
+    pValue[LBUF_SIZE-1] = '\0';
+
+    int nGets = 0, nPuts = 0, nDels = 0;
+    char aLine[256];
+    CLinearTimeAbsolute ltaStart;
+    ltaStart.GetUTC();
+    while (fgets(aLine, sizeof(aLine), fp))
+    {
+        const UTF8 *p = (UTF8 *)aLine;
+        UTF8 ch = *p++;
+        Aname nam;
+        size_t nLen;
+
+        switch (ch)
+        {
+        case 'g':
+            nam.object  = ReplayNumber(&p);
+            nam.attrnum = ReplayNumber(&p);
+            cache_get(&nam, &nLen);
+            nGets++;
+            break;
+
+        case 'p':
+            nam.object  = ReplayNumber(&p);
+            nam.attrnum = ReplayNumber(&p);
+            nLen = ReplayNumber(&p);
+            if (LBUF_SIZE <= nLen)
+            {
+                nLen = LBUF_SIZE-1;
+            }
+            cache_put(&nam, pValue + (LBUF_SIZE-1) - nLen, nLen + 1);
+            nPuts++;
+            break;
+
+        case 'd':
+            nam.object  = ReplayNumber(&p);
+            nam.attrnum = ReplayNumber(&p);
+            cache_del(&nam);
+            nDels++;
+            break;
+
+        case 's':
+            mudconf.max_cache_size = ReplayNumber(&p);
+            break;
+        }
+    }
+    CLinearTimeAbsolute ltaEnd;
+    ltaEnd.GetUTC();
+    CLinearTimeDelta ltd = ltaEnd - ltaStart;
+
+    static const UTF8 *QueueNames[ACACHE_QUEUES] =
+    {
+        T("Recent"),
+        T("Frequent"),
+        T("Ghost")
+    };
+
+    Log.tinyprintf(T("Replayed %d gets, %d puts, %d deletes in %ld msec." ENDLINE),
+        nGets, nPuts, nDels, ltd.ReturnMilliseconds());
+    Log.tinyprintf(T("Queue          Entries       Bytes        Hits   Evictions" ENDLINE));
+    for (int i = 0; i < ACACHE_QUEUES; i++)
+    {
+        Log.tinyprintf(T("%-10s %12d%12u%12d%12d" ENDLINE), QueueNames[i],
+            acache_stats[i].nEntries, (unsigned int)acache_stats[i].nBytes,
+            acache_stats[i].nHits, acache_stats[i].nEvictions);
+    }
+    int nHits = acache_stats[ACACHE_RECENT].nHits
+              + acache_stats[ACACHE_FREQUENT].nHits;
+    int nLookups = nHits + acache_stats[ACACHE_GHOST].nHits + acache_misses;
+    Log.tinyprintf(T("Misses     %12d" ENDLINE), acache_misses);
+    Log.tinyprintf(T("Hit ratio  %11d%%" ENDLINE),
+        (0 < nLookups) ? (100 * nHits)/nLookups : 0);
+
+    free_lbuf(pValue);
+    mudstate.bStandAlone = bStandAloneSave;
+}
+
 #endif // MEMORY_BASED
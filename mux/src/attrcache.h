@@ -12,13 +12,38 @@ typedef struct Aname
     unsigned int    attrnum;
 } Aname;
 
+// Attribute cache queues. See attrcache.cpp.
+//
+#define ACACHE_RECENT   0
+#define ACACHE_FREQUENT 1
+#define ACACHE_GHOST    2
+#define ACACHE_QUEUES   3
+
+typedef struct
+{
+    int     nEntries;       // Entries on the queue.
+    size_t  nBytes;         // Memory used by those entries.
+    int     nHits;          // Lookups which found the key on the queue.
+    int     nEvictions;     // Entries pushed off the end of the queue.
+} ACACHE_STATS;
+
+extern ACACHE_STATS acache_stats[ACACHE_QUEUES];
+extern int acache_misses;   // Lookups which did not find the key at all.
+extern int wal_records;     // Records appended to the write-ahead log.
+extern int wal_commits;     // Group commits of the write-ahead log.
+extern int wal_checkpoints; // Times the write-ahead log was emptied.
+
 extern const UTF8 *cache_get(Aname *nam, size_t *pLen);
 extern bool cache_put(Aname *nam, const UTF8 *obj, size_t len);
 extern int  cache_init(const UTF8 *game_dir_file, const UTF8 *game_pag_file,
-    int nCachePages);
+    int nCachePages, bool bMapped);
 extern void cache_close(void);
 extern void cache_tick(void);
 extern bool cache_sync(void);
 extern void cache_del(Aname *nam);
+extern void cache_replay(FILE *fp);
+extern bool cache_wal_open(const UTF8 *wal_file);
+extern void cache_wal_start(bool bReplay);
+extern void cache_wal_commit(void);
 
 #endif // !_ATTRCACHE_H
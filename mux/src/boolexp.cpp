@@ -16,6 +16,7 @@
 #include "mathutil.h"
 
 static bool parsing_internal = false;
+static bool parsing_uncacheable = false;
 
 /* ---------------------------------------------------------------------------
  * check_attr: indicate if attribute ATTR on player passes key when checked by
@@ -64,7 +65,6 @@ bool eval_boolexp(dbref player, dbref thing, dbref from, BOOLEXP *b)
     dbref aowner, obj, source;
     int aflags;
     UTF8 *buff, *buff2, *bp;
-    UTF8 *key;
     ATTR *a;
     bool bCheck, c;
 
@@ -127,9 +127,7 @@ bool eval_boolexp(dbref player, dbref thing, dbref from, BOOLEXP *b)
             mudstate.lock_nest_lev--;
             return false;
         }
-        key = atr_get("boolexp.130", b->sub1->thing, A_LOCK, &aowner, &aflags);
-        c = eval_boolexp_atr(player, b->sub1->thing, from, key);
-        free_lbuf(key);
+        c = eval_boolexp_lock(player, b->sub1->thing, from, A_LOCK);
         mudstate.lock_nest_lev--;
         return c;
 
@@ -285,6 +283,164 @@ bool eval_boolexp_atr(dbref player, dbref thing, dbref from, UTF8 *key)
     return ret_value;
 }
 
+/* ---------------------------------------------------------------------------
+ * Parsed lock cache.
+ *
+ * Stored locks are re-parsed every time they are checked. The cache below
+ * keeps the parsed tree for each (object, lock attribute) pair. An entry is
+ * dropped when its attribute is written, and the whole cache is dropped when
+ * attribute names are deleted, renamed, or renumbered by @dbclean.
+ *
+ * Evaluating a lock can run softcode which changes that same lock, so an
+ * entry which is being evaluated is only marked stale and is freed by the
+ * last evaluation to finish with it.
+ */
+
+int lc_parses = 0;      // Locks parsed.
+int lc_saved  = 0;      // Parses avoided by the cache.
+
+typedef struct tagLockCacheEntry
+{
+    BOOLEXP *b;
+    int      nRefs;
+    bool     bStale;
+} LOCK_CENT;
+
+static int nLockEntries = 0;
+
+static void lock_cache_discard(LOCK_CENT *pEntry)
+{
+    nLockEntries--;
+    if (0 < pEntry->nRefs)
+    {
+        pEntry->bStale = true;
+    }
+    else
+    {
+        free_boolexp(pEntry->b);
+        MEMFREE(pEntry);
+    }
+}
+
+/*! \brief Drop the cached parse of one lock.
+ *
+ * Called whenever an attribute is written or cleared.
+ *
+ * \param thing     Object.
+ * \param atr       Attribute number.
+ * \return          None.
+ */
+
+void lock_cache_invalidate(dbref thing, int atr)
+{
+    if (0 == nLockEntries)
+    {
+        return;
+    }
+
+    Aname key;
+    key.object  = thing;
+    key.attrnum = atr;
+    LOCK_CENT *pEntry = (LOCK_CENT *)hashfindLEN(&key, sizeof(key), &mudstate.lock_htab);
+    if (pEntry)
+    {
+        hashdeleteLEN(&key, sizeof(key), &mudstate.lock_htab);
+        lock_cache_discard(pEntry);
+    }
+}
+
+/*! \brief Drop every cached lock parse.
+ *
+ * \return          None.
+ */
+
+void lock_cache_flush(void)
+{
+    for (LOCK_CENT *pEntry = (LOCK_CENT *)hash_firstentry(&mudstate.lock_htab);
+         nullptr != pEntry;
+         pEntry = (LOCK_CENT *)hash_nextentry(&mudstate.lock_htab))
+    {
+        lock_cache_discard(pEntry);
+    }
+    hashflush(&mudstate.lock_htab);
+}
+
+/*! \brief Evaluate the lock stored in an attribute.
+ *
+ * Like eval_boolexp_atr(), but the attribute is fetched and parsed only
+ * if the cache does not already hold its parse.
+ *
+ * \param player    Object attempting to pass the lock.
+ * \param thing     Object holding the lock.
+ * \param from      Object on whose behalf the lock is checked.
+ * \param locknum   Lock attribute.
+ * \return          true if the lock is passed.
+ */
+
+bool eval_boolexp_lock(dbref player, dbref thing, dbref from, int locknum)
+{
+    Aname key;
+    key.object  = thing;
+    key.attrnum = locknum;
+
+    LOCK_CENT *pEntry = nullptr;
+    if (!mudstate.bStandAlone)
+    {
+        pEntry = (LOCK_CENT *)hashfindLEN(&key, sizeof(key), &mudstate.lock_htab);
+    }
+
+    if (pEntry)
+    {
+        lc_saved++;
+    }
+    else
+    {
+        dbref aowner;
+        int   aflags;
+        UTF8 *text = atr_get("eval_boolexp_lock", thing, locknum, &aowner, &aflags);
+        parsing_uncacheable = false;
+        BOOLEXP *b = parse_boolexp(player, text, true);
+        free_lbuf(text);
+        lc_parses++;
+
+        if (  mudstate.bStandAlone
+           || parsing_uncacheable)
+        {
+            bool ret_value = true;
+            if (b != TRUE_BOOLEXP)
+            {
+                ret_value = eval_boolexp(player, thing, from, b);
+                free_boolexp(b);
+            }
+            return ret_value;
+        }
+
+        pEntry = (LOCK_CENT *)MEMALLOC(sizeof(LOCK_CENT));
+        ISOUTOFMEMORY(pEntry);
+        pEntry->b      = b;
+        pEntry->nRefs  = 0;
+        pEntry->bStale = false;
+        hashaddLEN(&key, sizeof(key), pEntry, &mudstate.lock_htab);
+        nLockEntries++;
+    }
+
+    if (TRUE_BOOLEXP == pEntry->b)
+    {
+        return true;
+    }
+
+    pEntry->nRefs++;
+    bool ret_value = eval_boolexp(player, thing, from, pEntry->b);
+    pEntry->nRefs--;
+    if (  pEntry->bStale
+       && 0 == pEntry->nRefs)
+    {
+        free_boolexp(pEntry->b);
+        MEMFREE(pEntry);
+    }
+    return ret_value;
+}
+
 // If the parser returns TRUE_BOOLEXP, you lose
 // TRUE_BOOLEXP cannot be typed in by the user; use @unlock instead
 //
@@ -339,6 +495,11 @@ static BOOLEXP *test_atr(UTF8 *s)
     ATTR *attrib = atr_str(buff);
     if (!attrib)
     {
+        // The result depends on who is parsing and on attribute names which
+        // may be defined later, so it must not be cached.
+        //
+        parsing_uncacheable = true;
+
         // Only #1 can lock on numbers
         //
         if (!God(parse_player))
@@ -46,13 +46,22 @@ unsigned int ndescriptors = 0;
 DESC *descriptor_list = nullptr;
 
 static void telnet_setup(DESC *d);
+#if defined(UNIX_MCCP)
+static bool mccp_pending(const DESC *d);
+#endif // UNIX_MCCP
 static void site_mon_send(SOCKET, const UTF8 *, DESC *, const UTF8 *);
 static DESC *initializesock(SOCKET, MUX_SOCKADDR *msa);
 #if defined(UNIX_NETWORKING)
-static DESC *new_connection(PortInfo *Port, int *piError);
+static int accept_connections(PortInfo *Port, int *piError);
+static DESC *new_connection(PortInfo *Port, SOCKET newsock, mux_sockaddr *paddr);
 #endif
-static bool process_input(DESC *);
+static bool process_input(DESC *, bool *pfMore = nullptr);
 static int make_nonblocking(SOCKET s);
+#if defined(UNIX_SSL_WORKERS)
+static void epoll_service_desc(DESC *d, UINT32 events);
+static void tls_update(DESC *d);
+static void tls_stop_workers(void);
+#endif // UNIX_SSL_WORKERS
 
 pid_t game_pid;
 
@@ -354,6 +363,194 @@ static int get_slave_result(void)
 int maxd = 0;
 #endif // UNIX_NETWORKING_SELECT
 
+#if defined(UNIX_NETWORKING_EPOLL)
+
+// Each descriptor is registered with epoll once in initializesock() and
+// removed in shutdownsock(). The events requested for it follow its queues:
+// EPOLLIN while the input queue is empty, and EPOLLOUT while the output queue
+// is not. Listening ports and the slave sockets are reconciled once per pass
+// of shovechars().
+//
+#define EPOLL_MAX_EVENTS 256
+
+static int  epoll_fd = -1;
+static bool epoll_unavailable = false;
+static struct epoll_event aEpollEvents[EPOLL_MAX_EVENTS];
+static int  nEpollEvents = 0;
+
+static EPOLL_REG aEpollPorts[sizeof(main_game_ports)/sizeof(main_game_ports[0])];
+static int  nEpollPorts = 0;
+
+#if defined(HAVE_WORKING_FORK)
+static EPOLL_REG regSlave = { EPOLL_KIND_SLAVE, 0, INVALID_SOCKET, false, false, 0, nullptr };
+#ifdef STUB_SLAVE
+static EPOLL_REG regStubSlave = { EPOLL_KIND_STUBSLAVE, 0, INVALID_SOCKET, false, false, 0, nullptr };
+#endif // STUB_SLAVE
+#endif // HAVE_WORKING_FORK
+
+static bool epoll_init(void)
+{
+    if (0 <= epoll_fd)
+    {
+        return true;
+    }
+    else if (epoll_unavailable)
+    {
+        return false;
+    }
+
+    // The size argument is only a hint, but it must be positive.
+    //
+    epoll_fd = epoll_create(EPOLL_MAX_EVENTS);
+    if (epoll_fd < 0)
+    {
+        epoll_unavailable = true;
+        log_perror(T("NET"), T("FAIL"), T("epoll_init"), T("epoll_create"));
+        return false;
+    }
+
+    // Do not leak the epoll descriptor into the slaves or across @restart.
+    //
+    fcntl(epoll_fd, F_SETFD, FD_CLOEXEC);
+    return true;
+}
+
+static void epoll_set_events(EPOLL_REG *r, UINT32 events)
+{
+    if (  r->fRegistered
+       && r->events == events)
+    {
+        return;
+    }
+    else if (!epoll_init())
+    {
+        return;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = events;
+    ev.data.ptr = r;
+
+    int op = r->fRegistered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+    int ret = epoll_ctl(epoll_fd, op, r->socket, &ev);
+    if (  ret < 0
+       && EPOLL_CTL_ADD == op
+       && EEXIST == errno)
+    {
+        // The socket is already known (a listening port moved to a different
+        // slot), so just point it at its new registration.
+        //
+        ret = epoll_ctl(epoll_fd, EPOLL_CTL_MOD, r->socket, &ev);
+    }
+
+    if (ret < 0)
+    {
+        log_perror(T("NET"), T("FAIL"), T("epoll_set_events"), T("epoll_ctl"));
+        return;
+    }
+    r->fRegistered = true;
+    r->events = events;
+}
+
+// This must be called before the socket is closed. Otherwise, a forked child
+// holding a copy of the socket keeps the registration alive.
+//
+static void epoll_remove(EPOLL_REG *r)
+{
+    if (  r->fRegistered
+       && 0 <= epoll_fd)
+    {
+        // Kernels before 2.6.9 require a non-null event even for EPOLL_CTL_DEL.
+        //
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, r->socket, &ev);
+    }
+    r->fRegistered = false;
+    r->events = 0;
+
+    // Forget about any events for this socket which shovechars() has not
+    // gotten to, yet.
+    //
+    for (int i = 0; i < nEpollEvents; i++)
+    {
+        if (aEpollEvents[i].data.ptr == r)
+        {
+            aEpollEvents[i].data.ptr = nullptr;
+        }
+    }
+}
+
+void epoll_register(DESC *d)
+{
+    d->epoll.kind = EPOLL_KIND_DESC;
+    d->epoll.iPort = 0;
+    d->epoll.socket = d->socket;
+    d->epoll.fRegistered = false;
+    d->epoll.fHangup = false;
+    d->epoll.events = 0;
+    d->epoll.d = d;
+    epoll_update(d);
+}
+
+void epoll_update(DESC *d)
+{
+#if defined(UNIX_SSL_WORKERS)
+    if (nullptr != d->tls)
+    {
+        tls_update(d);
+        return;
+    }
+#endif // UNIX_SSL_WORKERS
+
+    if (d->epoll.fHangup)
+    {
+        // The peer is gone, but there is still input to process. Sit out
+        // until the input queue drains. Otherwise, a level-triggered EPOLLHUP
+        // would be reported on every pass.
+        //
+        if (nullptr != d->input_head)
+        {
+            epoll_remove(&d->epoll);
+            return;
+        }
+        d->epoll.fHangup = false;
+    }
+
+    UINT32 events = 0;
+    if (nullptr == d->input_head)
+    {
+        events |= EPOLLIN;
+    }
+    if (  nullptr != d->output_head
+#if defined(UNIX_MCCP)
+       || mccp_pending(d)
+#endif // UNIX_MCCP
+       )
+    {
+        events |= EPOLLOUT;
+    }
+    if (mudconf.epoll_edge_triggered)
+    {
+        events |= EPOLLET;
+    }
+    epoll_set_events(&d->epoll, events);
+}
+
+static void epoll_remove_socket(SOCKET s)
+{
+    for (int i = 0; i < nEpollPorts; i++)
+    {
+        if (aEpollPorts[i].socket == s)
+        {
+            epoll_remove(&aEpollPorts[i]);
+        }
+    }
+}
+
+#endif // UNIX_NETWORKING_EPOLL
+
 #if defined(HAVE_WORKING_FORK)
 
 pid_t slave_pid = 0;
@@ -367,6 +564,9 @@ void CleanUpSlaveSocket(void)
 {
     if (!IS_INVALID_SOCKET(slave_socket))
     {
+#if defined(UNIX_NETWORKING_EPOLL)
+        epoll_remove(&regSlave);
+#endif // UNIX_NETWORKING_EPOLL
         shutdown(slave_socket, SD_BOTH);
         if (0 == SOCKET_CLOSE(slave_socket))
         {
@@ -391,6 +591,9 @@ void CleanUpStubSlaveSocket(void)
 {
     if (!IS_INVALID_SOCKET(stubslave_socket))
     {
+#if defined(UNIX_NETWORKING_EPOLL)
+        epoll_remove(&regStubSlave);
+#endif // UNIX_NETWORKING_EPOLL
         shutdown(stubslave_socket, SD_BOTH);
         if (0 == SOCKET_CLOSE(stubslave_socket))
         {
@@ -924,6 +1127,9 @@ bool initialize_ssl()
 
 void shutdown_ssl()
 {
+#if defined(UNIX_SSL_WORKERS)
+    tls_stop_workers();
+#endif // UNIX_SSL_WORKERS
     if (ssl_ctx)
     {
         SSL_CTX_free(ssl_ctx);
@@ -938,150 +1144,1144 @@ void shutdown_ssl()
 
 void CleanUpSSLConnections()
 {
-    DESC *d;
+    DESC *d, *dnext;
 
-    DESC_ITER_ALL(d)
+    DESC_SAFEITER_ALL(d, dnext)
     {
         if (d->ssl_session)
         {
             shutdownsock(d, R_RESTART);
         }
     }
+#if defined(UNIX_SSL_WORKERS)
+    tls_stop_workers();
+#endif // UNIX_SSL_WORKERS
 }
 
 #endif
 
-int mux_socket_read(DESC *d, char *buffer, size_t nBytes, int flags)
+#if defined(UNIX_SSL_WORKERS)
+
+// TLS workers.  Handshakes, encryption, and the socket I/O for SSL sessions
+// run on a small pool of threads so that they do not hold up the game.  Each
+// session is owned by one worker, and it trades plaintext with the game
+// through a pair of rings.  Each ring has exactly one producer and one
+// consumer, so the data itself moves without locks.  The locks below only
+// guard the short lists used to wake the other side.
+//
+// The game reads from rIn and writes to rOut in place of the socket, and it
+// hears about a session through tls_aNotify, which shovechars() watches like
+// any other socket.  Once shutdownsock() releases a session, the worker
+// flushes what is left in rOut, closes the socket, and hands the session
+// back to be freed.
+//
+#define TLS_MAX_WORKERS   8
+#define TLS_RING_SIZE     32768
+#define TLS_LINGER        10
+#define TLS_MAX_EVENTS    64
+
+// The producer only advances iWrite, and the consumer only advances iRead.
+// Both are free-running, so iWrite - iRead is the number of bytes queued.
+//
+struct tls_ring
 {
-    int result;
+    size_t        iRead;
+    size_t        iWrite;
+    unsigned char aData[TLS_RING_SIZE];
+};
 
-#ifdef UNIX_SSL
-    if (d->ssl_session)
-    {
-        result = SSL_read(d->ssl_session, buffer, nBytes);
-    }
-    else
-#endif
-    {
-        result = SOCKET_READ(d->socket, buffer, nBytes, flags);
-    }
+struct tls_conn
+{
+    SSL       *ssl;
+    SOCKET     socket;
+    int        iWorker;
+    DESC      *d;                 // Game only.  nullptr once released.
 
-    return result;
+    tls_ring   rIn;               // Plaintext from the client.
+    tls_ring   rOut;              // Plaintext for the client.
+
+    // Written by the worker.
+    //
+    bool       bHandshaken;
+    bool       bClosed;           // No more input, and rOut will not drain.
+    int        iError;            // SSL error which closed the session.
+
+    // Written by the game.
+    //
+    bool       bRelease;
+
+    // Each side asks the other to say when a full ring has room again.
+    //
+    bool       bGameWantsRoom;
+    bool       bWorkerWantsRoom;
+
+    // Used only by the worker.
+    //
+    bool       bAttached;
+    bool       bLingering;
+    bool       bFinished;         // Closed, and waiting to be handed back.
+    UINT32     events;
+    time_t     tRelease;
+    tls_conn  *pNextConn;
+    tls_conn  *pNextFinished;
+
+    // Protected by the owning worker's mutex.
+    //
+    bool       bKicked;
+    tls_conn  *pNextKicked;
+
+    // Protected by tls_ready_mutex.
+    //
+    bool       bReady;
+    tls_conn  *pNextReady;
+
+    // Set by the worker under tls_ready_mutex when it has let go of the
+    // session for good.  The game frees the session only after it sees this
+    // under the same lock.
+    //
+    std::atomic<bool> bDone;
+};
+
+struct tls_worker
+{
+    pthread_t        thread;
+    pthread_mutex_t  mutex;
+    int              epfd;
+    int              aWake[2];
+    bool             bStop;       // Protected by mutex.
+    tls_conn        *pKicked;     // Protected by mutex.
+    tls_conn        *pConns;      // Used only by the worker.
+    int              nLingering;  // Used only by the worker.
+    int              nConns;      // Used only by the game.
+    INT64            nHandshakes;
+    INT64            nBytesIn;
+    INT64            nBytesOut;
+};
+
+static tls_worker      tls_aWorkers[TLS_MAX_WORKERS];
+static int             tls_nWorkers = 0;
+static pthread_mutex_t tls_ready_mutex = PTHREAD_MUTEX_INITIALIZER;
+static tls_conn       *tls_pReady = nullptr;
+static int             tls_aNotify[2] = { -1, -1 };
+static EPOLL_REG       regTlsNotify = { EPOLL_KIND_TLS, 0, INVALID_SOCKET, false, false, 0, nullptr };
+
+// Room the producer can fill in one piece.
+//
+static size_t tls_ring_write_span(tls_ring *r, unsigned char **pp)
+{
+    const size_t iWrite = __atomic_load_n(&r->iWrite, __ATOMIC_RELAXED);
+    const size_t iRead  = __atomic_load_n(&r->iRead, __ATOMIC_ACQUIRE);
+    const size_t iAt    = iWrite & (TLS_RING_SIZE - 1);
+    const size_t nFree  = TLS_RING_SIZE - (iWrite - iRead);
+    const size_t nSpan  = TLS_RING_SIZE - iAt;
+    *pp = r->aData + iAt;
+    return (nFree < nSpan) ? nFree : nSpan;
 }
 
+static void tls_ring_produce(tls_ring *r, size_t n)
+{
+    const size_t iWrite = __atomic_load_n(&r->iWrite, __ATOMIC_RELAXED);
+    __atomic_store_n(&r->iWrite, iWrite + n, __ATOMIC_RELEASE);
+}
 
-bool make_socket(SOCKET *ps, MUX_ADDRINFO *ai)
+// Bytes the consumer can take in one piece.
+//
+static size_t tls_ring_read_span(tls_ring *r, unsigned char **pp)
+{
+    const size_t iRead  = __atomic_load_n(&r->iRead, __ATOMIC_RELAXED);
+    const size_t iWrite = __atomic_load_n(&r->iWrite, __ATOMIC_ACQUIRE);
+    const size_t iAt    = iRead & (TLS_RING_SIZE - 1);
+    const size_t nUsed  = iWrite - iRead;
+    const size_t nSpan  = TLS_RING_SIZE - iAt;
+    *pp = r->aData + iAt;
+    return (nUsed < nSpan) ? nUsed : nSpan;
+}
+
+static void tls_ring_consume(tls_ring *r, size_t n)
 {
-    // Create a TCP/IP stream socket
-    //
-    SOCKET s = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
-    if (IS_INVALID_SOCKET(s))
-    {
-        log_perror(T("NET"), T("FAIL"), nullptr, T("creating socket"));
-        return false;
-    }
-    DebugTotalSockets++;
+    const size_t iRead = __atomic_load_n(&r->iRead, __ATOMIC_RELAXED);
+    __atomic_store_n(&r->iRead, iRead + n, __ATOMIC_RELEASE);
+}
 
-    int opt = 1;
-    if (setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (char *)&opt, sizeof(opt)) < 0)
+static size_t tls_ring_used(tls_ring *r)
+{
+    return __atomic_load_n(&r->iWrite, __ATOMIC_ACQUIRE)
+         - __atomic_load_n(&r->iRead, __ATOMIC_ACQUIRE);
+}
+
+// Put a session on the game's ready list unless it is already there.  A
+// worker handing a finished session back says so under the same lock.
+//
+static void tls_queue_ready(tls_conn *tc, bool bHandBack)
+{
+    pthread_mutex_lock(&tls_ready_mutex);
+    if (bHandBack)
     {
-        log_perror(T("NET"), T("FAIL"), nullptr, T("SO_REUSEADDR"));
+        tc->bDone.store(true, std::memory_order_release);
     }
-
-#if defined(HAVE_SOCKADDR_IN6)
-    if (AF_INET6 == ai->ai_family)
+    if (!tc->bReady)
     {
-        opt = 1;
-        if (setsockopt(s, IPPROTO_IPV6, IPV6_V6ONLY, (char *)&opt, sizeof(opt)) < 0)
+        const bool bWasEmpty = (nullptr == tls_pReady);
+        tc->bReady = true;
+        tc->pNextReady = tls_pReady;
+        tls_pReady = tc;
+        if (bWasEmpty)
         {
-            log_perror(T("NET"), T("FAIL"), nullptr, T("IPV6_V6ONLY"));
+            const char ch = 0;
+            (void)write(tls_aNotify[1], &ch, 1);
         }
     }
-#endif
+    pthread_mutex_unlock(&tls_ready_mutex);
+}
 
-    // bind our name to the socket
-    //
-    int nRet = bind(s, ai->ai_addr, ai->ai_addrlen);
-    if (IS_SOCKET_ERROR(nRet))
+// Called from either side to ask the game to look at a session.
+//
+static void tls_signal_game(tls_conn *tc)
+{
+    tls_queue_ready(tc, false);
+}
+
+// Called by a worker to give a finished session back to the game.  This is
+// the worker's last touch of the session.
+//
+static void tls_hand_back(tls_conn *tc)
+{
+    tls_queue_ready(tc, true);
+}
+
+// Called by the game to ask a worker to look at a session.
+//
+static void tls_kick(tls_conn *tc)
+{
+    tls_worker *pw = &tls_aWorkers[tc->iWorker];
+    pthread_mutex_lock(&pw->mutex);
+    if (!tc->bKicked)
     {
-        Log.tinyprintf(T("Error %ld on bind" ENDLINE), SOCKET_LAST_ERROR);
-        if (0 == SOCKET_CLOSE(s))
+        const bool bWasEmpty = (nullptr == pw->pKicked);
+        tc->bKicked = true;
+        tc->pNextKicked = pw->pKicked;
+        pw->pKicked = tc;
+        if (bWasEmpty)
         {
-            DebugTotalSockets--;
+            const char ch = 0;
+            (void)write(pw->aWake[1], &ch, 1);
         }
-        return false;
     }
+    pthread_mutex_unlock(&pw->mutex);
+}
 
-    // Set the socket to listen
+static void tls_set_events(tls_worker *pw, tls_conn *tc, UINT32 events)
+{
+    // EPOLLHUP and EPOLLERR cannot be masked, so a session which is waiting
+    // on the game is taken out of the set instead of being left in with no
+    // events.
     //
-    nRet = listen(s, SOMAXCONN);
+    if (tc->events == events)
+    {
+        return;
+    }
 
-    if (nRet)
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = events;
+    ev.data.ptr = tc;
+    if (0 == events)
     {
-        Log.tinyprintf(T("Error %ld on listen" ENDLINE), SOCKET_LAST_ERROR);
-        if (0 == SOCKET_CLOSE(s))
-        {
-            DebugTotalSockets--;
-        }
-        return false;
+        epoll_ctl(pw->epfd, EPOLL_CTL_DEL, tc->socket, &ev);
     }
-    *ps = s;
+    else if (0 == tc->events)
+    {
+        epoll_ctl(pw->epfd, EPOLL_CTL_ADD, tc->socket, &ev);
+    }
+    else
+    {
+        epoll_ctl(pw->epfd, EPOLL_CTL_MOD, tc->socket, &ev);
+    }
+    tc->events = events;
+}
 
-#if defined(WINDOWS_NETWORKING)
+static void tls_finish(tls_worker *pw, tls_conn *tc, tls_conn **ppFinished)
+{
+    tls_set_events(pw, tc, 0);
+    if (tc->bHandshaken && !tc->bClosed)
+    {
+        ERR_clear_error();
+        SSL_shutdown(tc->ssl);
+    }
+    SSL_free(tc->ssl);
+    tc->ssl = nullptr;
+    shutdown(tc->socket, SD_BOTH);
+    SOCKET_CLOSE(tc->socket);
+    tc->socket = INVALID_SOCKET;
+    if (tc->bLingering)
+    {
+        pw->nLingering--;
+    }
 
-    // Create the listening thread.
+    tls_conn **pp = &pw->pConns;
+    while (*pp != tc)
+    {
+        pp = &(*pp)->pNextConn;
+    }
+    *pp = tc->pNextConn;
+
+    // The session may have been kicked since the worker last looked, and it
+    // must not be found on that list once the game frees it.
     //
-    HANDLE hThread = CreateThread(nullptr, 0, mux_listen_thread, (LPVOID)ps, 0, nullptr);
-    if (nullptr == hThread)
+    pthread_mutex_lock(&pw->mutex);
+    if (tc->bKicked)
     {
-        log_perror(T("NET"), T("FAIL"), T("CreateThread"), T("setsockopt"));
-        if (0 == SOCKET_CLOSE(s))
+        pp = &pw->pKicked;
+        while (*pp != tc)
         {
-            DebugTotalSockets--;
+            pp = &(*pp)->pNextKicked;
         }
-        return false;
+        *pp = tc->pNextKicked;
+        tc->bKicked = false;
     }
-#endif
-    return true;
+    pthread_mutex_unlock(&pw->mutex);
+
+    // Hand the session back once the current batch of events is done with.
+    //
+    tc->bFinished = true;
+    tc->pNextFinished = *ppFinished;
+    *ppFinished = tc;
 }
 
-#if defined(UNIX_NETWORKING)
+/*! \brief Move a session along as far as it will go without blocking.
+ *
+ * \param pw          Worker which owns the session.
+ * \param tc          Session.
+ * \param ppFinished  List of sessions to give back to the game.
+ * \return            None.
+ */
 
-bool ValidSocket(SOCKET s)
+static void tls_service(tls_worker *pw, tls_conn *tc, tls_conn **ppFinished)
 {
-    struct stat fstatbuf;
-    if (fstat(s, &fstatbuf) < 0)
+    if (tc->bFinished)
     {
-        return false;
+        return;
     }
-    return true;
-}
 
-#endif // UNIX_NETWORKING
+    const bool bRelease = __atomic_load_n(&tc->bRelease, __ATOMIC_ACQUIRE);
+    bool bSignal = false;
+    bool bWantRead = false;
+    bool bWantWrite = false;
+    int  iError = SSL_ERROR_NONE;
 
-void PortInfoClose(int *pnPorts, PortInfo aPorts[], int i)
-{
-    if (0 == SOCKET_CLOSE(aPorts[i].socket))
+    if (!tc->bHandshaken)
     {
-        DebugTotalSockets--;
-        (*pnPorts)--;
-        int k = *pnPorts;
-        if (i != k)
+        ERR_clear_error();
+        const int r = SSL_accept(tc->ssl);
+        if (1 == r)
         {
-            aPorts[i] = aPorts[k];
+            __atomic_store_n(&tc->bHandshaken, true, __ATOMIC_RELEASE);
+            __atomic_add_fetch(&pw->nHandshakes, 1, __ATOMIC_RELAXED);
+            bSignal = true;
+        }
+        else
+        {
+            iError = SSL_get_error(tc->ssl, r);
         }
-        aPorts[k].socket = INVALID_SOCKET;
-        aPorts[k].fMatched = false;
     }
-}
 
-void PortInfoOpen(int *pnPorts, PortInfo aPorts[], MUX_ADDRINFO *ai, bool fSSL)
-{
-    int k = *pnPorts;
-    if (  k < MAX_LISTEN_PORTS
-       && make_socket(&aPorts[k].socket, ai)
-       && !IS_INVALID_SOCKET(aPorts[k].socket)
-#if defined(UNIX_NETWORKING)
+    if (tc->bHandshaken)
+    {
+        // Decrypt whatever has arrived, as long as the game has room for it.
+        //
+        while (!bRelease)
+        {
+            unsigned char *p;
+            size_t n = tls_ring_write_span(&tc->rIn, &p);
+            if (0 == n)
+            {
+                // Full.  Ask to hear when the game takes some, and look once
+                // more in case it already has.
+                //
+                __atomic_store_n(&tc->bWorkerWantsRoom, true, __ATOMIC_SEQ_CST);
+                __atomic_thread_fence(__ATOMIC_SEQ_CST);
+                n = tls_ring_write_span(&tc->rIn, &p);
+                if (0 == n)
+                {
+                    break;
+                }
+                __atomic_store_n(&tc->bWorkerWantsRoom, false, __ATOMIC_RELAXED);
+            }
+
+            ERR_clear_error();
+            const int r = SSL_read(tc->ssl, p, static_cast<int>(n));
+            if (0 < r)
+            {
+                tls_ring_produce(&tc->rIn, r);
+                __atomic_add_fetch(&pw->nBytesIn, r, __ATOMIC_RELAXED);
+                bSignal = true;
+                continue;
+            }
+            iError = SSL_get_error(tc->ssl, r);
+            break;
+        }
+        if (SSL_ERROR_WANT_READ == iError)
+        {
+            bWantRead = true;
+            iError = SSL_ERROR_NONE;
+        }
+
+        // Encrypt and send whatever the game has queued.
+        //
+        while (SSL_ERROR_NONE == iError)
+        {
+            unsigned char *p;
+            const size_t n = tls_ring_read_span(&tc->rOut, &p);
+            if (0 == n)
+            {
+                break;
+            }
+
+            ERR_clear_error();
+            const int r = SSL_write(tc->ssl, p, static_cast<int>(n));
+            if (r <= 0)
+            {
+                const int iWriteError = SSL_get_error(tc->ssl, r);
+                if (SSL_ERROR_WANT_READ == iWriteError)
+                {
+                    bWantRead = true;
+                }
+                else
+                {
+                    iError = iWriteError;
+                }
+                break;
+            }
+            tls_ring_consume(&tc->rOut, r);
+            __atomic_add_fetch(&pw->nBytesOut, r, __ATOMIC_RELAXED);
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+            if (__atomic_exchange_n(&tc->bGameWantsRoom, false, __ATOMIC_SEQ_CST))
+            {
+                bSignal = true;
+            }
+        }
+    }
+
+    if (SSL_ERROR_WANT_READ == iError)
+    {
+        bWantRead = true;
+    }
+    else if (SSL_ERROR_WANT_WRITE == iError)
+    {
+        bWantWrite = true;
+    }
+    else if (SSL_ERROR_NONE != iError)
+    {
+        // The client went away, or the session failed.
+        //
+        tc->iError = iError;
+        __atomic_store_n(&tc->bClosed, true, __ATOMIC_RELEASE);
+        bSignal = true;
+    }
+
+    if (bRelease)
+    {
+        if (  tc->bClosed
+           || 0 == tls_ring_used(&tc->rOut))
+        {
+            tls_finish(pw, tc, ppFinished);
+            return;
+        }
+        else if (!tc->bLingering)
+        {
+            // Give the client a while to take the rest of its output.
+            //
+            tc->bLingering = true;
+            tc->tRelease = time(nullptr);
+            pw->nLingering++;
+        }
+    }
+    else if (bSignal)
+    {
+        tls_signal_game(tc);
+    }
+
+    UINT32 events = 0;
+    if (!tc->bClosed)
+    {
+        if (  bWantRead
+           || (  !bRelease
+              && !__atomic_load_n(&tc->bWorkerWantsRoom, __ATOMIC_RELAXED)))
+        {
+            events |= EPOLLIN;
+        }
+        if (bWantWrite)
+        {
+            events |= EPOLLOUT;
+        }
+    }
+    tls_set_events(pw, tc, events);
+}
+
+static void *tls_worker_main(void *pArg)
+{
+    tls_worker *pw = static_cast<tls_worker *>(pArg);
+    struct epoll_event aEvents[TLS_MAX_EVENTS];
+    for (;;)
+    {
+        const int nEvents = epoll_wait(pw->epfd, aEvents, TLS_MAX_EVENTS,
+            (0 < pw->nLingering) ? 1000 : -1);
+
+        tls_conn *pFinished = nullptr;
+        for (int i = 0; i < nEvents; i++)
+        {
+            tls_conn *tc = static_cast<tls_conn *>(aEvents[i].data.ptr);
+            if (nullptr == tc)
+            {
+                char buf[64];
+                while (0 < read(pw->aWake[0], buf, sizeof(buf)))
+                {
+                    ; // Nothing.
+                }
+            }
+            else
+            {
+                tls_service(pw, tc, &pFinished);
+            }
+        }
+
+        // Pick up sessions the game has handed over or has work for.
+        //
+        pthread_mutex_lock(&pw->mutex);
+        tls_conn *pKicked = pw->pKicked;
+        pw->pKicked = nullptr;
+        for (tls_conn *tc = pKicked; nullptr != tc; tc = tc->pNextKicked)
+        {
+            tc->bKicked = false;
+        }
+        const bool bStop = pw->bStop;
+        pthread_mutex_unlock(&pw->mutex);
+
+        while (nullptr != pKicked)
+        {
+            tls_conn *tc = pKicked;
+            pKicked = tc->pNextKicked;
+            if (!tc->bAttached)
+            {
+                tc->bAttached = true;
+                tc->pNextConn = pw->pConns;
+                pw->pConns = tc;
+            }
+
+            // A room-wanted flag is only cleared here, so the session goes
+            // back to listening for input.
+            //
+            __atomic_store_n(&tc->bWorkerWantsRoom, false, __ATOMIC_RELAXED);
+            tls_service(pw, tc, &pFinished);
+        }
+
+        if (  0 < pw->nLingering
+           || bStop)
+        {
+            const time_t tNow = time(nullptr);
+            tls_conn *tcNext;
+            for (tls_conn *tc = pw->pConns; nullptr != tc; tc = tcNext)
+            {
+                tcNext = tc->pNextConn;
+                if (  bStop
+                   || (  tc->bLingering
+                      && TLS_LINGER <= tNow - tc->tRelease))
+                {
+                    tls_finish(pw, tc, &pFinished);
+                }
+            }
+        }
+
+        while (nullptr != pFinished)
+        {
+            tls_conn *tc = pFinished;
+            pFinished = tc->pNextFinished;
+            tls_hand_back(tc);
+        }
+
+        if (bStop)
+        {
+            break;
+        }
+    }
+    return nullptr;
+}
+
+/*! \brief Start the threads which run SSL sessions.
+ *
+ * With no threads, or if they cannot be started, sessions are run on the
+ * game thread as before.
+ *
+ * \param nThreads  Number of worker threads wanted.
+ * \return          None.
+ */
+
+static void tls_start_workers(int nThreads)
+{
+    if (  0 < tls_nWorkers
+       || (  nullptr == ssl_ctx
+          && nullptr == tls_ctx))
+    {
+        return;
+    }
+    if (TLS_MAX_WORKERS < nThreads)
+    {
+        nThreads = TLS_MAX_WORKERS;
+    }
+    if (nThreads <= 0)
+    {
+        return;
+    }
+
+    if (0 != pipe(tls_aNotify))
+    {
+        log_perror(T("NET"), T("FAIL"), T("tls_start_workers"), T("pipe"));
+        return;
+    }
+    make_nonblocking(tls_aNotify[0]);
+    make_nonblocking(tls_aNotify[1]);
+    fcntl(tls_aNotify[0], F_SETFD, FD_CLOEXEC);
+    fcntl(tls_aNotify[1], F_SETFD, FD_CLOEXEC);
+    regTlsNotify.socket = tls_aNotify[0];
+    regTlsNotify.fRegistered = false;
+    epoll_set_events(&regTlsNotify, EPOLLIN);
+
+    // The workers should never field the game's signals.
+    //
+    sigset_t sigAll, sigOld;
+    sigfillset(&sigAll);
+    pthread_sigmask(SIG_BLOCK, &sigAll, &sigOld);
+    for (int k = 0; k < nThreads; k++)
+    {
+        tls_worker *pw = &tls_aWorkers[tls_nWorkers];
+        memset(pw, 0, sizeof(*pw));
+        pthread_mutex_init(&pw->mutex, nullptr);
+        pw->epfd = epoll_create(TLS_MAX_EVENTS);
+        if (pw->epfd < 0)
+        {
+            break;
+        }
+        fcntl(pw->epfd, F_SETFD, FD_CLOEXEC);
+        if (0 != pipe(pw->aWake))
+        {
+            close(pw->epfd);
+            break;
+        }
+        make_nonblocking(pw->aWake[0]);
+        make_nonblocking(pw->aWake[1]);
+        fcntl(pw->aWake[0], F_SETFD, FD_CLOEXEC);
+        fcntl(pw->aWake[1], F_SETFD, FD_CLOEXEC);
+
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.ptr = nullptr;
+        epoll_ctl(pw->epfd, EPOLL_CTL_ADD, pw->aWake[0], &ev);
+
+        if (0 != pthread_create(&pw->thread, nullptr, tls_worker_main, pw))
+        {
+            close(pw->aWake[0]);
+            close(pw->aWake[1]);
+            close(pw->epfd);
+            break;
+        }
+        tls_nWorkers++;
+    }
+    pthread_sigmask(SIG_SETMASK, &sigOld, nullptr);
+
+    STARTLOG(LOG_ALWAYS, "NET", "SSL");
+    log_text(tprintf(T("Started %d TLS worker thread%s."), tls_nWorkers,
+        (1 == tls_nWorkers) ? "" : "s"));
+    ENDLOG;
+}
+
+// Free sessions the workers have handed back, and look at the rest.
+//
+static void tls_service_ready(void)
+{
+    char buf[64];
+    while (0 < read(tls_aNotify[0], buf, sizeof(buf)))
+    {
+        ; // Nothing.
+    }
+
+    pthread_mutex_lock(&tls_ready_mutex);
+    tls_conn *tc = tls_pReady;
+    tls_pReady = nullptr;
+    pthread_mutex_unlock(&tls_ready_mutex);
+
+    while (nullptr != tc)
+    {
+        // A worker may queue the session again as soon as bReady is clear,
+        // so the link is taken first.  Whether the session is done is decided
+        // under the same lock.  A session handed back is never made ready
+        // again, and the worker does not touch it after handing it back, so
+        // it can be freed.
+        //
+        pthread_mutex_lock(&tls_ready_mutex);
+        tls_conn *tcNext = tc->pNextReady;
+        const bool bDone = tc->bDone.load(std::memory_order_acquire);
+        if (!bDone)
+        {
+            tc->bReady = false;
+        }
+        pthread_mutex_unlock(&tls_ready_mutex);
+
+        if (bDone)
+        {
+            tls_aWorkers[tc->iWorker].nConns--;
+            DebugTotalSockets--;
+            delete tc;
+        }
+        else if (nullptr != tc->d)
+        {
+            DESC *d = tc->d;
+            epoll_service_desc(d, EPOLLIN
+                | ((  nullptr != d->output_head
+#if defined(UNIX_MCCP)
+                   || mccp_pending(d)
+#endif // UNIX_MCCP
+                   ) ? static_cast<UINT32>(EPOLLOUT) : 0));
+        }
+        tc = tcNext;
+    }
+}
+
+/*! \brief Stop the TLS workers.
+ *
+ * Sessions still open are closed after one last try at sending their output.
+ *
+ * \return  None.
+ */
+
+static void tls_stop_workers(void)
+{
+    if (0 == tls_nWorkers)
+    {
+        return;
+    }
+
+    for (int k = 0; k < tls_nWorkers; k++)
+    {
+        tls_worker *pw = &tls_aWorkers[k];
+        pthread_mutex_lock(&pw->mutex);
+        pw->bStop = true;
+        const char ch = 0;
+        (void)write(pw->aWake[1], &ch, 1);
+        pthread_mutex_unlock(&pw->mutex);
+    }
+
+    for (int k = 0; k < tls_nWorkers; k++)
+    {
+        tls_worker *pw = &tls_aWorkers[k];
+        pthread_join(pw->thread, nullptr);
+        close(pw->aWake[0]);
+        close(pw->aWake[1]);
+        close(pw->epfd);
+        pthread_mutex_destroy(&pw->mutex);
+    }
+
+    // Every session has been handed back.  Any descriptor which still points
+    // at one loses its connection.
+    //
+    DESC *d;
+    DESC_ITER_ALL(d)
+    {
+        if (nullptr != d->tls)
+        {
+            d->tls->d = nullptr;
+            d->tls = nullptr;
+            d->ssl_session = nullptr;
+            d->socket = INVALID_SOCKET;
+        }
+    }
+    tls_conn *tc = tls_pReady;
+    while (nullptr != tc)
+    {
+        tls_conn *tcNext = tc->pNextReady;
+        DebugTotalSockets--;
+        delete tc;
+        tc = tcNext;
+    }
+    tls_pReady = nullptr;
+    tls_nWorkers = 0;
+
+    epoll_remove(&regTlsNotify);
+    close(tls_aNotify[0]);
+    close(tls_aNotify[1]);
+    tls_aNotify[0] = tls_aNotify[1] = -1;
+    regTlsNotify.socket = INVALID_SOCKET;
+}
+
+/*! \brief Hand a descriptor's SSL session to a worker.
+ *
+ * The session must not have been accepted yet.  The worker does that, and
+ * until then, output is held in the ring.
+ *
+ * \param d   Network descriptor state, with ssl_session set.
+ * \return    true if a worker took the session.
+ */
+
+static bool tls_attach(DESC *d)
+{
+    if (0 == tls_nWorkers)
+    {
+        return false;
+    }
+
+    int iWorker = 0;
+    for (int k = 1; k < tls_nWorkers; k++)
+    {
+        if (tls_aWorkers[k].nConns < tls_aWorkers[iWorker].nConns)
+        {
+            iWorker = k;
+        }
+    }
+
+    tls_conn *tc = nullptr;
+    try
+    {
+        tc = new tls_conn();
+    }
+    catch (...)
+    {
+        ; // Nothing.
+    }
+    ISOUTOFMEMORY(tc);
+    tc->ssl = d->ssl_session;
+    tc->socket = d->socket;
+    tc->iWorker = iWorker;
+    tc->d = d;
+    tls_aWorkers[iWorker].nConns++;
+
+    // The socket belongs to the worker from now on.
+    //
+    epoll_remove(&d->epoll);
+    d->tls = tc;
+    tls_kick(tc);
+    return true;
+}
+
+/*! \brief Let go of a descriptor's session.
+ *
+ * The worker sends what is left in the ring, and then closes the socket.
+ *
+ * \param d   Network descriptor state.
+ * \return    None.
+ */
+
+static void tls_release(DESC *d)
+{
+    tls_conn *tc = d->tls;
+    tc->d = nullptr;
+    d->tls = nullptr;
+    d->ssl_session = nullptr;
+    __atomic_store_n(&tc->bRelease, true, __ATOMIC_RELEASE);
+    tls_kick(tc);
+}
+
+/*! \brief Take plaintext which a worker has decrypted.
+ *
+ * \param d        Network descriptor state.
+ * \param buffer   Where to put it.
+ * \param nBytes   Size of buffer.
+ * \return         Bytes read, 0 when the session has closed, or -1 with
+ *                 errno set to EWOULDBLOCK.
+ */
+
+static int tls_read(DESC *d, char *buffer, size_t nBytes)
+{
+    tls_conn *tc = d->tls;
+    const bool bClosed = __atomic_load_n(&tc->bClosed, __ATOMIC_ACQUIRE);
+    size_t nGot = 0;
+    while (nGot < nBytes)
+    {
+        unsigned char *p;
+        size_t n = tls_ring_read_span(&tc->rIn, &p);
+        if (0 == n)
+        {
+            break;
+        }
+        if (nBytes - nGot < n)
+        {
+            n = nBytes - nGot;
+        }
+        memcpy(buffer + nGot, p, n);
+        tls_ring_consume(&tc->rIn, n);
+        nGot += n;
+    }
+
+    if (0 < nGot)
+    {
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (__atomic_exchange_n(&tc->bWorkerWantsRoom, false, __ATOMIC_SEQ_CST))
+        {
+            tls_kick(tc);
+        }
+        return static_cast<int>(nGot);
+    }
+    else if (bClosed)
+    {
+        if (!__atomic_load_n(&tc->bHandshaken, __ATOMIC_ACQUIRE))
+        {
+            STARTLOG(LOG_ALWAYS, "NET", "SSL");
+            log_text(T("SSL negotiation failed: "));
+            log_number(tc->iError);
+            ENDLOG;
+        }
+        return 0;
+    }
+    errno = SOCKET_EWOULDBLOCK;
+    return -1;
+}
+
+/*! \brief Queue plaintext for a worker to encrypt and send.
+ *
+ * \param d   Network descriptor state.
+ * \param p   Plaintext.
+ * \param n   Length of plaintext.
+ * \return    Bytes taken, which is 0 if the ring is full, or -1 if the
+ *            session has closed.  The game hears from the worker once
+ *            there is room again.
+ */
+
+static int tls_write(DESC *d, const unsigned char *p, size_t n)
+{
+    tls_conn *tc = d->tls;
+    if (__atomic_load_n(&tc->bClosed, __ATOMIC_ACQUIRE))
+    {
+        return -1;
+    }
+
+    size_t nPut = 0;
+    for (;;)
+    {
+        unsigned char *q;
+        size_t nSpan;
+        while (  nPut < n
+              && 0 < (nSpan = tls_ring_write_span(&tc->rOut, &q)))
+        {
+            if (n - nPut < nSpan)
+            {
+                nSpan = n - nPut;
+            }
+            memcpy(q, p + nPut, nSpan);
+            tls_ring_produce(&tc->rOut, nSpan);
+            nPut += nSpan;
+        }
+        if (nPut == n)
+        {
+            break;
+        }
+
+        // Full.  Ask to hear when the worker makes room, and look once more
+        // in case it already has.
+        //
+        __atomic_store_n(&tc->bGameWantsRoom, true, __ATOMIC_SEQ_CST);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (0 == tls_ring_write_span(&tc->rOut, &q))
+        {
+            break;
+        }
+    }
+
+    if (0 < nPut)
+    {
+        tls_kick(tc);
+    }
+    return static_cast<int>(nPut);
+}
+
+// Stands in for epoll_update() once the worker owns the socket.  The game
+// looks at the session again when there is input it is ready for or output
+// it has room for.  Otherwise, the worker will say when there is.
+//
+static void tls_update(DESC *d)
+{
+    tls_conn *tc = d->tls;
+    if (  (  nullptr == d->input_head
+          && (  0 < tls_ring_used(&tc->rIn)
+             || __atomic_load_n(&tc->bClosed, __ATOMIC_ACQUIRE)))
+       || (  (  nullptr != d->output_head
+#if defined(UNIX_MCCP)
+             || mccp_pending(d)
+#endif // UNIX_MCCP
+             )
+          && tls_ring_used(&tc->rOut) < TLS_RING_SIZE))
+    {
+        tls_signal_game(tc);
+    }
+}
+
+/*! \brief Show the TLS workers for @list process.
+ *
+ * \param player  Who asked.
+ * \return        None.
+ */
+
+void list_tls_stats(dbref player)
+{
+    if (0 == tls_nWorkers)
+    {
+        return;
+    }
+
+    raw_notify(player, T("TLS worker  Sessions  Handshakes     Bytes In    Bytes Out"));
+    for (int k = 0; k < tls_nWorkers; k++)
+    {
+        tls_worker *pw = &tls_aWorkers[k];
+        UTF8 aHandshakes[I64BUF_SIZE], aIn[I64BUF_SIZE], aOut[I64BUF_SIZE];
+        mux_i64toa(__atomic_load_n(&pw->nHandshakes, __ATOMIC_RELAXED), aHandshakes);
+        mux_i64toa(__atomic_load_n(&pw->nBytesIn, __ATOMIC_RELAXED), aIn);
+        mux_i64toa(__atomic_load_n(&pw->nBytesOut, __ATOMIC_RELAXED), aOut);
+        raw_notify(player, tprintf(T("%10d  %8d  %10s  %11s  %11s"), k, pw->nConns,
+            aHandshakes, aIn, aOut));
+    }
+}
+
+#endif // UNIX_SSL_WORKERS
+
+int mux_socket_read(DESC *d, char *buffer, size_t nBytes, int flags)
+{
+    int result;
+
+#if defined(UNIX_SSL_WORKERS)
+    if (nullptr != d->tls)
+    {
+        result = tls_read(d, buffer, nBytes);
+    }
+    else
+#endif // UNIX_SSL_WORKERS
+#ifdef UNIX_SSL
+    if (d->ssl_session)
+    {
+        result = SSL_read(d->ssl_session, buffer, nBytes);
+    }
+    else
+#endif
+    {
+        result = SOCKET_READ(d->socket, buffer, nBytes, flags);
+    }
+
+    return result;
+}
+
+
+bool make_socket(SOCKET *ps, MUX_ADDRINFO *ai)
+{
+    // Create a TCP/IP stream socket
+    //
+    SOCKET s = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+    if (IS_INVALID_SOCKET(s))
+    {
+        log_perror(T("NET"), T("FAIL"), nullptr, T("creating socket"));
+        return false;
+    }
+    DebugTotalSockets++;
+
+    int opt = 1;
+    if (setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (char *)&opt, sizeof(opt)) < 0)
+    {
+        log_perror(T("NET"), T("FAIL"), nullptr, T("SO_REUSEADDR"));
+    }
+
+#if defined(HAVE_SOCKADDR_IN6)
+    if (AF_INET6 == ai->ai_family)
+    {
+        opt = 1;
+        if (setsockopt(s, IPPROTO_IPV6, IPV6_V6ONLY, (char *)&opt, sizeof(opt)) < 0)
+        {
+            log_perror(T("NET"), T("FAIL"), nullptr, T("IPV6_V6ONLY"));
+        }
+    }
+#endif
+
+    // bind our name to the socket
+    //
+    int nRet = bind(s, ai->ai_addr, ai->ai_addrlen);
+    if (IS_SOCKET_ERROR(nRet))
+    {
+        Log.tinyprintf(T("Error %ld on bind" ENDLINE), SOCKET_LAST_ERROR);
+        if (0 == SOCKET_CLOSE(s))
+        {
+            DebugTotalSockets--;
+        }
+        return false;
+    }
+
+    // Set the socket to listen
+    //
+    nRet = listen(s, SOMAXCONN);
+
+    if (nRet)
+    {
+        Log.tinyprintf(T("Error %ld on listen" ENDLINE), SOCKET_LAST_ERROR);
+        if (0 == SOCKET_CLOSE(s))
+        {
+            DebugTotalSockets--;
+        }
+        return false;
+    }
+    *ps = s;
+
+#if defined(WINDOWS_NETWORKING)
+
+    // Create the listening thread.
+    //
+    HANDLE hThread = CreateThread(nullptr, 0, mux_listen_thread, (LPVOID)ps, 0, nullptr);
+    if (nullptr == hThread)
+    {
+        log_perror(T("NET"), T("FAIL"), T("CreateThread"), T("setsockopt"));
+        if (0 == SOCKET_CLOSE(s))
+        {
+            DebugTotalSockets--;
+        }
+        return false;
+    }
+#endif
+    return true;
+}
+
+#if defined(UNIX_NETWORKING)
+
+bool ValidSocket(SOCKET s)
+{
+    struct stat fstatbuf;
+    if (fstat(s, &fstatbuf) < 0)
+    {
+        return false;
+    }
+    return true;
+}
+
+#endif // UNIX_NETWORKING
+
+void PortInfoClose(int *pnPorts, PortInfo aPorts[], int i)
+{
+#if defined(UNIX_NETWORKING_EPOLL)
+    epoll_remove_socket(aPorts[i].socket);
+#endif // UNIX_NETWORKING_EPOLL
+    if (0 == SOCKET_CLOSE(aPorts[i].socket))
+    {
+        DebugTotalSockets--;
+        (*pnPorts)--;
+        int k = *pnPorts;
+        if (i != k)
+        {
+            aPorts[i] = aPorts[k];
+        }
+        aPorts[k].socket = INVALID_SOCKET;
+        aPorts[k].fMatched = false;
+    }
+}
+
+void PortInfoOpen(int *pnPorts, PortInfo aPorts[], MUX_ADDRINFO *ai, bool fSSL)
+{
+    int k = *pnPorts;
+    if (  k < MAX_LISTEN_PORTS
+       && make_socket(&aPorts[k].socket, ai)
+       && !IS_INVALID_SOCKET(aPorts[k].socket)
+#if defined(UNIX_NETWORKING)
        && ValidSocket(aPorts[k].socket)
 #endif // UNIX_NETWORKING
        )
@@ -1235,6 +2435,17 @@ void SetupPorts(int *pnPorts, PortInfo aPorts[], IntArray *pia, IntArray *piaSSL
         }
     }
 
+#if defined(UNIX_NETWORKING)
+    // accept_connections() keeps accepting until the backlog is empty, so
+    // the listening sockets must not block.  This includes sockets inherited
+    // across @restart.
+    //
+    for (int i = 0; i < *pnPorts; i++)
+    {
+        make_nonblocking(aPorts[i].socket);
+    }
+#endif // UNIX_NETWORKING
+
     // If we were asked to listen on at least one port, but we aren't
     // listening to at least one port, we should bring the game down.
     //
@@ -1397,11 +2608,15 @@ void shovechars(int nPorts, PortInfo aPorts[])
 #define CheckInput(x)     FD_ISSET(x, &input_set)
 #define CheckOutput(x)    FD_ISSET(x, &output_set)
 
+#if defined(UNIX_NETWORKING_EPOLL)
+static void shovechars_select(int nPorts, PortInfo aPorts[])
+#else // UNIX_NETWORKING_EPOLL
 void shovechars(int nPorts, PortInfo aPorts[])
+#endif // UNIX_NETWORKING_EPOLL
 {
     fd_set input_set, output_set;
     int found;
-    DESC *d, *dnext, *newd;
+    DESC *d, *dnext;
     unsigned int avail_descriptors;
     int maxfds;
     int i;
@@ -1490,7 +2705,11 @@ void shovechars(int nPorts, PortInfo aPorts[])
             {
                 FD_SET(d->socket, &input_set);
             }
-            if (d->output_head)
+            if (  d->output_head
+#if defined(UNIX_MCCP)
+               || mccp_pending(d)
+#endif // UNIX_MCCP
+               )
             {
                 FD_SET(d->socket, &output_set);
             }
@@ -1564,117 +2783,425 @@ void shovechars(int nPorts, PortInfo aPorts[])
                     }
                 }
             }
-            else if (iSocketError != SOCKET_EINTR)
+            else if (iSocketError != SOCKET_EINTR)
+            {
+                log_perror(T("NET"), T("FAIL"), T("checking for activity"), T("select"));
+            }
+            continue;
+        }
+
+#if defined(HAVE_WORKING_FORK)
+        // Get usernames and hostnames.
+        //
+        if (  !IS_INVALID_SOCKET(slave_socket)
+           && CheckInput(slave_socket))
+        {
+            while (0 == get_slave_result())
+            {
+                ; // Nothing.
+            }
+        }
+
+#if defined(STUB_SLAVE)
+        // Get data from stubslave.
+        //
+        if (!IS_INVALID_SOCKET(stubslave_socket))
+        {
+            if (CheckInput(stubslave_socket))
+            {
+                while (0 == StubSlaveRead())
+                {
+                    ; // Nothing.
+                }
+            }
+
+            Pipe_DecodeFrames(CHANNEL_INVALID, &Queue_Out);
+
+            if (!IS_INVALID_SOCKET(stubslave_socket))
+            {
+                if (CheckOutput(stubslave_socket))
+                {
+                    StubSlaveWrite();
+                }
+            }
+        }
+#endif // STUB_SLAVE
+#endif // HAVE_WORKING_FORK
+
+        // Check for new connection requests.
+        //
+        for (i = 0; i < nPorts; i++)
+        {
+            if (CheckInput(aPorts[i].socket))
+            {
+                int iSocketError;
+                accept_connections(&aPorts[i], &iSocketError);
+                if (  iSocketError
+                   && iSocketError != SOCKET_EINTR)
+                {
+                    log_perror(T("NET"), T("FAIL"), nullptr, T("accept_connections"));
+                }
+            }
+        }
+
+        // Check for activity on user sockets.
+        //
+        DESC_SAFEITER_ALL(d, dnext)
+        {
+            // Process input from sockets with pending input.
+            //
+            if (CheckInput(d->socket))
+            {
+                // Undo autodark
+                //
+                if (d->flags & DS_AUTODARK)
+                {
+                    // Clear the DS_AUTODARK on every related session.
+                    //
+                    DESC *d1;
+                    DESC_ITER_PLAYER(d->player, d1)
+                    {
+                        d1->flags &= ~DS_AUTODARK;
+                    }
+                    SnapshotTouch(d->player);
+                    db[d->player].fs.word[FLAG_WORD1] &= ~DARK;
+                }
+
+                // Process received data.
+                //
+                if (!process_input(d))
+                {
+                    shutdownsock(d, R_SOCKDIED);
+                    continue;
+                }
+            }
+
+            // Process output for sockets with pending output.
+            //
+            if (CheckOutput(d->socket))
+            {
+                process_output(d, true);
+            }
+        }
+    }
+}
+
+#endif // UNIX_NETWORKING_SELECT
+
+#if defined(UNIX_NETWORKING_EPOLL)
+
+/*! \brief Bring the registrations of the listening ports and slave sockets
+ * up to date.
+ *
+ * Descriptors maintain their own registrations, but the listening ports can
+ * be opened, closed, and shuffled by SetupPorts(), and the slaves can be
+ * rebooted, so they are compared against what epoll knows once per pass.
+ *
+ * \param nPorts   Number of listening ports.
+ * \param aPorts   Listening ports.
+ * \param fAccept  Whether there are descriptors available for new connections.
+ * \return         None.
+ */
+
+static void epoll_reconcile(int nPorts, PortInfo aPorts[], bool fAccept)
+{
+    const UINT32 events = fAccept ? static_cast<UINT32>(EPOLLIN) : 0;
+    bool fChanged = (nPorts != nEpollPorts);
+    for (int i = 0; !fChanged && i < nPorts; i++)
+    {
+        fChanged = (aPorts[i].socket != aEpollPorts[i].socket);
+    }
+
+    if (fChanged)
+    {
+        // Closed ports were already removed by PortInfoClose(). The rest are
+        // (re-)pointed at the slot which matches their position in aPorts.
+        //
+        for (int i = 0; i < nPorts; i++)
+        {
+            EPOLL_REG *r = &aEpollPorts[i];
+            r->kind = EPOLL_KIND_PORT;
+            r->iPort = i;
+            r->socket = aPorts[i].socket;
+            r->fRegistered = false;
+            r->fHangup = false;
+            r->d = nullptr;
+            epoll_set_events(r, events);
+        }
+        for (int i = nPorts; i < nEpollPorts; i++)
+        {
+            aEpollPorts[i].socket = INVALID_SOCKET;
+            aEpollPorts[i].fRegistered = false;
+        }
+        nEpollPorts = nPorts;
+    }
+    else
+    {
+        for (int i = 0; i < nPorts; i++)
+        {
+            epoll_set_events(&aEpollPorts[i], events);
+        }
+    }
+
+#if defined(HAVE_WORKING_FORK)
+    if (  !IS_INVALID_SOCKET(slave_socket)
+       && (  !regSlave.fRegistered
+          || regSlave.socket != slave_socket))
+    {
+        regSlave.socket = slave_socket;
+        regSlave.fRegistered = false;
+        epoll_set_events(&regSlave, EPOLLIN);
+    }
+
+#if defined(STUB_SLAVE)
+    if (!IS_INVALID_SOCKET(stubslave_socket))
+    {
+        if (regStubSlave.socket != stubslave_socket)
+        {
+            regStubSlave.socket = stubslave_socket;
+            regStubSlave.fRegistered = false;
+        }
+        epoll_set_events(&regStubSlave,
+            (0 < Pipe_QueueLength(&Queue_Out)) ? (EPOLLIN|EPOLLOUT) : EPOLLIN);
+    }
+#endif // STUB_SLAVE
+#endif // HAVE_WORKING_FORK
+}
+
+static void epoll_service_desc(DESC *d, UINT32 events)
+{
+    if (events & (EPOLLIN|EPOLLHUP|EPOLLERR))
+    {
+        if (nullptr == d->input_head)
+        {
+            // Undo autodark
+            //
+            if (d->flags & DS_AUTODARK)
+            {
+                // Clear the DS_AUTODARK on every related session.
+                //
+                DESC *d1;
+                DESC_ITER_PLAYER(d->player, d1)
+                {
+                    d1->flags &= ~DS_AUTODARK;
+                }
+                SnapshotTouch(d->player);
+                db[d->player].fs.word[FLAG_WORD1] &= ~DARK;
+            }
+
+            // Process received data. When edge-triggered, we will not hear
+            // about this socket again until it has been drained or until we
+            // re-arm EPOLLIN after the input queue empties.
+            //
+            bool fEdge = isTRUE(d->epoll.events & EPOLLET);
+#if defined(UNIX_SSL_WORKERS)
+            // A TLS worker does not say again until it has more, either.
+            //
+            fEdge = fEdge || nullptr != d->tls;
+#endif // UNIX_SSL_WORKERS
+            bool fMore;
+            do
             {
-                log_perror(T("NET"), T("FAIL"), T("checking for activity"), T("select"));
-            }
-            continue;
+                if (!process_input(d, &fMore))
+                {
+                    shutdownsock(d, R_SOCKDIED);
+                    return;
+                }
+            } while (  fEdge
+                    && fMore
+                    && nullptr == d->input_head);
         }
+        else if (events & (EPOLLHUP|EPOLLERR))
+        {
+            d->epoll.fHangup = true;
+        }
+        epoll_update(d);
+    }
 
-#if defined(HAVE_WORKING_FORK)
-        // Get usernames and hostnames.
+    // Process output for sockets with pending output. This may close the
+    // socket, so it must be last.
+    //
+    if (events & EPOLLOUT)
+    {
+        process_output(d, true);
+    }
+}
+
+void shovechars(int nPorts, PortInfo aPorts[])
+{
+    unsigned int avail_descriptors;
+    int maxfds;
+
+    if (!epoll_init())
+    {
+        shovechars_select(nPorts, aPorts);
+        return;
+    }
+
+    mudstate.debug_cmd = T("< shovechars_epoll >");
+
+#if defined(UNIX_SSL_WORKERS)
+    tls_start_workers(mudconf.ssl_threads);
+#endif // UNIX_SSL_WORKERS
+
+    CLinearTimeAbsolute ltaLastSlice;
+    ltaLastSlice.GetUTC();
+
+#ifdef HAVE_GETDTABLESIZE
+    maxfds = getdtablesize();
+#else // HAVE_GETDTABLESIZE
+    maxfds = sysconf(_SC_OPEN_MAX);
+#endif // HAVE_GETDTABLESIZE
+
+    avail_descriptors = maxfds - 7;
+
+    while (!mudstate.shutdown_flag)
+    {
+        CLinearTimeAbsolute ltaCurrent;
+        ltaCurrent.GetUTC();
+        update_quotas(ltaLastSlice, ltaCurrent);
+
+        // Check the scheduler.
         //
-        if (  !IS_INVALID_SOCKET(slave_socket)
-           && CheckInput(slave_socket))
+        scheduler.RunTasks(ltaCurrent);
+        CLinearTimeAbsolute ltaWakeUp;
+        if (scheduler.WhenNext(&ltaWakeUp))
         {
-            while (0 == get_slave_result())
+            if (ltaWakeUp < ltaCurrent)
             {
-                ; // Nothing.
+                ltaWakeUp = ltaCurrent;
             }
         }
+        else
+        {
+            CLinearTimeDelta ltd = time_30m;
+            ltaWakeUp = ltaCurrent + ltd;
+        }
 
-#if defined(STUB_SLAVE)
-        // Get data from stubslave.
+        if (mudstate.shutdown_flag)
+        {
+            break;
+        }
+
+        // Listen for new connections only if there are free descriptors.
         //
-        if (!IS_INVALID_SOCKET(stubslave_socket))
+        epoll_reconcile(nPorts, aPorts, ndescriptors < avail_descriptors);
+
+        // Wait for something to happen. Round partial milliseconds up so
+        // that we do not spin waiting for the scheduler.
+        //
+        CLinearTimeDelta ltdTimeout = ltaWakeUp - ltaCurrent;
+        int msTimeout = static_cast<int>(ltdTimeout.ReturnMilliseconds());
+        if (  0 == msTimeout
+           && ltaCurrent < ltaWakeUp)
         {
-            if (CheckInput(stubslave_socket))
+            msTimeout = 1;
+        }
+
+        nEpollEvents = epoll_wait(epoll_fd, aEpollEvents, EPOLL_MAX_EVENTS, msTimeout);
+        if (nEpollEvents < 0)
+        {
+            int iSocketError = SOCKET_LAST_ERROR;
+            nEpollEvents = 0;
+            if (iSocketError != SOCKET_EINTR)
             {
-                while (0 == StubSlaveRead())
-                {
-                    ; // Nothing.
-                }
+                log_perror(T("NET"), T("FAIL"), T("checking for activity"), T("epoll_wait"));
             }
+            continue;
+        }
 
-            Pipe_DecodeFrames(CHANNEL_INVALID, &Queue_Out);
+#if defined(HAVE_WORKING_FORK) && defined(STUB_SLAVE)
+        bool fStubSlaveOutput = false;
+#endif // HAVE_WORKING_FORK && STUB_SLAVE
 
-            if (!IS_INVALID_SOCKET(stubslave_socket))
+        for (int i = 0; i < nEpollEvents; i++)
+        {
+            // Registrations removed earlier in this batch are nulled out by
+            // epoll_remove().
+            //
+            EPOLL_REG *r = static_cast<EPOLL_REG *>(aEpollEvents[i].data.ptr);
+            if (nullptr == r)
             {
-                if (CheckOutput(stubslave_socket))
-                {
-                    StubSlaveWrite();
-                }
+                continue;
             }
-        }
-#endif // STUB_SLAVE
-#endif // HAVE_WORKING_FORK
+            const UINT32 events = aEpollEvents[i].events;
 
-        // Check for new connection requests.
-        //
-        for (i = 0; i < nPorts; i++)
-        {
-            if (CheckInput(aPorts[i].socket))
+            switch (r->kind)
             {
-                int iSocketError;
-                newd = new_connection(&aPorts[i], &iSocketError);
-                if (!newd)
+            case EPOLL_KIND_DESC:
+                epoll_service_desc(r->d, events);
+                break;
+
+            case EPOLL_KIND_PORT:
                 {
+                    // Check for new connection requests.
+                    //
+                    int iSocketError;
+                    accept_connections(&aPorts[r->iPort], &iSocketError);
                     if (  iSocketError
                        && iSocketError != SOCKET_EINTR)
                     {
-                        log_perror(T("NET"), T("FAIL"), nullptr, T("new_connection"));
+                        log_perror(T("NET"), T("FAIL"), nullptr, T("accept_connections"));
                     }
                 }
-                else if (  !IS_INVALID_SOCKET(newd->socket)
-                        && maxd <= newd->socket)
+                break;
+
+#if defined(HAVE_WORKING_FORK)
+            case EPOLL_KIND_SLAVE:
+
+                // Get usernames and hostnames.
+                //
+                while (0 == get_slave_result())
                 {
-                    maxd = newd->socket + 1;
+                    ; // Nothing.
                 }
-            }
-        }
+                break;
 
-        // Check for activity on user sockets.
-        //
-        DESC_SAFEITER_ALL(d, dnext)
-        {
-            // Process input from sockets with pending input.
-            //
-            if (CheckInput(d->socket))
-            {
-                // Undo autodark
+#if defined(STUB_SLAVE)
+            case EPOLL_KIND_STUBSLAVE:
+
+                // Get data from stubslave.
                 //
-                if (d->flags & DS_AUTODARK)
+                if (events & (EPOLLIN|EPOLLHUP|EPOLLERR))
                 {
-                    // Clear the DS_AUTODARK on every related session.
-                    //
-                    DESC *d1;
-                    DESC_ITER_PLAYER(d->player, d1)
+                    while (0 == StubSlaveRead())
                     {
-                        d1->flags &= ~DS_AUTODARK;
+                        ; // Nothing.
                     }
-                    db[d->player].fs.word[FLAG_WORD1] &= ~DARK;
                 }
+                fStubSlaveOutput = isTRUE(events & EPOLLOUT);
+                break;
+#endif // STUB_SLAVE
+#endif // HAVE_WORKING_FORK
 
-                // Process received data.
+#if defined(UNIX_SSL_WORKERS)
+            case EPOLL_KIND_TLS:
+
+                // Sessions which TLS workers have news about.
                 //
-                if (!process_input(d))
-                {
-                    shutdownsock(d, R_SOCKDIED);
-                    continue;
-                }
+                tls_service_ready();
+                break;
+#endif // UNIX_SSL_WORKERS
             }
+        }
+        nEpollEvents = 0;
 
-            // Process output for sockets with pending output.
-            //
-            if (CheckOutput(d->socket))
+#if defined(HAVE_WORKING_FORK) && defined(STUB_SLAVE)
+        if (!IS_INVALID_SOCKET(stubslave_socket))
+        {
+            Pipe_DecodeFrames(CHANNEL_INVALID, &Queue_Out);
+
+            if (  fStubSlaveOutput
+               && !IS_INVALID_SOCKET(stubslave_socket))
             {
-                process_output(d, true);
+                StubSlaveWrite();
             }
         }
+#endif // HAVE_WORKING_FORK && STUB_SLAVE
     }
 }
 
-#endif // UNIX_NETWORKING_SELECT
+#endif // UNIX_NETWORKING_EPOLL
 
 #if defined(HAVE_WORKING_FORK) && defined(STUB_SLAVE)
 extern "C" MUX_RESULT DCL_API pipepump(void)
@@ -1749,37 +3276,184 @@ extern "C" MUX_RESULT DCL_API pipepump(void)
 }
 #endif // HAVE_WORKINGFORK && STUB_SLAVE
 
-DESC *new_connection(PortInfo *Port, int *piSocketError)
+// Connections are accepted in batches as soon as a listening socket is ready,
+// but the site check, logging, the slave request, and the welcome screen wait
+// for Task_GreetConnections, which handles a few at a time.  A storm of
+// reconnects after a restart or a netsplit is then spread over several passes
+// of the main loop instead of holding it up in one go.
+//
+#define ACCEPT_BATCH 64
+#define GREET_BATCH  16
+
+typedef struct pending_connection
 {
-    DESC *d;
-    mux_sockaddr addr;
+    SOCKET                     socket;
+    mux_sockaddr               addr;
+    PortInfo                  *Port;
+    struct pending_connection *next;
+} PENDING_CONNECTION;
+
+static PENDING_CONNECTION *pending_head = nullptr;
+static PENDING_CONNECTION *pending_tail = nullptr;
+
+static void Task_GreetConnections(void *arg_voidptr, int arg_iInteger);
+
+/*! \brief Accept waiting connections on a listening socket.
+ *
+ * Up to ACCEPT_BATCH connections are taken from the backlog and queued for
+ * Task_GreetConnections.
+ *
+ * \param Port           Listening port which is ready.
+ * \param piSocketError  Error which stopped the batch, or 0.
+ * \return               Number of connections accepted.
+ */
+
+static int accept_connections(PortInfo *Port, int *piSocketError)
+{
+    *piSocketError = 0;
+
+#if defined(HAVE_ACCEPT4) && defined(SOCK_NONBLOCK)
+    // Inline SSL negotiation still expects a blocking socket.
+    //
+    int flags = SOCK_NONBLOCK;
+#if defined(UNIX_SSL)
+    if (Port->fSSL)
+    {
+#if defined(UNIX_SSL_WORKERS)
+        if (0 == tls_nWorkers)
+#endif // UNIX_SSL_WORKERS
+        {
+            flags = 0;
+        }
+    }
+#endif // UNIX_SSL
+#endif // HAVE_ACCEPT4 && SOCK_NONBLOCK
+
+    int nAccepted = 0;
+    while (nAccepted < ACCEPT_BATCH)
+    {
+        PENDING_CONNECTION *pc = nullptr;
+        try
+        {
+            pc = new PENDING_CONNECTION;
+        }
+        catch (...)
+        {
+            ; // Nothing.
+        }
+
+        if (nullptr == pc)
+        {
+            break;
+        }
+
 #ifdef SOCKLEN_T_DCL
-    socklen_t addr_len;
+        socklen_t addr_len = pc->addr.maxaddrlen();
 #else // SOCKLEN_T_DCL
-    int addr_len;
+        int addr_len = pc->addr.maxaddrlen();
 #endif // SOCKLEN_T_DCL
+
+#if defined(HAVE_ACCEPT4) && defined(SOCK_NONBLOCK)
+        pc->socket = accept4(Port->socket, pc->addr.sa(), &addr_len, flags);
+#else
+        pc->socket = accept(Port->socket, pc->addr.sa(), &addr_len);
+#endif // HAVE_ACCEPT4 && SOCK_NONBLOCK
+
+        if (IS_INVALID_SOCKET(pc->socket))
+        {
+            const int iSocketError = SOCKET_LAST_ERROR;
+            delete pc;
+            if (  SOCKET_EAGAIN != iSocketError
+               && SOCKET_EWOULDBLOCK != iSocketError)
+            {
+                *piSocketError = iSocketError;
+            }
+            break;
+        }
+        DebugTotalSockets++;
+
+        pc->Port = Port;
+        pc->next = nullptr;
+        if (nullptr == pending_tail)
+        {
+            pending_head = pc;
+            scheduler.DeferImmediateTask(PRIORITY_SYSTEM, Task_GreetConnections, 0, 0);
+        }
+        else
+        {
+            pending_tail->next = pc;
+        }
+        pending_tail = pc;
+        nAccepted++;
+    }
+    return nAccepted;
+}
+
+/*! \brief Greet queued connections.
+ *
+ * Each queued connection is checked against the site list, logged, and
+ * given a descriptor and the welcome screen.  Only GREET_BATCH are handled
+ * at a time, so commands from connected players are not held up for long.
+ *
+ * \param arg_voidptr   Unused.
+ * \param arg_iInteger  Largest number of connections to greet, or 0 for
+ *                      GREET_BATCH.
+ * \return              None.
+ */
+
+static void Task_GreetConnections(void *arg_voidptr, int arg_iInteger)
+{
+    UNUSED_PARAMETER(arg_voidptr);
+
+    int nGreet = (0 == arg_iInteger) ? GREET_BATCH : arg_iInteger;
+    while (  0 < nGreet--
+          && nullptr != pending_head)
+    {
+        PENDING_CONNECTION *pc = pending_head;
+        pending_head = pc->next;
+        if (nullptr == pending_head)
+        {
+            pending_tail = nullptr;
+        }
+        new_connection(pc->Port, pc->socket, &pc->addr);
+        delete pc;
+    }
+
+    if (nullptr != pending_head)
+    {
+        scheduler.DeferImmediateTask(PRIORITY_SYSTEM, Task_GreetConnections, 0, 0);
+    }
+}
+
+/*! \brief Greet every queued connection now.
+ *
+ * Used before @restart so that no accepted socket is left without a
+ * descriptor.
+ *
+ * \return None.
+ */
+
+void greet_pending_connections(void)
+{
+    scheduler.CancelTask(Task_GreetConnections, 0, 0);
+    Task_GreetConnections(nullptr, INT_MAX);
+}
+
+DESC *new_connection(PortInfo *Port, SOCKET newsock, mux_sockaddr *paddr)
+{
+    DESC *d;
+    mux_sockaddr &addr = *paddr;
 #if defined(UNIX_NETWORKING)
     int len;
 #endif // UNIX_NETWORKING
 
     const UTF8 *cmdsave = mudstate.debug_cmd;
     mudstate.debug_cmd = T("< new_connection >");
-    addr_len = addr.maxaddrlen();
-
-    SOCKET newsock = accept(Port->socket, addr.sa(), &addr_len);
-
-    if (IS_INVALID_SOCKET(newsock))
-    {
-        *piSocketError = SOCKET_LAST_ERROR;
-        mudstate.debug_cmd = cmdsave;
-        return 0;
-    }
 
     UTF8 *pBuffM2 = alloc_mbuf("new_connection.address");
     addr.ntop(pBuffM2, MBUF_SIZE);
     unsigned short usPort = addr.port();
 
-    DebugTotalSockets++;
     if (mudstate.access_list.isForbid(&addr))
     {
         STARTLOG(LOG_NET | LOG_SECURITY, "NET", "SITE");
@@ -1843,7 +3517,13 @@ DESC *new_connection(PortInfo *Port, int *piSocketError)
         {
             ssl_session = SSL_new(ssl_ctx);
             SSL_set_fd(ssl_session, newsock);
+#if defined(UNIX_SSL_WORKERS)
+            // A worker accepts the session without holding up the game.
+            //
+            int ssl_result = (0 < tls_nWorkers) ? 1 : SSL_accept(ssl_session);
+#else
             int ssl_result = SSL_accept(ssl_session);
+#endif // UNIX_SSL_WORKERS
             if (ssl_result != 1)
             {
                 // Something errored out.  We'll have to drop.
@@ -1860,8 +3540,8 @@ DESC *new_connection(PortInfo *Port, int *piSocketError)
                     DebugTotalSockets--;
                 }
                 newsock = INVALID_SOCKET;
-                *piSocketError = ssl_err;
                 errno = 0;
+                mudstate.debug_cmd = cmdsave;
                 return nullptr;
             }
         }
@@ -1871,6 +3551,12 @@ DESC *new_connection(PortInfo *Port, int *piSocketError)
 
 #ifdef UNIX_SSL
         d->ssl_session = ssl_session;
+#if defined(UNIX_SSL_WORKERS)
+        if (nullptr != ssl_session)
+        {
+            tls_attach(d);
+        }
+#endif // UNIX_SSL_WORKERS
 #endif
 
         telnet_setup(d);
@@ -1881,9 +3567,16 @@ DESC *new_connection(PortInfo *Port, int *piSocketError)
         site_mon_send(newsock, pBuffM2, d, T("Connection"));
 
         welcome_user(d);
+
+#if defined(UNIX_NETWORKING_SELECT)
+        if (  !IS_INVALID_SOCKET(d->socket)
+           && maxd <= d->socket)
+        {
+            maxd = d->socket + 1;
+        }
+#endif // UNIX_NETWORKING_SELECT
     }
     free_mbuf(pBuffM2);
-    *piSocketError = SOCKET_LAST_ERROR;
     mudstate.debug_cmd = cmdsave;
     return d;
 }
@@ -2117,6 +3810,7 @@ void shutdownsock(DESC *d, int reason)
         // Cancel any scheduled processing on this socket.
         //
         scheduler.CancelTask(Task_ProcessCommand, d, 0);
+        stop_command_batch(d);
 
 #if defined(WINDOWS_NETWORKING)
         // Don't close down the socket twice.
@@ -2152,19 +3846,34 @@ void shutdownsock(DESC *d, int reason)
     }
 #elif defined(UNIX_NETWORKING)
 
-#ifdef UNIX_SSL
-        if (d->ssl_session)
+#if defined(UNIX_SSL_WORKERS)
+        if (nullptr != d->tls)
         {
-            SSL_shutdown(d->ssl_session);
-            SSL_free(d->ssl_session);
-            d->ssl_session = nullptr;
+            // The worker closes the socket after it sends what is left.
+            //
+            tls_release(d);
         }
+        else
+#endif // UNIX_SSL_WORKERS
+        {
+#ifdef UNIX_SSL
+            if (d->ssl_session)
+            {
+                SSL_shutdown(d->ssl_session);
+                SSL_free(d->ssl_session);
+                d->ssl_session = nullptr;
+            }
 #endif
 
-        shutdown(d->socket, SD_BOTH);
-        if (0 == SOCKET_CLOSE(d->socket))
-        {
-            DebugTotalSockets--;
+#if defined(UNIX_NETWORKING_EPOLL)
+            epoll_remove(&d->epoll);
+#endif // UNIX_NETWORKING_EPOLL
+
+            shutdown(d->socket, SD_BOTH);
+            if (0 == SOCKET_CLOSE(d->socket))
+            {
+                DebugTotalSockets--;
+            }
         }
         d->socket = INVALID_SOCKET;
 
@@ -2338,6 +4047,9 @@ DESC *initializesock(SOCKET s, MUX_SOCKADDR *msa)
 #ifdef UNIX_SSL
     d->ssl_session = nullptr;
 #endif
+#if defined(UNIX_SSL_WORKERS)
+    d->tls = nullptr;
+#endif // UNIX_SSL_WORKERS
 
     // Be sure #0 isn't wizard. Shouldn't be.
     //
@@ -2352,6 +4064,14 @@ DESC *initializesock(SOCKET s, MUX_SOCKADDR *msa)
     d->output_size = 0;
     d->output_tot = 0;
     d->output_lost = 0;
+    d->output_syscalls = 0;
+    d->output_sent = 0;
+    memset(d->command_latency, 0, sizeof(d->command_latency));
+#if defined(UNIX_MCCP)
+    d->mccp = nullptr;
+    d->compress_in = 0;
+    d->compress_out = 0;
+#endif // UNIX_MCCP
     d->output_head = nullptr;
     d->output_tail = nullptr;
     d->input_head = nullptr;
@@ -2401,6 +4121,10 @@ DESC *initializesock(SOCKET s, MUX_SOCKADDR *msa)
     d->prev = &descriptor_list;
     descriptor_list = d;
 
+#if defined(UNIX_NETWORKING_EPOLL)
+    epoll_register(d);
+#endif // UNIX_NETWORKING_EPOLL
+
 #if defined(WINDOWS_NETWORKING)
     // ok to continue now
     //
@@ -2468,7 +4192,7 @@ void process_output_socket(DESC *d, int bHandleShutdown)
     {
         auto save = tb;
         tb = tb->hdr.nxt;
-        MEMFREE(save);
+        free_tblock(save);
         save = nullptr;
         d->output_head = tb;
         if (nullptr == tb)
@@ -2501,6 +4225,7 @@ void process_output_socket(DESC *d, int bHandleShutdown)
         d->OutboundOverlapped.OffsetHigh = 0;
         const auto bResult = WriteFile(reinterpret_cast<HANDLE>(d->socket), tb->hdr.start,
             static_cast<DWORD>(tb->hdr.nchars), nullptr, &d->OutboundOverlapped);
+        d->output_syscalls++;
         if (bResult)
         {
             // The WriteFile request completed immediately, and technically,
@@ -2509,6 +4234,7 @@ void process_output_socket(DESC *d, int bHandleShutdown)
             // we will let it free the TBLOCK.
             //
             d->output_size -= tb->hdr.nchars;
+            d->output_sent += tb->hdr.nchars;
         }
         else
         {
@@ -2521,6 +4247,7 @@ void process_output_socket(DESC *d, int bHandleShutdown)
                 // ProcessWindowsTCP().
                 //
                 d->output_size -= tb->hdr.nchars;
+                d->output_sent += tb->hdr.nchars;
             }
             else
             {
@@ -2542,136 +4269,672 @@ void process_output_socket(DESC *d, int bHandleShutdown)
             }
         }
     }
-    mudstate.debug_cmd = cmdsave;
+    mudstate.debug_cmd = cmdsave;
+}
+
+#elif defined(UNIX_NETWORKING)
+
+/*! \brief Service network request for more output to a specific socket.
+ *
+ * This function is called when the network wants to consume more data, but it
+ * must also be called to kick-start output to the network, so truthfully, the
+ * call can come from shovechars or the output routines.  Currently, this is
+ * not being called by the task queue, but it is in a form that is callable by
+ * the task queue.
+ *
+ * \param dvoid             Network descriptor state.
+ * \param bHandleShutdown   Whether the shutdownsock() call is being handled..
+ * \return                  None.
+ */
+
+void process_output_socket(DESC *d, int bHandleShutdown)
+{
+    const UTF8 *cmdsave = mudstate.debug_cmd;
+    mudstate.debug_cmd = T("< process_output >");
+
+#if defined(UNIX_NETWORKING_WRITEV)
+    // Hand the kernel as much of the output queue as it will take in one
+    // call.  Each TBLOCK becomes one element of the I/O vector.
+    //
+    static struct iovec iov[OUTPUT_IOV_MAX];
+    for (;;)
+    {
+        // Release any blocks which have already been sent.
+        //
+        TBLOCK *tb = d->output_head;
+        while (  nullptr != tb
+              && 0 == tb->hdr.nchars)
+        {
+            TBLOCK *save = tb;
+            tb = tb->hdr.nxt;
+            free_tblock(save);
+            save = nullptr;
+            d->output_head = tb;
+            if (nullptr == tb)
+            {
+                d->output_tail = nullptr;
+            }
+        }
+
+        if (nullptr == tb)
+        {
+            break;
+        }
+
+        int niov = 0;
+        size_t nRequested = 0;
+        for (TBLOCK *tp = tb; nullptr != tp && niov < OUTPUT_IOV_MAX; tp = tp->hdr.nxt)
+        {
+            if (0 < tp->hdr.nchars)
+            {
+                iov[niov].iov_base = tp->hdr.start;
+                iov[niov].iov_len  = tp->hdr.nchars;
+                nRequested += tp->hdr.nchars;
+                niov++;
+            }
+        }
+
+        ssize_t cnt = writev(d->socket, iov, niov);
+        d->output_syscalls++;
+        if (cnt < 0)
+        {
+            int iSocketError = SOCKET_LAST_ERROR;
+            mudstate.debug_cmd = cmdsave;
+            if (  SOCKET_EWOULDBLOCK   == iSocketError
+#ifdef SOCKET_EAGAIN
+               || SOCKET_EAGAIN        == iSocketError
+#endif
+               || SOCKET_EINTR         == iSocketError
+            )
+            {
+                // The call would have blocked, so we need to mark the
+                // buffer at the head as read-only and try again later.
+                //
+                tb->hdr.flags |= TBLK_FLAG_LOCKED;
+            }
+            else if (bHandleShutdown)
+            {
+                shutdownsock(d, R_SOCKDIED);
+            }
+            return;
+        }
+
+        d->output_size -= cnt;
+        d->output_sent += cnt;
+
+        // Consume what was written across the blocks.
+        //
+        size_t nLeft = static_cast<size_t>(cnt);
+        for (TBLOCK *tp = tb; nullptr != tp && 0 < nLeft; tp = tp->hdr.nxt)
+        {
+            size_t n = (tp->hdr.nchars < nLeft) ? tp->hdr.nchars : nLeft;
+            tp->hdr.nchars -= n;
+            tp->hdr.start += n;
+            nLeft -= n;
+        }
+
+        if (static_cast<size_t>(cnt) < nRequested)
+        {
+            // The socket buffer is full.  The next writability notification
+            // will bring us back.  Release the blocks which were sent, and
+            // mark the one the write stopped in as read-only, just as for
+            // EWOULDBLOCK, so that it is not thrown away mid-sequence.
+            //
+            while (0 == tb->hdr.nchars)
+            {
+                TBLOCK *save = tb;
+                tb = tb->hdr.nxt;
+                free_tblock(save);
+                save = nullptr;
+                d->output_head = tb;
+            }
+            tb->hdr.flags |= TBLK_FLAG_LOCKED;
+            mudstate.debug_cmd = cmdsave;
+            return;
+        }
+    }
+#else // UNIX_NETWORKING_WRITEV
+    TBLOCK *tb = d->output_head;
+    while (nullptr != tb)
+    {
+        while (0 < tb->hdr.nchars)
+        {
+            int cnt = SOCKET_WRITE(d->socket, reinterpret_cast<char *>(tb->hdr.start), tb->hdr.nchars, 0);
+            d->output_syscalls++;
+            if (IS_SOCKET_ERROR(cnt))
+            {
+                int iSocketError = SOCKET_LAST_ERROR;
+                mudstate.debug_cmd = cmdsave;
+                if (  SOCKET_EWOULDBLOCK   == iSocketError
+#ifdef SOCKET_EAGAIN
+                   || SOCKET_EAGAIN        == iSocketError
+#endif
+                   || SOCKET_EINTR         == iSocketError
+                )
+                {
+                    // The call would have blocked, so we need to mark the
+                    // buffer we used as read-only and try again later with
+                    // the exactly same buffer.
+                    //
+                    tb->hdr.flags |= TBLK_FLAG_LOCKED;
+                }
+                else if (bHandleShutdown)
+                {
+                    shutdownsock(d, R_SOCKDIED);
+                }
+                return;
+            }
+            d->output_size -= cnt;
+            d->output_sent += cnt;
+            tb->hdr.nchars -= cnt;
+            tb->hdr.start += cnt;
+        }
+        TBLOCK *save = tb;
+        tb = tb->hdr.nxt;
+        free_tblock(save);
+        save = nullptr;
+        d->output_head = tb;
+        if (tb == nullptr)
+        {
+            d->output_tail = nullptr;
+        }
+    }
+#endif // UNIX_NETWORKING_WRITEV
+
+#if defined(UNIX_NETWORKING_EPOLL)
+    // The output queue is empty, so stop asking about writability.
+    //
+    epoll_update(d);
+#endif // UNIX_NETWORKING_EPOLL
+    mudstate.debug_cmd = cmdsave;
+}
+
+#ifdef UNIX_SSL
+void process_output_ssl(DESC *d, int bHandleShutdown)
+{
+    const UTF8 *cmdsave = mudstate.debug_cmd;
+    mudstate.debug_cmd = T("< process_output_ssl >");
+
+    TBLOCK *tb = d->output_head;
+    while (nullptr != tb)
+    {
+        while (0 < tb->hdr.nchars)
+        {
+#if defined(UNIX_SSL_WORKERS)
+            if (nullptr != d->tls)
+            {
+                // The block is copied out, so it need not be locked.
+                //
+                int cnt = tls_write(d, tb->hdr.start, tb->hdr.nchars);
+                d->output_syscalls++;
+                if (IS_SOCKET_ERROR(cnt))
+                {
+                    mudstate.debug_cmd = cmdsave;
+                    if (bHandleShutdown)
+                    {
+                        shutdownsock(d, R_SOCKDIED);
+                    }
+                    return;
+                }
+                d->output_size -= cnt;
+                d->output_sent += cnt;
+                tb->hdr.nchars -= cnt;
+                tb->hdr.start += cnt;
+                if (0 < tb->hdr.nchars)
+                {
+                    mudstate.debug_cmd = cmdsave;
+                    return;
+                }
+                continue;
+            }
+#endif // UNIX_SSL_WORKERS
+            int cnt = SSL_write(d->ssl_session, reinterpret_cast<char *>(tb->hdr.start), tb->hdr.nchars);
+            d->output_syscalls++;
+            if (IS_SOCKET_ERROR(cnt))
+            {
+                int iSocketError = SSL_get_error(d->ssl_session, cnt);
+                mudstate.debug_cmd = cmdsave;
+                if (  SOCKET_EWOULDBLOCK   == iSocketError
+#ifdef SOCKET_EAGAIN
+                   || SOCKET_EAGAIN        == iSocketError
+#endif
+                   || SOCKET_EINTR         == iSocketError
+                   || SSL_ERROR_WANT_WRITE == iSocketError
+                   || SSL_ERROR_WANT_READ  == iSocketError
+                )
+                {
+                    // The call would have blocked, so we need to mark the
+                    // buffer we used as read-only and try again later with
+                    // the exactly same buffer.
+                    //
+                    tb->hdr.flags |= TBLK_FLAG_LOCKED;
+                }
+                else if (bHandleShutdown)
+                {
+                    shutdownsock(d, R_SOCKDIED);
+                }
+                return;
+            }
+            d->output_size -= cnt;
+            d->output_sent += cnt;
+            tb->hdr.nchars -= cnt;
+            tb->hdr.start += cnt;
+        }
+        TBLOCK *save = tb;
+        tb = tb->hdr.nxt;
+        free_tblock(save);
+        save = nullptr;
+        d->output_head = tb;
+        if (tb == nullptr)
+        {
+            d->output_tail = nullptr;
+        }
+    }
+
+#if defined(UNIX_NETWORKING_EPOLL)
+    // The output queue is empty, so stop asking about writability.
+    //
+    epoll_update(d);
+#endif // UNIX_NETWORKING_EPOLL
+    mudstate.debug_cmd = cmdsave;
+}
+#endif // UNIX_SSL
+
+#if defined(UNIX_MCCP)
+
+// MCCP2 (telnet option 86).  Once the client agrees, everything sent after
+// IAC SB COMPRESS2 IAC SE goes through a zlib stream.  Text stays
+// uncompressed in the output queue, so the output limit works as before, and
+// is deflated on its way to the socket.  The stream is sync-flushed whenever
+// the queue drains, so a prompt reaches the client as soon as it would have
+// without compression.
+//
+#define MCCP_BUFFER_SIZE 8192
+
+struct mccp_state
+{
+    z_stream       zs;
+    size_t         nRaw;        // Queued bytes which precede the stream.
+    size_t         nRemaining;  // Queued bytes to compress before Z_FINISH.
+    bool           bEnding;
+    bool           bFinished;
+    bool           bDraining;   // deflate() may be holding more output.
+    unsigned char *pPending;
+    size_t         nPending;
+    unsigned char  aBuffer[MCCP_BUFFER_SIZE];
+};
+
+static bool mccp_pending(const DESC *d)
+{
+    return (  nullptr != d->mccp
+           && 0 < d->mccp->nPending);
+}
+
+// nRaw and nRemaining are measured from the head of the queue, so nothing
+// queued so far may be discarded by queue_write_LEN().
+//
+static void mccp_lock_queue(DESC *d)
+{
+    for (TBLOCK *tb = d->output_head; nullptr != tb; tb = tb->hdr.nxt)
+    {
+        tb->hdr.flags |= TBLK_FLAG_LOCKED;
+    }
+}
+
+/*! \brief Begin compressing output after the client agrees to MCCP2.
+ *
+ * \param d        Player connection context.
+ * \return         None.
+ */
+
+static void mccp_start(DESC *d)
+{
+    if (nullptr != d->mccp)
+    {
+        return;
+    }
+
+    int iLevel = mudconf.mccp_level;
+    if (Z_BEST_COMPRESSION < iLevel)
+    {
+        iLevel = Z_BEST_COMPRESSION;
+    }
+    else if (iLevel < Z_BEST_SPEED)
+    {
+        iLevel = Z_BEST_SPEED;
+    }
+
+    mccp_state *pm = static_cast<mccp_state *>(MEMALLOC(sizeof(mccp_state)));
+    ISOUTOFMEMORY(pm);
+    memset(pm, 0, sizeof(mccp_state));
+    if (Z_OK != deflateInit(&pm->zs, iLevel))
+    {
+        MEMFREE(pm);
+        STARTLOG(LOG_PROBLEMS, "NET", "MCCP");
+        log_text(T("deflateInit() failed."));
+        ENDLOG;
+        return;
+    }
+
+    const UTF8 aStart[5] = { NVT_IAC, NVT_SB, TELNET_COMPRESS2, NVT_IAC, NVT_SE };
+    queue_write_LEN(d, aStart, sizeof(aStart));
+    pm->nRaw = d->output_size;
+    mccp_lock_queue(d);
+    d->mccp = pm;
+}
+
+/*! \brief End the compression stream after what is already queued.
+ *
+ * Output queued after this point is sent uncompressed once the stream has
+ * been finished.
+ *
+ * \param d        Player connection context.
+ * \return         None.
+ */
+
+void mccp_stop(DESC *d)
+{
+    mccp_state *pm = d->mccp;
+    if (  nullptr == pm
+       || pm->bEnding)
+    {
+        return;
+    }
+    pm->bEnding = true;
+    pm->nRemaining = d->output_size - pm->nRaw;
+    mccp_lock_queue(d);
+}
+
+/*! \brief Release the compression stream without finishing it.
+ *
+ * \param d        Player connection context.
+ * \return         None.
+ */
+
+void mccp_free(DESC *d)
+{
+    if (nullptr != d->mccp)
+    {
+        deflateEnd(&d->mccp->zs);
+        MEMFREE(d->mccp);
+        d->mccp = nullptr;
+    }
+}
+
+/*! \brief Finish every compression stream before a restart.
+ *
+ * The restarted process cannot pick up a zlib stream, so each stream is
+ * ended and flushed while we still can.  A client that cannot take the
+ * output right now will see a truncated stream.
+ *
+ * \return         None.
+ */
+
+void mccp_stop_all(void)
+{
+    DESC *d, *dnext;
+    DESC_SAFEITER_ALL(d, dnext)
+    {
+        if (nullptr != d->mccp)
+        {
+            d->nvt_us_state[TELNET_COMPRESS2] = OPTION_NO;
+            mccp_stop(d);
+            process_output(d, false);
+        }
+    }
 }
 
-#elif defined(UNIX_NETWORKING)
+// Returns the number of bytes written, 0 if the write would block, or -1 if
+// the connection failed.  After -1, d may have been shut down.
+//
+static int mccp_write(DESC *d, unsigned char *p, size_t n, int bHandleShutdown)
+{
+    int cnt;
+    int iSocketError;
+#if defined(UNIX_SSL_WORKERS)
+    if (nullptr != d->tls)
+    {
+        cnt = tls_write(d, p, n);
+        d->output_syscalls++;
+        if (!IS_SOCKET_ERROR(cnt))
+        {
+            d->output_sent += cnt;
+            return cnt;
+        }
+        else if (bHandleShutdown)
+        {
+            shutdownsock(d, R_SOCKDIED);
+        }
+        return -1;
+    }
+#endif // UNIX_SSL_WORKERS
+#ifdef UNIX_SSL
+    if (d->ssl_session)
+    {
+        cnt = SSL_write(d->ssl_session, reinterpret_cast<char *>(p), static_cast<int>(n));
+        iSocketError = IS_SOCKET_ERROR(cnt) ? SSL_get_error(d->ssl_session, cnt) : 0;
+    }
+    else
+#endif
+    {
+        cnt = SOCKET_WRITE(d->socket, reinterpret_cast<char *>(p), n, 0);
+        iSocketError = IS_SOCKET_ERROR(cnt) ? SOCKET_LAST_ERROR : 0;
+    }
+    d->output_syscalls++;
 
-/*! \brief Service network request for more output to a specific socket.
- *
- * This function is called when the network wants to consume more data, but it
- * must also be called to kick-start output to the network, so truthfully, the
- * call can come from shovechars or the output routines.  Currently, this is
- * not being called by the task queue, but it is in a form that is callable by
- * the task queue.
+    if (!IS_SOCKET_ERROR(cnt))
+    {
+        d->output_sent += cnt;
+        return cnt;
+    }
+
+    if (  SOCKET_EWOULDBLOCK   == iSocketError
+#ifdef SOCKET_EAGAIN
+       || SOCKET_EAGAIN        == iSocketError
+#endif
+       || SOCKET_EINTR         == iSocketError
+#ifdef UNIX_SSL
+       || (  d->ssl_session
+          && (  SSL_ERROR_WANT_WRITE == iSocketError
+             || SSL_ERROR_WANT_READ  == iSocketError))
+#endif
+       )
+    {
+        return 0;
+    }
+
+    if (bHandleShutdown)
+    {
+        shutdownsock(d, R_SOCKDIED);
+    }
+    return -1;
+}
+
+/*! \brief Compress and send queued output for an MCCP2 connection.
  *
- * \param dvoid             Network descriptor state.
- * \param bHandleShutdown   Whether the shutdownsock() call is being handled..
+ * \param d                 Network descriptor state.
+ * \param bHandleShutdown   Whether the shutdownsock() call is being handled.
  * \return                  None.
  */
 
-void process_output_socket(DESC *d, int bHandleShutdown)
+static void process_output_mccp(DESC *d, int bHandleShutdown)
 {
     const UTF8 *cmdsave = mudstate.debug_cmd;
-    mudstate.debug_cmd = T("< process_output >");
+    mudstate.debug_cmd = T("< process_output_mccp >");
 
-    TBLOCK *tb = d->output_head;
-    while (nullptr != tb)
+    mccp_state *pm = d->mccp;
+    for (;;)
     {
-        while (0 < tb->hdr.nchars)
+        // Compressed bytes already produced go first.
+        //
+        if (0 < pm->nPending)
         {
-            int cnt = SOCKET_WRITE(d->socket, reinterpret_cast<char *>(tb->hdr.start), tb->hdr.nchars, 0);
-            if (IS_SOCKET_ERROR(cnt))
+            int cnt = mccp_write(d, pm->pPending, pm->nPending, bHandleShutdown);
+            if (cnt < 0)
             {
-                int iSocketError = SOCKET_LAST_ERROR;
                 mudstate.debug_cmd = cmdsave;
-                if (  SOCKET_EWOULDBLOCK   == iSocketError
-#ifdef SOCKET_EAGAIN
-                   || SOCKET_EAGAIN        == iSocketError
-#endif
-                   || SOCKET_EINTR         == iSocketError
-                )
-                {
-                    // The call would have blocked, so we need to mark the
-                    // buffer we used as read-only and try again later with
-                    // the exactly same buffer.
-                    //
-                    tb->hdr.flags |= TBLK_FLAG_LOCKED;
-                }
-                else if (bHandleShutdown)
-                {
-                    shutdownsock(d, R_SOCKDIED);
-                }
                 return;
             }
-            d->output_size -= cnt;
-            tb->hdr.nchars -= cnt;
-            tb->hdr.start += cnt;
+            pm->pPending += cnt;
+            pm->nPending -= cnt;
+            if (0 < pm->nPending)
+            {
+                mudstate.debug_cmd = cmdsave;
+                return;
+            }
+            continue;
         }
-        TBLOCK *save = tb;
-        tb = tb->hdr.nxt;
-        MEMFREE(save);
-        save = nullptr;
-        d->output_head = tb;
-        if (tb == nullptr)
+
+        if (pm->bFinished)
         {
-            d->output_tail = nullptr;
+            // The stream has ended, and whatever is queued now is sent as it
+            // is.
+            //
+            mccp_free(d);
+            mudstate.debug_cmd = cmdsave;
+            process_output(d, bHandleShutdown);
+            return;
         }
-    }
 
-    mudstate.debug_cmd = cmdsave;
-}
+        TBLOCK *tb = d->output_head;
+        while (  nullptr != tb
+              && 0 == tb->hdr.nchars)
+        {
+            TBLOCK *save = tb;
+            tb = tb->hdr.nxt;
+            free_tblock(save);
+            save = nullptr;
+            d->output_head = tb;
+            if (nullptr == tb)
+            {
+                d->output_tail = nullptr;
+            }
+        }
 
-#ifdef UNIX_SSL
-void process_output_ssl(DESC *d, int bHandleShutdown)
-{
-    const UTF8 *cmdsave = mudstate.debug_cmd;
-    mudstate.debug_cmd = T("< process_output_ssl >");
+        if (nullptr == tb)
+        {
+            pm->nRaw = 0;
+            pm->nRemaining = 0;
+        }
 
-    TBLOCK *tb = d->output_head;
-    while (nullptr != tb)
-    {
-        while (0 < tb->hdr.nchars)
+        if (0 < pm->nRaw)
         {
-            int cnt = SSL_write(d->ssl_session, reinterpret_cast<char *>(tb->hdr.start), tb->hdr.nchars);
-            if (IS_SOCKET_ERROR(cnt))
+            // Output queued before IAC SB COMPRESS2 IAC SE, including that
+            // sequence itself, is not compressed.
+            //
+            size_t n = (tb->hdr.nchars < pm->nRaw) ? tb->hdr.nchars : pm->nRaw;
+            int cnt = mccp_write(d, tb->hdr.start, n, bHandleShutdown);
+            if (cnt < 0)
             {
-                int iSocketError = SSL_get_error(d->ssl_session, cnt);
                 mudstate.debug_cmd = cmdsave;
-                if (  SOCKET_EWOULDBLOCK   == iSocketError
-#ifdef SOCKET_EAGAIN
-                   || SOCKET_EAGAIN        == iSocketError
-#endif
-                   || SOCKET_EINTR         == iSocketError
-                   || SSL_ERROR_WANT_WRITE == iSocketError
-                   || SSL_ERROR_WANT_READ  == iSocketError
-                )
-                {
-                    // The call would have blocked, so we need to mark the
-                    // buffer we used as read-only and try again later with
-                    // the exactly same buffer.
-                    //
-                    tb->hdr.flags |= TBLK_FLAG_LOCKED;
-                }
-                else if (bHandleShutdown)
-                {
-                    shutdownsock(d, R_SOCKDIED);
-                }
                 return;
             }
-            d->output_size -= cnt;
-            tb->hdr.nchars -= cnt;
             tb->hdr.start += cnt;
+            tb->hdr.nchars -= cnt;
+            d->output_size -= cnt;
+            pm->nRaw -= cnt;
+            if (static_cast<size_t>(cnt) < n)
+            {
+                mudstate.debug_cmd = cmdsave;
+                return;
+            }
+            continue;
         }
-        TBLOCK *save = tb;
-        tb = tb->hdr.nxt;
-        MEMFREE(save);
-        save = nullptr;
-        d->output_head = tb;
-        if (tb == nullptr)
+
+        size_t nIn = (nullptr != tb) ? tb->hdr.nchars : 0;
+        int flush;
+        if (pm->bEnding)
         {
-            d->output_tail = nullptr;
+            if (pm->nRemaining < nIn)
+            {
+                nIn = pm->nRemaining;
+            }
+            flush = (nIn == pm->nRemaining) ? Z_FINISH : Z_NO_FLUSH;
+        }
+        else if (  0 == nIn
+                && !pm->bDraining)
+        {
+            // Everything queued has been sent.
+            //
+            break;
+        }
+        else if (  nullptr == tb
+                || nullptr == tb->hdr.nxt)
+        {
+            flush = Z_SYNC_FLUSH;
+        }
+        else
+        {
+            flush = Z_NO_FLUSH;
+        }
+
+        pm->zs.next_in = (nullptr != tb) ? reinterpret_cast<Bytef *>(tb->hdr.start) : nullptr;
+        pm->zs.avail_in = static_cast<uInt>(nIn);
+        pm->zs.next_out = pm->aBuffer;
+        pm->zs.avail_out = sizeof(pm->aBuffer);
+        int zr = deflate(&pm->zs, flush);
+        if (Z_STREAM_ERROR == zr)
+        {
+            STARTLOG(LOG_PROBLEMS, "NET", "MCCP");
+            log_text(T("deflate() failed."));
+            ENDLOG;
+            mudstate.debug_cmd = cmdsave;
+            if (bHandleShutdown)
+            {
+                shutdownsock(d, R_SOCKDIED);
+            }
+            return;
+        }
+
+        size_t nConsumed = nIn - pm->zs.avail_in;
+        size_t nProduced = sizeof(pm->aBuffer) - pm->zs.avail_out;
+        if (0 < nConsumed)
+        {
+            tb->hdr.start += nConsumed;
+            tb->hdr.nchars -= nConsumed;
+            d->output_size -= nConsumed;
+            if (pm->bEnding)
+            {
+                pm->nRemaining -= nConsumed;
+            }
+        }
+        d->compress_in += nConsumed;
+        d->compress_out += nProduced;
+
+        pm->pPending = pm->aBuffer;
+        pm->nPending = nProduced;
+        pm->bDraining = (0 == pm->zs.avail_out);
+        if (Z_STREAM_END == zr)
+        {
+            pm->bFinished = true;
+        }
+        else if (  0 == nConsumed
+                && 0 == nProduced)
+        {
+            break;
         }
     }
 
+#if defined(UNIX_NETWORKING_EPOLL)
+    // The output queue is empty, so stop asking about writability.
+    //
+    epoll_update(d);
+#endif // UNIX_NETWORKING_EPOLL
     mudstate.debug_cmd = cmdsave;
 }
-#endif // UNIX_SSL
+#endif // UNIX_MCCP
 
 #endif // UNIX_NETWORKING
 
 void process_output(DESC *d, int bHandleShutdown)
 {
+#if defined(UNIX_MCCP)
+    if (nullptr != d->mccp)
+    {
+        process_output_mccp(d, bHandleShutdown);
+        return;
+    }
+#endif // UNIX_MCCP
 #ifdef UNIX_SSL
     if (d->ssl_session) process_output_ssl(d, bHandleShutdown);
     else
@@ -2718,6 +4981,62 @@ static const unsigned char nvt_input_xlat_table[256] =
     4,  5,  5,  5,  5,  5,  6,  7,  5,  5,  8,  9, 10, 11, 12, 13   // F
 };
 
+/*! \brief Measure the run of printable ASCII at the front of a buffer.
+ *
+ * Bytes 0x20 through 0x7E are accepted the same way in the Normal telnet
+ * state and under every supported encoding, so process_input_helper() can
+ * copy such a run without consulting its state tables.
+ *
+ * \param p   Input bytes.
+ * \param n   Number of input bytes.
+ * \return    Length of the leading run of 0x20 through 0x7E.
+ */
+
+static size_t printable_ascii_span(const unsigned char *p, size_t n)
+{
+    size_t i = 0;
+#if defined(__AVX2__)
+    // As signed bytes, control characters and bytes with the high bit set
+    // are all less than a space.
+    //
+    const __m256i vSpace = _mm256_set1_epi8(0x20);
+    const __m256i vDel   = _mm256_set1_epi8(0x7F);
+    while (i + sizeof(__m256i) <= n)
+    {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+        const __m256i vStop = _mm256_or_si256(_mm256_cmpgt_epi8(vSpace, v), _mm256_cmpeq_epi8(v, vDel));
+        const unsigned int mask = static_cast<unsigned int>(_mm256_movemask_epi8(vStop));
+        if (0 != mask)
+        {
+            return i + __builtin_ctz(mask);
+        }
+        i += sizeof(__m256i);
+    }
+#endif // __AVX2__
+#if defined(__SSE2__)
+    const __m128i vSpace16 = _mm_set1_epi8(0x20);
+    const __m128i vDel16   = _mm_set1_epi8(0x7F);
+    while (i + sizeof(__m128i) <= n)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+        const __m128i vStop = _mm_or_si128(_mm_cmplt_epi8(v, vSpace16), _mm_cmpeq_epi8(v, vDel16));
+        const unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(vStop));
+        if (0 != mask)
+        {
+            return i + __builtin_ctz(mask);
+        }
+        i += sizeof(__m128i);
+    }
+#endif // __SSE2__
+    while (  i < n
+          && 0x20 <= p[i]
+          && p[i] < 0x7F)
+    {
+        i++;
+    }
+    return i;
+}
+
 /*! \brief Table to map current telnet parsing state state and input to
  * specific actions and state changes.
  *
@@ -3017,6 +5336,12 @@ static void set_us_state(DESC *d, unsigned char chOption, int iUsState)
         {
             send_charset_request(d);
         }
+#if defined(UNIX_MCCP)
+        else if (TELNET_COMPRESS2 == chOption)
+        {
+            mccp_start(d);
+        }
+#endif // UNIX_MCCP
     }
     else if (OPTION_NO == iUsState)
     {
@@ -3028,6 +5353,12 @@ static void set_us_state(DESC *d, unsigned char chOption, int iUsState)
         {
             defacto_charset_check(d);
         }
+#if defined(UNIX_MCCP)
+        else if (TELNET_COMPRESS2 == chOption)
+        {
+            mccp_stop(d);
+        }
+#endif // UNIX_MCCP
     }
 }
 
@@ -3072,6 +5403,12 @@ static bool desired_him_option(DESC *d, unsigned char chOption)
 
 static bool desired_us_option(DESC *d, unsigned char chOption)
 {
+#if defined(UNIX_MCCP)
+    if (TELNET_COMPRESS2 == chOption)
+    {
+        return 0 < mudconf.mccp_level;
+    }
+#endif // UNIX_MCCP
     return TELNET_EOR == chOption || TELNET_BINARY == chOption || TELNET_CHARSET == chOption || (TELNET_SGA == chOption
         && OPTION_YES == us_state(d, TELNET_EOR));
 }
@@ -3222,6 +5559,12 @@ void telnet_setup(DESC *d)
 //    EnableHim(d, TELNET_OLDENV);
     enable_us(d, TELNET_CHARSET);
     enable_him(d, TELNET_CHARSET);
+#if defined(UNIX_MCCP)
+    if (0 < mudconf.mccp_level)
+    {
+        enable_us(d, TELNET_COMPRESS2);
+    }
+#endif // UNIX_MCCP
 #ifdef UNIX_SSL
     if (!d->ssl_session && (tls_ctx != nullptr))
     {
@@ -3275,9 +5618,39 @@ static void process_input_helper(DESC *d, char *pBytes, int nBytes)
     auto q    = d->aOption + d->nOption;
     const auto qend = d->aOption + SBUF_SIZE - 1;
 
+    // The single-byte encodings need one byte of slack after each character.
+    //
+    const size_t nSlack = (  CHARSET_UTF8 == d->encoding
+                          || CHARSET_ASCII == d->encoding) ? 0 : 1;
+
     auto n = nBytes;
-    while (n--)
+    while (0 < n)
     {
+        if (  NVT_IS_NORMAL == d->raw_input_state
+           && CL_PRINT_START_STATE == d->raw_codepoint_state
+           && p + nSlack < pend)
+        {
+            // Copy a run of printable ASCII straight through.  The byte after
+            // the run, if any, needs the state tables below.
+            //
+            size_t nRun = printable_ascii_span(reinterpret_cast<unsigned char *>(pBytes), n);
+            const size_t nRoom = pend - p - nSlack;
+            if (nRoom < nRun)
+            {
+                nRun = nRoom;
+            }
+            memcpy(p, pBytes, nRun);
+            p += nRun;
+            pBytes += nRun;
+            nInputBytes += nRun;
+            n -= static_cast<int>(nRun);
+            if (0 == n)
+            {
+                break;
+            }
+        }
+        n--;
+
         const auto ch = static_cast<unsigned char>(*pBytes);
         const auto iAction = nvt_input_action_table[d->raw_input_state][nvt_input_xlat_table[ch]];
         switch (iAction)
@@ -3518,14 +5891,13 @@ static void process_input_helper(DESC *d, char *pBytes, int nBytes)
                 d->raw_codepoint_state = CL_PRINT_START_STATE;
             }
 
-            *p = '\0';
             if (d->raw_input->cmd < p)
             {
-                save_command(d, d->raw_input);
-                d->raw_input = reinterpret_cast<CBLK *>(alloc_lbuf("process_input.raw"));
-
+                // The line is copied into the command queue, and the same
+                // buffer collects the next one.
+                //
+                save_command(d, d->raw_input->cmd, p - d->raw_input->cmd);
                 p = d->raw_input_at = d->raw_input->cmd;
-                pend = d->raw_input->cmd + (LBUF_SIZE - sizeof(CBLKHDR) - 1);
             }
             break;
 
@@ -3734,7 +6106,12 @@ static void process_input_helper(DESC *d, char *pBytes, int nBytes)
                     {
                        d->ssl_session = SSL_new(tls_ctx);
                        SSL_set_fd(d->ssl_session, d->socket);
-                       SSL_accept(d->ssl_session);
+#if defined(UNIX_SSL_WORKERS)
+                       if (!tls_attach(d))
+#endif // UNIX_SSL_WORKERS
+                       {
+                           SSL_accept(d->ssl_session);
+                       }
                     }
                     break;
 #endif
@@ -4122,11 +6499,16 @@ static void process_input_helper(DESC *d, char *pBytes, int nBytes)
     d->input_lost += nLostBytes;
 }
 
-bool process_input(DESC *d)
+bool process_input(DESC *d, bool *pfMore)
 {
     const UTF8 *cmdsave = mudstate.debug_cmd;
     mudstate.debug_cmd = T("< process_input >");
 
+    if (nullptr != pfMore)
+    {
+        *pfMore = false;
+    }
+
     char buf[LBUF_SIZE];
     const auto got = mux_socket_read(d, buf, sizeof(buf), 0);
     if (  IS_SOCKET_ERROR(got)
@@ -4134,7 +6516,11 @@ bool process_input(DESC *d)
     {
 #ifdef UNIX_SSL
         int iSocketError;
-        if (d->ssl_session)
+        if (  d->ssl_session
+#if defined(UNIX_SSL_WORKERS)
+           && nullptr == d->tls
+#endif // UNIX_SSL_WORKERS
+           )
         {
            iSocketError = SSL_get_error(d->ssl_session, got);
         }
@@ -4165,6 +6551,19 @@ bool process_input(DESC *d)
         return false;
     }
     process_input_helper(d, buf, got);
+
+    if (nullptr != pfMore)
+    {
+        // A full buffer means the socket may have more to give. An SSL
+        // session only reads one record at a time, so it is not drained until
+        // it reports that it wants more.
+        //
+        *pfMore = (sizeof(buf) == static_cast<size_t>(got))
+#ifdef UNIX_SSL
+               || nullptr != d->ssl_session
+#endif
+               ;
+    }
     mudstate.debug_cmd = cmdsave;
     return true;
 }
@@ -4177,6 +6576,16 @@ void close_sockets(bool emergency, const UTF8 *message)
     {
         if (emergency)
         {
+#if defined(UNIX_SSL_WORKERS)
+            if (nullptr != d->tls)
+            {
+                // The socket belongs to a worker, so the message is left
+                // for it to send.
+                //
+                tls_write(d, message, strlen(reinterpret_cast<const char *>(message)));
+                continue;
+            }
+#endif // UNIX_SSL_WORKERS
 #ifdef UNIX_SSL
             if (d->ssl_session)
             {
@@ -4623,7 +7032,7 @@ static void DCL_CDECL sighandler(int sig)
 #ifdef FRIENDLY_SIGUSR2
         raw_broadcast(0, T("GAME: Flatfile backup in progress. Please wait."));
 #else
-        raw_broadcast(0, T("Caught signal %s requesting a flatfile @dump. Please wait."), SignalDesc(sig));
+        raw_broadcast(0, T("Caught signal %s requesting a flatfile @dump. Please wait."), signal_desc(sig));
 #endif
         dump_database_internal(DUMP_I_SIGNAL);
 #ifdef FRIENDLY_SIGUSR2
@@ -5256,7 +7665,7 @@ void process_windows_tcp(DWORD dwTimeout)
 
                 TBLOCK *save = tb;
                 tb = tb->hdr.nxt;
-                MEMFREE(save);
+                free_tblock(save);
                 save = nullptr;
                 d->output_head = tb;
                 if (nullptr == tb)
@@ -5312,6 +7721,7 @@ void process_windows_tcp(DWORD dwTimeout)
                 {
                     d1->flags &= ~DS_AUTODARK;
                 }
+                SnapshotTouch(d->player);
                 db[d->player].fs.word[FLAG_WORD1] &= ~DARK;
             }
 
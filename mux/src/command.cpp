@@ -1571,7 +1571,7 @@ static void process_cmdent(CMDENT *cmdp, UTF8 *switchp, dbref executor, dbref ca
                 if (  (  (aflags & AF_REGEXP)
                       && regexp_match(buff + 1, new0,
                              ((aflags & AF_CASE) ? 0 : PCRE_CASELESS), aargs,
-                             NUM_ENV_VARS))
+                             NUM_ENV_VARS, add->thing, add->atr))
                    || (  (aflags & AF_REGEXP) == 0
                       && wild(buff + 1, new0, aargs, NUM_ENV_VARS)))
                 {
@@ -3566,6 +3566,10 @@ static void list_options(dbref player)
         raw_notify(player, T("Database dumps are performed by a fork()ed process."));
     }
 #endif // HAVE_WORKING_FORK
+    if (mudconf.snapshot_dump)
+    {
+        raw_notify(player, T("Database checkpoints are written incrementally by the main loop."));
+    }
     if (mudconf.max_players >= 0)
         raw_notify(player,
         tprintf(T("There may be at most %d players logged in at once."),
@@ -3762,6 +3766,13 @@ static void list_hashstats(dbref player)
     list_hashstat(player, T("Excl. $-cmds"), &mudstate.parent_htab);
     list_hashstat(player, T("Mail Messages"), &mudstate.mail_htab);
     list_hashstat(player, T("Channel Names"), &mudstate.channel_htab);
+    list_hashstat(player, T("Regexp Cache"), &mudstate.regexp_htab);
+    list_hashstat(player, T("Lock Cache"), &mudstate.lock_htab);
+    list_hashstat(player, T("Eval Cache"), &mudstate.eval_htab);
+    list_hashstat(player, T("Queue Execs"), &mudstate.queue_htab[QUE_BY_EXECUTOR]);
+    list_hashstat(player, T("Queue Owners"), &mudstate.queue_htab[QUE_BY_OWNER]);
+    list_hashstat(player, T("Queue Sems"), &mudstate.queue_htab[QUE_BY_SEMAPHORE]);
+    list_hashstat(player, T("Queue Shares"), &mudstate.queue_share_htab);
 #if !defined(MEMORY_BASED)
     list_hashstat(player, T("Attr. Cache"), &mudstate.acache_htab);
 #endif // MEMORY_BASED
@@ -3770,6 +3781,12 @@ static void list_hashstats(dbref player)
         list_hashstat(player, mudstate.aHelpDesc[i].pBaseFilename,
             mudstate.aHelpDesc[i].ht);
     }
+    raw_notify(player, tprintf(T("Regexp Cache: %d hits, %d misses, %d evicted, %d invalidated"),
+        rc_hits, rc_misses, rc_evictions, rc_invalidates));
+    raw_notify(player, tprintf(T("Lock Cache: %d parses, %d parses saved"),
+        lc_parses, lc_saved));
+    raw_notify(player, tprintf(T("Eval Cache: %d hits, %d misses, %d evicted, %d scans saved"),
+        ec_hits, ec_misses, ec_evictions, ec_scans_saved));
 }
 
 
@@ -3790,6 +3807,25 @@ static void list_db_stats(dbref player)
     raw_notify(player, tprintf(T("Syncs      %12d"), cs_syncs));
     raw_notify(player, tprintf(T("I/O        %12d%12d"), cs_dbwrites, cs_dbreads));
     raw_notify(player, tprintf(T("Cache Hits %12d%12d"), cs_whits, cs_rhits));
+
+    static const UTF8 *QueueNames[ACACHE_QUEUES] =
+    {
+        T("Recent"),
+        T("Frequent"),
+        T("Ghost")
+    };
+    raw_notify(player, T("\nAttr Cache     Entries       Bytes        Hits   Evictions"));
+    for (int i = 0; i < ACACHE_QUEUES; i++)
+    {
+        raw_notify(player, tprintf(T("%-10s %12d%12u%12d%12d"), QueueNames[i],
+            acache_stats[i].nEntries, (unsigned int)acache_stats[i].nBytes,
+            acache_stats[i].nHits, acache_stats[i].nEvictions));
+    }
+    raw_notify(player, tprintf(T("Misses     %12d"), acache_misses));
+
+    raw_notify(player, T("\nWrite-Ahead Log Records     Commits Checkpoints"));
+    raw_notify(player, tprintf(T("           %12d%12d%12d"), wal_records,
+        wal_commits, wal_checkpoints));
 #endif // MEMORY_BASED
 }
 
@@ -3866,6 +3902,8 @@ static void list_process(dbref player)
     raw_notify(player,
            tprintf(T("Descs avail: %10d"), maxfds));
 #endif // HAVE_GETRUSAGE
+    list_output_stats(player);
+    list_queue_shares(player);
 }
 
 //----------------------------------------------------------------------------
@@ -4025,6 +4063,7 @@ void do_list(dbref executor, dbref caller, dbref enactor, int eval, int key,
     {
     case LIST_ALLOCATOR:
         list_bufstats(executor);
+        list_questats(executor);
         break;
     case LIST_BUFTRACE:
         list_buftrace(executor);
@@ -1518,6 +1518,7 @@ void SendChannelMessage
     ch->num_messages++;
 
     struct comuser *user;
+    begin_broadcast();
     for (user = ch->on_users; user; user = user->on_next)
     {
         if (  user->bUserIsOn
@@ -1535,6 +1536,7 @@ void SendChannelMessage
             }
         }
     }
+    end_broadcast();
 
     // Handle logging.
     //
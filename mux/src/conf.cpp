@@ -50,6 +50,7 @@ void cf_init(void)
     mudconf.crashdb = StringClone(T(""));
     mudconf.game_dir = StringClone(T(""));
     mudconf.game_pag = StringClone(T(""));
+    mudconf.game_wal = StringClone(T(""));
     mudconf.mail_db   = StringClone(T("mail.db"));
     mudconf.comsys_db = StringClone(T("comsys.db"));
 
@@ -77,6 +78,7 @@ void cf_init(void)
     mudconf.ssl_certificate_file[0] = '\0';
     mudconf.ssl_certificate_key[0] = '\0';
     mudconf.ssl_certificate_password[0] = '\0';
+    mudconf.ssl_threads = 2;
 #endif
 
     mudconf.init_size = 1000;
@@ -138,6 +140,8 @@ void cf_init(void)
     mudstate.dumped   = 0;
     mudstate.write_protect = false;
 #endif // HAVE_WORKING_FORK
+    mudconf.snapshot_dump = false;
+    mudstate.snapshot = false;
     mudconf.restrict_home = false;
     mudconf.have_comsys = true;
     mudconf.have_mailer = true;
@@ -156,6 +160,7 @@ void cf_init(void)
     mudconf.keepalive_interval = 60;
     mudconf.retry_limit = 3;
     mudconf.output_limit = 16384;
+    mudconf.mccp_level = 6;
     mudconf.paycheck = 0;
     mudconf.paystart = 0;
     mudconf.paylimit = 10000;
@@ -194,13 +199,20 @@ void cf_init(void)
     mudconf.queuemax = 100;
     mudconf.queue_chunk = 10;
     mudconf.active_q_chunk  = 10;
+    mudconf.timer_wheel     = true;
+    mudconf.queue_fair_share = true;
     mudconf.sacfactor       = 5;
     mudconf.sacadjust       = -1;
     mudconf.trace_limit     = 200;
     mudconf.float_precision = -1;
+    mudconf.regexp_cache_size = 256;
+    mudconf.eval_cache_size = 256;
 
     mudconf.autozone        = true;
     mudconf.use_hostname    = true;
+#if defined(UNIX_NETWORKING_EPOLL)
+    mudconf.epoll_edge_triggered = true;
+#endif // UNIX_NETWORKING_EPOLL
     mudconf.clone_copy_cost = false;
     mudconf.dark_sleepers   = true;
     mudconf.ex_flags        = true;
@@ -265,9 +277,12 @@ void cf_init(void)
     mudconf.timeslice.SetSeconds(1);
     mudconf.cmd_quota_max = 100;
     mudconf.cmd_quota_incr = 1;
+    mudconf.command_batch_time.SetMilliseconds(10);
     mudconf.rpt_cmdsecs.SetSeconds(120);
     mudconf.max_cmdsecs.SetSeconds(60);
     mudconf.cache_tick_period.SetSeconds(30);
+    mudconf.wal_commit_period.SetMilliseconds(100);
+    mudconf.write_ahead_log = true;
     mudconf.control_flags = 0xffffffff; // Everything for now...
     mudconf.log_options = LOG_ALWAYS | LOG_BUGS | LOG_SECURITY |
         LOG_NET | LOG_LOGIN | LOG_DBSAVES | LOG_CONFIGMODS |
@@ -301,6 +316,8 @@ void cf_init(void)
     mudconf.help_executor = NOTHING;
     mudconf.global_error_obj = NOTHING;
     mudconf.cache_pages = 40;
+    mudconf.cache_mmap = false;
+    mudconf.load_threads = 8;
     mudconf.mail_per_hour = 50;
     mudconf.vattr_per_hour = 5000;
     mudconf.references_per_hour = 500;
@@ -1769,12 +1786,14 @@ static CONFPARM conftable[] =
     {T("autozone"),                  cf_bool,        CA_GOD,    CA_PUBLIC,   (int *)&mudconf.autozone,        nullptr,            0},
     {T("bad_name"),                  cf_badname,     CA_GOD,    CA_DISABLED, nullptr,                         nullptr,            0},
     {T("badsite_file"),              cf_string_dyn,  CA_STATIC, CA_GOD,      (int *)&mudconf.site_file,       nullptr, SIZEOF_PATHNAME},
+    {T("cache_mmap"),                cf_bool,        CA_STATIC, CA_WIZARD,   (int *)&mudconf.cache_mmap,      nullptr,            0},
     {T("cache_names"),               cf_bool,        CA_STATIC, CA_GOD,      (int *)&mudconf.cache_names,     nullptr,            0},
     {T("cache_pages"),               cf_int,         CA_STATIC, CA_WIZARD,   &mudconf.cache_pages,            nullptr,            0},
     {T("cache_tick_period"),         cf_seconds,     CA_GOD,    CA_WIZARD,   (int *)&mudconf.cache_tick_period, nullptr,          0},
     {T("check_interval"),            cf_int,         CA_GOD,    CA_WIZARD,   &mudconf.check_interval,         nullptr,            0},
     {T("check_offset"),              cf_int,         CA_GOD,    CA_WIZARD,   &mudconf.check_offset,           nullptr,            0},
     {T("clone_copies_cost"),         cf_bool,        CA_GOD,    CA_PUBLIC,   (int *)&mudconf.clone_copy_cost, nullptr,            0},
+    {T("command_batch_time"),        cf_seconds,     CA_GOD,    CA_WIZARD,   (int *)&mudconf.command_batch_time, nullptr,         0},
     {T("command_quota_increment"),   cf_int,         CA_GOD,    CA_WIZARD,   &mudconf.cmd_quota_incr,         nullptr,            0},
     {T("command_quota_max"),         cf_int,         CA_GOD,    CA_WIZARD,   &mudconf.cmd_quota_max,          nullptr,            0},
     {T("compress_program"),          cf_string_dyn,  CA_STATIC, CA_GOD,      (int *)&mudconf.compress,        nullptr, SIZEOF_PATHNAME},
@@ -1800,6 +1819,10 @@ static CONFPARM conftable[] =
     {T("dump_message"),              cf_string,      CA_GOD,    CA_WIZARD,   (int *)mudconf.dump_msg,         nullptr,          256},
     {T("dump_offset"),               cf_int,         CA_GOD,    CA_WIZARD,   &mudconf.dump_offset,            nullptr,            0},
     {T("earn_limit"),                cf_int,         CA_GOD,    CA_PUBLIC,   &mudconf.paylimit,               nullptr,            0},
+#if defined(UNIX_NETWORKING_EPOLL)
+    {T("epoll_edge_triggered"),      cf_bool,        CA_GOD,    CA_WIZARD,   (int *)&mudconf.epoll_edge_triggered, nullptr,       0},
+#endif // UNIX_NETWORKING_EPOLL
+    {T("eval_cache_size"),           cf_int,         CA_GOD,    CA_WIZARD,   &mudconf.eval_cache_size,        nullptr,            0},
     {T("eval_comtitle"),             cf_bool,        CA_GOD,    CA_PUBLIC,   (int *)&mudconf.eval_comtitle,   nullptr,            0},
     {T("events_daily_hour"),         cf_int,         CA_GOD,    CA_PUBLIC,   &mudconf.events_daily_hour,      nullptr,            0},
     {T("examine_flags"),             cf_bool,        CA_GOD,    CA_PUBLIC,   (int *)&mudconf.ex_flags,        nullptr,            0},
@@ -1829,6 +1852,7 @@ static CONFPARM conftable[] =
     {T("function_recursion_limit"),  cf_int,         CA_GOD,    CA_PUBLIC,   &mudconf.func_nest_lim,          nullptr,            0},
     {T("game_dir_file"),             cf_string_dyn,  CA_STATIC, CA_GOD,      (int *)&mudconf.game_dir,        nullptr, SIZEOF_PATHNAME},
     {T("game_pag_file"),             cf_string_dyn,  CA_STATIC, CA_GOD,      (int *)&mudconf.game_pag,        nullptr, SIZEOF_PATHNAME},
+    {T("game_wal_file"),             cf_string_dyn,  CA_STATIC, CA_GOD,      (int *)&mudconf.game_wal,        nullptr, SIZEOF_PATHNAME},
     {T("global_error_obj"),          cf_dbref,       CA_GOD,    CA_GOD,      &mudconf.global_error_obj,       nullptr,            0},
     {T("good_name"),                 cf_badname,     CA_GOD,    CA_DISABLED, nullptr,                         nullptr,            1},
     {T("guest_char_num"),            cf_dbref,       CA_STATIC, CA_WIZARD,   &mudconf.guest_char,             nullptr,            0},
@@ -1862,6 +1886,7 @@ static CONFPARM conftable[] =
     {T("lbuf_size"),                 cf_int,       CA_DISABLED, CA_PUBLIC,   (int *)&mudconf.lbuf_size,       nullptr,            0},
     {T("link_cost"),                 cf_int,         CA_GOD,    CA_PUBLIC,   &mudconf.linkcost,               nullptr,            0},
     {T("list_access"),               cf_ntab_access, CA_GOD,    CA_DISABLED, (int *)list_names,               access_nametab,     0},
+    {T("load_threads"),              cf_int,         CA_STATIC, CA_WIZARD,   &mudconf.load_threads,           nullptr,            0},
     {T("lock_recursion_limit"),      cf_int,         CA_WIZARD, CA_PUBLIC,   &mudconf.lock_nest_lim,          nullptr,            0},
     {T("log"),                       cf_modify_bits, CA_GOD,    CA_DISABLED, &mudconf.log_options,            logoptions_nametab, 0},
     {T("log_options"),               cf_modify_bits, CA_GOD,    CA_DISABLED, &mudconf.log_info,               logdata_nametab,    0},
@@ -1876,6 +1901,7 @@ static CONFPARM conftable[] =
     {T("match_own_commands"),        cf_bool,        CA_GOD,    CA_PUBLIC,   (int *)&mudconf.match_mine,      nullptr,            0},
     {T("max_cache_size"),            cf_int,         CA_GOD,    CA_GOD,      (int *)&mudconf.max_cache_size,  nullptr,            0},
     {T("max_players"),               cf_int,         CA_GOD,    CA_WIZARD,   &mudconf.max_players,            nullptr,            0},
+    {T("mccp_level"),                cf_int,         CA_GOD,    CA_WIZARD,   &mudconf.mccp_level,             nullptr,            0},
     {T("min_guests"),                cf_int,         CA_STATIC, CA_GOD,      (int *)&mudconf.min_guests,      nullptr,            0},
     {T("money_name_plural"),         cf_string,      CA_GOD,    CA_PUBLIC,   (int *)mudconf.many_coins,       nullptr,           32},
     {T("money_name_singular"),       cf_string,      CA_GOD,    CA_PUBLIC,   (int *)mudconf.one_coin,         nullptr,           32},
@@ -1921,6 +1947,7 @@ static CONFPARM conftable[] =
     {T("public_flags"),              cf_bool,        CA_GOD,    CA_PUBLIC,   (int *)&mudconf.pub_flags,       nullptr,            0},
     {T("pueblo_message"),            cf_string,      CA_GOD,    CA_WIZARD,   (int *)mudconf.pueblo_msg,       nullptr,    GBUF_SIZE},
     {T("queue_active_chunk"),        cf_int,         CA_GOD,    CA_PUBLIC,   &mudconf.active_q_chunk,         nullptr,            0},
+    {T("queue_fair_share"),          cf_bool,        CA_GOD,    CA_PUBLIC,   (int *)&mudconf.queue_fair_share, nullptr,           0},
     {T("queue_idle_chunk"),          cf_int,         CA_GOD,    CA_PUBLIC,   &mudconf.queue_chunk,            nullptr,            0},
     {T("quiet_look"),                cf_bool,        CA_GOD,    CA_PUBLIC,   (int *)&mudconf.quiet_look,      nullptr,            0},
     {T("quiet_whisper"),             cf_bool,        CA_GOD,    CA_PUBLIC,   (int *)&mudconf.quiet_whisper,   nullptr,            0},
@@ -1930,6 +1957,7 @@ static CONFPARM conftable[] =
     {T("read_remote_desc"),          cf_bool,        CA_GOD,    CA_PUBLIC,   (int *)&mudconf.read_rem_desc,   nullptr,            0},
     {T("read_remote_name"),          cf_bool,        CA_GOD,    CA_PUBLIC,   (int *)&mudconf.read_rem_name,   nullptr,            0},
     {T("references_per_hour"),       cf_int,         CA_GOD,    CA_PUBLIC,   &mudconf.references_per_hour,    nullptr,            0},
+    {T("regexp_cache_size"),         cf_int,         CA_GOD,    CA_WIZARD,   &mudconf.regexp_cache_size,      nullptr,            0},
     {T("register_create_file"),      cf_string_dyn,  CA_STATIC, CA_GOD,      (int *)&mudconf.regf_file,       nullptr, SIZEOF_PATHNAME},
     {T("register_site"),             cf_site,        CA_GOD,    CA_DISABLED, (int *)&mudstate.access_list,    nullptr,  HC_REGISTER},
     {T("reset_players"),             cf_bool,        CA_GOD,    CA_DISABLED, (int *)&mudconf.reset_players,   nullptr,            0},
@@ -1958,11 +1986,13 @@ static CONFPARM conftable[] =
     {T("signal_action"),             cf_option,      CA_STATIC, CA_GOD,      &mudconf.sig_action,             sigactions_nametab, 0},
     {T("site_chars"),                cf_int,         CA_GOD,    CA_WIZARD,   (int *)&mudconf.site_chars,      nullptr,            0},
     {T("sitemon_site"),              cf_site,        CA_GOD,    CA_DISABLED, (int *)&mudstate.access_list,    nullptr,   HC_SITEMON},
+    {T("snapshot_dump"),             cf_bool,        CA_GOD,    CA_WIZARD,   (int *)&mudconf.snapshot_dump,   nullptr,            0},
     {T("space_compress"),            cf_bool,        CA_GOD,    CA_PUBLIC,   (int *)&mudconf.space_compress,  nullptr,            0},
 #ifdef UNIX_SSL
     {T("ssl_certificate_file"),      cf_string,      CA_STATIC, CA_DISABLED, (int *)mudconf.ssl_certificate_file,nullptr,       128},
     {T("ssl_certificate_key"),       cf_string,      CA_STATIC, CA_DISABLED, (int *)mudconf.ssl_certificate_key, nullptr,       128},
     {T("ssl_certificate_password"),  cf_string,      CA_STATIC, CA_DISABLED, (int *)mudconf.ssl_certificate_password, nullptr,  128},
+    {T("ssl_threads"),               cf_int,         CA_STATIC, CA_WIZARD,   &mudconf.ssl_threads,            nullptr,            0},
 #endif
     {T("stack_limit"),               cf_int,         CA_GOD,    CA_PUBLIC,   &mudconf.stack_limit,            nullptr,            0},
     {T("starting_money"),            cf_int,         CA_GOD,    CA_PUBLIC,   &mudconf.paystart,               nullptr,            0},
@@ -1979,6 +2009,7 @@ static CONFPARM conftable[] =
     {T("thing_name_charset"),        cf_modify_bits, CA_GOD,    CA_PUBLIC,   &mudconf.thing_name_charset,     allow_charset_nametab, 0},
     {T("thing_parent"),              cf_dbref,       CA_GOD,    CA_PUBLIC,   &mudconf.thing_parent,           nullptr,            0},
     {T("thing_quota"),               cf_int,         CA_GOD,    CA_PUBLIC,   &mudconf.thing_quota,            nullptr,            0},
+    {T("timer_wheel"),               cf_bool,        CA_GOD,    CA_PUBLIC,   (int *)&mudconf.timer_wheel,     nullptr,            0},
     {T("timeslice"),                 cf_seconds,     CA_GOD,    CA_PUBLIC,   (int *)&mudconf.timeslice,       nullptr,            0},
     {T("toad_recipient"),            cf_dbref,       CA_GOD,    CA_WIZARD,   &mudconf.toad_recipient,         nullptr,            0},
     {T("trace_output_limit"),        cf_int,         CA_GOD,    CA_PUBLIC,   &mudconf.trace_limit,            nullptr,            0},
@@ -1989,8 +2020,10 @@ static CONFPARM conftable[] =
     {T("user_attr_access"),          cf_modify_bits, CA_GOD,    CA_DISABLED, &mudconf.vattr_flags,            attraccess_nametab, 0},
     {T("user_attr_per_hour"),        cf_int,         CA_GOD,    CA_PUBLIC,   &mudconf.vattr_per_hour,         nullptr,            0},
     {T("wait_cost"),                 cf_int,         CA_GOD,    CA_PUBLIC,   &mudconf.waitcost,               nullptr,            0},
+    {T("wal_commit_period"),         cf_seconds,     CA_GOD,    CA_WIZARD,   (int *)&mudconf.wal_commit_period, nullptr,          0},
     {T("wizard_motd_file"),          cf_string_dyn,  CA_STATIC, CA_GOD,      (int *)&mudconf.wizmotd_file,    nullptr, SIZEOF_PATHNAME},
     {T("wizard_motd_message"),       cf_string,      CA_GOD,    CA_WIZARD,   (int *)mudconf.wizmotd_msg,      nullptr,    GBUF_SIZE},
+    {T("write_ahead_log"),           cf_bool,        CA_STATIC, CA_WIZARD,   (int *)&mudconf.write_ahead_log, nullptr,            0},
     {T("zone_recursion_limit"),      cf_int,         CA_GOD,    CA_PUBLIC,   &mudconf.zone_nest_lim,          nullptr,            0},
 #ifdef REALITY_LVLS
     {T("reality_level"),             cf_rlevel,      CA_STATIC, CA_GOD,      (int *)&mudconf,                 nullptr,            0},
@@ -2219,6 +2252,7 @@ static struct
     { &mudconf.crashdb,  T(".CRASH") },
     { &mudconf.game_dir, T(".dir") },
     { &mudconf.game_pag, T(".pag") },
+    { &mudconf.game_wal, T(".wal") },
     { 0, 0 }
 };
 
@@ -60,6 +60,21 @@
 #define UNIX_FILES
 #define UNIX_CRYPT
 #define UNIX_TIME
+#if defined(HAVE_SYS_EPOLL_H) && defined(HAVE_EPOLL_CREATE) && defined(HAVE_EPOLL_CTL) && defined(HAVE_EPOLL_WAIT)
+#define UNIX_NETWORKING_EPOLL
+#endif // HAVE_SYS_EPOLL_H && HAVE_EPOLL_CREATE && HAVE_EPOLL_CTL && HAVE_EPOLL_WAIT
+#if defined(HAVE_SYS_UIO_H) && defined(HAVE_WRITEV)
+#define UNIX_NETWORKING_WRITEV
+#endif // HAVE_SYS_UIO_H && HAVE_WRITEV
+#if defined(HAVE_ZLIB_H) && defined(HAVE_LIBZ)
+#define UNIX_MCCP
+#endif // HAVE_ZLIB_H && HAVE_LIBZ
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP) && defined(HAVE_MSYNC)
+#define UNIX_FILES_MMAP
+#endif // HAVE_SYS_MMAN_H && HAVE_MMAP && HAVE_MSYNC
+#if defined(HAVE_PTHREAD_H) && defined(HAVE_PTHREAD_CREATE)
+#define UNIX_THREADS
+#endif // HAVE_PTHREAD_H && HAVE_PTHREAD_CREATE
 #if defined(HAVE_DLOPEN)
 #define UNIX_DYNALIB
 #else
@@ -69,6 +84,9 @@
 #define UNIX_SSL
 #define UNIX_DIGEST
 #endif // SSL_ENABLED
+#if defined(UNIX_SSL) && defined(UNIX_THREADS) && defined(UNIX_NETWORKING_EPOLL)
+#define UNIX_SSL_WORKERS
+#endif // UNIX_SSL && UNIX_THREADS && UNIX_NETWORKING_EPOLL
 
 #endif // WIN32
 
@@ -167,6 +185,28 @@ extern int getdtablesize(void);
 #include <sys/wait.h>
 #endif
 
+#if defined(UNIX_FILES_MMAP)
+#include <sys/mman.h>
+#endif // UNIX_FILES_MMAP
+
+#if defined(UNIX_THREADS)
+#include <pthread.h>
+#endif // UNIX_THREADS
+#include <atomic>
+
+#if defined(UNIX_NETWORKING_WRITEV)
+#include <sys/uio.h>
+#if defined(IOV_MAX)
+#define OUTPUT_IOV_MAX IOV_MAX
+#else // IOV_MAX
+#define OUTPUT_IOV_MAX 16
+#endif // IOV_MAX
+#endif // UNIX_NETWORKING_WRITEV
+
+#if defined(UNIX_MCCP)
+#include <zlib.h>
+#endif // UNIX_MCCP
+
 #ifdef HAVE_NETINET_IN_H
 #include <netinet/in.h>
 #endif // HAVE_NETINET_IN_H
@@ -187,6 +227,7 @@ extern int getdtablesize(void);
 
 #ifdef UNIX_SSL
 #include <openssl/ssl.h>
+#include <openssl/err.h>
 #endif
 
 #ifdef HAVE_GETPAGESIZE
@@ -260,6 +301,14 @@ extern char *sys_errlist[];
 
 #include <stdio.h>
 
+// Scans of network input use SSE2 or AVX2 when the compiler targets them.
+//
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif // __AVX2__
+
 #ifndef EXTENDED_STDIO_DCLS
 extern int    fprintf(FILE *, const char *, ...);
 extern int    printf(const char *, ...);
@@ -315,6 +364,7 @@ typedef char  boolexp_type;
 #define MAX_GLOBAL_REGS     36  /* r() registers */
 
 #define OUTPUT_BLOCK_SIZE   16384
+#define INPUT_CHUNK_SIZE    2048
 
 /* ---------------------------------------------------------------------------
  * Database R/W flags.
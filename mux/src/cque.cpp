@@ -75,166 +75,711 @@ static int add_to(dbref executor, int am, int attrnum)
     return num;
 }
 
-// This Task assumes that pEntry is already unlinked from any lists it may
-// have been related to.
+// ---------------------------------------------------------------------------
+// Queue entry arena.
 //
-static void Task_RunQueueEntry(void *pEntry, int iUnused)
+// Records are carved from 64 KB slabs in size classes which double from 256
+// bytes, and a freed record goes on a list for its class to be reused by
+// the next entry of that size.  Records too large for the biggest class come
+// from MEMALLOC and go back to it.
+//
+#define QUE_SLAB_SIZE       65536
+#define QUE_MIN_CLASS_SHIFT 8
+#define QUE_NUM_CLASSES     7
+#define QUE_CLASS_LARGE     QUE_NUM_CLASSES
+
+typedef struct que_free
 {
-    UNUSED_PARAMETER(iUnused);
+    struct que_free *next;
+} QUE_FREE;
 
-    BQUE *point = (BQUE *)pEntry;
-    dbref executor = point->executor;
+static struct
+{
+    QUE_FREE *free_head;            // Freed records
+    UTF8     *slab_next;            // Uncarved part of the newest slab
+    size_t    slab_left;
+    UINT64    num_slabs;            // Slabs taken from MEMALLOC
+    UINT64    num_alloc;            // Records currently in use
+    UINT64    tot_alloc;            // Records ever handed out
+} que_arena[QUE_NUM_CLASSES + 1];
+
+static UINT64 Queue_Bytes = 0;      // Record bytes in use
+static UINT64 Queue_Large = 0;      // Bytes held by large records
+
+static BQUE *alloc_que(size_t nSize)
+{
+    int iClass = 0;
+    while (  iClass < QUE_NUM_CLASSES
+          && (static_cast<size_t>(1) << (iClass + QUE_MIN_CLASS_SHIFT)) < nSize)
+    {
+        iClass++;
+    }
 
-    if (  Good_obj(executor)
-       && !Going(executor))
+    UTF8 *p;
+    if (QUE_CLASS_LARGE == iClass)
     {
-        giveto(executor, mudconf.waitcost);
-        mudstate.curr_enactor = point->enactor;
-        mudstate.curr_executor = executor;
-        a_Queue(Owner(executor), -1);
-        point->executor = NOTHING;
-        if (!Halted(executor))
+        p = (UTF8 *)MEMALLOC(nSize);
+        ISOUTOFMEMORY(p);
+        Queue_Large += nSize;
+    }
+    else if (nullptr != que_arena[iClass].free_head)
+    {
+        p = (UTF8 *)que_arena[iClass].free_head;
+        que_arena[iClass].free_head = que_arena[iClass].free_head->next;
+    }
+    else
+    {
+        size_t nClass = static_cast<size_t>(1) << (iClass + QUE_MIN_CLASS_SHIFT);
+        if (que_arena[iClass].slab_left < nClass)
         {
-            // Load scratch args.
-            //
-            for (int i = 0; i < MAX_GLOBAL_REGS; i++)
-            {
-                if (mudstate.global_regs[i])
-                {
-                    RegRelease(mudstate.global_regs[i]);
-                    mudstate.global_regs[i] = nullptr;
-                }
-                mudstate.global_regs[i] = point->scr[i];
-                point->scr[i] = nullptr;
-            }
+            que_arena[iClass].slab_next = (UTF8 *)MEMALLOC(QUE_SLAB_SIZE);
+            ISOUTOFMEMORY(que_arena[iClass].slab_next);
+            que_arena[iClass].slab_left = QUE_SLAB_SIZE;
+            que_arena[iClass].num_slabs++;
+        }
+        p = que_arena[iClass].slab_next;
+        que_arena[iClass].slab_next += nClass;
+        que_arena[iClass].slab_left -= nClass;
+    }
+    que_arena[iClass].num_alloc++;
+    que_arena[iClass].tot_alloc++;
+    Queue_Bytes += nSize;
+
+    BQUE *point = (BQUE *)p;
+    point->iClass = static_cast<UINT8>(iClass);
+    point->nSize = nSize;
+    return point;
+}
 
-#if defined(STUB_SLAVE)
-            if (nullptr != mudstate.pResultsSet)
+// The registers an entry still holds follow the header.
+//
+static reg_ref **que_regs(BQUE *point)
+{
+    return (reg_ref **)(point + 1);
+}
+
+// Fills env[] with the arguments of an entry.
+//
+static void que_args(BQUE *point, const UTF8 *env[])
+{
+    UTF8 *p = (UTF8 *)(que_regs(point) + point->nRegs);
+    for (int i = 0; i < point->nargs; i++)
+    {
+        if (point->fArgs & (1 << i))
+        {
+            env[i] = p;
+            p += strlen((char *)p) + 1;
+        }
+        else
+        {
+            env[i] = nullptr;
+        }
+    }
+}
+
+static void que_unready(BQUE *point);
+
+static void free_que(BQUE *point)
+{
+    que_unready(point);
+
+    reg_ref **regs = que_regs(point);
+    for (int i = 0; i < point->nRegs; i++)
+    {
+        if (regs[i])
+        {
+            RegRelease(regs[i]);
+        }
+    }
+
+    int iClass = point->iClass;
+    que_arena[iClass].num_alloc--;
+    Queue_Bytes -= point->nSize;
+    if (QUE_CLASS_LARGE == iClass)
+    {
+        Queue_Large -= point->nSize;
+        MEMFREE(point);
+    }
+    else
+    {
+        QUE_FREE *pFree = (QUE_FREE *)point;
+        pFree->next = que_arena[iClass].free_head;
+        que_arena[iClass].free_head = pFree;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// list_questats: Show the queue entry arena for @list allocations.
+//
+void list_questats(dbref player)
+{
+    notify(player, T("Queue Arena   Size      InUse      Slabs           Allocs"));
+    UINT64 nEntries = 0;
+    UINT64 nReserved = Queue_Large;
+    for (int i = 0; i <= QUE_NUM_CLASSES; i++)
+    {
+        UTF8 buff[MBUF_SIZE];
+        UTF8 *p = buff;
+
+        if (QUE_CLASS_LARGE == i)
+        {
+            p += LeftJustifyString(p, 12, T("Large"));                         *p++ = ' ';
+            p += LeftJustifyString(p,  5, T(""));                              *p++ = ' ';
+        }
+        else
+        {
+            p += LeftJustifyString(p, 12, T("Qentries"));                      *p++ = ' ';
+            p += RightJustifyNumber(p,  5, 1 << (i + QUE_MIN_CLASS_SHIFT), ' '); *p++ = ' ';
+        }
+        p += RightJustifyNumber(p, 10, que_arena[i].num_alloc, ' ');           *p++ = ' ';
+        p += RightJustifyNumber(p, 10, que_arena[i].num_slabs, ' ');           *p++ = ' ';
+        p += RightJustifyNumber(p, 16, que_arena[i].tot_alloc, ' ');           *p++ = '\0';
+        notify(player, buff);
+
+        nEntries += que_arena[i].num_alloc;
+        nReserved += que_arena[i].num_slabs * QUE_SLAB_SIZE;
+    }
+
+    UTF8 *buff = alloc_lbuf("list_questats");
+    UTF8 *bp = buff;
+    safe_i64toa(nEntries, buff, &bp);
+    safe_str(T(" queue entries use "), buff, &bp);
+    safe_i64toa(Queue_Bytes, buff, &bp);
+    safe_str(T(" bytes, "), buff, &bp);
+    safe_i64toa(nEntries ? Queue_Bytes/nEntries : 0, buff, &bp);
+    safe_str(T(" per entry, of "), buff, &bp);
+    safe_i64toa(nReserved, buff, &bp);
+    safe_str(T(" bytes reserved."), buff, &bp);
+    *bp = '\0';
+    notify(player, buff);
+    free_lbuf(buff);
+}
+
+// ---------------------------------------------------------------------------
+// Queue entry indexes.
+//
+// Every @wait, semaphore, and SQL entry in the scheduler is also on a list
+// of entries with the same executor and a list of entries with the same
+// owner.  Entries blocked on a semaphore are on a third list for the
+// semaphore object.  The heads of the lists are kept in mudstate.queue_htab,
+// and the entries remember their task, so matching entries can be found and
+// removed from the scheduler without visiting every task.
+//
+static void Task_RunQueueEntry(void *pEntry, int iUnused);
+static void Task_SemaphoreTimeout(void *pExpired, int iUnused);
+void Task_SQLTimeout(void *pExpired, int iUnused);
+
+static int Queue_Waits      = 0;
+static int Queue_Semaphores = 0;
+static int Queue_Queries    = 0;
+static int Queue_Removals   = 0;
+
+static void que_tally(FTASK *fpTask, int iDelta)
+{
+    if (Task_RunQueueEntry == fpTask)
+    {
+        Queue_Waits += iDelta;
+    }
+    else if (Task_SemaphoreTimeout == fpTask)
+    {
+        Queue_Semaphores += iDelta;
+    }
+    else if (Task_SQLTimeout == fpTask)
+    {
+        Queue_Queries += iDelta;
+    }
+}
+
+static BQUE *que_first(int iIndex, dbref key)
+{
+    return (BQUE *)hashfindLEN(&key, sizeof(key), &mudstate.queue_htab[iIndex]);
+}
+
+static void que_link(int iIndex, dbref key, BQUE *point)
+{
+    BQUE *head = que_first(iIndex, key);
+    point->links[iIndex].prev = nullptr;
+    point->links[iIndex].next = head;
+    if (nullptr == head)
+    {
+        hashaddLEN(&key, sizeof(key), point, &mudstate.queue_htab[iIndex]);
+    }
+    else
+    {
+        head->links[iIndex].prev = point;
+        hashreplLEN(&key, sizeof(key), point, &mudstate.queue_htab[iIndex]);
+    }
+}
+
+static void que_unlink(int iIndex, dbref key, BQUE *point)
+{
+    BQUE *next = point->links[iIndex].next;
+    BQUE *prev = point->links[iIndex].prev;
+    if (nullptr != next)
+    {
+        next->links[iIndex].prev = prev;
+    }
+
+    if (nullptr != prev)
+    {
+        prev->links[iIndex].next = next;
+    }
+    else if (nullptr != next)
+    {
+        hashreplLEN(&key, sizeof(key), next, &mudstate.queue_htab[iIndex]);
+    }
+    else
+    {
+        hashdeleteLEN(&key, sizeof(key), &mudstate.queue_htab[iIndex]);
+    }
+    point->links[iIndex].next = nullptr;
+    point->links[iIndex].prev = nullptr;
+}
+
+// index_que: Make a newly-scheduled entry findable.
+//
+static void index_que(BQUE *point, PTASK_RECORD pTask)
+{
+    point->pTask = pTask;
+    if (nullptr == pTask)
+    {
+        return;
+    }
+
+    point->owner = Owner(point->executor);
+    que_link(QUE_BY_EXECUTOR, point->executor, point);
+    que_link(QUE_BY_OWNER, point->owner, point);
+    if (Task_SemaphoreTimeout == pTask->fpTask)
+    {
+        que_link(QUE_BY_SEMAPHORE, point->u.s.sem, point);
+    }
+    que_tally(pTask->fpTask, 1);
+}
+
+// unindex_que: Forget an entry that is about to run or be discarded.  This
+// must happen while its task still exists.
+//
+static void unindex_que(BQUE *point)
+{
+    PTASK_RECORD pTask = point->pTask;
+    if (nullptr == pTask)
+    {
+        return;
+    }
+
+    que_unlink(QUE_BY_EXECUTOR, point->executor, point);
+    que_unlink(QUE_BY_OWNER, point->owner, point);
+    if (Task_SemaphoreTimeout == pTask->fpTask)
+    {
+        que_unlink(QUE_BY_SEMAPHORE, point->u.s.sem, point);
+    }
+    que_tally(pTask->fpTask, -1);
+    point->pTask = nullptr;
+    Queue_Removals++;
+}
+
+// retask_que: Change what a waiting entry will do when its task runs.
+//
+static void retask_que(BQUE *point, FTASK *fpTask)
+{
+    PTASK_RECORD pTask = point->pTask;
+    if (Task_SemaphoreTimeout == pTask->fpTask)
+    {
+        que_unlink(QUE_BY_SEMAPHORE, point->u.s.sem, point);
+    }
+    que_tally(pTask->fpTask, -1);
+    pTask->fpTask = fpTask;
+    que_tally(fpTask, 1);
+}
+
+// ---------------------------------------------------------------------------
+// Fair-share scheduling.
+//
+// Each owner of queue entries has an account.  As an entry becomes ready to
+// run, its task is tagged with a start in virtual time: the later of the
+// current virtual time and the end of the owner's previous ready entry.
+// An entry's length is its owner's recent processor time per entry, so the
+// entries of an owner who uses more processor are spread further apart,
+// and other owners' entries run in between.  The virtual time is the tag of
+// the entry which started most recently, so an owner who was idle gets no
+// credit for it.  The scheduler orders ready tasks of the same priority by
+// tag, and an owner's own entries stay in the order they became ready.
+//
+typedef struct
+{
+    dbref   owner;
+    int     nReady;             // Entries ready and waiting to run.
+    int     nRun;               // Entries which have run.
+    INT64   iFinish;            // Where the owner's next ready entry starts.
+    INT64   iCost;              // Recent processor time per entry, in 100ns.
+    INT64   iWait;              // Time entries waited while ready, in 100ns.
+    INT64   iUsage;             // Processor time used by entries, in 100ns.
+} QUE_SHARE;
+
+#define QS_MIN_COST 100         // Least length of an entry, in 100ns.
+#define QS_LIST_MAX 20          // Owners shown by @list process.
+
+static INT64 Share_iVirtual = 0;
+
+static QUE_SHARE *que_share(dbref owner)
+{
+    QUE_SHARE *ps = (QUE_SHARE *)hashfindLEN(&owner, sizeof(owner), &mudstate.queue_share_htab);
+    if (nullptr == ps)
+    {
+        ps = (QUE_SHARE *)MEMALLOC(sizeof(QUE_SHARE));
+        ISOUTOFMEMORY(ps);
+        ps->owner = owner;
+        ps->nReady = 0;
+        ps->nRun = 0;
+        ps->iFinish = 0;
+        ps->iCost = 0;
+        ps->iWait = 0;
+        ps->iUsage = 0;
+        hashaddLEN(&owner, sizeof(owner), ps, &mudstate.queue_share_htab);
+    }
+    return ps;
+}
+
+// que_ready: The scheduler's ready hook.  Tags the task of a queue entry
+// which has just become ready to run.
+//
+void que_ready(PTASK_RECORD pTask)
+{
+    if (  (  Task_RunQueueEntry != pTask->fpTask
+          && Task_SemaphoreTimeout != pTask->fpTask)
+       || PRIORITY_SUSPEND <= pTask->iPriority)
+    {
+        return;
+    }
+
+    BQUE *point = (BQUE *)pTask->arg_voidptr;
+    if (point->IsReady)
+    {
+        return;
+    }
+
+    QUE_SHARE *ps = que_share(point->owner);
+    if (mudconf.queue_fair_share)
+    {
+        INT64 iStart = (Share_iVirtual < ps->iFinish) ? ps->iFinish : Share_iVirtual;
+        pTask->m_iShare = iStart;
+        ps->iFinish = iStart + ((QS_MIN_COST < ps->iCost) ? ps->iCost : QS_MIN_COST);
+    }
+    else
+    {
+        pTask->m_iShare = Share_iVirtual;
+    }
+    point->IsReady = true;
+    point->ltaReady.GetUTC();
+    ps->nReady++;
+}
+
+// que_unready: An entry is no longer waiting to run, because it is about to
+// run or is being discarded.
+//
+static void que_unready(BQUE *point)
+{
+    if (point->IsReady)
+    {
+        point->IsReady = false;
+        que_share(point->owner)->nReady--;
+    }
+}
+
+// que_started: An entry taken from the scheduler with pTask is about to run.
+// Its wait is counted, and the virtual time moves up to its tag.
+//
+static void que_started(BQUE *point, PTASK_RECORD pTask)
+{
+    if (  !point->IsReady
+       || nullptr == pTask)
+    {
+        return;
+    }
+    que_unready(point);
+
+    if (Share_iVirtual < pTask->m_iShare)
+    {
+        Share_iVirtual = pTask->m_iShare;
+    }
+    CLinearTimeAbsolute ltaNow;
+    ltaNow.GetUTC();
+    CLinearTimeDelta ltdWait = ltaNow - point->ltaReady;
+    que_share(point->owner)->iWait += ltdWait.Return100ns();
+}
+
+// que_charge: Charge an entry's owner for the processor time it used.  The
+// recent time per entry decays by an eighth with each entry.
+//
+static void que_charge(BQUE *point, CLinearTimeDelta ltdUsage)
+{
+    QUE_SHARE *ps = que_share(point->owner);
+    INT64 iUsage = ltdUsage.Return100ns();
+    ps->nRun++;
+    ps->iUsage += iUsage;
+    ps->iCost += (iUsage - ps->iCost) / 8;
+}
+
+// Formats an owner's account for @ps and @list process.
+//
+static const UTF8 *Share_Header = T(" Ready      Run  Wait ms    CPU ms  us/Each  Owner");
+
+static void que_share_line(UTF8 *buff, QUE_SHARE *ps)
+{
+    UTF8 aUsage[I64BUF_SIZE];
+    mux_i64toa(ps->iUsage / 10000, aUsage);
+    int iWait = (0 < ps->nRun) ? static_cast<int>(ps->iWait / ps->nRun / 10000) : 0;
+    mux_sprintf(buff, MBUF_SIZE, T("%6d %8d %8d %9s %8d  %s"), ps->nReady, ps->nRun,
+        iWait, aUsage, static_cast<int>(ps->iCost / 10),
+        Good_obj(ps->owner) ? Moniker(ps->owner) : T("*GONE*"));
+}
+
+static int que_compare_usage(const void *pA, const void *pB)
+{
+    const QUE_SHARE *a = *(QUE_SHARE * const *)pA;
+    const QUE_SHARE *b = *(QUE_SHARE * const *)pB;
+    if (a->iUsage != b->iUsage)
+    {
+        return (a->iUsage < b->iUsage) ? 1 : -1;
+    }
+    return a->owner - b->owner;
+}
+
+// list_queue_shares: Show the owners whose queue entries have used the most
+// processor time, for @list process.
+//
+void list_queue_shares(dbref player)
+{
+    int nShares = 0;
+    QUE_SHARE *ps;
+    for (ps = (QUE_SHARE *)hash_firstentry(&mudstate.queue_share_htab);
+         nullptr != ps;
+         ps = (QUE_SHARE *)hash_nextentry(&mudstate.queue_share_htab))
+    {
+        nShares++;
+    }
+    if (0 == nShares)
+    {
+        return;
+    }
+
+    QUE_SHARE **aShares = (QUE_SHARE **)MEMALLOC(nShares * sizeof(QUE_SHARE *));
+    ISOUTOFMEMORY(aShares);
+    int i = 0;
+    for (ps = (QUE_SHARE *)hash_firstentry(&mudstate.queue_share_htab);
+         nullptr != ps;
+         ps = (QUE_SHARE *)hash_nextentry(&mudstate.queue_share_htab))
+    {
+        aShares[i++] = ps;
+    }
+    qsort(aShares, nShares, sizeof(QUE_SHARE *), que_compare_usage);
+
+    raw_notify(player, mudconf.queue_fair_share
+        ? T("Queue owners (fair share):") : T("Queue owners (first come):"));
+    raw_notify(player, Share_Header);
+    UTF8 *buff = alloc_mbuf("list_queue_shares");
+    for (i = 0; i < nShares && i < QS_LIST_MAX; i++)
+    {
+        que_share_line(buff, aShares[i]);
+        raw_notify(player, buff);
+    }
+    free_mbuf(buff);
+    MEMFREE(aShares);
+}
+
+// chown_que: Keep the owner index in step with the owner of an executor.
+//
+void chown_que(dbref thing)
+{
+    BQUE *point = que_first(QUE_BY_EXECUTOR, thing);
+    if (nullptr == point)
+    {
+        return;
+    }
+
+    dbref owner = Owner(thing);
+    while (nullptr != point)
+    {
+        BQUE *next = point->links[QUE_BY_EXECUTOR].next;
+        if (point->owner != owner)
+        {
+            if (point->IsReady)
             {
-                mudstate.pResultsSet->Release();
-                mudstate.pResultsSet = nullptr;
+                que_share(point->owner)->nReady--;
+                que_share(owner)->nReady++;
             }
-            mudstate.pResultsSet = point->pResultsSet;
-            point->pResultsSet = nullptr;
-            mudstate.iRow = point->iRow;
-#endif // STUB_SLAVE
+            que_unlink(QUE_BY_OWNER, point->owner, point);
+            point->owner = owner;
+            que_link(QUE_BY_OWNER, owner, point);
+        }
+        point = next;
+    }
+}
 
-            UTF8 *command = point->comm;
+// Sorts an array of entries into the order TraverseOrdered() would visit
+// their tasks.
+//
+static int que_compare_ordered(const void *pA, const void *pB)
+{
+    BQUE *a = *(BQUE * const *)pA;
+    BQUE *b = *(BQUE * const *)pB;
+    return scheduler.CompareOrdered(a->pTask, b->pTask);
+}
 
-            mux_assert(!mudstate.inpipe);
-            mux_assert(mudstate.pipe_nest_lev == 0);
-            mux_assert(mudstate.poutobj == NOTHING);
-            mux_assert(!mudstate.pout);
+// Runs the commands of an entry which has been taken off of the scheduler
+// and out of the indexes.  Its registers and SQL results become the current
+// ones.  Returns the processor time the commands used.
+//
+static CLinearTimeDelta que_run_commands(BQUE *point, dbref executor)
+{
+    CLinearTimeDelta ltdUsage;
 
-            break_called = false;
-            while (  command
-                  && !break_called)
-            {
-                mux_assert(!mudstate.poutnew);
-                mux_assert(!mudstate.poutbufc);
+    // Load scratch args.
+    //
+    reg_ref **regs = que_regs(point);
+    int iReg = 0;
+    for (int i = 0; i < MAX_GLOBAL_REGS; i++)
+    {
+        if (mudstate.global_regs[i])
+        {
+            RegRelease(mudstate.global_regs[i]);
+            mudstate.global_regs[i] = nullptr;
+        }
+        if (point->fRegs & (UINT64_C(1) << i))
+        {
+            mudstate.global_regs[i] = regs[iReg];
+            regs[iReg++] = nullptr;
+        }
+    }
 
-                UTF8 *cp = parse_to(&command, ';', 0);
+#if defined(STUB_SLAVE)
+    if (nullptr != mudstate.pResultsSet)
+    {
+        mudstate.pResultsSet->Release();
+        mudstate.pResultsSet = nullptr;
+    }
+    mudstate.pResultsSet = point->pResultsSet;
+    point->pResultsSet = nullptr;
+    mudstate.iRow = point->iRow;
+#endif // STUB_SLAVE
 
-                if (  cp
-                   && *cp)
-                {
-                    // Will command be piped?
-                    //
-                    if (  command
-                       && *command == '|'
-                       && mudstate.pipe_nest_lev < mudconf.ntfy_nest_lim)
-                    {
-                        command++;
-                        mudstate.pipe_nest_lev++;
-                        mudstate.inpipe = true;
+    UTF8 *command = point->comm;
+    const UTF8 *env[NUM_ENV_VARS];
+    que_args(point, env);
 
-                        mudstate.poutnew  = alloc_lbuf("process_command.pipe");
-                        mudstate.poutbufc = mudstate.poutnew;
-                        mudstate.poutobj  = executor;
-                    }
-                    else
-                    {
-                        mudstate.inpipe = false;
-                        mudstate.poutobj = NOTHING;
-                    }
+    mux_assert(!mudstate.inpipe);
+    mux_assert(mudstate.pipe_nest_lev == 0);
+    mux_assert(mudstate.poutobj == NOTHING);
+    mux_assert(!mudstate.pout);
 
-                    CLinearTimeAbsolute ltaBegin;
-                    ltaBegin.GetUTC();
-                    alarm_clock.set(mudconf.max_cmdsecs);
-                    CLinearTimeDelta ltdUsageBegin = GetProcessorUsage();
+    break_called = false;
+    while (  command
+          && !break_called)
+    {
+        mux_assert(!mudstate.poutnew);
+        mux_assert(!mudstate.poutbufc);
 
-                    UTF8 *log_cmdbuf = process_command(executor, point->caller,
-                        point->enactor, point->eval, false, cp, (const UTF8 **)point->env,
-                        point->nargs);
+        UTF8 *cp = parse_to(&command, ';', 0);
 
-                    CLinearTimeAbsolute ltaEnd;
-                    ltaEnd.GetUTC();
-                    if (alarm_clock.alarmed)
-                    {
-                        notify(executor, T("GAME: Expensive activity abbreviated."));
-                        s_Flags(point->enactor, FLAG_WORD1, Flags(point->enactor) | HALT);
-                        s_Flags(point->executor, FLAG_WORD1, Flags(point->executor) | HALT);
-                        halt_que(point->enactor, NOTHING);
-                        halt_que(executor, NOTHING);
-                    }
-                    alarm_clock.clear();
+        if (  cp
+           && *cp)
+        {
+            // Will command be piped?
+            //
+            if (  command
+               && *command == '|'
+               && mudstate.pipe_nest_lev < mudconf.ntfy_nest_lim)
+            {
+                command++;
+                mudstate.pipe_nest_lev++;
+                mudstate.inpipe = true;
+
+                mudstate.poutnew  = alloc_lbuf("process_command.pipe");
+                mudstate.poutbufc = mudstate.poutnew;
+                mudstate.poutobj  = executor;
+            }
+            else
+            {
+                mudstate.inpipe = false;
+                mudstate.poutobj = NOTHING;
+            }
 
-                    CLinearTimeDelta ltdUsageEnd = GetProcessorUsage();
-                    CLinearTimeDelta ltd = ltdUsageEnd - ltdUsageBegin;
-                    db[executor].cpu_time_used += ltd;
+            CLinearTimeAbsolute ltaBegin;
+            ltaBegin.GetUTC();
+            alarm_clock.set(mudconf.max_cmdsecs);
+            CLinearTimeDelta ltdUsageBegin = GetProcessorUsage();
 
-                    ltd = ltaEnd - ltaBegin;
-                    if (mudconf.rpt_cmdsecs < ltd)
-                    {
-                        STARTLOG(LOG_PROBLEMS, "CMD", "CPU");
-                        log_name_and_loc(executor);
-                        UTF8 *logbuf = alloc_lbuf("do_top.LOG.cpu");
-                        mux_sprintf(logbuf, LBUF_SIZE, T(" queued command taking %s secs (enactor #%d): "),
-                            ltd.ReturnSecondsString(4), point->enactor);
-                        log_text(logbuf);
-                        free_lbuf(logbuf);
-                        log_text(log_cmdbuf);
-                        ENDLOG;
-                    }
-                }
+            UTF8 *log_cmdbuf = process_command(executor, point->caller,
+                point->enactor, point->eval, false, cp, env,
+                point->nargs);
 
-                // Transition %| value.
-                //
-                if (mudstate.pout)
-                {
-                    free_lbuf(mudstate.pout);
-                    mudstate.pout = nullptr;
-                }
-                if (mudstate.poutnew)
-                {
-                    *mudstate.poutbufc = '\0';
-                    mudstate.pout = mudstate.poutnew;
-                    mudstate.poutnew  = nullptr;
-                    mudstate.poutbufc = nullptr;
-                }
+            CLinearTimeAbsolute ltaEnd;
+            ltaEnd.GetUTC();
+            if (alarm_clock.alarmed)
+            {
+                notify(executor, T("GAME: Expensive activity abbreviated."));
+                s_Flags(point->enactor, FLAG_WORD1, Flags(point->enactor) | HALT);
+                s_Flags(point->executor, FLAG_WORD1, Flags(point->executor) | HALT);
+                halt_que(point->enactor, NOTHING);
+                halt_que(executor, NOTHING);
             }
+            alarm_clock.clear();
 
-            // Clean up %| value.
-            //
-            if (mudstate.pout)
+            CLinearTimeDelta ltdUsageEnd = GetProcessorUsage();
+            CLinearTimeDelta ltd = ltdUsageEnd - ltdUsageBegin;
+            db[executor].cpu_time_used += ltd;
+            ltdUsage += ltd;
+
+            ltd = ltaEnd - ltaBegin;
+            if (mudconf.rpt_cmdsecs < ltd)
             {
-                free_lbuf(mudstate.pout);
-                mudstate.pout = nullptr;
+                STARTLOG(LOG_PROBLEMS, "CMD", "CPU");
+                log_name_and_loc(executor);
+                UTF8 *logbuf = alloc_lbuf("do_top.LOG.cpu");
+                mux_sprintf(logbuf, LBUF_SIZE, T(" queued command taking %s secs (enactor #%d): "),
+                    ltd.ReturnSecondsString(4), point->enactor);
+                log_text(logbuf);
+                free_lbuf(logbuf);
+                log_text(log_cmdbuf);
+                ENDLOG;
             }
-            mudstate.pipe_nest_lev = 0;
-            mudstate.inpipe = false;
-            mudstate.poutobj = NOTHING;
+        }
+
+        // Transition %| value.
+        //
+        if (mudstate.pout)
+        {
+            free_lbuf(mudstate.pout);
+            mudstate.pout = nullptr;
+        }
+        if (mudstate.poutnew)
+        {
+            *mudstate.poutbufc = '\0';
+            mudstate.pout = mudstate.poutnew;
+            mudstate.poutnew  = nullptr;
+            mudstate.poutbufc = nullptr;
         }
     }
 
-    for (int i = 0; i < MAX_GLOBAL_REGS; i++)
+    // Clean up %| value.
+    //
+    if (mudstate.pout)
     {
-        if (point->scr[i])
-        {
-            RegRelease(point->scr[i]);
-            point->scr[i] = nullptr;
-        }
+        free_lbuf(mudstate.pout);
+        mudstate.pout = nullptr;
+    }
+    mudstate.pipe_nest_lev = 0;
+    mudstate.inpipe = false;
+    mudstate.poutobj = NOTHING;
+    return ltdUsage;
+}
 
+// Lets go of the registers and SQL results the last entry left behind.
+//
+static void que_clear_state(void)
+{
+    for (int i = 0; i < MAX_GLOBAL_REGS; i++)
+    {
         if (mudstate.global_regs[i])
         {
             RegRelease(mudstate.global_regs[i]);
@@ -250,10 +795,35 @@ static void Task_RunQueueEntry(void *pEntry, int iUnused)
         mudstate.pResultsSet = nullptr;
     }
 #endif // STUB_SLAVE
+}
+
+// This Task takes pEntry out of the indexes before running it.  Its task
+// has already been taken off of the scheduler.
+//
+static void Task_RunQueueEntry(void *pEntry, int iUnused)
+{
+    UNUSED_PARAMETER(iUnused);
+
+    BQUE *point = (BQUE *)pEntry;
+    que_started(point, point->pTask);
+    unindex_que(point);
 
-    MEMFREE(point->text);
-    point->text = nullptr;
-    free_qentry(point);
+    dbref executor = point->executor;
+    if (  Good_obj(executor)
+       && !Going(executor))
+    {
+        giveto(executor, mudconf.waitcost);
+        mudstate.curr_enactor = point->enactor;
+        mudstate.curr_executor = executor;
+        a_Queue(Owner(executor), -1);
+        point->executor = NOTHING;
+        if (!Halted(executor))
+        {
+            que_charge(point, que_run_commands(point, executor));
+        }
+    }
+    que_clear_state();
+    free_que(point);
 }
 
 // ---------------------------------------------------------------------------
@@ -277,6 +847,8 @@ static void Task_SemaphoreTimeout(void *pExpired, int iUnused)
     // A semaphore has timed out.
     //
     BQUE *point = (BQUE *)pExpired;
+    que_started(point, point->pTask);
+    unindex_que(point);
     add_to(point->u.s.sem, -1, point->u.s.attr);
     point->u.s.sem = NOTHING;
     Task_RunQueueEntry(point, 0);
@@ -298,6 +870,38 @@ static int   Halt_Entries;
 static dbref Halt_Player_Run;
 static dbref Halt_Entries_Run;
 
+// Discards an entry that has been taken out of the indexes and off of the
+// scheduler.
+//
+static void halt_entry(BQUE *point, bool bSemaphore)
+{
+    // Accounting for pennies and queue quota.
+    //
+    dbref dbOwner = point->executor;
+    if (!isPlayer(dbOwner))
+    {
+        dbOwner = Owner(dbOwner);
+    }
+    if (dbOwner != Halt_Player_Run)
+    {
+        if (Halt_Player_Run != NOTHING)
+        {
+            giveto(Halt_Player_Run, mudconf.waitcost * Halt_Entries_Run);
+            a_Queue(Halt_Player_Run, -Halt_Entries_Run);
+        }
+        Halt_Player_Run = dbOwner;
+        Halt_Entries_Run = 0;
+    }
+    Halt_Entries++;
+    Halt_Entries_Run++;
+    if (bSemaphore)
+    {
+        add_to(point->u.s.sem, -1, point->u.s.attr);
+    }
+
+    free_que(point);
+}
+
 static int CallBack_HaltQueue(PTASK_RECORD p)
 {
     if (  p->fpTask == Task_RunQueueEntry
@@ -309,48 +913,34 @@ static int CallBack_HaltQueue(PTASK_RECORD p)
         BQUE *point = (BQUE *)(p->arg_voidptr);
         if (que_want(point, Halt_Player_Target, Halt_Object_Target))
         {
-            // Accounting for pennies and queue quota.
-            //
-            dbref dbOwner = point->executor;
-            if (!isPlayer(dbOwner))
-            {
-                dbOwner = Owner(dbOwner);
-            }
-            if (dbOwner != Halt_Player_Run)
-            {
-                if (Halt_Player_Run != NOTHING)
-                {
-                    giveto(Halt_Player_Run, mudconf.waitcost * Halt_Entries_Run);
-                    a_Queue(Halt_Player_Run, -Halt_Entries_Run);
-                }
-                Halt_Player_Run = dbOwner;
-                Halt_Entries_Run = 0;
-            }
-            Halt_Entries++;
-            Halt_Entries_Run++;
-            if (p->fpTask == Task_SemaphoreTimeout)
-            {
-                add_to(point->u.s.sem, -1, point->u.s.attr);
-            }
-
-            for (int i = 0; i < MAX_GLOBAL_REGS; i++)
-            {
-                if (point->scr[i])
-                {
-                    RegRelease(point->scr[i]);
-                    point->scr[i] = nullptr;
-                }
-            }
-
-            MEMFREE(point->text);
-            point->text = nullptr;
-            free_qentry(point);
+            unindex_que(point);
+            halt_entry(point, p->fpTask == Task_SemaphoreTimeout);
             return IU_REMOVE_TASK;
         }
     }
     return IU_NEXT_TASK;
 }
 
+// Halts the wanted entries on one index list.
+//
+static void halt_list(int iIndex, dbref key)
+{
+    BQUE *point = que_first(iIndex, key);
+    while (nullptr != point)
+    {
+        BQUE *next = point->links[iIndex].next;
+        if (que_want(point, Halt_Player_Target, Halt_Object_Target))
+        {
+            PTASK_RECORD pTask = point->pTask;
+            bool bSemaphore = (Task_SemaphoreTimeout == pTask->fpTask);
+            unindex_que(point);
+            scheduler.CancelTask(pTask);
+            halt_entry(point, bSemaphore);
+        }
+        point = next;
+    }
+}
+
 // ------------------------------------------------------------------
 //
 // halt_que: Remove all queued commands that match (executor, object).
@@ -369,9 +959,21 @@ int halt_que(dbref executor, dbref object)
     Halt_Player_Run    = NOTHING;
     Halt_Entries_Run   = 0;
 
-    // Process @wait, timed semaphores, and untimed semaphores.
+    // Process @wait, timed semaphores, and untimed semaphores.  Only
+    // halting everything needs to look at every task.
     //
-    scheduler.TraverseUnordered(CallBack_HaltQueue);
+    if (NOTHING != object)
+    {
+        halt_list(QUE_BY_EXECUTOR, object);
+    }
+    else if (NOTHING != executor)
+    {
+        halt_list(QUE_BY_OWNER, executor);
+    }
+    else
+    {
+        scheduler.TraverseUnordered(CallBack_HaltQueue);
+    }
 
     if (Halt_Player_Run != NOTHING)
     {
@@ -457,110 +1059,47 @@ void do_halt(dbref executor, dbref caller, dbref enactor, int eval, int key, UTF
     notify(Owner(executor), tprintf(T("%d queue entr%s removed."), numhalted, numhalted == 1 ? "y" : "ies"));
 }
 
-static int Notify_Key;
-static int Notify_Num_Done;
-static int Notify_Num_Max;
-static int Notify_Sem;
-static int Notify_Attr;
-
-// NFY_DRAIN or NFY_NFYALL
+// Lets a semaphore entry run.  The priority may have been PRIORITY_SUSPEND,
+// so we need to change it.
 //
-static int CallBack_NotifySemaphoreDrainOrAll(PTASK_RECORD p)
+static void release_semaphore(BQUE *point)
 {
-    if (p->fpTask == Task_SemaphoreTimeout)
+    PTASK_RECORD pTask = point->pTask;
+    retask_que(point, Task_RunQueueEntry);
+    if (isPlayer(point->enactor))
     {
-        // This represents a semaphore.
-        //
-        BQUE *point = (BQUE *)(p->arg_voidptr);
-        if (  point->u.s.sem == Notify_Sem
-           && (  point->u.s.attr == Notify_Attr
-              || !Notify_Attr))
-        {
-            Notify_Num_Done++;
-            if (NFY_DRAIN == (Notify_Key & NFY_MASK))
-            {
-                // Discard the command
-                //
-                giveto(point->executor, mudconf.waitcost);
-                a_Queue(Owner(point->executor), -1);
-
-                for (int i = 0; i < MAX_GLOBAL_REGS; i++)
-                {
-                    if (point->scr[i])
-                    {
-                        RegRelease(point->scr[i]);
-                        point->scr[i] = nullptr;
-                    }
-                }
-
-                MEMFREE(point->text);
-                point->text = nullptr;
-                free_qentry(point);
-
-                return IU_REMOVE_TASK;
-            }
-            else
-            {
-                // Allow the command to run. The priority may have been
-                // PRIORITY_SUSPEND, so we need to change it.
-                //
-                if (isPlayer(point->enactor))
-                {
-                    p->iPriority = PRIORITY_PLAYER;
-                }
-                else
-                {
-                    p->iPriority = PRIORITY_OBJECT;
-                }
-                p->ltaWhen.GetUTC();
-                p->fpTask = Task_RunQueueEntry;
-                return IU_UPDATE_TASK;
-            }
-        }
+        pTask->iPriority = PRIORITY_PLAYER;
     }
-    return IU_NEXT_TASK;
+    else
+    {
+        pTask->iPriority = PRIORITY_OBJECT;
+    }
+    pTask->ltaWhen.GetUTC();
+    if (scheduler.IsReady(pTask))
+    {
+        que_ready(pTask);
+    }
+    scheduler.UpdateTask(pTask);
 }
 
-// NFY_NFY
+// Discards a semaphore entry for @drain.
 //
-static int CallBack_NotifySemaphoreFirst(PTASK_RECORD p)
+static void drain_semaphore(BQUE *point)
 {
-    // If we've notified enough, exit.
-    //
-    if (  NFY_NFY == (Notify_Key & NFY_MASK)
-       && Notify_Num_Done >= Notify_Num_Max)
-    {
-        return IU_DONE;
-    }
+    PTASK_RECORD pTask = point->pTask;
+    unindex_que(point);
+    scheduler.CancelTask(pTask);
 
-    if (p->fpTask == Task_SemaphoreTimeout)
-    {
-        // This represents a semaphore.
-        //
-        BQUE *point = (BQUE *)(p->arg_voidptr);
-        if (  point->u.s.sem == Notify_Sem
-           && (  point->u.s.attr == Notify_Attr
-              || !Notify_Attr))
-        {
-            Notify_Num_Done++;
+    giveto(point->executor, mudconf.waitcost);
+    a_Queue(Owner(point->executor), -1);
 
-            // Allow the command to run. The priority may have been
-            // PRIORITY_SUSPEND, so we need to change it.
-            //
-            if (isPlayer(point->enactor))
-            {
-                p->iPriority = PRIORITY_PLAYER;
-            }
-            else
-            {
-                p->iPriority = PRIORITY_OBJECT;
-            }
-            p->ltaWhen.GetUTC();
-            p->fpTask = Task_RunQueueEntry;
-            return IU_UPDATE_TASK;
-        }
-    }
-    return IU_NEXT_TASK;
+    free_que(point);
+}
+
+static bool sem_want(BQUE *point, int attr)
+{
+    return (  0 == attr
+           || point->u.s.attr == attr);
 }
 
 // ---------------------------------------------------------------------------
@@ -578,20 +1117,67 @@ int nfy_que(dbref sem, int attr, int key, int count)
         free_lbuf(str);
     }
 
-    Notify_Num_Done = 0;
+    int nDone = 0;
     if (0 < cSemaphore)
     {
-        Notify_Key     = key;
-        Notify_Sem     = sem;
-        Notify_Attr    = attr;
-        Notify_Num_Max = count;
         if (NFY_NFY == (key & NFY_MASK))
         {
-            scheduler.TraverseOrdered(CallBack_NotifySemaphoreFirst);
+            // The waiters are released in the order the scheduler would
+            // have visited them, so gather and sort them first.
+            //
+            int nWaiters = 0;
+            BQUE *point;
+            for (point = que_first(QUE_BY_SEMAPHORE, sem); nullptr != point; point = point->links[QUE_BY_SEMAPHORE].next)
+            {
+                if (sem_want(point, attr))
+                {
+                    nWaiters++;
+                }
+            }
+
+            if (0 < nWaiters)
+            {
+                BQUE **aWaiters = (BQUE **)MEMALLOC(nWaiters * sizeof(BQUE *));
+                ISOUTOFMEMORY(aWaiters);
+
+                int i = 0;
+                for (point = que_first(QUE_BY_SEMAPHORE, sem); nullptr != point; point = point->links[QUE_BY_SEMAPHORE].next)
+                {
+                    if (sem_want(point, attr))
+                    {
+                        aWaiters[i++] = point;
+                    }
+                }
+                qsort(aWaiters, nWaiters, sizeof(BQUE *), que_compare_ordered);
+
+                for (i = 0; i < nWaiters && nDone < count; i++)
+                {
+                    release_semaphore(aWaiters[i]);
+                    nDone++;
+                }
+                MEMFREE(aWaiters);
+            }
         }
         else
         {
-            scheduler.TraverseUnordered(CallBack_NotifySemaphoreDrainOrAll);
+            BQUE *point = que_first(QUE_BY_SEMAPHORE, sem);
+            while (nullptr != point)
+            {
+                BQUE *next = point->links[QUE_BY_SEMAPHORE].next;
+                if (sem_want(point, attr))
+                {
+                    nDone++;
+                    if (NFY_DRAIN == (key & NFY_MASK))
+                    {
+                        drain_semaphore(point);
+                    }
+                    else
+                    {
+                        release_semaphore(point);
+                    }
+                }
+                point = next;
+            }
         }
     }
 
@@ -606,7 +1192,7 @@ int nfy_que(dbref sem, int attr, int key, int count)
         atr_clr(sem, attr);
     }
 
-    return Notify_Num_Done;
+    return nDone;
 }
 
 // ---------------------------------------------------------------------------
@@ -758,85 +1344,83 @@ static BQUE *setup_que
     // We passed all the tests.
     //
 
-    // Calculate the length of the save string.
+    // Calculate the length of the record.
     //
-    size_t tlen = 0;
-    static size_t nCommand;
+    size_t nCommand = 0;
     static size_t nLenEnv[NUM_ENV_VARS];
-
-    if (command)
-    {
-        nCommand = strlen((char *)command) + 1;
-        tlen = nCommand;
-    }
+    size_t tlen = sizeof(BQUE);
 
     if (NUM_ENV_VARS < nargs)
     {
         nargs = NUM_ENV_VARS;
     }
 
-    for (a = 0; a < nargs; a++)
+    int nRegs = 0;
+    if (sargs)
     {
-        if (args[a])
+        for (a = 0; a < MAX_GLOBAL_REGS; a++)
         {
-            nLenEnv[a] = strlen((char *)args[a]) + 1;
-            tlen += nLenEnv[a];
+            if (sargs[a])
+            {
+                nRegs++;
+            }
         }
-    }
-
-    // Create the qeue entry and load the save string.
-    //
-    BQUE *tmp = alloc_qentry("setup_que.qblock");
-    tmp->comm = nullptr;
-
-    UTF8 *tptr = tmp->text = (UTF8 *)MEMALLOC(tlen);
-    ISOUTOFMEMORY(tptr);
-
-    if (command)
-    {
-        memcpy(tptr, command, nCommand);
-        tmp->comm = tptr;
-        tptr += nCommand;
+        tlen += nRegs * sizeof(reg_ref *);
     }
 
     for (a = 0; a < nargs; a++)
     {
         if (args[a])
         {
-            memcpy(tptr, args[a], nLenEnv[a]);
-            tmp->env[a] = tptr;
-            tptr += nLenEnv[a];
-        }
-        else
-        {
-            tmp->env[a] = nullptr;
+            nLenEnv[a] = strlen((char *)args[a]) + 1;
+            tlen += nLenEnv[a];
         }
     }
 
-    for ( ; a < NUM_ENV_VARS; a++)
+    if (command)
     {
-        tmp->env[a] = nullptr;
+        nCommand = strlen((char *)command) + 1;
+        tlen += nCommand;
     }
 
+    // Create the queue entry and load the registers and text.
+    //
+    BQUE *tmp = alloc_que(tlen);
+    reg_ref **regs = que_regs(tmp);
+    tmp->fRegs = 0;
+    tmp->nRegs = static_cast<UINT8>(nRegs);
     if (sargs)
     {
         for (a = 0; a < MAX_GLOBAL_REGS; a++)
         {
-            tmp->scr[a] = sargs[a];
             if (sargs[a])
             {
+                tmp->fRegs |= UINT64_C(1) << a;
+                *regs++ = sargs[a];
                 RegAddRef(sargs[a]);
             }
         }
     }
-    else
+
+    UTF8 *tptr = (UTF8 *)regs;
+    tmp->fArgs = 0;
+    for (a = 0; a < nargs; a++)
     {
-        for (a = 0; a < MAX_GLOBAL_REGS; a++)
+        if (args[a])
         {
-            tmp->scr[a] = nullptr;
+            tmp->fArgs |= static_cast<UINT16>(1 << a);
+            memcpy(tptr, args[a], nLenEnv[a]);
+            tptr += nLenEnv[a];
         }
     }
 
+    tmp->comm = nullptr;
+    if (command)
+    {
+        memcpy(tptr, command, nCommand);
+        tmp->comm = tptr;
+    }
+
 #if defined(STUB_SLAVE)
     tmp->iRow = mudstate.iRow;
     tmp->pResultsSet = mudstate.pResultsSet;
@@ -849,7 +1433,9 @@ static BQUE *setup_que
     // Load the rest of the queue block.
     //
     tmp->executor = executor;
+    tmp->pTask = nullptr;
     tmp->IsTimed = false;
+    tmp->IsReady = false;
     tmp->u.s.sem = NOTHING;
     tmp->u.s.attr = 0;
     tmp->enactor = enactor;
@@ -915,11 +1501,11 @@ void wait_que
         //
         if (tmp->IsTimed)
         {
-            scheduler.DeferTask(tmp->waittime, iPriority, Task_RunQueueEntry, tmp, 0);
+            index_que(tmp, scheduler.DeferTask(tmp->waittime, iPriority, Task_RunQueueEntry, tmp, 0));
         }
         else
         {
-            scheduler.DeferImmediateTask(iPriority, Task_RunQueueEntry, tmp, 0);
+            index_que(tmp, scheduler.DeferImmediateTask(iPriority, Task_RunQueueEntry, tmp, 0));
         }
     }
     else
@@ -932,7 +1518,7 @@ void wait_que
             //
             iPriority = PRIORITY_SUSPEND;
         }
-        scheduler.DeferTask(tmp->waittime, iPriority, Task_SemaphoreTimeout, tmp, 0);
+        index_que(tmp, scheduler.DeferTask(tmp->waittime, iPriority, Task_SemaphoreTimeout, tmp, 0));
     }
 }
 
@@ -957,13 +1543,17 @@ static int CallBack_QueryComplete(PTASK_RECORD p)
         {
             p->iPriority = PRIORITY_OBJECT;
             p->ltaWhen.GetUTC();
-            p->fpTask    = Task_RunQueueEntry;
+            retask_que(point, Task_RunQueueEntry);
 
             point->u.s.sem    = NOTHING;
             point->u.s.attr   = 0;
             QueryComplete_prsResultsSet->AddRef();
             point->pResultsSet = QueryComplete_prsResultsSet;
             point->iRow = RS_TOP;
+            if (scheduler.IsReady(p))
+            {
+                que_ready(p);
+            }
 
             QueryComplete_bDone = true;
             return IU_UPDATE_TASK;
@@ -1039,7 +1629,7 @@ void sql_que
 
     tmp->u.hQuery = hQuery;
 
-    scheduler.DeferTask(tmp->waittime, PRIORITY_SUSPEND, Task_SQLTimeout, tmp, 0);
+    index_que(tmp, scheduler.DeferTask(tmp->waittime, PRIORITY_SUSPEND, Task_SQLTimeout, tmp, 0));
     MUX_RESULT mr = mudstate.pIQueryControl->Query(hQuery, dbname, query);
     if (MUX_FAILED(mr))
     {
@@ -1254,6 +1844,10 @@ static int CallBack_ShowDispatches(PTASK_RECORD p)
     {
         notify(Show_Player, tprintf(T("[%d]auto-@dump"), ltd.ReturnSeconds()));
     }
+    else if (p->fpTask == dispatch_DatabaseSnapshot)
+    {
+        notify(Show_Player, tprintf(T("[%d]Incremental checkpoint"), ltd.ReturnSeconds()));
+    }
     else if (p->fpTask == dispatch_FreeListReconstruction)
     {
         notify(Show_Player, tprintf(T("[%d]auto-@dbck"), ltd.ReturnSeconds()));
@@ -1275,6 +1869,10 @@ static int CallBack_ShowDispatches(PTASK_RECORD p)
     {
         notify(Show_Player, tprintf(T("[%d]Database cache tick"), ltd.ReturnSeconds()));
     }
+    else if (p->fpTask == dispatch_WalCommit)
+    {
+        notify(Show_Player, tprintf(T("[%d]Write-ahead log commit"), ltd.ReturnSeconds()));
+    }
 #endif
     else if (p->fpTask == Task_ProcessCommand)
     {
@@ -1321,14 +1919,16 @@ static void ShowPsLine(BQUE *tmp)
     UTF8 *bp = bufp;
     if (Show_Key == PS_LONG)
     {
+        const UTF8 *env[NUM_ENV_VARS];
+        que_args(tmp, env);
         for (int i = 0; i < tmp->nargs; i++)
         {
-            if (tmp->env[i] != nullptr)
+            if (env[i] != nullptr)
             {
                 safe_str(T("; Arg"), bufp, &bp);
                 safe_chr((UTF8)(i + '0'), bufp, &bp);
                 safe_str(T("=\xE2\x80\x98"), bufp, &bp);
-                safe_str(tmp->env[i], bufp, &bp);
+                safe_str(env[i], bufp, &bp);
                 safe_str(T("\xE2\x80\x99"), bufp, &bp);
             }
         }
@@ -1418,6 +2018,72 @@ int CallBack_ShowSQLQueries(PTASK_RECORD p)
     return IU_NEXT_TASK;
 }
 
+// Shows the entries for one executor or owner from the indexes instead of
+// sorting the whole scheduler.  The totals come from the running counts.
+//
+static void ShowIndexed(dbref executor_targ, dbref obj_targ)
+{
+    int iIndex = QUE_BY_OWNER;
+    dbref key = executor_targ;
+    if (NOTHING != obj_targ)
+    {
+        iIndex = QUE_BY_EXECUTOR;
+        key = obj_targ;
+    }
+
+    int nEntries = 0;
+    BQUE *point;
+    for (point = que_first(iIndex, key); nullptr != point; point = point->links[iIndex].next)
+    {
+        if (que_want(point, executor_targ, obj_targ))
+        {
+            nEntries++;
+        }
+    }
+
+    if (0 < nEntries)
+    {
+        BQUE **aEntries = (BQUE **)MEMALLOC(nEntries * sizeof(BQUE *));
+        ISOUTOFMEMORY(aEntries);
+
+        int i = 0;
+        for (point = que_first(iIndex, key); nullptr != point; point = point->links[iIndex].next)
+        {
+            if (que_want(point, executor_targ, obj_targ))
+            {
+                aEntries[i++] = point;
+            }
+        }
+        qsort(aEntries, nEntries, sizeof(BQUE *), que_compare_ordered);
+
+        // Showing a line can trigger a listener which queues a command,
+        // and that can halt the very entries being shown.  If anything
+        // leaves the queue, the array can no longer be trusted.
+        //
+        int nRemovals = Queue_Removals;
+        Show_bFirstLine = true;
+        for (i = 0; i < nEntries && nRemovals == Queue_Removals; i++)
+        {
+            CallBack_ShowWait(aEntries[i]->pTask);
+        }
+        Show_bFirstLine = true;
+        for (i = 0; i < nEntries && nRemovals == Queue_Removals; i++)
+        {
+            CallBack_ShowSemaphore(aEntries[i]->pTask);
+        }
+        Show_bFirstLine = true;
+        for (i = 0; i < nEntries && nRemovals == Queue_Removals; i++)
+        {
+            CallBack_ShowSQLQueries(aEntries[i]->pTask);
+        }
+        MEMFREE(aEntries);
+    }
+
+    Total_RunQueueEntry = Queue_Waits;
+    Total_SemaphoreTimeout = Queue_Semaphores;
+    Total_SQLTimeout = Queue_Queries;
+}
+
 // ---------------------------------------------------------------------------
 // do_ps: tell executor what commands they have pending in the queue
 //
@@ -1500,12 +2166,20 @@ void do_ps(dbref executor, dbref caller, dbref enactor, int eval, int key, UTF8
     Show_Object_Target = obj_targ;
     Show_Key = key;
     Show_Player = executor;
-    Show_bFirstLine = true;
-    scheduler.TraverseOrdered(CallBack_ShowWait);
-    Show_bFirstLine = true;
-    scheduler.TraverseOrdered(CallBack_ShowSemaphore);
-    Show_bFirstLine = true;
-    scheduler.TraverseOrdered(CallBack_ShowSQLQueries);
+    if (  NOTHING == executor_targ
+       && NOTHING == obj_targ)
+    {
+        Show_bFirstLine = true;
+        scheduler.TraverseOrdered(CallBack_ShowWait);
+        Show_bFirstLine = true;
+        scheduler.TraverseOrdered(CallBack_ShowSemaphore);
+        Show_bFirstLine = true;
+        scheduler.TraverseOrdered(CallBack_ShowSQLQueries);
+    }
+    else
+    {
+        ShowIndexed(executor_targ, obj_targ);
+    }
     if (Wizard(executor))
     {
         notify(executor, T("----- System Queue -----"));
@@ -1520,11 +2194,46 @@ void do_ps(dbref executor, dbref caller, dbref enactor, int eval, int key, UTF8
         Shown_SemaphoreTimeout, Total_SemaphoreTimeout,
         Shown_SQLTimeout, Total_SQLTimeout);
     notify(executor, bufp);
+
     if (Wizard(executor))
     {
         mux_sprintf(bufp, MBUF_SIZE, T("        System Tasks.....%d"), Total_SystemTasks);
         notify(executor, bufp);
     }
+
+    // Show the owner's share of the queue, or for /all, the shares of owners
+    // with entries ready to run.
+    //
+    if (NOTHING != executor_targ)
+    {
+        QUE_SHARE *ps = (QUE_SHARE *)hashfindLEN(&executor_targ, sizeof(executor_targ),
+            &mudstate.queue_share_htab);
+        if (nullptr != ps)
+        {
+            notify(executor, Share_Header);
+            que_share_line(bufp, ps);
+            notify(executor, bufp);
+        }
+    }
+    else
+    {
+        bool bHeader = false;
+        for (QUE_SHARE *ps = (QUE_SHARE *)hash_firstentry(&mudstate.queue_share_htab);
+             nullptr != ps;
+             ps = (QUE_SHARE *)hash_nextentry(&mudstate.queue_share_htab))
+        {
+            if (0 < ps->nReady)
+            {
+                if (!bHeader)
+                {
+                    notify(executor, Share_Header);
+                    bHeader = true;
+                }
+                que_share_line(bufp, ps);
+                notify(executor, bufp);
+            }
+        }
+    }
     free_mbuf(bufp);
 }
 
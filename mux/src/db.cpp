@@ -1654,46 +1654,24 @@ bool Commer(dbref thing)
 
     bool bFoundListens = false;
 
-    atr_push();
-    UTF8 *buff = alloc_lbuf("Commer");
-    unsigned char *as;
-    for (int atr = atr_head(thing, &as); atr; atr = atr_next(&as))
+    int nCmds;
+    const ATRCMD *list = atr_cmd_list(thing, &nCmds);
+    for (int i = 0; i < nCmds; i++)
     {
-        ATTR *ap = atr_num(atr);
-        if (  !ap
-           || (ap->flags & AF_NOPROG))
+        if ('\0' == list[i].type)
         {
             continue;
         }
 
-        int   aflags;
-        dbref aowner;
-
-        atr_get_str(buff, thing, atr, &aowner, &aflags);
-
-        if (aflags & AF_NOPROG)
-        {
-            continue;
-        }
-
-        if (  AMATCH_CMD != buff[0]
-           && AMATCH_LISTEN != buff[0])
-        {
-            continue;
-        }
-
-        // Search for unescaped ':'
-        //
-        UTF8 *s = (UTF8 *)strchr((char *)buff+1, ':');
-        if (!s)
+        ATTR *ap = atr_num(list[i].number);
+        if (  !ap
+           || (ap->flags & AF_NOPROG))
         {
             continue;
         }
 
-        if (AMATCH_CMD == buff[0])
+        if (AMATCH_CMD == list[i].type)
         {
-            free_lbuf(buff);
-            atr_pop();
             mudstate.bfCommands.Set(thing);
             if (bFoundListens)
             {
@@ -1702,13 +1680,11 @@ bool Commer(dbref thing)
             }
             return true;
         }
-        else // AMATCH_LISTEN == buff[0]
+        else // AMATCH_LISTEN == list[i].type
         {
             bFoundListens = true;
         }
     }
-    free_lbuf(buff);
-    atr_pop();
     mudstate.bfNoCommands.Set(thing);
     if (bFoundListens)
     {
@@ -2016,12 +1992,223 @@ static void atr_decode_LEN(const UTF8 *iattr, size_t nLen, UTF8 *oattr,
     }
 }
 
+/* ---------------------------------------------------------------------------
+ * Command index: Track the $-command and ^-listen attributes of an object.
+ *
+ * The index is built the first time an object is searched for commands and
+ * is kept current by atr_add_raw_LEN() and atr_clr() afterwards.  Command
+ * matching can then visit only the attributes which might match instead of
+ * fetching and decoding every attribute on the object.
+ */
+
+// Find where atr belongs in the index. Returns true if it is already there.
+//
+static bool atrcmd_search(dbref thing, int atr, int *piWhere)
+{
+    ATRCMD *list = db[thing].pCmdHead;
+    int lo = 0;
+    int hi = db[thing].nCmdUsed - 1;
+    while (lo <= hi)
+    {
+        int mid = ((hi - lo) >> 1) + lo;
+        if (list[mid].number > atr)
+        {
+            hi = mid - 1;
+        }
+        else if (list[mid].number < atr)
+        {
+            lo = mid + 1;
+        }
+        else // if (list[mid].number == atr)
+        {
+            *piWhere = mid;
+            return true;
+        }
+    }
+    *piWhere = lo;
+    return false;
+}
+
+static void atrcmd_remove(dbref thing, int atr)
+{
+    int i;
+    if (atrcmd_search(thing, atr, &i))
+    {
+        if (db[thing].pCmdHead[i].pattern)
+        {
+            MEMFREE(db[thing].pCmdHead[i].pattern);
+        }
+        db[thing].nCmdUsed--;
+        if (i < db[thing].nCmdUsed)
+        {
+            memmove( db[thing].pCmdHead + i,
+                     db[thing].pCmdHead + i + 1,
+                     (db[thing].nCmdUsed - i) * sizeof(ATRCMD));
+        }
+    }
+}
+
+// Add, replace, or remove the index entry for an attribute given its raw
+// (encoded) value.
+//
+static void atrcmd_update(dbref thing, int atr, const UTF8 *pValue, size_t nValue)
+{
+    atrcmd_remove(thing, atr);
+
+    dbref aowner;
+    int   aflags;
+    const UTF8 *pText = atr_decode_flags_owner(pValue, &aowner, &aflags);
+    size_t nText = nValue - (pText - pValue);
+
+    UTF8 type = '\0';
+    const UTF8 *pColon = nullptr;
+    if (  0 == (aflags & AF_NOPROG)
+       && (  AMATCH_CMD    == pText[0]
+          || AMATCH_LISTEN == pText[0]))
+    {
+        pColon = (UTF8 *)strchr((char *)pText+1, ':');
+        if (pColon)
+        {
+            type = pText[0];
+        }
+    }
+
+    if (  '\0' == type
+       && 0 == (aflags & AF_PRIVATE))
+    {
+        return;
+    }
+
+    if (db[thing].nCmdUsed == db[thing].nCmdAlloc)
+    {
+        int nAlloc = GrowFiftyPercent(db[thing].nCmdAlloc, 4, INT_MAX);
+        ATRCMD *list = (ATRCMD *)MEMALLOC(nAlloc * sizeof(ATRCMD));
+        ISOUTOFMEMORY(list);
+        if (db[thing].pCmdHead)
+        {
+            memcpy(list, db[thing].pCmdHead, db[thing].nCmdUsed * sizeof(ATRCMD));
+            MEMFREE(db[thing].pCmdHead);
+        }
+        db[thing].pCmdHead  = list;
+        db[thing].nCmdAlloc = nAlloc;
+    }
+
+    int i;
+    atrcmd_search(thing, atr, &i);
+    if (i < db[thing].nCmdUsed)
+    {
+        memmove( db[thing].pCmdHead + i + 1,
+                 db[thing].pCmdHead + i,
+                 (db[thing].nCmdUsed - i) * sizeof(ATRCMD));
+    }
+    db[thing].nCmdUsed++;
+
+    ATRCMD *pc = db[thing].pCmdHead + i;
+    pc->number  = atr;
+    pc->flags   = aflags;
+    pc->type    = type;
+    pc->pattern = nullptr;
+    pc->action  = nullptr;
+    if ('\0' != type)
+    {
+        // Keep the pattern (without the leadin character) and the action
+        // as two strings in one allocation.
+        //
+        pc->pattern = StringCloneLen(pText + 1, nText - 1);
+        size_t iColon = pColon - (pText + 1);
+        pc->pattern[iColon] = '\0';
+        pc->action = pc->pattern + iColon + 1;
+    }
+}
+
+static void atrcmd_free(dbref thing)
+{
+    for (int i = 0; i < db[thing].nCmdUsed; i++)
+    {
+        if (db[thing].pCmdHead[i].pattern)
+        {
+            MEMFREE(db[thing].pCmdHead[i].pattern);
+        }
+    }
+    if (db[thing].pCmdHead)
+    {
+        MEMFREE(db[thing].pCmdHead);
+    }
+    db[thing].pCmdHead    = nullptr;
+    db[thing].nCmdAlloc   = 0;
+    db[thing].nCmdUsed    = 0;
+    db[thing].bCmdIndexed = false;
+}
+
+/*! \brief Return the command index of an object, building it if necessary.
+ *
+ * The returned list is only valid until the next attribute write on the
+ * object.
+ *
+ * \param thing     Object.
+ * \param pnCmds    Receives the number of entries.
+ * \return          List sorted by attribute number.
+ */
+
+const ATRCMD *atr_cmd_list(dbref thing, int *pnCmds)
+{
+    if (!db[thing].bCmdIndexed)
+    {
+        atrcmd_free(thing);
+
+        atr_push();
+        unsigned char *as;
+        for (int atr = atr_head(thing, &as); atr; atr = atr_next(&as))
+        {
+            size_t nValue;
+            const UTF8 *pValue = atr_get_raw_LEN(thing, atr, &nValue);
+            if (pValue)
+            {
+                atrcmd_update(thing, atr, pValue, nValue);
+            }
+        }
+        atr_pop();
+        db[thing].bCmdIndexed = true;
+    }
+    *pnCmds = db[thing].nCmdUsed;
+    return db[thing].pCmdHead;
+}
+
+/*! \brief Look up a single attribute in the command index of an object.
+ *
+ * \param thing     Object.
+ * \param atr       Attribute number.
+ * \return          Index entry or nullptr if the attribute is neither a
+ *                  command nor AF_PRIVATE.
+ */
+
+const ATRCMD *atr_cmd_find(dbref thing, int atr)
+{
+    int nCmds;
+    atr_cmd_list(thing, &nCmds);
+
+    int i;
+    if (  0 < nCmds
+       && atrcmd_search(thing, atr, &i))
+    {
+        return db[thing].pCmdHead + i;
+    }
+    return nullptr;
+}
+
 /* ---------------------------------------------------------------------------
  * atr_clr: clear an attribute in the list.
  */
 
 void atr_clr(dbref thing, int atr)
 {
+    regexp_cache_invalidate(thing, atr);
+    lock_cache_invalidate(thing, atr);
+    if (db[thing].bCmdIndexed)
+    {
+        atrcmd_remove(thing, atr);
+    }
+
 #ifdef MEMORY_BASED
 
     if (  !db[thing].nALUsed
@@ -2029,6 +2216,7 @@ void atr_clr(dbref thing, int atr)
     {
         return;
     }
+    SnapshotTouch(thing);
 
     mux_assert(0 <= db[thing].nALUsed);
 
@@ -2075,16 +2263,19 @@ void atr_clr(dbref thing, int atr)
     {
     case A_STARTUP:
 
+        SnapshotTouch(thing);
         db[thing].fs.word[FLAG_WORD1] &= ~HAS_STARTUP;
         break;
 
     case A_DAILY:
 
+        SnapshotTouch(thing);
         db[thing].fs.word[FLAG_WORD2] &= ~HAS_DAILY;
         break;
 
     case A_FORWARDLIST:
 
+        SnapshotTouch(thing);
         db[thing].fs.word[FLAG_WORD2] &= ~HAS_FWDLIST;
         if (!mudstate.bStandAlone)
         {
@@ -2096,6 +2287,7 @@ void atr_clr(dbref thing, int atr)
 
     case A_LISTEN:
 
+        SnapshotTouch(thing);
         db[thing].fs.word[FLAG_WORD2] &= ~HAS_LISTEN;
         break;
 
@@ -2133,7 +2325,15 @@ void atr_add_raw_LEN(dbref thing, int atr, const UTF8 *szValue, size_t nValue)
         return;
     }
 
+    regexp_cache_invalidate(thing, atr);
+    lock_cache_invalidate(thing, atr);
+    if (db[thing].bCmdIndexed)
+    {
+        atrcmd_update(thing, atr, szValue, nValue);
+    }
+
 #ifdef MEMORY_BASED
+    SnapshotTouch(thing);
     ATRLIST *list = db[thing].pALHead;
     UTF8 *text = StringCloneLen(szValue, nValue);
 
@@ -2266,21 +2466,25 @@ FoundAttribute:
     {
     case A_STARTUP:
 
+        SnapshotTouch(thing);
         db[thing].fs.word[FLAG_WORD1] |= HAS_STARTUP;
         break;
 
     case A_DAILY:
 
+        SnapshotTouch(thing);
         db[thing].fs.word[FLAG_WORD2] |= HAS_DAILY;
         break;
 
     case A_FORWARDLIST:
 
+        SnapshotTouch(thing);
         db[thing].fs.word[FLAG_WORD2] |= HAS_FWDLIST;
         break;
 
     case A_LISTEN:
 
+        SnapshotTouch(thing);
         db[thing].fs.word[FLAG_WORD2] |= HAS_LISTEN;
         break;
 
@@ -2571,6 +2775,12 @@ bool atr_pget_info(dbref thing, int atr, dbref *owner, int *flags)
 void atr_free(dbref thing)
 {
 #ifdef MEMORY_BASED
+    SnapshotTouch(thing);
+    for (int i = 0; i < db[thing].nALUsed; i++)
+    {
+        regexp_cache_invalidate(thing, db[thing].pALHead[i].number);
+        lock_cache_invalidate(thing, db[thing].pALHead[i].number);
+    }
     if (db[thing].pALHead)
     {
         MEMFREE(db[thing].pALHead);
@@ -2592,6 +2802,7 @@ void atr_free(dbref thing)
     }
     atr_clr(thing, A_LIST);
 #endif // MEMORY_BASED
+    atrcmd_free(thing);
 
     mudstate.bfCommands.Clear(thing);
     mudstate.bfNoCommands.Set(thing);
@@ -2919,6 +3130,7 @@ static void initialize_objects(dbref first, dbref last)
         s_ThAttrib(thing, 0);
         s_ThMail(thing, 0);
         s_ThRefs(thing, 0);
+        db[thing].epoch = 0;
 
 #ifdef MEMORY_BASED
         db[thing].pALHead  = nullptr;
@@ -2929,6 +3141,10 @@ static void initialize_objects(dbref first, dbref last)
 #endif // MEMORY_BASED
         db[thing].purename = nullptr;
         db[thing].moniker = nullptr;
+        db[thing].pCmdHead    = nullptr;
+        db[thing].nCmdAlloc   = 0;
+        db[thing].nCmdUsed    = 0;
+        db[thing].bCmdIndexed = false;
     }
 }
 
@@ -3366,6 +3582,99 @@ void *getstring_noalloc(FILE *f, bool new_strings, size_t *pnBuffer)
     }
 }
 
+/*! \brief Decodes a quoted string from a flatfile image in memory.
+ *
+ * This is the in-memory counterpart of getstring_noalloc() for V_QUOTED
+ * flatfiles and decodes to the same bytes.  It does not try to reproduce
+ * what getstring_noalloc() does with unusual input (embedded NULs, a
+ * missing opening quote, or strings longer than its buffer) and instead
+ * returns false so the caller can fall back to the stdio path.  The rest
+ * of the line after the closing quote is skipped.
+ *
+ * \param pp        Cursor.  Advanced past the string on success.
+ * \param pEnd      End of the image.
+ * \param pOutput   Receives the string. Must hold the raw length plus one.
+ * \param pnOutput  Receives the length of the decoded string.
+ * \return          true if the string was decoded.
+ */
+
+bool getstring_mem(const UTF8 **pp, const UTF8 *pEnd, UTF8 *pOutput, size_t *pnOutput)
+{
+    const UTF8 *pInput = *pp;
+    if (  pEnd <= pInput
+       || '"' != *pInput)
+    {
+        return false;
+    }
+    pInput++;
+
+    // getstring_noalloc() reads at most 2*LBUF_SIZE bytes without
+    // truncating.
+    //
+    const UTF8 *pLimit = pInput + 2*LBUF_SIZE;
+    if (pEnd < pLimit)
+    {
+        pLimit = pEnd;
+    }
+
+    UTF8 *pStart = pOutput;
+    int iState = STATE_START;
+    while (pInput < pLimit)
+    {
+        UTF8 ch = *pInput++;
+        int iAction = action_table[iState][decode_table[(unsigned char)ch]];
+        switch (iAction)
+        {
+        case 0:
+        case 2:
+            *pOutput++ = ch;
+            iState = STATE_START;
+            break;
+
+        case 1:
+            return false;
+
+        case 3:
+            {
+                const UTF8 *pEOL = (UTF8 *)memchr(pInput, '\n', pLimit - pInput);
+                if (nullptr == pEOL)
+                {
+                    return false;
+                }
+                *pOutput = '\0';
+                *pnOutput = pOutput - pStart;
+                *pp = pEOL + 1;
+            }
+            return true;
+
+        case 4:
+            iState = STATE_HAVE_ESC;
+            break;
+
+        case 5:
+            *pOutput++ = ESC_CHAR;
+            iState = STATE_START;
+            break;
+
+        case 6:
+            *pOutput++ = '\n';
+            iState = STATE_START;
+            break;
+
+        case 7:
+            *pOutput++ = '\r';
+            iState = STATE_START;
+            break;
+
+        default:
+            *pOutput++ = '\t';
+            iState = STATE_START;
+            break;
+        }
+    }
+    return false;
+}
+
 // Code 0 - Any byte.
 // Code 1 - NUL  (0x00)
 // Code 2 - '"'  (0x22)
@@ -3458,6 +3767,36 @@ int getref(FILE *f)
     }
 }
 
+/*! \brief Reads a number line from a flatfile image in memory.
+ *
+ * Like getref(), but returns false instead of guessing when the line is
+ * missing its line feed or is longer than getref() would read at once.
+ *
+ * \param pp      Cursor.  Advanced past the line on success.
+ * \param pEnd    End of the image.
+ * \param pValue  Receives the number.
+ * \return        true if a line was read.
+ */
+
+bool getref_mem(const UTF8 **pp, const UTF8 *pEnd, int *pValue)
+{
+    const UTF8 *p = *pp;
+    const UTF8 *pEOL = (UTF8 *)memchr(p, '\n', pEnd - p);
+    if (  nullptr == pEOL
+       || SBUF_SIZE - 1 < pEOL - p + 1)
+    {
+        return false;
+    }
+
+    UTF8 buf[SBUF_SIZE];
+    size_t n = pEOL - p;
+    memcpy(buf, p, n);
+    buf[n] = '\0';
+    *pValue = mux_atol(buf);
+    *pp = pEOL + 1;
+    return true;
+}
+
 void free_boolexp(BOOLEXP *b)
 {
     if (b == TRUE_BOOLEXP)
@@ -3524,13 +3863,13 @@ static BOOLEXP *dup_bool(BOOLEXP *b)
 }
 
 #ifndef MEMORY_BASED
-int init_dbfile(UTF8 *game_dir_file, UTF8 *game_pag_file, int nCachePages)
+int init_dbfile(UTF8 *game_dir_file, UTF8 *game_pag_file, int nCachePages, bool bMapped)
 {
     if (mudstate.bStandAlone)
     {
         Log.tinyprintf(T("Opening (%s,%s)" ENDLINE), game_dir_file, game_pag_file);
     }
-    int cc = cache_init(game_dir_file, game_pag_file, nCachePages);
+    int cc = cache_init(game_dir_file, game_pag_file, nCachePages, bMapped);
     if (cc != HF_OPEN_STATUS_ERROR)
     {
         if (mudstate.bStandAlone)
@@ -3544,6 +3883,14 @@ int init_dbfile(UTF8 *game_dir_file, UTF8 *game_pag_file, int nCachePages)
             Log.tinyprintf(T("Using game db files: (%s,%s)."), game_dir_file,
                 game_pag_file);
             ENDLOG;
+
+            if (  mudconf.write_ahead_log
+               && !cache_wal_open(mudconf.game_wal))
+            {
+                STARTLOG(LOG_ALWAYS, "INI", "LOAD");
+                Log.tinyprintf(T("Couldn\xE2\x80\x99t open write-ahead log %s."), mudconf.game_wal);
+                ENDLOG;
+            }
         }
         db_free();
     }
@@ -3780,6 +4127,9 @@ void load_restart_db(void)
 #ifdef UNIX_SSL
         d->ssl_session = nullptr;
 #endif
+#if defined(UNIX_SSL_WORKERS)
+        d->tls = nullptr;
+#endif // UNIX_SSL_WORKERS
         if (3 <= version)
         {
             d->raw_input_state              = getref(f);
@@ -3924,6 +4274,18 @@ void load_restart_db(void)
         d->output_size = 0;
         d->output_tot = 0;
         d->output_lost = 0;
+        d->output_syscalls = 0;
+        d->output_sent = 0;
+        memset(d->command_latency, 0, sizeof(d->command_latency));
+#if defined(UNIX_MCCP)
+
+        // A compression stream does not survive the restart.
+        //
+        d->mccp = nullptr;
+        d->compress_in = 0;
+        d->compress_out = 0;
+        d->nvt_us_state[TELNET_COMPRESS2] = OPTION_NO;
+#endif // UNIX_MCCP
         d->output_head = nullptr;
         d->output_tail = nullptr;
         d->input_head = nullptr;
@@ -3963,6 +4325,10 @@ void load_restart_db(void)
         }
 #endif // UNIX_NETWORKING_SELECT
 
+#if defined(UNIX_NETWORKING_EPOLL)
+        epoll_register(d);
+#endif // UNIX_NETWORKING_EPOLL
+
         desc_addhash(d);
         if (isPlayer(d->player))
         {
@@ -43,6 +43,21 @@ struct atrlist
 };
 #endif // MEMORY_BASED
 
+// The $-command and ^-listen attributes of an object, kept sorted by
+// attribute number. Attributes carrying AF_PRIVATE are also listed (with a
+// type of '\0') so that parent exclusion can be decided without fetching
+// every attribute.
+//
+typedef struct atrcmd ATRCMD;
+struct atrcmd
+{
+    UTF8 *pattern;  /* Pattern text, followed by the action text. */
+    UTF8 *action;   /* Action text (within the same allocation). */
+    int number;     /* Attribute number. */
+    int flags;      /* Attribute flags stored with the value. */
+    UTF8 type;      /* AMATCH_CMD, AMATCH_LISTEN, or '\0'. */
+};
+
 UTF8 *MakeCanonicalAttributeName(const UTF8 *pName, size_t *pnName, bool *pbValid);
 UTF8 *MakeCanonicalAttributeCommand(const UTF8 *pName, size_t *pnName, bool *pbValid);
 
@@ -164,6 +179,8 @@ struct object
     int     throttled_mail;
     int     throttled_references;
 
+    int     epoch;      // ALL: Last checkpoint that kept a pre-image.
+
     UTF8    *purename;
     UTF8    *moniker;
 
@@ -174,6 +191,11 @@ struct object
 #else
     UTF8    *name;
 #endif // MEMORY_BASED
+
+    ATRCMD  *pCmdHead;  /* $-command and ^-listen attribute index. */
+    int      nCmdAlloc; /* Size of the allocated index.            */
+    int      nCmdUsed;  /* Used portion of the index.              */
+    bool     bCmdIndexed; /* Has the index been built?             */
 };
 
 const int INITIAL_ATRLIST_SIZE = 10;
@@ -201,19 +223,35 @@ extern OBJ *db;
 #define ThMail(t)       db[t].throttled_mail
 #define ThRefs(t)       db[t].throttled_references
 
-#define s_Location(t,n)     db[t].location = (n)
+// While a checkpoint is written incrementally, an object it has not reached
+// yet must be copied aside before it changes.  See db_snapshot_begin().
+//
+extern dbref snapshot_next;
+extern dbref snapshot_top;
+void snapshot_preimage(dbref thing);
 
-#define s_Zone(t,n)         db[t].zone = (n)
-
-#define s_Contents(t,n)     db[t].contents = (n)
-#define s_Exits(t,n)        db[t].exits = (n)
-#define s_Next(t,n)         db[t].next = (n)
-#define s_Link(t,n)         db[t].link = (n)
-#define s_Owner(t,n)        db[t].owner = (n)
-#define s_Parent(t,n)       db[t].parent = (n)
-#define s_Flags(t,f,n)      db[t].fs.word[f] = (n)
-#define s_Powers(t,n)       db[t].powers = (n)
-#define s_Powers2(t,n)      db[t].powers2 = (n)
+inline void SnapshotTouch(dbref thing)
+{
+    if (  snapshot_next <= thing
+       && thing < snapshot_top)
+    {
+        snapshot_preimage(thing);
+    }
+}
+
+#define s_Location(t,n)     (SnapshotTouch(t), db[t].location = (n))
+
+#define s_Zone(t,n)         (SnapshotTouch(t), db[t].zone = (n))
+
+#define s_Contents(t,n)     (SnapshotTouch(t), db[t].contents = (n))
+#define s_Exits(t,n)        (SnapshotTouch(t), db[t].exits = (n))
+#define s_Next(t,n)         (SnapshotTouch(t), db[t].next = (n))
+#define s_Link(t,n)         (SnapshotTouch(t), db[t].link = (n))
+#define s_Owner(t,n)        (SnapshotTouch(t), db[t].owner = (n), chown_que(t))
+#define s_Parent(t,n)       (SnapshotTouch(t), db[t].parent = (n))
+#define s_Flags(t,f,n)      (SnapshotTouch(t), db[t].fs.word[f] = (n))
+#define s_Powers(t,n)       (SnapshotTouch(t), db[t].powers = (n))
+#define s_Powers2(t,n)      (SnapshotTouch(t), db[t].powers2 = (n))
 #define s_Home(t,n)         s_Link(t,n)
 #define s_Dropto(t,n)       s_Location(t,n)
 #define s_ThAttrib(t,n)     db[t].throttled_attributes = (n);
@@ -234,6 +272,7 @@ void load_restart_db(void);
 #endif // HAVE_WORKING_FORK
 
 dbref    getref(FILE *);
+bool getref_mem(const UTF8 **pp, const UTF8 *pEnd, int *pValue);
 void putref(FILE *, dbref);
 void free_boolexp(BOOLEXP *);
 dbref    parse_dbref(const UTF8 *);
@@ -248,10 +287,14 @@ void db_free(void);
 void db_make_minimal(void);
 dbref    db_read(FILE *, int *, int *, int *);
 dbref    db_write(FILE *, int, int);
+bool db_snapshot_begin(FILE *f, int format, int version);
+bool db_snapshot_step(int nObjects);
+void db_snapshot_end(int *pnImages, INT64 *pnBytes);
 void destroy_thing(dbref);
 void destroy_exit(dbref);
 void putstring(FILE *f, const UTF8 *s);
 void *getstring_noalloc(FILE *f, bool new_strings, size_t *pnBuffer);
+bool getstring_mem(const UTF8 **pp, const UTF8 *pEnd, UTF8 *pOutput, size_t *pnOutput);
 void init_attrtab(void);
 int GrowFiftyPercent(int x, int low, int high);
 
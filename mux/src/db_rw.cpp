@@ -346,6 +346,659 @@ static bool get_list(FILE *f, dbref i)
     }
 }
 
+#if defined(UNIX_FILES_MMAP)
+
+/* ---------------------------------------------------------------------------
+ * Flatfile loader: Parse object records from a memory image of the flatfile.
+ *
+ * The object section of a V_QUOTED flatfile is mapped into memory and
+ * pre-scanned for lines beginning with '!'.  Each of those starts a record
+ * which is parsed on its own -- by a pool of worker threads when they are
+ * available -- into per-worker staging buffers.  The main thread then
+ * commits the staged records in file order with the same setters that the
+ * stdio path uses, so the resulting database is the same.
+ *
+ * Anything that the in-memory parser does not reproduce exactly (bad
+ * characters, over-long lines, embedded NULs, or a record that does not
+ * end where the next one begins) stops the loader.  The stdio path then
+ * continues from that point in the file.
+ */
+
+#define LOADER_BATCH_RECORDS 2048
+#define LOADER_MAX_WORKERS   32
+
+// Numeric fields in the order they appear in an object record.
+//
+#define LREF_LOCATION  0
+#define LREF_ZONE      1
+#define LREF_CONTENTS  2
+#define LREF_EXITS     3
+#define LREF_LINK      4
+#define LREF_NEXT      5
+#define LREF_OWNER     6
+#define LREF_PARENT    7
+#define LREF_PENNIES   8
+#define LREF_FLAGS1    9
+#define LREF_FLAGS2   10
+#define LREF_FLAGS3   11
+#define LREF_POWERS   12
+#define LREF_POWERS2  13
+#define LREF_COUNT    14
+
+typedef struct
+{
+    int    atr;
+    size_t iText;
+    size_t nText;
+} LOADER_ATTR;
+
+typedef struct
+{
+    size_t iStart;      // Offset of the leading '!'.
+    size_t iLimit;      // Offset of the next record (or end of file).
+    size_t iEnd;        // Offset just past the parsed record.
+    bool   bParsed;     // Parsed the same as the stdio path would.
+    dbref  thing;
+    int    aRef[LREF_COUNT];
+    size_t iName;
+    size_t iAttr;
+    size_t nAttr;
+} LOADER_RECORD;
+
+typedef struct
+{
+    UTF8        *pText;
+    size_t       nText;
+    size_t       nTextAlloc;
+    LOADER_ATTR *pAttr;
+    size_t       nAttr;
+    size_t       nAttrAlloc;
+} LOADER_STAGE;
+
+typedef struct
+{
+    LOADER_RECORD aRecord[LOADER_BATCH_RECORDS];
+    size_t        nRecords;
+    size_t        aChunk[LOADER_MAX_WORKERS+1];
+    LOADER_STAGE  aStage[LOADER_MAX_WORKERS];
+} LOADER_BATCH;
+
+static const UTF8 *loader_base;
+static size_t      loader_size;
+static bool        loader_read_name;
+static bool        loader_read_attribs;
+static bool        loader_read_money;
+
+// Parse one object record into a staging buffer.  The staging buffer is
+// large enough for anything the record's byte range can decode to, and the
+// parse is not allowed past that range.
+//
+static void loader_parse(LOADER_STAGE *ps, LOADER_RECORD *pr)
+{
+    const UTF8 *p = loader_base + pr->iStart + 1;
+    const UTF8 *pEnd = loader_base + pr->iLimit;
+    size_t nText;
+
+    pr->bParsed = false;
+    if (!getref_mem(&p, pEnd, &pr->thing))
+    {
+        return;
+    }
+
+    if (loader_read_name)
+    {
+        pr->iName = ps->nText;
+        if (!getstring_mem(&p, pEnd, ps->pText + ps->nText, &nText))
+        {
+            return;
+        }
+        ps->nText += nText + 1;
+    }
+
+    for (int iRef = 0; iRef < LREF_COUNT; iRef++)
+    {
+        if (  LREF_PENNIES == iRef
+           && !loader_read_money)
+        {
+            pr->aRef[iRef] = 0;
+        }
+        else if (!getref_mem(&p, pEnd, &pr->aRef[iRef]))
+        {
+            return;
+        }
+    }
+
+    pr->iAttr = ps->nAttr;
+    pr->nAttr = 0;
+    if (!loader_read_attribs)
+    {
+        pr->iEnd = p - loader_base;
+        pr->bParsed = true;
+        return;
+    }
+
+    while (p < pEnd)
+    {
+        switch (*p++)
+        {
+        case '>':
+            {
+                int atr;
+                if (  !getref_mem(&p, pEnd, &atr)
+                   || !getstring_mem(&p, pEnd, ps->pText + ps->nText, &nText))
+                {
+                    return;
+                }
+
+                if (0 < atr)
+                {
+                    LOADER_ATTR *pa = &ps->pAttr[ps->nAttr++];
+                    pa->atr = atr;
+                    pa->iText = ps->nText;
+                    pa->nText = nText;
+                    ps->nText += nText + 1;
+                    pr->nAttr++;
+                }
+            }
+            break;
+
+        case '\n':
+            break;
+
+        case '<':
+            if (  p < pEnd
+               && '\n' == *p)
+            {
+                pr->iEnd = (p + 1) - loader_base;
+                pr->bParsed = true;
+            }
+            return;
+
+        default:
+
+            // get_list() logs this, so let it.
+            //
+            return;
+        }
+    }
+}
+
+static void loader_parse_chunk(LOADER_BATCH *pb, int iWorker)
+{
+    LOADER_STAGE *ps = &pb->aStage[iWorker];
+    ps->nText = 0;
+    ps->nAttr = 0;
+    for (size_t j = pb->aChunk[iWorker]; j < pb->aChunk[iWorker+1]; j++)
+    {
+        loader_parse(ps, &pb->aRecord[j]);
+        if (!pb->aRecord[j].bParsed)
+        {
+            // Nothing after this record will be committed.
+            //
+            break;
+        }
+    }
+}
+
+// Size the batch's staging buffers from the byte ranges of its records.
+//
+static void loader_prepare(LOADER_BATCH *pb, int nChunks)
+{
+    size_t nPerChunk = (pb->nRecords + nChunks - 1) / nChunks;
+    for (int k = 0; k < nChunks; k++)
+    {
+        size_t iFirst = k * nPerChunk;
+        size_t iLast  = iFirst + nPerChunk;
+        if (pb->nRecords < iFirst)
+        {
+            iFirst = pb->nRecords;
+        }
+        if (pb->nRecords < iLast)
+        {
+            iLast = pb->nRecords;
+        }
+        pb->aChunk[k] = iFirst;
+
+        size_t nBytes = 0;
+        for (size_t j = iFirst; j < iLast; j++)
+        {
+            nBytes += pb->aRecord[j].iLimit - pb->aRecord[j].iStart;
+        }
+
+        // A decoded string is never longer than its quoted form, and every
+        // attribute takes at least five bytes (">n\n\"\"").
+        //
+        LOADER_STAGE *ps = &pb->aStage[k];
+        if (ps->nTextAlloc < nBytes + 1)
+        {
+            if (nullptr != ps->pText)
+            {
+                MEMFREE(ps->pText);
+            }
+            ps->nTextAlloc = nBytes + nBytes/4 + 1;
+            ps->pText = (UTF8 *)MEMALLOC(ps->nTextAlloc);
+            ISOUTOFMEMORY(ps->pText);
+        }
+
+        size_t nAttrs = nBytes/5 + 1;
+        if (ps->nAttrAlloc < nAttrs)
+        {
+            if (nullptr != ps->pAttr)
+            {
+                MEMFREE(ps->pAttr);
+            }
+            ps->nAttrAlloc = nAttrs + nAttrs/4;
+            ps->pAttr = (LOADER_ATTR *)MEMALLOC(ps->nAttrAlloc * sizeof(LOADER_ATTR));
+            ISOUTOFMEMORY(ps->pAttr);
+        }
+    }
+    pb->aChunk[nChunks] = pb->nRecords;
+}
+
+// Commit staged records in file order.  Returns false when the loader should
+// stop, with *piResume set to where the stdio path picks up.
+//
+static bool loader_commit(LOADER_BATCH *pb, int nChunks, dbref *pi, int *piDotCounter, size_t *piResume, int *pnCommitted)
+{
+    for (int k = 0; k < nChunks; k++)
+    {
+        LOADER_STAGE *ps = &pb->aStage[k];
+        for (size_t j = pb->aChunk[k]; j < pb->aChunk[k+1]; j++)
+        {
+            LOADER_RECORD *pr = &pb->aRecord[j];
+            if (!pr->bParsed)
+            {
+                *piResume = pr->iStart;
+                return false;
+            }
+
+            if (mudstate.bStandAlone)
+            {
+                if (!*piDotCounter)
+                {
+                    *piDotCounter = 100;
+                    fputc('.', stderr);
+                    fflush(stderr);
+                }
+                (*piDotCounter)--;
+            }
+
+            dbref i = pr->thing;
+            *pi = i;
+            db_grow(i + 1);
+
+            if (loader_read_name)
+            {
+                UTF8 *buff = alloc_mbuf("dbread.s_Name");
+                StripTabsAndTruncate(ps->pText + pr->iName, buff, MBUF_SIZE-1, MBUF_SIZE-1);
+                s_Name(i, buff);
+                free_mbuf(buff);
+            }
+
+            s_Location(i, pr->aRef[LREF_LOCATION]);
+
+            int zone = pr->aRef[LREF_ZONE];
+            if (zone < NOTHING)
+            {
+                zone = NOTHING;
+            }
+            s_Zone(i, zone);
+
+            s_Contents(i, pr->aRef[LREF_CONTENTS]);
+            s_Exits(i, pr->aRef[LREF_EXITS]);
+            s_Link(i, pr->aRef[LREF_LINK]);
+            s_Next(i, pr->aRef[LREF_NEXT]);
+            s_Owner(i, pr->aRef[LREF_OWNER]);
+            s_Parent(i, pr->aRef[LREF_PARENT]);
+            if (loader_read_money)
+            {
+                s_PenniesDirect(i, pr->aRef[LREF_PENNIES]);
+            }
+            s_Flags(i, FLAG_WORD1, pr->aRef[LREF_FLAGS1]);
+            s_Flags(i, FLAG_WORD2, pr->aRef[LREF_FLAGS2]);
+            s_Flags(i, FLAG_WORD3, pr->aRef[LREF_FLAGS3]);
+            s_Powers(i, pr->aRef[LREF_POWERS]);
+            s_Powers2(i, pr->aRef[LREF_POWERS2]);
+
+            for (size_t n = 0; n < pr->nAttr; n++)
+            {
+                LOADER_ATTR *pa = &ps->pAttr[pr->iAttr + n];
+                if (g_max_obj_atr < pa->atr)
+                {
+                    g_max_obj_atr = pa->atr;
+                }
+                atr_add_raw_LEN(i, pa->atr, ps->pText + pa->iText, pa->nText);
+            }
+
+            if (isPlayer(i))
+            {
+                c_Connected(i);
+            }
+
+            (*pnCommitted)++;
+            *piResume = pr->iEnd;
+            if (pr->iEnd != pr->iLimit)
+            {
+                // Something other than a record follows. This is normally
+                // the end-of-dump marker.
+                //
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static int loader_nWorkers;
+
+#if defined(UNIX_THREADS)
+static pthread_t       loader_thread[LOADER_MAX_WORKERS];
+static pthread_mutex_t loader_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  loader_cvWork = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t  loader_cvDone = PTHREAD_COND_INITIALIZER;
+static LOADER_BATCH   *loader_batch;
+static unsigned int    loader_generation;
+static int             loader_pending;
+static bool            loader_shutdown;
+
+static void *loader_worker(void *pArg)
+{
+    int iWorker = static_cast<int>(reinterpret_cast<intptr_t>(pArg));
+    unsigned int iSeen = 0;
+
+    pthread_mutex_lock(&loader_mutex);
+    for (;;)
+    {
+        while (  !loader_shutdown
+              && iSeen == loader_generation)
+        {
+            pthread_cond_wait(&loader_cvWork, &loader_mutex);
+        }
+
+        if (loader_shutdown)
+        {
+            break;
+        }
+        iSeen = loader_generation;
+        LOADER_BATCH *pb = loader_batch;
+        pthread_mutex_unlock(&loader_mutex);
+
+        loader_parse_chunk(pb, iWorker);
+
+        pthread_mutex_lock(&loader_mutex);
+        if (0 == --loader_pending)
+        {
+            pthread_cond_signal(&loader_cvDone);
+        }
+    }
+    pthread_mutex_unlock(&loader_mutex);
+    return nullptr;
+}
+#endif // UNIX_THREADS
+
+static void loader_start_workers(int nThreads)
+{
+    loader_nWorkers = 0;
+#if defined(UNIX_THREADS)
+    if (1 < nThreads)
+    {
+        loader_generation = 0;
+        loader_pending = 0;
+        loader_shutdown = false;
+        for (int k = 0; k < nThreads; k++)
+        {
+            if (0 != pthread_create(&loader_thread[k], nullptr, loader_worker,
+                reinterpret_cast<void *>(static_cast<intptr_t>(k))))
+            {
+                break;
+            }
+            loader_nWorkers++;
+        }
+    }
+#else
+    UNUSED_PARAMETER(nThreads);
+#endif // UNIX_THREADS
+}
+
+static void loader_stop_workers(void)
+{
+#if defined(UNIX_THREADS)
+    if (0 < loader_nWorkers)
+    {
+        pthread_mutex_lock(&loader_mutex);
+        loader_shutdown = true;
+        pthread_cond_broadcast(&loader_cvWork);
+        pthread_mutex_unlock(&loader_mutex);
+        for (int k = 0; k < loader_nWorkers; k++)
+        {
+            pthread_join(loader_thread[k], nullptr);
+        }
+    }
+#endif // UNIX_THREADS
+    loader_nWorkers = 0;
+}
+
+// Begin parsing a batch.  Without workers, the batch is parsed here.
+//
+static void loader_dispatch(LOADER_BATCH *pb)
+{
+#if defined(UNIX_THREADS)
+    if (0 < loader_nWorkers)
+    {
+        pthread_mutex_lock(&loader_mutex);
+        loader_batch = pb;
+        loader_pending = loader_nWorkers;
+        loader_generation++;
+        pthread_cond_broadcast(&loader_cvWork);
+        pthread_mutex_unlock(&loader_mutex);
+        return;
+    }
+#endif // UNIX_THREADS
+    loader_parse_chunk(pb, 0);
+}
+
+static void loader_wait(void)
+{
+#if defined(UNIX_THREADS)
+    if (0 < loader_nWorkers)
+    {
+        pthread_mutex_lock(&loader_mutex);
+        while (0 < loader_pending)
+        {
+            pthread_cond_wait(&loader_cvDone, &loader_mutex);
+        }
+        pthread_mutex_unlock(&loader_mutex);
+    }
+#endif // UNIX_THREADS
+}
+
+static void loader_fill(LOADER_BATCH *pb, const size_t *aStart, size_t nStarts, size_t *piNext)
+{
+    size_t n = nStarts - *piNext;
+    if (LOADER_BATCH_RECORDS < n)
+    {
+        n = LOADER_BATCH_RECORDS;
+    }
+
+    for (size_t j = 0; j < n; j++)
+    {
+        size_t iRecord = (*piNext)++;
+        pb->aRecord[j].iStart = aStart[iRecord];
+        pb->aRecord[j].iLimit = (iRecord + 1 < nStarts) ? aStart[iRecord+1] : loader_size;
+        pb->aRecord[j].bParsed = false;
+    }
+    pb->nRecords = n;
+}
+
+/*! \brief Reads the object records of a flatfile from a memory image.
+ *
+ * Called by db_read() after it has read the '!' of the first object record.
+ * On return, the file is positioned where db_read() should continue, which
+ * is normally the end-of-dump marker.
+ *
+ * \param f             Flatfile.
+ * \param read_name     Object records include names.
+ * \param read_attribs  Object records include attributes.
+ * \param read_money    Object records include pennies.
+ * \param pi            Receives the last object read.
+ * \param piDotCounter  Progress counter for the standalone dots.
+ * \return              false if the memory image could not be used.
+ */
+
+static bool db_read_loader(FILE *f, bool read_name, bool read_attribs, bool read_money,
+    dbref *pi, int *piDotCounter)
+{
+    int nThreads = mudconf.load_threads;
+    if (nThreads <= 0)
+    {
+        return false;
+    }
+
+    // Compressed flatfiles arrive through a pipe.
+    //
+    struct stat st;
+    int fd = fileno(f);
+    if (  fstat(fd, &st) < 0
+       || !S_ISREG(st.st_mode)
+       || st.st_size <= 0)
+    {
+        return false;
+    }
+
+    long lPos = ftell(f);
+    if (  lPos <= 0
+       || st.st_size <= lPos)
+    {
+        return false;
+    }
+
+    void *pMap = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (MAP_FAILED == pMap)
+    {
+        return false;
+    }
+    loader_base = static_cast<const UTF8 *>(pMap);
+    loader_size = st.st_size;
+    loader_read_name = read_name;
+    loader_read_attribs = read_attribs;
+    loader_read_money = read_money;
+
+    // Find the lines that begin with '!'.  A raw '\n!' could also occur
+    // inside a string, but then the record before it does not end there,
+    // and the stdio path takes over.
+    //
+    size_t nStartsAlloc = 1024;
+    size_t nStarts = 0;
+    size_t *aStart = (size_t *)MEMALLOC(nStartsAlloc * sizeof(size_t));
+    ISOUTOFMEMORY(aStart);
+    aStart[nStarts++] = lPos - 1;
+
+    const UTF8 *p = loader_base + lPos;
+    const UTF8 *pEnd = loader_base + loader_size;
+    while (nullptr != (p = (UTF8 *)memchr(p, '!', pEnd - p)))
+    {
+        if ('\n' == p[-1])
+        {
+            if (nStarts == nStartsAlloc)
+            {
+                nStartsAlloc *= 2;
+                size_t *aNew = (size_t *)MEMALLOC(nStartsAlloc * sizeof(size_t));
+                ISOUTOFMEMORY(aNew);
+                memcpy(aNew, aStart, nStarts * sizeof(size_t));
+                MEMFREE(aStart);
+                aStart = aNew;
+            }
+            aStart[nStarts++] = p - loader_base;
+        }
+        p++;
+    }
+
+#if defined(_SC_NPROCESSORS_ONLN)
+    long nCPUs = sysconf(_SC_NPROCESSORS_ONLN);
+    if (  0 < nCPUs
+       && nCPUs < nThreads)
+    {
+        nThreads = static_cast<int>(nCPUs);
+    }
+#endif // _SC_NPROCESSORS_ONLN
+    if (LOADER_MAX_WORKERS < nThreads)
+    {
+        nThreads = LOADER_MAX_WORKERS;
+    }
+    loader_start_workers(nThreads);
+    int nChunks = (0 < loader_nWorkers) ? loader_nWorkers : 1;
+
+    // While the main thread commits one batch, the workers parse the next.
+    //
+    LOADER_BATCH *aBatch[2];
+    for (int k = 0; k < 2; k++)
+    {
+        aBatch[k] = (LOADER_BATCH *)MEMALLOC(sizeof(LOADER_BATCH));
+        ISOUTOFMEMORY(aBatch[k]);
+        memset(aBatch[k], 0, sizeof(LOADER_BATCH));
+    }
+
+    size_t iNext = 0;
+    size_t iResume = aStart[0];
+    int nCommitted = 0;
+    int iCurrent = 0;
+    loader_fill(aBatch[iCurrent], aStart, nStarts, &iNext);
+    loader_prepare(aBatch[iCurrent], nChunks);
+    loader_dispatch(aBatch[iCurrent]);
+    for (;;)
+    {
+        loader_wait();
+
+        bool bMore = (iNext < nStarts);
+        if (bMore)
+        {
+            LOADER_BATCH *pb = aBatch[1 - iCurrent];
+            loader_fill(pb, aStart, nStarts, &iNext);
+            loader_prepare(pb, nChunks);
+            loader_dispatch(pb);
+        }
+
+        if (  !loader_commit(aBatch[iCurrent], nChunks, pi, piDotCounter, &iResume, &nCommitted)
+           || !bMore)
+        {
+            loader_wait();
+            break;
+        }
+        iCurrent = 1 - iCurrent;
+    }
+    loader_stop_workers();
+
+    if (  iResume < loader_size
+       && '!' == loader_base[iResume])
+    {
+        Log.tinyprintf(T(ENDLINE "Flatfile loader stopped after %d objects. Continuing with stdio." ENDLINE), nCommitted);
+    }
+
+    for (int k = 0; k < 2; k++)
+    {
+        for (int w = 0; w < LOADER_MAX_WORKERS; w++)
+        {
+            if (nullptr != aBatch[k]->aStage[w].pText)
+            {
+                MEMFREE(aBatch[k]->aStage[w].pText);
+            }
+            if (nullptr != aBatch[k]->aStage[w].pAttr)
+            {
+                MEMFREE(aBatch[k]->aStage[w].pAttr);
+            }
+        }
+        MEMFREE(aBatch[k]);
+    }
+    MEMFREE(aStart);
+    munmap(pMap, loader_size);
+    loader_base = nullptr;
+    loader_size = 0;
+
+    fseek(f, static_cast<long>(iResume), SEEK_SET);
+    return true;
+}
+#endif // UNIX_FILES_MMAP
+
 dbref db_read(FILE *f, int *db_format, int *db_version, int *db_flags)
 {
     dbref i, anum;
@@ -377,6 +1030,10 @@ dbref db_read(FILE *f, int *db_format, int *db_version, int *db_flags)
     bool bValid;
     UTF8 *pName;
 
+#if defined(UNIX_FILES_MMAP)
+    bool bTryLoader = true;
+#endif // UNIX_FILES_MMAP
+
     int iDotCounter = 0;
     if (mudstate.bStandAlone)
     {
@@ -555,6 +1212,19 @@ dbref db_read(FILE *f, int *db_format, int *db_version, int *db_flags)
             break;
 
         case '!':   // MUX entry
+#if defined(UNIX_FILES_MMAP)
+            if (bTryLoader)
+            {
+                bTryLoader = false;
+                if (  3 <= g_version
+                   && (g_flags & V_QUOTED)
+                   && !read_key
+                   && db_read_loader(f, read_name, read_attribs, read_money, &i, &iDotCounter))
+                {
+                    break;
+                }
+            }
+#endif // UNIX_FILES_MMAP
             i = getref(f);
             db_grow(i + 1);
 
@@ -862,29 +1532,24 @@ static bool db_write_object(FILE *f, dbref i, int db_format, int flags)
     return false;
 }
 
-dbref db_write(FILE *f, int format, int version)
+// Writes the header and the user-named attribute table.
+//
+static bool db_write_header(FILE *f, int format, int version, int *pflags)
 {
-    dbref i;
-    int flags;
     ATTR *vp;
 
     switch (format)
     {
     case F_MUX:
-        flags = version;
+        *pflags = version;
         break;
 
     default:
         Log.WriteString(T("Can only write MUX format." ENDLINE));
-        return -1;
+        return false;
     }
-    if (mudstate.bStandAlone)
-    {
-        Log.WriteString(T("Writing "));
-        Log.Flush();
-    }
-    i = mudstate.attr_next;
-    mux_fprintf(f, T("+X%d\n+S%d\n+N%d\n"), flags, mudstate.db_top, i);
+    int flags = *pflags;
+    mux_fprintf(f, T("+X%d\n+S%d\n+N%d\n"), flags, mudstate.db_top, mudstate.attr_next);
     mux_fprintf(f, T("-R%d\n"), mudstate.record_players);
 
     // Dump user-named attribute info.
@@ -915,10 +1580,42 @@ dbref db_write(FILE *f, int format, int version)
             fwrite(Buffer, sizeof(UTF8), pBuffer-Buffer, f);
         }
     }
+    return true;
+}
+
+// Writes one object, if it is not garbage.
+//
+static void db_write_record(FILE *f, dbref i, int format, int flags)
+{
+    if (!isGarbage(i))
+    {
+        // Format is: "!%d\n", i
+        //
+        UTF8 buf[SBUF_SIZE];
+        buf[0] = '!';
+        size_t n = mux_ltoa(i, buf+1) + 1;
+        buf[n++] = '\n';
+        fwrite(buf, sizeof(UTF8), n, f);
+        db_write_object(f, i, format, flags);
+    }
+}
+
+dbref db_write(FILE *f, int format, int version)
+{
+    dbref i;
+    int flags;
+
+    if (!db_write_header(f, format, version, &flags))
+    {
+        return -1;
+    }
+    if (mudstate.bStandAlone)
+    {
+        Log.WriteString(T("Writing "));
+        Log.Flush();
+    }
 
     int iDotCounter = 0;
-    UTF8 buf[SBUF_SIZE];
-    buf[0] = '!';
     DO_WHOLE_DB(i)
     {
         if (mudstate.bStandAlone)
@@ -931,16 +1628,7 @@ dbref db_write(FILE *f, int format, int version)
             }
             iDotCounter--;
         }
-
-        if (!isGarbage(i))
-        {
-            // Format is: "!%d\n", i
-            //
-            size_t n = mux_ltoa(i, buf+1) + 1;
-            buf[n++] = '\n';
-            fwrite(buf, sizeof(UTF8), n, f);
-            db_write_object(f, i, format, flags);
-        }
+        db_write_record(f, i, format, flags);
     }
     fputs("***END OF DUMP***\n", f);
     if (mudstate.bStandAlone)
@@ -950,3 +1638,159 @@ dbref db_write(FILE *f, int format, int version)
     }
     return mudstate.db_top;
 }
+
+// Incremental checkpoints.
+//
+// Instead of fork()ing a child to write the structure database, the main loop
+// writes it a few objects at a time.  db_snapshot_begin() fixes the header
+// and the range of objects, and each db_snapshot_step() writes the next few
+// objects.  Before an object that has not been written yet changes,
+// snapshot_preimage() formats its record as it stands into a side file, and
+// that record is copied out when the object's turn comes.  Each object
+// carries the epoch of the last checkpoint that kept its pre-image, so only
+// the first change to an object costs anything.
+//
+dbref snapshot_next = 0;
+dbref snapshot_top  = 0;
+
+typedef struct
+{
+    long   iOffset;
+    size_t nLength;
+} SNAPSHOT_IMAGE;
+
+static FILE *snapshot_file  = nullptr;
+static FILE *snapshot_side  = nullptr;
+static int   snapshot_epoch = 0;
+static int   snapshot_format;
+static int   snapshot_flags;
+static int   snapshot_images;
+static INT64 snapshot_bytes;
+static CHashTable snapshot_htab;
+
+void snapshot_preimage(dbref thing)
+{
+    if (db[thing].epoch == snapshot_epoch)
+    {
+        return;
+    }
+    db[thing].epoch = snapshot_epoch;
+
+    SNAPSHOT_IMAGE *pImage = (SNAPSHOT_IMAGE *)MEMALLOC(sizeof(SNAPSHOT_IMAGE));
+    ISOUTOFMEMORY(pImage);
+    fseek(snapshot_side, 0, SEEK_END);
+    pImage->iOffset = ftell(snapshot_side);
+    db_write_record(snapshot_side, thing, snapshot_format, snapshot_flags);
+    pImage->nLength = ftell(snapshot_side) - pImage->iOffset;
+    hashaddLEN(&thing, sizeof(thing), pImage, &snapshot_htab);
+
+    snapshot_images++;
+    snapshot_bytes += pImage->nLength;
+}
+
+/*! \brief Starts writing a checkpoint of the database incrementally.
+ *
+ * \param f        Output file.
+ * \param format   Database format.
+ * \param version  Database version and flags.
+ * \return         true if the checkpoint was started.
+ */
+
+bool db_snapshot_begin(FILE *f, int format, int version)
+{
+    snapshot_side = tmpfile();
+    if (nullptr == snapshot_side)
+    {
+        return false;
+    }
+    if (!db_write_header(f, format, version, &snapshot_flags))
+    {
+        fclose(snapshot_side);
+        snapshot_side = nullptr;
+        return false;
+    }
+    snapshot_file   = f;
+    snapshot_format = format;
+    snapshot_images = 0;
+    snapshot_bytes  = 0;
+    snapshot_epoch++;
+    snapshot_next   = 0;
+    snapshot_top    = mudstate.db_top;
+    return true;
+}
+
+/*! \brief Writes the next part of the checkpoint in progress.
+ *
+ * \param nObjects  Number of objects to write.
+ * \return          true if every object has been written.
+ */
+
+bool db_snapshot_step(int nObjects)
+{
+    UTF8 buf[LBUF_SIZE];
+    while (  0 < nObjects--
+          && snapshot_next < snapshot_top)
+    {
+        dbref i = snapshot_next++;
+        if (db[i].epoch != snapshot_epoch)
+        {
+            db_write_record(snapshot_file, i, snapshot_format, snapshot_flags);
+            continue;
+        }
+
+        SNAPSHOT_IMAGE *pImage = (SNAPSHOT_IMAGE *)hashfindLEN(&i, sizeof(i),
+            &snapshot_htab);
+        if (nullptr != pImage)
+        {
+            fseek(snapshot_side, pImage->iOffset, SEEK_SET);
+            size_t nLeft = pImage->nLength;
+            while (0 < nLeft)
+            {
+                size_t n = fread(buf, sizeof(UTF8), nLeft < sizeof(buf) ? nLeft : sizeof(buf), snapshot_side);
+                if (0 == n)
+                {
+                    break;
+                }
+                fwrite(buf, sizeof(UTF8), n, snapshot_file);
+                nLeft -= n;
+            }
+            hashdeleteLEN(&i, sizeof(i), &snapshot_htab);
+            MEMFREE(pImage);
+        }
+    }
+    return snapshot_top <= snapshot_next;
+}
+
+/*! \brief Finishes or abandons the checkpoint in progress.
+ *
+ * The trailer is written only if every object was written.
+ *
+ * \param pnImages  Number of pre-images kept.
+ * \param pnBytes   Size of the pre-images kept.
+ */
+
+void db_snapshot_end(int *pnImages, INT64 *pnBytes)
+{
+    if (snapshot_top <= snapshot_next)
+    {
+        fputs("***END OF DUMP***\n", snapshot_file);
+    }
+    snapshot_next = 0;
+    snapshot_top  = 0;
+
+    SNAPSHOT_IMAGE *pImage;
+    for (pImage = (SNAPSHOT_IMAGE *)hash_firstentry(&snapshot_htab);
+         nullptr != pImage;
+         pImage = (SNAPSHOT_IMAGE *)hash_nextentry(&snapshot_htab))
+    {
+        MEMFREE(pImage);
+    }
+    hashflush(&snapshot_htab);
+
+    fclose(snapshot_side);
+    snapshot_side = nullptr;
+    snapshot_file = nullptr;
+
+    *pnImages = snapshot_images;
+    *pnBytes  = snapshot_bytes;
+}
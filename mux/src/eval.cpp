@@ -826,6 +826,477 @@ static const UTF8 *parse_arglist_lite( dbref executor, dbref caller, dbref enact
     return pNext;
 }
 
+/* ---------------------------------------------------------------------------
+ * Softcode program cache.
+ *
+ * u(), ulocal(), @function, and the list functions evaluate the same
+ * attribute text over and over. Each evaluation finds the boundaries of every
+ * argument list, [] and {} with parse_to_lite() and looks up every function
+ * name in func_htab. Nested calls make this worse because the text of an
+ * inner call is rescanned once for each enclosing call.
+ *
+ * The cache keeps a copy of such text keyed by its hash and length. As
+ * mux_exec() evaluates text which lies inside a cached copy, it records the
+ * results of these scans and lookups against the offset of the '(', '[', or
+ * '{' which caused them. Later evaluations of the same text reuse them. The
+ * boundaries depend only on the text, and the function name is compared
+ * against the output actually produced before '(', so evaluation is
+ * unchanged. Sites are never modified once recorded, and a program in use is
+ * not freed until the last evaluation using it returns.
+ *
+ * Like the attribute cache, programs are organized by a CHashTable and a
+ * linked list, and least-recently-used programs are trimmed when the cache
+ * exceeds eval_cache_size. Setting eval_cache_size to 0 disables the cache.
+ */
+
+int ec_hits        = 0;     // Programs found in the cache.
+int ec_misses      = 0;     // Programs added to the cache.
+int ec_evictions   = 0;     // Programs trimmed as least-recently-used.
+int ec_scans_saved = 0;     // Scans and lookups answered by a recorded site.
+
+typedef struct tagEvalCacheKey
+{
+    UINT32 nHash;
+    UINT32 nText;
+} ECACHE_KEY;
+
+typedef struct tagEvalArg
+{
+    size_t iArg;            // Offset of the argument in the program text.
+    size_t nArg;            // Length of the argument.
+} EVAL_ARG;
+
+typedef struct tagEvalSite
+{
+    size_t  iSite;          // Offset of the '(', '[', or '{'.
+    bool    bClosed;        // Whether the closing delimiter was found.
+    size_t  iNext;          // Offset just past the closing delimiter.
+    size_t  nInner;         // Length of the text inside [] or {}.
+    size_t  nName;          // Length of the function name before '('.
+    UTF8    aName[MAX_UFUN_NAME_LEN+1];
+    FUN    *fp;             // Builtin function by that name or nullptr.
+    int     nfargs;         // Argument limit the boundaries were found for.
+    int     nArgs;          // Number of arguments found.
+    EVAL_ARG aArgs[1];
+} EVAL_SITE;
+
+typedef struct tagEvalProgram
+{
+    struct tagEvalProgram *pPrevEntry;
+    struct tagEvalProgram *pNextEntry;
+    ECACHE_KEY  key;
+    int         nRefs;
+    bool        bStale;
+    int         nSites;
+    int         nSitesAlloc;
+    EVAL_SITE **aSites;     // Sorted by iSite.
+    size_t      nText;
+    UTF8       *pText;
+} EVAL_PROG;
+
+static EVAL_PROG *pEvalHead = nullptr;
+static EVAL_PROG *pEvalTail = nullptr;
+static int nEvalEntries = 0;
+
+// The program whose text is being evaluated by mux_exec_cached().
+//
+static EVAL_PROG *pEvalCurrent = nullptr;
+
+static void ecache_unlink(EVAL_PROG *pProg)
+{
+    if (pProg->pPrevEntry)
+    {
+        pProg->pPrevEntry->pNextEntry = pProg->pNextEntry;
+    }
+    else
+    {
+        pEvalHead = pProg->pNextEntry;
+    }
+
+    if (pProg->pNextEntry)
+    {
+        pProg->pNextEntry->pPrevEntry = pProg->pPrevEntry;
+    }
+    else
+    {
+        pEvalTail = pProg->pPrevEntry;
+    }
+}
+
+static void ecache_push(EVAL_PROG *pProg)
+{
+    if (pEvalHead)
+    {
+        pEvalHead->pPrevEntry = pProg;
+    }
+    pProg->pNextEntry = pEvalHead;
+    pProg->pPrevEntry = nullptr;
+    pEvalHead = pProg;
+    if (!pEvalTail)
+    {
+        pEvalTail = pEvalHead;
+    }
+}
+
+static void ecache_destroy(EVAL_PROG *pProg)
+{
+    for (int i = 0; i < pProg->nSites; i++)
+    {
+        MEMFREE(pProg->aSites[i]);
+    }
+    if (pProg->aSites)
+    {
+        MEMFREE(pProg->aSites);
+    }
+    MEMFREE(pProg);
+}
+
+// Remove a program from the cache. If an evaluation is still using it, it
+// is freed when that evaluation finishes.
+//
+static void ecache_remove(EVAL_PROG *pProg)
+{
+    ecache_unlink(pProg);
+    hashdeleteLEN(&pProg->key, sizeof(ECACHE_KEY), &mudstate.eval_htab);
+    nEvalEntries--;
+
+    if (0 < pProg->nRefs)
+    {
+        pProg->bStale = true;
+    }
+    else
+    {
+        ecache_destroy(pProg);
+    }
+}
+
+static void ecache_trim(void)
+{
+    while (  0 < nEvalEntries
+          && mudconf.eval_cache_size < nEvalEntries)
+    {
+        ec_evictions++;
+        ecache_remove(pEvalTail);
+    }
+}
+
+/*! \brief Discard all cached programs.
+ *
+ * Called when the set of builtin or global functions changes.
+ *
+ * \return          None.
+ */
+
+void eval_cache_flush(void)
+{
+    while (pEvalHead)
+    {
+        ecache_remove(pEvalHead);
+    }
+}
+
+static EVAL_PROG *ecache_fetch(const UTF8 *pStr)
+{
+    size_t nText = strlen((const char *)pStr);
+
+    ECACHE_KEY key;
+    memset(&key, 0, sizeof(key));
+    key.nHash = HASH_ProcessBuffer(0, pStr, nText);
+    key.nText = static_cast<UINT32>(nText);
+
+    EVAL_PROG *pProg = (EVAL_PROG *)hashfindLEN(&key, sizeof(key),
+        &mudstate.eval_htab);
+    if (pProg)
+    {
+        if (memcmp(pProg->pText, pStr, nText) == 0)
+        {
+            ec_hits++;
+            ecache_unlink(pProg);
+            ecache_push(pProg);
+            return pProg;
+        }
+
+        // A different text with the same hash. The newcomer replaces it.
+        //
+        ecache_remove(pProg);
+    }
+    ec_misses++;
+
+    pProg = (EVAL_PROG *)MEMALLOC(sizeof(EVAL_PROG) + nText + 1);
+    ISOUTOFMEMORY(pProg);
+    pProg->key = key;
+    pProg->nRefs = 0;
+    pProg->bStale = false;
+    pProg->nSites = 0;
+    pProg->nSitesAlloc = 0;
+    pProg->aSites = nullptr;
+    pProg->nText = nText;
+    pProg->pText = (UTF8 *)(pProg + 1);
+    memcpy(pProg->pText, pStr, nText + 1);
+
+    hashaddLEN(&key, sizeof(key), pProg, &mudstate.eval_htab);
+    nEvalEntries++;
+    ecache_push(pProg);
+    return pProg;
+}
+
+// Find the site recorded at the given offset. If there isn't one,
+// *piInsert receives the position where it belongs.
+//
+static EVAL_SITE *ecache_find_site(EVAL_PROG *pProg, size_t iSite, int *piInsert)
+{
+    int lo = 0;
+    int hi = pProg->nSites - 1;
+    while (lo <= hi)
+    {
+        int mid = (lo + hi)/2;
+        EVAL_SITE *pSite = pProg->aSites[mid];
+        if (pSite->iSite == iSite)
+        {
+            return pSite;
+        }
+        else if (pSite->iSite < iSite)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid - 1;
+        }
+    }
+    *piInsert = lo;
+    return nullptr;
+}
+
+static EVAL_SITE *ecache_add_site(EVAL_PROG *pProg, int iInsert, size_t iSite, int nArgs)
+{
+    if (pProg->nSites == pProg->nSitesAlloc)
+    {
+        int nAlloc = (0 == pProg->nSitesAlloc) ? 8 : 2*pProg->nSitesAlloc;
+        EVAL_SITE **aSites = (EVAL_SITE **)MEMALLOC(nAlloc * sizeof(EVAL_SITE *));
+        ISOUTOFMEMORY(aSites);
+        if (pProg->aSites)
+        {
+            memcpy(aSites, pProg->aSites, pProg->nSites * sizeof(EVAL_SITE *));
+            MEMFREE(pProg->aSites);
+        }
+        pProg->aSites = aSites;
+        pProg->nSitesAlloc = nAlloc;
+    }
+
+    size_t nSize = sizeof(EVAL_SITE);
+    if (1 < nArgs)
+    {
+        nSize += (nArgs - 1) * sizeof(EVAL_ARG);
+    }
+    EVAL_SITE *pSite = (EVAL_SITE *)MEMALLOC(nSize);
+    ISOUTOFMEMORY(pSite);
+    memset(pSite, 0, sizeof(EVAL_SITE));
+    pSite->iSite = iSite;
+
+    memmove(pProg->aSites + iInsert + 1, pProg->aSites + iInsert,
+        (pProg->nSites - iInsert) * sizeof(EVAL_SITE *));
+    pProg->aSites[iInsert] = pSite;
+    pProg->nSites++;
+    return pSite;
+}
+
+// Find the boundaries of an argument list without evaluating it. This
+// follows parse_arglist_lite() exactly.
+//
+static const UTF8 *parse_arglist_bounds(const UTF8 *pText, const UTF8 *dstr,
+    int nfargs, EVAL_ARG aArgs[], int *nArgsParsed)
+{
+    const UTF8 *pCurr = dstr;
+    const UTF8 *pNext = dstr;
+    size_t nLen;
+    int  arg = 0;
+    int  iWhichDelim = 0;
+
+    while (  arg < nfargs
+          && pNext
+          && iWhichDelim != 2)
+    {
+        pCurr = pNext;
+        if (arg < nfargs - 1)
+        {
+            pNext = parse_to_lite(pCurr, ',', ')', &nLen, &iWhichDelim);
+        }
+        else
+        {
+            pNext = parse_to_lite(pCurr, '\0', ')', &nLen, &iWhichDelim);
+        }
+
+        if (  2 == iWhichDelim
+           && 0 == arg
+           && 0 == nLen)
+        {
+            break;
+        }
+
+        if (aArgs)
+        {
+            aArgs[arg].iArg = pCurr - pText;
+            aArgs[arg].nArg = nLen;
+        }
+        arg++;
+    }
+    *nArgsParsed = arg;
+    return pNext;
+}
+
+// Record the function name and argument boundaries for the '(' at pSite.
+//
+static EVAL_SITE *ecache_function_site(EVAL_PROG *pProg, const UTF8 *pSite,
+    const UTF8 *pName, size_t nName, FUN *fp, int nfargs)
+{
+    size_t iSite = pSite - pProg->pText;
+    int iInsert;
+    EVAL_SITE *pEntry = ecache_find_site(pProg, iSite, &iInsert);
+    if (pEntry)
+    {
+        return pEntry;
+    }
+
+    int nArgs;
+    parse_arglist_bounds(pProg->pText, pSite + 1, nfargs, nullptr, &nArgs);
+
+    pEntry = ecache_add_site(pProg, iInsert, iSite, nArgs);
+    pEntry->nName = nName;
+    memcpy(pEntry->aName, pName, nName);
+    pEntry->fp = fp;
+    pEntry->nfargs = nfargs;
+
+    const UTF8 *pNext = parse_arglist_bounds(pProg->pText, pSite + 1,
+        nfargs, pEntry->aArgs, &pEntry->nArgs);
+    if (pNext)
+    {
+        pEntry->bClosed = true;
+        pEntry->iNext = pNext - pProg->pText;
+    }
+    return pEntry;
+}
+
+// Find the end of the [] or {} starting at pSite, recording it the first
+// time.
+//
+static const UTF8 *ecache_bracket_site(EVAL_PROG *pProg, const UTF8 *pSite,
+    UTF8 delim, size_t *nLen)
+{
+    size_t iSite = pSite - pProg->pText;
+    int iInsert;
+    EVAL_SITE *pEntry = ecache_find_site(pProg, iSite, &iInsert);
+    if (nullptr == pEntry)
+    {
+        int iWhichDelim;
+        const UTF8 *pNext = parse_to_lite(pSite + 1, delim, '\0', nLen, &iWhichDelim);
+
+        pEntry = ecache_add_site(pProg, iInsert, iSite, 0);
+        pEntry->nInner = *nLen;
+        if (pNext)
+        {
+            pEntry->bClosed = true;
+            pEntry->iNext = pNext - pProg->pText;
+        }
+        return pNext;
+    }
+
+    ec_scans_saved++;
+    *nLen = pEntry->nInner;
+    if (pEntry->bClosed)
+    {
+        return pProg->pText + pEntry->iNext;
+    }
+    return nullptr;
+}
+
+// Evaluate an argument list using recorded boundaries. This produces the
+// same arguments as parse_arglist_lite().
+//
+static const UTF8 *eval_arglist_site( dbref executor, dbref caller, dbref enactor,
+                          const EVAL_PROG *pProg, const EVAL_SITE *pEntry,
+                          int eval, UTF8 *fargs[], const UTF8 *cargs[],
+                          int ncargs, int *nArgsParsed)
+{
+    int peval = eval;
+    if (eval & EV_EVAL)
+    {
+        peval = eval | EV_FCHECK;
+    }
+    else
+    {
+        peval = ((eval & ~EV_FCHECK)|EV_NOFCHECK);
+    }
+
+    UTF8 *bp;
+    int arg;
+    for (arg = 0; arg < pEntry->nArgs; arg++)
+    {
+        size_t nLen = pEntry->aArgs[arg].nArg;
+        bp = fargs[arg] = alloc_lbuf("parse_arglist");
+        if (0 < nLen)
+        {
+            mux_exec(pProg->pText + pEntry->aArgs[arg].iArg, nLen, fargs[arg],
+                     &bp, executor, caller, enactor, peval, cargs, ncargs);
+        }
+        *bp = '\0';
+    }
+    *nArgsParsed = arg;
+    if (pEntry->bClosed)
+    {
+        return pProg->pText + pEntry->iNext;
+    }
+    return nullptr;
+}
+
+/*! \brief Evaluate attribute text through the program cache.
+ *
+ * This is equivalent to calling mux_exec() on the whole of pStr. Callers use
+ * it for text which is likely to be evaluated again.
+ *
+ * \param pStr      Text to evaluate.
+ * \param buff      Output buffer.
+ * \param bufc      Current position in output buffer.
+ * \param executor  Executor.
+ * \param caller    Caller.
+ * \param enactor   Enactor.
+ * \param eval      Evaluation flags.
+ * \param cargs     %0-%9 arguments.
+ * \param ncargs    Number of arguments.
+ * \return          None.
+ */
+
+void mux_exec_cached(const UTF8 *pStr, UTF8 *buff, UTF8 **bufc, dbref executor,
+                     dbref caller, dbref enactor, int eval, const UTF8 *cargs[],
+                     int ncargs)
+{
+    if (  mudconf.eval_cache_size <= 0
+       || nullptr == pStr
+       || '\0' == pStr[0])
+    {
+        mux_exec(pStr, LBUF_SIZE-1, buff, bufc, executor, caller, enactor,
+            eval, cargs, ncargs);
+        return;
+    }
+
+    EVAL_PROG *pProg = ecache_fetch(pStr);
+    pProg->nRefs++;
+    ecache_trim();
+
+    EVAL_PROG *pSave = pEvalCurrent;
+    pEvalCurrent = pProg;
+    mux_exec(pProg->pText, pProg->nText, buff, bufc, executor, caller, enactor,
+        eval, cargs, ncargs);
+    pEvalCurrent = pSave;
+
+    pProg->nRefs--;
+    if (  0 == pProg->nRefs
+       && pProg->bStale)
+    {
+        ecache_destroy(pProg);
+    }
+}
+
 //-----------------------------------------------------------------------------
 // exec: Process a command line, evaluating function calls and %-substitutions.
 //
@@ -1300,6 +1771,18 @@ void mux_exec( const UTF8 *pStr, size_t nStr, UTF8 *buff, UTF8 **bufc, dbref exe
     bool is_trace = (Trace(executor) || (eval & EV_TRACE)) && !(eval & EV_NOTRACE);
     bool is_top = false;
 
+    // Use the sites recorded for the cached program if this text belongs to
+    // it.
+    //
+    EVAL_PROG *pProg = nullptr;
+    EVAL_SITE *pSite;
+    if (  nullptr != pEvalCurrent
+       && pEvalCurrent->pText <= pStr
+       && pStr < pEvalCurrent->pText + pEvalCurrent->nText)
+    {
+        pProg = pEvalCurrent;
+    }
+
     // Extend the buffer if we need to.
     //
     if (LBUF_SIZE - SBUF_SIZE < (*bufc) - buff)
@@ -1413,6 +1896,7 @@ void mux_exec( const UTF8 *pStr, size_t nStr, UTF8 *buff, UTF8 **bufc, dbref exe
 
             fp = nullptr;
             ufp = nullptr;
+            pSite = nullptr;
 
             size_t nFun = 0;
             if (oldp <= pEnd)
@@ -1435,7 +1919,23 @@ void mux_exec( const UTF8 *pStr, size_t nStr, UTF8 *buff, UTF8 **bufc, dbref exe
             if (  0 < nFun
                && nFun <= MAX_UFUN_NAME_LEN)
             {
-                fp = (FUN *)hashfindLEN(mux_scratch, nFun, &mudstate.func_htab);
+                if (pProg)
+                {
+                    int iInsert;
+                    pSite = ecache_find_site(pProg, pStr + iStr - pProg->pText, &iInsert);
+                }
+
+                if (  pSite
+                   && pSite->nName == nFun
+                   && memcmp(pSite->aName, mux_scratch, nFun) == 0)
+                {
+                    ec_scans_saved++;
+                    fp = pSite->fp;
+                }
+                else
+                {
+                    fp = (FUN *)hashfindLEN(mux_scratch, nFun, &mudstate.func_htab);
+                }
 
                 // If not a builtin func, check for global func.
                 //
@@ -1488,10 +1988,27 @@ void mux_exec( const UTF8 *pStr, size_t nStr, UTF8 *buff, UTF8 **bufc, dbref exe
                     feval = eval & ~(EV_TOP|EV_FMAND);
                 }
 
+                if (  pProg
+                   && nullptr == pSite)
+                {
+                    pSite = ecache_function_site(pProg, pStr + iStr, mux_scratch,
+                        nFun, fp, nfargs);
+                }
+
                 UTF8 **fargs = PushPointers(MAX_ARG);
-                tstr = parse_arglist_lite(executor, caller, enactor,
-                      pStr + iStr + 1, feval, fargs, nfargs, cargs, ncargs,
-                      &nfargs);
+                if (  pSite
+                   && pSite->nfargs == nfargs)
+                {
+                    ec_scans_saved++;
+                    tstr = eval_arglist_site(executor, caller, enactor, pProg,
+                          pSite, feval, fargs, cargs, ncargs, &nfargs);
+                }
+                else
+                {
+                    tstr = parse_arglist_lite(executor, caller, enactor,
+                          pStr + iStr + 1, feval, fargs, nfargs, cargs, ncargs,
+                          &nfargs);
+                }
 
 
                 // If no closing delim, just insert the '(' and continue normally.
@@ -1552,7 +2069,7 @@ void mux_exec( const UTF8 *pStr, size_t nStr, UTF8 *buff, UTF8 **bufc, dbref exe
                             save_global_regs(preserve);
                         }
 
-                        mux_exec(tbuf, LBUF_SIZE-1, buff, &oldp, i, executor, enactor,
+                        mux_exec_cached(tbuf, buff, &oldp, i, executor, enactor,
                             AttrTrace(aflags, feval), (const UTF8 **)fargs, nfargs);
 
                         if (ufp->flags & FN_PRES)
@@ -2223,7 +2740,14 @@ void mux_exec( const UTF8 *pStr, size_t nStr, UTF8 *buff, UTF8 **bufc, dbref exe
             // continue.
             //
             mudstate.nStackNest++;
-            tstr = parse_to_lite(pStr + iStr + 1, ']', '\0', &n, &at_space);
+            if (pProg)
+            {
+                tstr = ecache_bracket_site(pProg, pStr + iStr, ']', &n);
+            }
+            else
+            {
+                tstr = parse_to_lite(pStr + iStr + 1, ']', '\0', &n, &at_space);
+            }
             at_space = 0;
             if (tstr == nullptr)
             {
@@ -2278,7 +2802,14 @@ void mux_exec( const UTF8 *pStr, size_t nStr, UTF8 *buff, UTF8 **bufc, dbref exe
             // continue.
             //
             mudstate.nStackNest++;
-            tstr = parse_to_lite(pStr + iStr + 1, '}', '\0', &n, &at_space);
+            if (pProg)
+            {
+                tstr = ecache_bracket_site(pProg, pStr + iStr, '}', &n);
+            }
+            else
+            {
+                tstr = parse_to_lite(pStr + iStr + 1, '}', '\0', &n, &at_space);
+            }
             at_space = 0;
             if (nullptr == tstr)
             {
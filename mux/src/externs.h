@@ -108,6 +108,8 @@ void finish_mail();
 //
 void DCL_CDECL raw_broadcast(int, __in_z const UTF8 *, ...);
 void list_siteinfo(dbref);
+void begin_broadcast(void);
+void end_broadcast(void);
 void logged_out0(dbref executor, dbref caller, dbref enactor, int eval, int key);
 void logged_out1(dbref executor, dbref caller, dbref enactor, int eval, int key, UTF8 *arg, const UTF8 *cargs[], int ncargs);
 void init_logout_cmdtab(void);
@@ -119,9 +121,12 @@ LBUF_OFFSET trimmed_name(dbref player, UTF8 cbuff[MBUF_SIZE], LBUF_OFFSET nMin,
 /* From cque.cpp */
 int  nfy_que(dbref, int, int, int);
 int  halt_que(dbref, dbref);
+void chown_que(dbref);
 void wait_que(dbref executor, dbref caller, dbref enactor, int, bool,
     CLinearTimeAbsolute&, dbref, int, UTF8 *, int, const UTF8 *[], reg_ref *[]);
 void query_complete(UINT32 hQuery, UINT32 iError, CResultsSet *prs);
+void list_questats(dbref);
+void list_queue_shares(dbref);
 
 #if defined(UNIX_CRYPT)
 extern "C" char *crypt(const char *inptr, const char *inkey);
@@ -136,6 +141,14 @@ void parse_arglist(dbref executor, dbref caller, dbref enactor, UTF8 *,
 int get_gender(dbref);
 void mux_exec(const UTF8 *pdstr, size_t nStr, UTF8 *buff, UTF8 **bufc, dbref executor,
               dbref caller, dbref enactor, int eval, const UTF8 *cargs[], int ncargs);
+void mux_exec_cached(const UTF8 *pStr, UTF8 *buff, UTF8 **bufc, dbref executor,
+                     dbref caller, dbref enactor, int eval, const UTF8 *cargs[],
+                     int ncargs);
+void eval_cache_flush(void);
+extern int ec_hits;
+extern int ec_misses;
+extern int ec_evictions;
+extern int ec_scans_saved;
 
 inline void BufAddRef(lbuf_ref *lbufref)
 {
@@ -249,8 +262,27 @@ bool regexp_match
     UTF8 *str,
     int case_opt,
     UTF8 *args[],
-    int nargs
+    int nargs,
+    dbref thing,
+    int atr
+);
+
+struct real_pcre;
+struct pcre_extra;
+struct real_pcre *regexp_compile_cached
+(
+    const UTF8  *pattern,
+    int          case_opt,
+    dbref        thing,
+    int          atr,
+    struct pcre_extra **pstudy,
+    const char **perrptr
 );
+void regexp_cache_invalidate(dbref thing, int atr);
+extern int rc_hits;
+extern int rc_misses;
+extern int rc_evictions;
+extern int rc_invalidates;
 
 bool list_check
 (
@@ -271,6 +303,8 @@ bool html_escape(const UTF8 *src, UTF8 *dest, UTF8 **destp);
 #define NUM_DUMP_TYPES   5
 void dump_database_internal(int);
 void fork_and_dump(int key);
+bool dump_snapshot_continue(void);
+void dump_snapshot_abandon(void);
 
 #define MUX_OPEN_INVALID_HANDLE_VALUE (-1)
 bool mux_fopen(FILE **pFile, const UTF8 *filename, const UTF8 *mode);
@@ -450,6 +484,11 @@ void SetClearFlags(dbref thing, FLAG aClearFlags[3], FLAG aSetFlags[3]);
 bool eval_boolexp(dbref, dbref, dbref, BOOLEXP *);
 BOOLEXP *parse_boolexp(dbref, const UTF8 *, bool);
 bool eval_boolexp_atr(dbref, dbref, dbref, UTF8 *);
+bool eval_boolexp_lock(dbref player, dbref thing, dbref from, int locknum);
+void lock_cache_invalidate(dbref thing, int atr);
+void lock_cache_flush(void);
+extern int lc_parses;
+extern int lc_saved;
 
 /* From functions.cpp */
 bool xlate(UTF8 *);
@@ -512,7 +551,7 @@ void atr_push(void);
 void atr_pop(void);
 int  atr_head(dbref, unsigned char **);
 int  atr_next(UTF8 **);
-int  init_dbfile(UTF8 *game_dir_file, UTF8 *game_pag_file, int nCachePages);
+int  init_dbfile(UTF8 *game_dir_file, UTF8 *game_pag_file, int nCachePages, bool bMapped);
 void atr_cpy(dbref dest, dbref source, bool bInternal);
 void atr_chown(dbref);
 void atr_clr(dbref, int);
@@ -542,6 +581,8 @@ UTF8 *atr_pget_str(UTF8 *, dbref, int, dbref *, int *);
 bool atr_get_info(dbref, int, dbref *, int *);
 bool atr_pget_info(dbref, int, dbref *, int *);
 void atr_free(dbref);
+const ATRCMD *atr_cmd_list(dbref thing, int *pnCmds);
+const ATRCMD *atr_cmd_find(dbref thing, int atr);
 bool check_zone_handler(dbref player, dbref thing, bool bPlayerCheck);
 #define check_zone(player, thing) check_zone_handler(player, thing, false)
 void ReleaseAllResources(dbref obj);
@@ -1035,12 +1076,14 @@ extern pid_t game_pid;
 //
 void init_timer(void);
 void dispatch_DatabaseDump(void *pUnused, int iUnused);
+void dispatch_DatabaseSnapshot(void *pUnused, int iUnused);
 void dispatch_FreeListReconstruction(void *pUnused, int iUnused);
 void dispatch_IdleCheck(void *pUnused, int iUnused);
 void dispatch_CheckEvents(void *pUnused, int iUnused);
 void dispatch_KeepAlive(void *pUnused, int iUnused);
 #ifndef MEMORY_BASED
 void dispatch_CacheTick(void *pUnused, int iUnused);
+void dispatch_WalCommit(void *pUnused, int iUnused);
 #endif
 
 // Using a heap as the data structure for representing this priority
@@ -1055,7 +1098,7 @@ void dispatch_CacheTick(void *pUnused, int iUnused);
 //
 typedef void FTASK(void *, int);
 
-typedef struct
+typedef struct task_record
 {
     CLinearTimeAbsolute ltaWhen;
 
@@ -1065,6 +1108,11 @@ typedef struct
     void       *arg_voidptr;
     int        arg_Integer;
     int        m_iVisitedMark;
+    INT64      m_iShare;        // Fair-share tag ordering ready tasks of one priority.
+    int        m_iHeapIndex;    // Position within whichever heap holds the task.
+    int        m_iWheelSlot;    // Timing wheel slot holding the task, or -1.
+    struct task_record *m_pWheelNext;
+    struct task_record *m_pWheelPrev;
 } TASK_RECORD, *PTASK_RECORD;
 
 #define PRIORITY_SYSTEM  100
@@ -1079,6 +1127,7 @@ typedef struct
 
 typedef int SCHCMP(PTASK_RECORD, PTASK_RECORD);
 typedef int SCHLOOK(PTASK_RECORD);
+typedef void SCHREADY(PTASK_RECORD);
 
 class CTaskHeap
 {
@@ -1106,6 +1155,9 @@ public:
     PTASK_RECORD PeekAtTopmost(void);
     PTASK_RECORD RemoveTopmost(SCHCMP *);
     void CancelTask(FTASK *fpTask, void *arg_voidptr, int arg_Integer);
+    bool Contains(PTASK_RECORD pTask);
+    bool RemoveTask(PTASK_RECORD pTask, SCHCMP *pfCompare);
+    bool UpdateTask(PTASK_RECORD pTask, SCHCMP *pfCompare);
 
 #define IU_DONE        0
 #define IU_NEXT_TASK   1
@@ -1115,26 +1167,55 @@ public:
     int TraverseOrdered(SCHLOOK *pfLook, SCHCMP *pfCompare);
 };
 
+// Timed tasks more than a second away wait on a hierarchical timing wheel
+// instead of the WhenHeap.  Level 0 has a slot for each second of a
+// 256-second block, and each higher level has 64 slots, one for each block
+// of the level below.
+//
+#define WHEEL_LEVELS 4
+#define WHEEL_SLOTS  (256 + 3*64)
+
 class CScheduler
 {
 private:
     CTaskHeap m_WhenHeap;
     CTaskHeap m_PriorityHeap;
+    CTaskHeap m_ReadyHeap;      // Tasks becoming ready together, by ticket.
     int       m_Ticket;
     int       m_minPriority;
+    SCHREADY *m_pfReady;
+
+    PTASK_RECORD m_aWheel[WHEEL_SLOTS];
+    INT64     m_nWheelSecond;   // Every task on the wheel is due after this second.
+    int       m_nWheelTasks;
+    int       m_iWheelVisitedMark;
+
+    bool Schedule(PTASK_RECORD pTask);
+    bool WheelInsert(PTASK_RECORD pTask);
+    void WheelRemove(PTASK_RECORD pTask);
+    void WheelEmptySlot(int iSlot);
+    void TurnWheel(const CLinearTimeAbsolute& ltaNow);
+    INT64 WheelNextSecond(void);
+    int  TraverseWheel(SCHLOOK *pfLook);
 
 public:
     void TraverseUnordered(SCHLOOK *pfLook);
     void TraverseOrdered(SCHLOOK *pfLook);
-    CScheduler(void) { m_Ticket = 0; m_minPriority = PRIORITY_CF_DEQUEUE_ENABLED; }
-    void DeferTask(const CLinearTimeAbsolute& ltWhen, int iPriority, FTASK *fpTask, void *arg_voidptr, int arg_Integer);
-    void DeferImmediateTask(int iPriority, FTASK *fpTask, void *arg_voidptr, int arg_Integer);
+    CScheduler(void);
+    ~CScheduler(void);
+    PTASK_RECORD DeferTask(const CLinearTimeAbsolute& ltWhen, int iPriority, FTASK *fpTask, void *arg_voidptr, int arg_Integer);
+    PTASK_RECORD DeferImmediateTask(int iPriority, FTASK *fpTask, void *arg_voidptr, int arg_Integer);
     bool WhenNext(CLinearTimeAbsolute *);
     int  RunTasks(int iCount);
     int  RunAllTasks(void);
     int  RunTasks(const CLinearTimeAbsolute& tNow);
+    bool IsReady(PTASK_RECORD pTask);
+    void SetReadyHook(SCHREADY *pfReady) { m_pfReady = pfReady; }
     void ReadyTasks(const CLinearTimeAbsolute& tNow);
     void CancelTask(FTASK *fpTask, void *arg_voidptr, int arg_Integer);
+    void CancelTask(PTASK_RECORD pTask);
+    void UpdateTask(PTASK_RECORD pTask);
+    int  CompareOrdered(PTASK_RECORD pTaskA, PTASK_RECORD pTaskB);
     void Shrink(void);
 
     void SetMinPriority(int arg_minPriority);
@@ -1142,6 +1223,7 @@ public:
 };
 
 extern CScheduler scheduler;
+void que_ready(PTASK_RECORD pTask);
 
 int fetch_cmds(dbref target);
 void fetch_ConnectionInfoFields(dbref target, long anFields[4]);
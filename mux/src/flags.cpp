@@ -34,10 +34,12 @@ static bool fh_any(dbref target, dbref player, FLAG flag, int fflags, bool reset
     //
     if (reset)
     {
+        SnapshotTouch(target);
         db[target].fs.word[fflags] &= ~flag;
     }
     else
     {
+        SnapshotTouch(target);
         db[target].fs.word[fflags] |= flag;
     }
     return true;
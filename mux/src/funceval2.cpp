@@ -718,7 +718,7 @@ FUNCTION(fun_mix)
                 os[i] = T("");
             }
         }
-        mux_exec(atext, LBUF_SIZE-1, buff, bufc, thing, executor, enactor,
+        mux_exec_cached(atext, buff, bufc, thing, executor, enactor,
             AttrTrace(aflags, EV_STRIP_CURLY|EV_FCHECK|EV_EVAL),
             os, lastn);
     }
@@ -787,7 +787,7 @@ FUNCTION(fun_step)
         {
             os[i] = split_token(&cp, isep);
         }
-        mux_exec(atext, LBUF_SIZE-1, buff, bufc, executor, caller, enactor,
+        mux_exec_cached(atext, buff, bufc, executor, caller, enactor,
              AttrTrace(aflags, EV_STRIP_CURLY|EV_FCHECK|EV_EVAL), os, i);
     }
     free_lbuf(atext);
@@ -884,7 +884,7 @@ FUNCTION(fun_foreach)
                 }
             }
 
-            mux_exec(atext, LBUF_SIZE-1, buff, bufc, thing, executor, enactor,
+            mux_exec_cached(atext, buff, bufc, thing, executor, enactor,
                 AttrTrace(aflags, EV_STRIP_CURLY|EV_FCHECK|EV_EVAL), &bp, 1);
             prev = cbuf[0];
         }
@@ -897,7 +897,7 @@ FUNCTION(fun_foreach)
         {
             nBytes = sStr->export_Char_UTF8(i, cbuf);
 
-            mux_exec(atext, LBUF_SIZE-1, buff, bufc, thing, executor, enactor,
+            mux_exec_cached(atext, buff, bufc, thing, executor, enactor,
                 AttrTrace(aflags, EV_STRIP_CURLY|EV_FCHECK|EV_EVAL), &bp, 1);
             i = i + nBytes;
         }
@@ -1045,7 +1045,7 @@ FUNCTION(fun_munge)
     bp = rlist = alloc_lbuf("fun_munge");
     uargs[0] = list1;
     uargs[1] = sep.str;
-    mux_exec(atext, LBUF_SIZE-1, rlist, &bp, executor, caller, enactor,
+    mux_exec_cached(atext, rlist, &bp, executor, caller, enactor,
              AttrTrace(aflags, EV_STRIP_CURLY|EV_FCHECK|EV_EVAL), uargs, 2);
     *bp = '\0';
     free_lbuf(atext);
@@ -1209,9 +1209,9 @@ FUNCTION(fun_dumping)
     UNUSED_PARAMETER(ncargs);
 
 #if !defined(HAVE_WORKING_FORK)
-    safe_chr('0', buff, bufc);
+    safe_bool(mudstate.snapshot, buff, bufc);
 #else // HAVE_WORKING_FORK
-    safe_bool(mudstate.dumping, buff, bufc);
+    safe_bool(mudstate.dumping || mudstate.snapshot, buff, bufc);
 #endif // HAVE_WORKING_FORK
 }
 
@@ -2240,15 +2240,15 @@ static void real_regmatch(const UTF8 *search, const UTF8 *pattern, UTF8 *registe
     }
 
     const char *errptr;
-    int erroffset;
     // To capture N substrings, you need space for 3(N+1) offsets in the
     // offset vector. We'll allow 2N-1 substrings and possibly ignore some.
     //
     const int ovecsize = 6 * MAX_GLOBAL_REGS;
     int ovec[ovecsize];
 
-    pcre *re = pcre_compile((char *)pattern, PCRE_UTF8|(cis ? PCRE_CASELESS : 0),
-        &errptr, &erroffset, nullptr);
+    pcre_extra *study;
+    pcre *re = regexp_compile_cached(pattern, cis ? PCRE_CASELESS : 0,
+        NOTHING, 0, &study, &errptr);
     if (!re)
     {
         // Matching error.
@@ -2258,7 +2258,7 @@ static void real_regmatch(const UTF8 *search, const UTF8 *pattern, UTF8 *registe
         return;
     }
 
-    int matches = pcre_exec(re, nullptr, (char *)search, static_cast<int>(strlen((char *)search)), 0, 0,
+    int matches = pcre_exec(re, study, (char *)search, static_cast<int>(strlen((char *)search)), 0, 0,
         ovec, ovecsize);
     if (matches == 0)
     {
@@ -2277,7 +2277,6 @@ static void real_regmatch(const UTF8 *search, const UTF8 *pattern, UTF8 *registe
     //
     if (nfargs != 3)
     {
-        MEMFREE(re);
         return;
     }
 
@@ -2311,7 +2310,6 @@ static void real_regmatch(const UTF8 *search, const UTF8 *pattern, UTF8 *registe
             free_lbuf(p);
         }
     }
-    MEMFREE(re);
 }
 
 FUNCTION(fun_regmatch)
@@ -2354,17 +2352,16 @@ static void real_regrab(__in UTF8 *search, __in const UTF8 *pattern, __in const
         return;
     }
     pcre *re;
-    pcre_extra *study = nullptr;
+    pcre_extra *study;
     const char *errptr;
-    int erroffset;
     // To capture N substrings, you need space for 3(N+1) offsets in the
     // offset vector. We'll allow 2N-1 substrings and possibly ignore some.
     //
     const int ovecsize = 6 * MAX_GLOBAL_REGS;
     int ovec[ovecsize];
 
-    re = pcre_compile((char *)pattern, PCRE_UTF8|(cis ? PCRE_CASELESS : 0),
-        &errptr, &erroffset, nullptr);
+    re = regexp_compile_cached(pattern, cis ? PCRE_CASELESS : 0, NOTHING, 0,
+        &study, &errptr);
     if (!re)
     {
         // Matching error.
@@ -2374,11 +2371,6 @@ static void real_regrab(__in UTF8 *search, __in const UTF8 *pattern, __in const
         return;
     }
 
-    if (all)
-    {
-        study = pcre_study(re, 0, &errptr);
-    }
-
     bool first = true;
     UTF8 *s = trim_space_sep(search, sep);
     do
@@ -2402,12 +2394,6 @@ static void real_regrab(__in UTF8 *search, __in const UTF8 *pattern, __in const
             }
         }
     } while (s);
-
-    MEMFREE(re);
-    if (study)
-    {
-        MEMFREE(study);
-    }
 }
 
 FUNCTION(fun_regrab)
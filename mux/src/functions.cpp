@@ -2193,7 +2193,7 @@ static void do_ufun(UTF8 *buff, UTF8 **bufc, dbref executor, dbref caller,
 
     // Evaluate it using the rest of the passed function args.
     //
-    mux_exec(atext, LBUF_SIZE-1, buff, bufc, thing, executor, enactor,
+    mux_exec_cached(atext, buff, bufc, thing, executor, enactor,
         AttrTrace(aflags, EV_FCHECK|EV_EVAL),
         (const UTF8 **)&(fargs[1]), nfargs - 1);
     free_lbuf(atext);
@@ -6726,7 +6726,7 @@ static FUNCTION(fun_fold)
         clist[0] = fargs[2];
         clist[1] = split_token(&cp, sep);
         result = bp = alloc_lbuf("fun_fold");
-        mux_exec(atext, LBUF_SIZE-1, result, &bp, thing, executor, enactor,
+        mux_exec_cached(atext, result, &bp, thing, executor, enactor,
             AttrTrace(aflags, EV_STRIP_CURLY|EV_FCHECK|EV_EVAL),
             clist, 2);
         *bp = '\0';
@@ -6736,7 +6736,7 @@ static FUNCTION(fun_fold)
         clist[0] = split_token(&cp, sep);
         clist[1] = split_token(&cp, sep);
         result = bp = alloc_lbuf("fun_fold");
-        mux_exec(atext, LBUF_SIZE-1, result, &bp, thing, executor, enactor,
+        mux_exec_cached(atext, result, &bp, thing, executor, enactor,
             AttrTrace(aflags, EV_STRIP_CURLY|EV_FCHECK|EV_EVAL),
             clist, 2);
         *bp = '\0';
@@ -6752,7 +6752,7 @@ static FUNCTION(fun_fold)
         clist[0] = rstore;
         clist[1] = split_token(&cp, sep);
         bp = result;
-        mux_exec(atext, LBUF_SIZE-1, result, &bp, thing, executor, enactor,
+        mux_exec_cached(atext, result, &bp, thing, executor, enactor,
             AttrTrace(aflags, EV_STRIP_CURLY|EV_FCHECK|EV_EVAL),
             clist, 2);
         *bp = '\0';
@@ -7158,7 +7158,7 @@ static void filter_handler(__inout UTF8 *buff, __deref_inout UTF8 **bufc, dbref
             UTF8 *objstring = split_token(&cp, sep);
             UTF8 *bp = result;
             filter_args[0] = objstring;
-            mux_exec(atext, LBUF_SIZE-1, result, &bp, thing, executor, enactor,
+            mux_exec_cached(atext, result, &bp, thing, executor, enactor,
                 AttrTrace(aflags, EV_STRIP_CURLY|EV_FCHECK|EV_EVAL),
                 filter_args, filter_nargs);
             *bp = '\0';
@@ -7271,7 +7271,7 @@ static FUNCTION(fun_map)
             first = false;
             UTF8 *objstring = split_token(&cp, sep);
             map_args[0] = objstring;
-            mux_exec(atext, LBUF_SIZE-1, buff, bufc, thing, executor, enactor,
+            mux_exec_cached(atext, buff, bufc, thing, executor, enactor,
                 AttrTrace(aflags, EV_STRIP_CURLY|EV_FCHECK|EV_EVAL),
                 map_args, map_nargs);
         }
@@ -11269,6 +11269,7 @@ void function_add(FUN *fp)
     if (nullptr == hashfindLEN(pCased, nCased, &mudstate.func_htab))
     {
         hashaddLEN(pCased, nCased, fp, &mudstate.func_htab);
+        eval_cache_flush();
     }
 }
 
@@ -11277,6 +11278,7 @@ void function_remove(FUN *fp)
     size_t nCased;
     UTF8 *pCased = mux_strupr(fp->name, nCased);
     hashdeleteLEN(pCased, nCased, &mudstate.func_htab);
+    eval_cache_flush();
 }
 
 void functions_add(FUN funlist[])
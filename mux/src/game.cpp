@@ -16,6 +16,7 @@
 #include "file_c.h"
 #include "functions.h"
 #include "help.h"
+#include "mathutil.h"
 #include "mguests.h"
 #include "muxcli.h"
 #include "pcre.h"
@@ -43,6 +44,11 @@ void do_dump(dbref executor, dbref caller, dbref enactor, int eval, int key)
         return;
     }
 #endif
+    if (mudstate.snapshot)
+    {
+        notify(executor, T("Dumping in progress. Try again later."));
+        return;
+    }
     notify(executor, T("Dumping..."));
     fork_and_dump(key);
 }
@@ -71,6 +77,281 @@ void report(void)
     }
 }
 
+/* ----------------------------------------------------------------------
+ * Compiled regular expression cache.
+ *
+ * $-commands, ^-listens, @filter, regmatch(), and regrab() all compile their
+ * patterns on every use. The cache below keeps the compiled pattern and its
+ * study information keyed on the pattern text and case option. Like the
+ * attribute cache, it is organized by a CHashTable and a linked list. The
+ * former allows random access while the linked list helps find the
+ * least-recently-used pattern when the cache exceeds regexp_cache_size.
+ *
+ * Patterns which came from an attribute are also threaded onto a per-
+ * attribute list so that writing the attribute releases them immediately
+ * rather than waiting for them to age out.
+ */
+
+int rc_hits        = 0;     // Lookups satisfied from the cache.
+int rc_misses      = 0;     // Lookups which required pcre_compile().
+int rc_evictions   = 0;     // Entries trimmed as least-recently-used.
+int rc_invalidates = 0;     // Entries released by an attribute write.
+
+typedef struct tagRegexpCacheKey
+{
+    UINT32 nHash;
+    UINT32 nPattern;
+    int    case_opt;
+} RCACHE_KEY;
+
+typedef struct tagRegexpCacheEntry
+{
+    struct tagRegexpCacheEntry *pPrevEntry;
+    struct tagRegexpCacheEntry *pNextEntry;
+    struct tagRegexpCacheEntry *pPrevOwned;
+    struct tagRegexpCacheEntry *pNextOwned;
+    RCACHE_KEY  key;
+    bool        bOwned;
+    Aname       owner;
+    pcre       *re;
+    pcre_extra *study;
+} RCACHE_ENT, *PRCACHE_ENT;
+
+static PRCACHE_ENT pRegexpHead = nullptr;
+static PRCACHE_ENT pRegexpTail = nullptr;
+static int nRegexpEntries = 0;
+
+static void rcache_unlink(PRCACHE_ENT pEntry)
+{
+    if (pEntry->pPrevEntry)
+    {
+        pEntry->pPrevEntry->pNextEntry = pEntry->pNextEntry;
+    }
+    else
+    {
+        pRegexpHead = pEntry->pNextEntry;
+    }
+
+    if (pEntry->pNextEntry)
+    {
+        pEntry->pNextEntry->pPrevEntry = pEntry->pPrevEntry;
+    }
+    else
+    {
+        pRegexpTail = pEntry->pPrevEntry;
+    }
+}
+
+static void rcache_push(PRCACHE_ENT pEntry)
+{
+    if (pRegexpHead)
+    {
+        pRegexpHead->pPrevEntry = pEntry;
+    }
+    pEntry->pNextEntry = pRegexpHead;
+    pEntry->pPrevEntry = nullptr;
+    pRegexpHead = pEntry;
+    if (!pRegexpTail)
+    {
+        pRegexpTail = pRegexpHead;
+    }
+}
+
+// Remove an entry from the per-attribute list of its owner.
+//
+static void rcache_disown(PRCACHE_ENT pEntry)
+{
+    if (!pEntry->bOwned)
+    {
+        return;
+    }
+
+    if (pEntry->pNextOwned)
+    {
+        pEntry->pNextOwned->pPrevOwned = pEntry->pPrevOwned;
+    }
+
+    if (pEntry->pPrevOwned)
+    {
+        pEntry->pPrevOwned->pNextOwned = pEntry->pNextOwned;
+    }
+    else if (pEntry->pNextOwned)
+    {
+        hashreplLEN(&pEntry->owner, sizeof(Aname), pEntry->pNextOwned,
+            &mudstate.regexp_owner_htab);
+    }
+    else
+    {
+        hashdeleteLEN(&pEntry->owner, sizeof(Aname),
+            &mudstate.regexp_owner_htab);
+    }
+    pEntry->pPrevOwned = nullptr;
+    pEntry->pNextOwned = nullptr;
+    pEntry->bOwned = false;
+}
+
+static void rcache_free(PRCACHE_ENT pEntry)
+{
+    rcache_unlink(pEntry);
+    rcache_disown(pEntry);
+    hashdeleteLEN(&pEntry->key, sizeof(RCACHE_KEY), &mudstate.regexp_htab);
+    nRegexpEntries--;
+
+    MEMFREE(pEntry->re);
+    if (pEntry->study)
+    {
+        MEMFREE(pEntry->study);
+    }
+    MEMFREE(pEntry);
+}
+
+static void rcache_trim(void)
+{
+    // The entry at the head of the list was just handed to a caller, so at
+    // least one entry is always kept.
+    //
+    while (  1 < nRegexpEntries
+          && mudconf.regexp_cache_size < nRegexpEntries)
+    {
+        rc_evictions++;
+        rcache_free(pRegexpTail);
+    }
+}
+
+/*! \brief Find or compile a regular expression.
+ *
+ * The returned pattern and study information belong to the cache and must
+ * not be freed by the caller. They remain valid until the next call into
+ * the cache.
+ *
+ * \param pattern   Regular expression.
+ * \param case_opt  0 or PCRE_CASELESS.
+ * \param thing     Object holding the pattern or NOTHING.
+ * \param atr       Attribute holding the pattern.
+ * \param pstudy    Receives study information (possibly nullptr).
+ * \param perrptr   Receives error message if the compile fails.
+ * \return          Compiled pattern or nullptr.
+ */
+
+pcre *regexp_compile_cached
+(
+    const UTF8  *pattern,
+    int          case_opt,
+    dbref        thing,
+    int          atr,
+    pcre_extra **pstudy,
+    const char **perrptr
+)
+{
+    size_t nPattern = strlen((const char *)pattern);
+
+    RCACHE_KEY key;
+    memset(&key, 0, sizeof(key));
+    key.nHash    = HASH_ProcessBuffer(0, pattern, nPattern);
+    key.nPattern = static_cast<UINT32>(nPattern);
+    key.case_opt = case_opt;
+
+    PRCACHE_ENT pEntry = (PRCACHE_ENT)hashfindLEN(&key, sizeof(key),
+        &mudstate.regexp_htab);
+    if (pEntry)
+    {
+        if (memcmp(pEntry + 1, pattern, nPattern) == 0)
+        {
+            rc_hits++;
+            rcache_unlink(pEntry);
+            rcache_push(pEntry);
+            *pstudy = pEntry->study;
+            return pEntry->re;
+        }
+
+        // A different pattern with the same hash. The newcomer replaces it.
+        //
+        rcache_free(pEntry);
+    }
+    rc_misses++;
+
+    int erroffset;
+    pcre *re = pcre_compile((const char *)pattern, PCRE_UTF8|case_opt,
+        perrptr, &erroffset, nullptr);
+    if (nullptr == re)
+    {
+        *pstudy = nullptr;
+        return nullptr;
+    }
+
+    const char *errptr;
+    pcre_extra *study = pcre_study(re, 0, &errptr);
+
+    pEntry = (PRCACHE_ENT)MEMALLOC(sizeof(RCACHE_ENT) + nPattern);
+    ISOUTOFMEMORY(pEntry);
+    memcpy(pEntry + 1, pattern, nPattern);
+    pEntry->key = key;
+    pEntry->re = re;
+    pEntry->study = study;
+    pEntry->pPrevOwned = nullptr;
+    pEntry->pNextOwned = nullptr;
+    pEntry->bOwned = false;
+
+    if (Good_obj(thing))
+    {
+        pEntry->bOwned = true;
+        pEntry->owner.object  = thing;
+        pEntry->owner.attrnum = atr;
+
+        PRCACHE_ENT pOwned = (PRCACHE_ENT)hashfindLEN(&pEntry->owner,
+            sizeof(Aname), &mudstate.regexp_owner_htab);
+        if (pOwned)
+        {
+            pOwned->pPrevOwned = pEntry;
+            pEntry->pNextOwned = pOwned;
+            hashreplLEN(&pEntry->owner, sizeof(Aname), pEntry,
+                &mudstate.regexp_owner_htab);
+        }
+        else
+        {
+            hashaddLEN(&pEntry->owner, sizeof(Aname), pEntry,
+                &mudstate.regexp_owner_htab);
+        }
+    }
+
+    hashaddLEN(&key, sizeof(key), pEntry, &mudstate.regexp_htab);
+    nRegexpEntries++;
+    rcache_push(pEntry);
+    rcache_trim();
+
+    *pstudy = study;
+    return re;
+}
+
+/*! \brief Release compiled patterns which came from an attribute.
+ *
+ * Called whenever an attribute is written or cleared.
+ *
+ * \param thing     Object.
+ * \param atr       Attribute number.
+ * \return          None.
+ */
+
+void regexp_cache_invalidate(dbref thing, int atr)
+{
+    if (0 == nRegexpEntries)
+    {
+        return;
+    }
+
+    Aname owner;
+    owner.object  = thing;
+    owner.attrnum = atr;
+
+    PRCACHE_ENT pEntry;
+    while ((pEntry = (PRCACHE_ENT)hashfindLEN(&owner, sizeof(Aname),
+        &mudstate.regexp_owner_htab)) != nullptr)
+    {
+        rc_invalidates++;
+        rcache_free(pEntry);
+    }
+}
+
 /* ----------------------------------------------------------------------
  * regexp_match: Load a regular expression match and insert it into
  * registers.
@@ -82,23 +363,24 @@ bool regexp_match
     UTF8 *str,
     int case_opt,
     UTF8 *args[],
-    int nargs
+    int nargs,
+    dbref thing,
+    int atr
 )
 {
     int matches;
     int i;
     const char *errptr;
-    int erroffset;
 
     /*
-     * Load the regexp pattern. This allocates memory which must be
-     * later freed. A free() of the regexp does free all structures
-     * under it.
+     * Load the regexp pattern. The compiled pattern belongs to the regexp
+     * cache and must not be freed here.
      */
 
     pcre *re;
+    pcre_extra *study;
     if (  alarm_clock.alarmed
-       || (re = pcre_compile((char *)pattern, PCRE_UTF8|case_opt, &errptr, &erroffset, nullptr)) == nullptr)
+       || (re = regexp_compile_cached(pattern, case_opt, thing, atr, &study, &errptr)) == nullptr)
     {
         /*
          * This is a matching error. We have an error message in
@@ -118,11 +400,10 @@ bool regexp_match
      * Now we try to match the pattern. The relevant fields will
      * automatically be filled in by this.
      */
-    matches = pcre_exec(re, nullptr, (char *)str, static_cast<int>(strlen((char *)str)), 0, 0, ovec, ovecsize);
+    matches = pcre_exec(re, study, (char *)str, static_cast<int>(strlen((char *)str)), 0, 0, ovec, ovecsize);
     if (matches < 0)
     {
         delete [] ovec;
-        MEMFREE(re);
         return false;
     }
 
@@ -153,7 +434,6 @@ bool regexp_match
     }
 
     delete [] ovec;
-    MEMFREE(re);
     return true;
 }
 
@@ -180,152 +460,118 @@ static int atr_match1
         return -1;
     }
 
+    // Only the attributes in the command index can match. They are visited
+    // before any of this object's attributes are added to parent_htab, so
+    // the exclusion test below only sees attributes from lower levels.
+    //
     int match = 0;
-    if (  (  AMATCH_CMD    == type
-          && mudstate.bfNoCommands.IsSet(parent))
-       || (  AMATCH_LISTEN == type
-          && mudstate.bfNoListens.IsSet(parent)))
-    {
-        // We may need to process the hash_insert to support exclusion of
-        // this parent's $-commands before we return no matches.
-        //
-        if (hash_insert)
-        {
-            // Because we know this object contains no commands, there is no
-            // need to look at the attribute values.
-            //
-            atr_push();
-            unsigned char *as;
-            for (int atr = atr_head(parent, &as); atr; atr = atr_next(&as))
-            {
-                ATTR *ap = atr_num(atr);
-
-                if (  ap
-                   && 0 == (ap->flags & AF_NOPROG)
-                   && (  !check_exclude
-                      || (  0 == (ap->flags & AF_PRIVATE)
-                         && !hashfindLEN(&(ap->number), sizeof(ap->number), &mudstate.parent_htab))))
-                {
-                    hashaddLEN(&(ap->number), sizeof(ap->number), &atr, &mudstate.parent_htab);
-                }
-            }
-            atr_pop();
-        }
-        return match;
-    }
-
     bool bFoundCommands = false;
     bool bFoundListens  = false;
 
-    atr_push();
-    unsigned char *as;
-    for (int atr = atr_head(parent, &as); atr; atr = atr_next(&as))
+    int nCmds;
+    const ATRCMD *list = atr_cmd_list(parent, &nCmds);
+    for (int i = 0; i < nCmds; i++)
     {
-        ATTR *ap = atr_num(atr);
-
-        // Never check NOPROG attributes.
-        //
-        if (  !ap
-           || (ap->flags & AF_NOPROG))
+        const ATRCMD *pc = list + i;
+        if ('\0' == pc->type)
         {
             continue;
         }
 
-        // We need to grab the attribute even before we know whether we'll use
-        // it or not in order to maintain cached knowledge about ^-Commands
-        // and $-Commands.
-        //
-        dbref aowner;
-        int   aflags;
-        UTF8 buff[LBUF_SIZE];
-        atr_get_str(buff, parent, atr, &aowner, &aflags);
-
-        UTF8 *s = nullptr;
-        if (  0 == (aflags & AF_NOPROG)
-           &&  (  AMATCH_CMD    == buff[0]
-               || AMATCH_LISTEN == buff[0]))
-        {
-            s = (UTF8 *)strchr((char *)buff+1, ':');
-            if (s)
-            {
-                if (AMATCH_CMD == buff[0])
-                {
-                    bFoundCommands = true;
-                }
-                else
-                {
-                    bFoundListens = true;
-                }
-            }
-        }
-
-        // If we aren't the bottom level, check if we saw this attr
-        // before. Also exclude it if the attribute type is PRIVATE.
+        // Never check NOPROG attributes.
         //
-        if (  check_exclude
-           && (  (ap->flags & AF_PRIVATE)
-              || (aflags & AF_PRIVATE)
-              || hashfindLEN(&(ap->number), sizeof(ap->number), &mudstate.parent_htab)))
+        ATTR *ap = atr_num(pc->number);
+        if (  !ap
+           || (ap->flags & AF_NOPROG))
         {
             continue;
         }
 
-        // If we aren't the top level, remember this attr so we
-        // exclude it from now on.
-        //
-        if (hash_insert)
+        if (AMATCH_CMD == pc->type)
         {
-            hashaddLEN(&(ap->number), sizeof(ap->number), &atr, &mudstate.parent_htab);
+            bFoundCommands = true;
         }
-
-        if (aflags & AF_NOPROG)
+        else
         {
-            continue;
+            bFoundListens = true;
         }
 
-        // Check for the leadin character after excluding the attrib.
-        // This lets non-command attribs on the child block commands
-        // on the parent.
-        //
-        if (buff[0] != type)
+        if (pc->type != type)
         {
             continue;
         }
 
-        // Was there a ':'?
+        // If we aren't the bottom level, check if we saw this attr
+        // before. Also exclude it if the attribute type is PRIVATE.
         //
-        if (!s)
+        if (  check_exclude
+           && (  (ap->flags & AF_PRIVATE)
+              || (pc->flags & AF_PRIVATE)
+              || hashfindLEN(&(ap->number), sizeof(ap->number), &mudstate.parent_htab)))
         {
             continue;
         }
-        *s++ = '\0';
 
+        int aflags = pc->flags;
         UTF8 *args[NUM_ENV_VARS];
         if (  (  0 != (aflags & AF_REGEXP)
-            && regexp_match(buff + 1, (aflags & AF_NOPARSE) ? raw_str : str,
-                ((aflags & AF_CASE) ? 0 : PCRE_CASELESS), args, NUM_ENV_VARS))
+            && regexp_match(pc->pattern, (aflags & AF_NOPARSE) ? raw_str : str,
+                ((aflags & AF_CASE) ? 0 : PCRE_CASELESS), args, NUM_ENV_VARS,
+                parent, pc->number))
            || (  0 == (aflags & AF_REGEXP)
-              && wild(buff + 1, (aflags & AF_NOPARSE) ? raw_str : str,
+              && wild(pc->pattern, (aflags & AF_NOPARSE) ? raw_str : str,
                 args, NUM_ENV_VARS)))
         {
             match = 1;
             CLinearTimeAbsolute lta;
             wait_que(thing, player, player, AttrTrace(aflags, 0), false, lta,
                 NOTHING, 0,
-                s,
+                pc->action,
                 NUM_ENV_VARS, (const UTF8 **)args,
                 mudstate.global_regs);
 
-            for (int i = 0; i < NUM_ENV_VARS; i++)
+            for (int j = 0; j < NUM_ENV_VARS; j++)
             {
-                if (args[i])
+                if (args[j])
                 {
-                    free_lbuf(args[i]);
+                    free_lbuf(args[j]);
                 }
             }
         }
     }
-    atr_pop();
+
+    // If we aren't the top level, remember every attr on this object so we
+    // exclude it from now on. This needs attribute numbers, not values.
+    //
+    if (hash_insert)
+    {
+        atr_push();
+        unsigned char *as;
+        for (int atr = atr_head(parent, &as); atr; atr = atr_next(&as))
+        {
+            ATTR *ap = atr_num(atr);
+            if (  !ap
+               || (ap->flags & AF_NOPROG))
+            {
+                continue;
+            }
+
+            if (check_exclude)
+            {
+                const ATRCMD *pc;
+                if (  (ap->flags & AF_PRIVATE)
+                   || (  0 < nCmds
+                      && (pc = atr_cmd_find(parent, atr)) != nullptr
+                      && (pc->flags & AF_PRIVATE))
+                   || hashfindLEN(&(ap->number), sizeof(ap->number), &mudstate.parent_htab))
+                {
+                    continue;
+                }
+            }
+            hashaddLEN(&(ap->number), sizeof(ap->number), &atr, &mudstate.parent_htab);
+        }
+        atr_pop();
+    }
 
     if (bFoundCommands)
     {
@@ -471,24 +717,22 @@ static bool check_filter(dbref object, dbref player, int filter, const UTF8 *msg
         int case_opt = (aflags & AF_CASE) ? 0 : PCRE_CASELESS;
         do
         {
-            int erroffset;
             const char *errptr;
             UTF8 *cp = parse_to(&dp, ',', EV_STRIP_CURLY);
             pcre *re;
+            pcre_extra *study;
             if (  !alarm_clock.alarmed
-               && (re = pcre_compile((char *)cp, PCRE_UTF8|case_opt, &errptr, &erroffset, nullptr)) != nullptr)
+               && (re = regexp_compile_cached(cp, case_opt, NOTHING, 0, &study, &errptr)) != nullptr)
             {
                 const int ovecsize = 33;
                 int ovec[ovecsize];
-                int matches = pcre_exec(re, nullptr, (char *)msg, static_cast<int>(strlen((char *)msg)), 0, 0,
+                int matches = pcre_exec(re, study, (char *)msg, static_cast<int>(strlen((char *)msg)), 0, 0,
                     ovec, ovecsize);
                 if (0 <= matches)
                 {
-                    MEMFREE(re);
                     free_lbuf(nbuf);
                     return false;
                 }
-                MEMFREE(re);
             }
         } while (dp != nullptr);
     }
@@ -980,6 +1224,7 @@ void notify_check(dbref target, dbref sender, const mux_string &msg, int key)
                 msgFinal->import(msg);
             }
 
+            begin_broadcast();
             DOLIST(obj, Contents(target))
             {
                 if (obj != target)
@@ -988,6 +1233,7 @@ void notify_check(dbref target, dbref sender, const mux_string &msg, int key)
                         MSG_ME | MSG_F_DOWN | MSG_S_OUTSIDE | (key & (MSG_HTML | MSG_SRC_MASK | MSG_SAYPOSE | MSG_OOC)));
                 }
             }
+            end_broadcast();
         }
 
         // Deliver message to neighbors.
@@ -1011,6 +1257,7 @@ void notify_check(dbref target, dbref sender, const mux_string &msg, int key)
                 msgFinal->import(msg);
             }
 
+            begin_broadcast();
             DOLIST(obj, Contents(targetloc))
             {
                 if (  obj != target
@@ -1020,6 +1267,7 @@ void notify_check(dbref target, dbref sender, const mux_string &msg, int key)
                         MSG_ME | MSG_F_DOWN | MSG_S_OUTSIDE | (key & (MSG_SRC_MASK | MSG_SAYPOSE | MSG_OOC)));
                 }
             }
+            end_broadcast();
         }
 
         // Deliver message to container.
@@ -1074,6 +1322,7 @@ void notify_except(dbref loc, dbref player, dbref exception, const UTF8 *msg, in
 {
     dbref first;
 
+    begin_broadcast();
     if (loc != exception)
     {
         notify_check(loc, player, msg, MSG_ME_ALL | MSG_F_UP | MSG_S_INSIDE | MSG_NBR_EXITS_A | key);
@@ -1085,12 +1334,14 @@ void notify_except(dbref loc, dbref player, dbref exception, const UTF8 *msg, in
             notify_check(first, player, msg, MSG_ME | MSG_F_DOWN | MSG_S_OUTSIDE | key);
         }
     }
+    end_broadcast();
 }
 
 void notify_except2(dbref loc, dbref player, dbref exc1, dbref exc2, const UTF8 *msg)
 {
     dbref first;
 
+    begin_broadcast();
     if (  loc != exc1
        && loc != exc2)
     {
@@ -1104,6 +1355,7 @@ void notify_except2(dbref loc, dbref player, dbref exc1, dbref exc2, const UTF8
             notify_check(first, player, msg, MSG_ME | MSG_F_DOWN | MSG_S_OUTSIDE);
         }
     }
+    end_broadcast();
 }
 
 /* ----------------------------------------------------------------------
@@ -1369,11 +1621,91 @@ static DUMP_PROCEDURE DumpProcedures[NUM_DUMP_TYPES] =
 #define POPEN_WRITE_OP "w"
 #endif // UNIX_FILES
 
+// Type 0 dumps are written to a temporary file named after the epoch.  When
+// the file is complete, the previous output database becomes the .prev file,
+// and the temporary file takes its place.
+//
+typedef struct
+{
+    FILE *f;
+    bool  bCompressed;
+    UTF8  tmpfile[SIZEOF_PATHNAME+32];
+    UTF8  outfn[SIZEOF_PATHNAME+32];
+    UTF8  prevfile[SIZEOF_PATHNAME+32];
+} CHECKPOINT_FILE;
+
+static bool checkpoint_open(CHECKPOINT_FILE *pcf)
+{
+    // Nuke our predecessor
+    //
+    pcf->bCompressed = mudconf.compress_db;
+    if (pcf->bCompressed)
+    {
+        mux_sprintf(pcf->prevfile, sizeof(pcf->prevfile), T("%s.prev.gz"), mudconf.outdb);
+        mux_sprintf(pcf->tmpfile, sizeof(pcf->tmpfile), T("%s.#%d#.gz"), mudconf.outdb, mudstate.epoch - 1);
+        RemoveFile(pcf->tmpfile);
+        mux_sprintf(pcf->tmpfile, sizeof(pcf->tmpfile), T("%s.#%d#.gz"), mudconf.outdb, mudstate.epoch);
+        mux_sprintf(pcf->outfn, sizeof(pcf->outfn), T("%s.gz"), mudconf.outdb);
+
+        pcf->f = popen((char *)tprintf(T("%s > %s"), mudconf.compress, pcf->tmpfile), POPEN_WRITE_OP);
+    }
+    else
+    {
+        mux_sprintf(pcf->prevfile, sizeof(pcf->prevfile), T("%s.prev"), mudconf.outdb);
+        mux_sprintf(pcf->tmpfile, sizeof(pcf->tmpfile), T("%s.#%d#"), mudconf.outdb, mudstate.epoch - 1);
+        RemoveFile(pcf->tmpfile);
+        mux_sprintf(pcf->tmpfile, sizeof(pcf->tmpfile), T("%s.#%d#"), mudconf.outdb, mudstate.epoch);
+        mux_strncpy(pcf->outfn, mudconf.outdb, sizeof(pcf->outfn)-1);
+
+        if (!mux_fopen(&pcf->f, pcf->tmpfile, T("wb")))
+        {
+            pcf->f = nullptr;
+        }
+    }
+
+    if (nullptr == pcf->f)
+    {
+        log_perror(T("SAV"), T("FAIL"), T("Opening"), pcf->tmpfile);
+        return false;
+    }
+    DebugTotalFiles++;
+    setvbuf(pcf->f, nullptr, _IOFBF, 16384);
+    return true;
+}
+
+static void checkpoint_close(CHECKPOINT_FILE *pcf, bool bComplete)
+{
+    if (pcf->bCompressed)
+    {
+        if (pclose(pcf->f) != -1)
+        {
+            DebugTotalFiles--;
+        }
+    }
+    else if (fclose(pcf->f) == 0)
+    {
+        DebugTotalFiles--;
+    }
+    pcf->f = nullptr;
+
+    if (bComplete)
+    {
+        ReplaceFile(pcf->outfn, pcf->prevfile);
+        if (ReplaceFile(pcf->tmpfile, pcf->outfn) < 0)
+        {
+            log_perror(T("SAV"), T("FAIL"), T("Renaming output file to DB file"), pcf->tmpfile);
+        }
+    }
+    else
+    {
+        RemoveFile(pcf->tmpfile);
+    }
+}
+
 void dump_database_internal(int dump_type)
 {
     UTF8 tmpfile[SIZEOF_PATHNAME+32];
     UTF8 outfn[SIZEOF_PATHNAME+32];
-    UTF8 prevfile[SIZEOF_PATHNAME+32];
     FILE *f;
 
     if (  dump_type < 0
@@ -1468,63 +1800,11 @@ void dump_database_internal(int dump_type)
         return;
     }
 
-    // Nuke our predecessor
-    //
-    if (mudconf.compress_db)
-    {
-        mux_sprintf(prevfile, sizeof(prevfile), T("%s.prev.gz"), mudconf.outdb);
-        mux_sprintf(tmpfile, sizeof(tmpfile), T("%s.#%d#.gz"), mudconf.outdb, mudstate.epoch - 1);
-        RemoveFile(tmpfile);
-        mux_sprintf(tmpfile, sizeof(tmpfile), T("%s.#%d#.gz"), mudconf.outdb, mudstate.epoch);
-        mux_sprintf(outfn, sizeof(outfn), T("%s.gz"), mudconf.outdb);
-
-        f = popen((char *)tprintf(T("%s > %s"), mudconf.compress, tmpfile), POPEN_WRITE_OP);
-        if (f)
-        {
-            DebugTotalFiles++;
-            setvbuf(f, nullptr, _IOFBF, 16384);
-            db_write(f, F_MUX, OUTPUT_VERSION | OUTPUT_FLAGS);
-            if (pclose(f) != -1)
-            {
-                DebugTotalFiles--;
-            }
-            ReplaceFile(outfn, prevfile);
-            if (ReplaceFile(tmpfile, outfn) < 0)
-            {
-                log_perror(T("SAV"), T("FAIL"), T("Renaming output file to DB file"), tmpfile);
-            }
-        }
-        else
-        {
-            log_perror(T("SAV"), T("FAIL"), T("Opening"), tmpfile);
-        }
-    }
-    else
+    CHECKPOINT_FILE cf;
+    if (checkpoint_open(&cf))
     {
-        mux_sprintf(prevfile, sizeof(prevfile), T("%s.prev"), mudconf.outdb);
-        mux_sprintf(tmpfile, sizeof(tmpfile), T("%s.#%d#"), mudconf.outdb, mudstate.epoch - 1);
-        RemoveFile(tmpfile);
-        mux_sprintf(tmpfile, sizeof(tmpfile), T("%s.#%d#"), mudconf.outdb, mudstate.epoch);
-
-        if (mux_fopen(&f, tmpfile, T("wb")))
-        {
-            DebugTotalFiles++;
-            setvbuf(f, nullptr, _IOFBF, 16384);
-            db_write(f, F_MUX, OUTPUT_VERSION | OUTPUT_FLAGS);
-            if (fclose(f) == 0)
-            {
-                DebugTotalFiles--;
-            }
-            ReplaceFile(mudconf.outdb, prevfile);
-            if (ReplaceFile(tmpfile, mudconf.outdb) < 0)
-            {
-                log_perror(T("SAV"), T("FAIL"), T("Renaming output file to DB file"), tmpfile);
-            }
-        }
-        else
-        {
-            log_perror(T("SAV"), T("FAIL"), T("Opening"), tmpfile);
-        }
+        db_write(cf.f, F_MUX, OUTPUT_VERSION | OUTPUT_FLAGS);
+        checkpoint_close(&cf, true);
     }
 
     if (mudconf.have_mailer)
@@ -1550,6 +1830,7 @@ static void dump_database(void)
 {
     UTF8 *buff;
 
+    dump_snapshot_abandon();
     mudstate.epoch++;
 
 #if defined(HAVE_WORKING_FORK)
@@ -1619,8 +1900,177 @@ static void dump_database(void)
     }
 }
 
+// Incremental checkpoints.
+//
+// With snapshot_dump enabled, a checkpoint of the structure database is not
+// written by a fork()ed child.  Instead, dispatch_DatabaseSnapshot writes it
+// from the main loop a slice at a time, and db_snapshot_begin() keeps the
+// objects it has not reached yet as they were when the checkpoint began.
+//
+static CHECKPOINT_FILE  snapshot_cf;
+static CLinearTimeDelta ltdSnapshotStall;
+static CLinearTimeDelta ltdSnapshotLongest;
+static int              nSnapshotSlices;
+
+static void dump_snapshot_account(const CLinearTimeAbsolute &ltaStart)
+{
+    CLinearTimeAbsolute ltaNow;
+    ltaNow.GetUTC();
+    CLinearTimeDelta ltd = ltaNow - ltaStart;
+    ltdSnapshotStall += ltd;
+    if (ltdSnapshotLongest < ltd)
+    {
+        ltdSnapshotLongest = ltd;
+    }
+    nSnapshotSlices++;
+}
+
+static void dump_snapshot_end(bool bComplete)
+{
+    int   nImages;
+    INT64 nBytes;
+    db_snapshot_end(&nImages, &nBytes);
+    checkpoint_close(&snapshot_cf, bComplete);
+    mudstate.snapshot = false;
+
+    if (bComplete)
+    {
+        UTF8 *buff = alloc_lbuf("dump_snapshot_end");
+        mux_sprintf(buff, LBUF_SIZE, T("Checkpoint complete: %s (stalled %ldms over %d slices, longest %ldms; kept %d pre-images, %s bytes)"),
+            snapshot_cf.tmpfile, ltdSnapshotStall.ReturnMilliseconds(),
+            nSnapshotSlices, ltdSnapshotLongest.ReturnMilliseconds(),
+            nImages, mux_i64toa_t(nBytes));
+        STARTLOG(LOG_DBSAVES, "DMP", "DONE");
+        log_text(buff);
+        ENDLOG;
+        free_lbuf(buff);
+    }
+    else
+    {
+        STARTLOG(LOG_DBSAVES, "DMP", "ABORT");
+        log_text(T("Checkpoint abandoned: "));
+        log_text(snapshot_cf.tmpfile);
+        ENDLOG;
+    }
+
+    local_dump_complete_signal();
+    ServerEventsSinkNode *p = g_pServerEventsSinkListHead;
+    while (nullptr != p)
+    {
+        p->pSink->dump_complete_signal();
+        p = p->pNext;
+    }
+}
+
+static bool dump_snapshot_begin(void)
+{
+    CLinearTimeAbsolute ltaStart;
+    ltaStart.GetUTC();
+
+    if (!checkpoint_open(&snapshot_cf))
+    {
+        return false;
+    }
+    if (!db_snapshot_begin(snapshot_cf.f, F_MUX, OUTPUT_VERSION | OUTPUT_FLAGS))
+    {
+        checkpoint_close(&snapshot_cf, false);
+        return false;
+    }
+    mudstate.snapshot = true;
+    ltdSnapshotStall.Set100ns(0);
+    ltdSnapshotLongest.Set100ns(0);
+    nSnapshotSlices = 0;
+
+    // Everything except the structure database is written now.
+    //
+    local_dump_database(DUMP_I_NORMAL);
+    ServerEventsSinkNode *p = g_pServerEventsSinkListHead;
+    while (nullptr != p)
+    {
+        p->pSink->dump_database(DUMP_I_NORMAL);
+        p = p->pNext;
+    }
+
+    FILE *f;
+    if (mudconf.have_mailer)
+    {
+        if (mux_fopen(&f, mudconf.mail_db, T("wb")))
+        {
+            DebugTotalFiles++;
+            dump_mail(f);
+            if (fclose(f) == 0)
+            {
+                DebugTotalFiles--;
+            }
+        }
+    }
+
+    if (mudconf.have_comsys)
+    {
+        save_comsys(mudconf.comsys_db);
+    }
+
+    CLinearTimeAbsolute ltaNextTime;
+    ltaNextTime.GetUTC();
+    ltaNextTime += time_5ms;
+    scheduler.DeferTask(ltaNextTime, PRIORITY_SYSTEM, dispatch_DatabaseSnapshot, 0, 0);
+    dump_snapshot_account(ltaStart);
+    return true;
+}
+
+/*! \brief Writes the next slice of the checkpoint in progress.
+ *
+ * \return true if the checkpoint is finished.
+ */
+
+bool dump_snapshot_continue(void)
+{
+    if (!mudstate.snapshot)
+    {
+        return true;
+    }
+
+    CLinearTimeAbsolute ltaStart;
+    ltaStart.GetUTC();
+    CLinearTimeAbsolute ltaLimit = ltaStart + time_5ms;
+    CLinearTimeAbsolute ltaNow;
+
+    bool bDone;
+    do
+    {
+        bDone = db_snapshot_step(256);
+        ltaNow.GetUTC();
+    } while (  !bDone
+            && ltaNow < ltaLimit);
+
+    dump_snapshot_account(ltaStart);
+    if (bDone)
+    {
+        dump_snapshot_end(true);
+    }
+    return bDone;
+}
+
+/*! \brief Abandons the checkpoint in progress, if any.
+ *
+ * Used before the database is written some other way.
+ */
+
+void dump_snapshot_abandon(void)
+{
+    if (mudstate.snapshot)
+    {
+        dump_snapshot_end(false);
+    }
+}
+
 void fork_and_dump(int key)
 {
+    if (mudstate.snapshot)
+    {
+        return;
+    }
+
 #if defined(HAVE_WORKING_FORK)
     static volatile bool bRequestAccepted = false;
 
@@ -1695,6 +2145,16 @@ void fork_and_dump(int key)
     pcache_sync();
     SYNC;
 
+    if (  mudconf.snapshot_dump
+       && DUMP_STRUCT == (key & (DUMP_STRUCT|DUMP_FLATFILE))
+       && dump_snapshot_begin())
+    {
+        // dispatch_DatabaseSnapshot writes the structure database and
+        // signals its completion.
+        //
+        key &= ~DUMP_STRUCT;
+    }
+
 #if defined(HAVE_WORKING_FORK)
     mudstate.write_protect = true;
     int child = 0;
@@ -1784,12 +2244,15 @@ void fork_and_dump(int key)
         //
         mudstate.dumper = 0;
         mudstate.dumping = false;
-        local_dump_complete_signal();
-        ServerEventsSinkNode *p = g_pServerEventsSinkListHead;
-        while (nullptr != p)
+        if (!mudstate.snapshot)
         {
-            p->pSink->dump_complete_signal();
-            p = p->pNext;
+            local_dump_complete_signal();
+            ServerEventsSinkNode *p = g_pServerEventsSinkListHead;
+            while (nullptr != p)
+            {
+                p->pSink->dump_complete_signal();
+                p = p->pNext;
+            }
         }
     }
     bRequestAccepted = false;
@@ -1926,6 +2389,12 @@ static int load_game(int ccPageFile)
             ENDLOG;
         }
     }
+
+    // Attribute changes since the last checkpoint of the attribute database
+    // are in the write-ahead log.
+    //
+    cache_wal_start(  (db_flags & V_DATABASE)
+                   && HF_OPEN_STATUS_OLD == ccPageFile);
 #endif // !MEMORY_BASED
 
     if (mudconf.have_comsys)
@@ -2225,6 +2694,8 @@ static const UTF8 *standalone_basename = nullptr;
 static bool standalone_check = false;
 static bool standalone_load = false;
 static bool standalone_unload = false;
+static bool standalone_bench = false;
+static const UTF8 *standalone_threads = nullptr;
 
 static void dbconvert(void)
 {
@@ -2243,6 +2714,10 @@ static void dbconvert(void)
     pool_init(POOL_STRING, sizeof(mux_string));
 
     cf_init();
+    if (nullptr != standalone_threads)
+    {
+        mudconf.load_threads = mux_atol(standalone_threads);
+    }
 
     // Decide what conversions to do and how to format the output file.
     //
@@ -2284,7 +2759,7 @@ static void dbconvert(void)
     safe_copy_str(T(".pag"), pagfile, &pagfile_c, (SIZEOF_PATHNAME-1));
     *pagfile_c = '\0';
 
-    int cc = init_dbfile(dirfile, pagfile, 650);
+    int cc = init_dbfile(dirfile, pagfile, 650, false);
     if (cc == HF_OPEN_STATUS_ERROR)
     {
         Log.tinyprintf(T("Can\xE2\x80\x99t open database in (%s, %s) files\n"), dirfile, pagfile);
@@ -2315,6 +2790,16 @@ static void dbconvert(void)
         exit(1);
     }
 
+    if (standalone_bench)
+    {
+        // The input file is an attribute access trace.
+        //
+        cache_replay(fpIn);
+        fclose(fpIn);
+        CLOSE;
+        exit(0);
+    }
+
     // Go do it.
     //
     if (do_redirect)
@@ -2476,6 +2961,8 @@ long DebugTotalMemory = 0;
 #define CLI_DO_BASENAME    CLI_USER+9
 #define CLI_DO_PID_FILE    CLI_USER+10
 #define CLI_DO_ERRORPATH   CLI_USER+11
+#define CLI_DO_BENCH       CLI_USER+12
+#define CLI_DO_THREADS     CLI_USER+13
 
 static bool bMinDB = false;
 static bool bSyntaxError = false;
@@ -2498,6 +2985,8 @@ static CLI_OptionEntry OptionTable[] =
     { "l", CLI_NONE,     CLI_DO_LOAD        },
     { "u", CLI_NONE,     CLI_DO_UNLOAD      },
     { "d", CLI_REQUIRED, CLI_DO_BASENAME    },
+    { "b", CLI_NONE,     CLI_DO_BENCH       },
+    { "t", CLI_REQUIRED, CLI_DO_THREADS     },
 #endif // MEMORY_BASED
     { "p", CLI_REQUIRED, CLI_DO_PID_FILE    },
     { "e", CLI_REQUIRED, CLI_DO_ERRORPATH   }
@@ -2560,6 +3049,16 @@ static void CLI_CallBack(CLI_OptionEntry *p, const char *pValue)
             standalone_unload = true;
             break;
 
+        case CLI_DO_BENCH:
+            mudstate.bStandAlone = true;
+            standalone_bench = true;
+            break;
+
+        case CLI_DO_THREADS:
+            mudstate.bStandAlone = true;
+            standalone_threads = (UTF8 *)pValue;
+            break;
+
         case CLI_DO_BASENAME:
             mudstate.bStandAlone = true;
             standalone_basename = (UTF8 *)pValue;
@@ -2682,9 +3181,14 @@ int DCL_CDECL main(int argc, char *argv[])
         {
             n++;
         }
+        if (standalone_bench)
+        {
+            n++;
+        }
         if (  !standalone_basename
            || !standalone_infile
-           || !standalone_outfile
+           || (  !standalone_outfile
+              && !standalone_bench)
            || n != 1
            || bServerOption)
         {
@@ -2711,12 +3215,14 @@ int DCL_CDECL main(int argc, char *argv[])
         mux_fprintf(stderr, T("Version: %s" ENDLINE), mudstate.version);
         if (mudstate.bStandAlone)
         {
-            mux_fprintf(stderr, T("Usage: %s -d <dbname> -i <infile> [-o <outfile>] [-l|-u|-k]" ENDLINE), pProg);
+            mux_fprintf(stderr, T("Usage: %s -d <dbname> -i <infile> [-o <outfile>] [-t <threads>] [-l|-u|-k|-b]" ENDLINE), pProg);
+            mux_fprintf(stderr, T("  -b  Replay attribute access trace <infile>." ENDLINE));
             mux_fprintf(stderr, T("  -d  Basename." ENDLINE));
             mux_fprintf(stderr, T("  -i  Input file." ENDLINE));
             mux_fprintf(stderr, T("  -k  Check." ENDLINE));
             mux_fprintf(stderr, T("  -l  Load." ENDLINE));
             mux_fprintf(stderr, T("  -o  Output file." ENDLINE));
+            mux_fprintf(stderr, T("  -t  Threads used to parse <infile> (0 reads it serially)." ENDLINE));
             mux_fprintf(stderr, T("  -u  Unload." ENDLINE));
         }
         else
@@ -2766,8 +3272,8 @@ int DCL_CDECL main(int argc, char *argv[])
     extern CHashFile hfAllocData;
     extern CHashFile hfIdentData;
     extern bool bMemAccountingInitialized;
-    hfAllocData.Open("svdptrs.dir", "svdptrs.pag", 40);
-    hfIdentData.Open("svdlines.dir", "svdlines.pag", 40);
+    hfAllocData.Open("svdptrs.dir", "svdptrs.pag", 40, false);
+    hfIdentData.Open("svdlines.dir", "svdlines.pag", 40, false);
     bMemAccountingInitialized = true;
 #endif
 
@@ -2810,7 +3316,6 @@ int DCL_CDECL main(int argc, char *argv[])
     pool_init(POOL_BOOL, sizeof(struct boolexp));
 
     pool_init(POOL_DESC, sizeof(DESC));
-    pool_init(POOL_QENTRY, sizeof(BQUE));
     pool_init(POOL_LBUFREF, sizeof(lbuf_ref));
     pool_init(POOL_REGREF, sizeof(reg_ref));
     pool_init(POOL_STRING, sizeof(mux_string));
@@ -2918,7 +3423,8 @@ int DCL_CDECL main(int argc, char *argv[])
         RemoveFile(mudconf.game_dir);
         RemoveFile(mudconf.game_pag);
     }
-    int ccPageFile = init_dbfile(mudconf.game_dir, mudconf.game_pag, mudconf.cache_pages);
+    int ccPageFile = init_dbfile(mudconf.game_dir, mudconf.game_pag, mudconf.cache_pages,
+        mudconf.cache_mmap);
     if (HF_OPEN_STATUS_ERROR == ccPageFile)
     {
         STARTLOG(LOG_ALWAYS, "INI", "LOAD");
@@ -2969,6 +3475,11 @@ int DCL_CDECL main(int argc, char *argv[])
             return 2;
         }
     }
+#ifndef MEMORY_BASED
+    // If load_game() did not use the write-ahead log, it does not apply.
+    //
+    cache_wal_start(false);
+#endif // !MEMORY_BASED
     set_signals();
     Guest.StartUp();
 
@@ -22,6 +22,26 @@ struct name_table
 /* BQUE - Command queue */
 
 typedef struct bque BQUE;
+
+// Entries are also kept on doubly-linked lists by executor, by owner, and
+// by semaphore object, so that @halt, @notify, @drain and @ps can find
+// them without visiting the whole scheduler.
+//
+#define QUE_BY_EXECUTOR  0
+#define QUE_BY_OWNER     1
+#define QUE_BY_SEMAPHORE 2
+#define QUE_NUM_INDEXES  3
+
+typedef struct
+{
+    BQUE    *next;
+    BQUE    *prev;
+} BQUE_LINK;
+
+// An entry is one variable-length record.  The header is followed by a
+// reg_ref pointer for each register set in fRegs, then by each argument set
+// in fArgs, and then by the command, all NUL-terminated.
+//
 struct bque
 {
     CLinearTimeAbsolute waittime;   // time to run command
@@ -39,15 +59,22 @@ struct bque
         UINT32 hQuery;              // blocking query
     } u;
     int     nargs;                  // How many args I have
-    UTF8    *text;                  // buffer for comm, env, and scr text
+    UINT16  fArgs;                  // Which args are present
+    UINT8   iClass;                 // Arena size class of the record
+    UINT8   nRegs;                  // How many temp vars are present
+    UINT64  fRegs;                  // Which temp vars are present
+    size_t  nSize;                  // Size of the record
     UTF8    *comm;                  // command
-    UTF8    *env[NUM_ENV_VARS];     // environment vars
-    reg_ref *scr[MAX_GLOBAL_REGS];  // temp vars
 #if defined(STUB_SLAVE)
     CResultsSet *pResultsSet;       // Results Set
     int     iRow;                   // Current Row
 #endif // STUB_SLAVE
+    struct task_record *pTask;      // Scheduled task, or nullptr when not indexed.
+    dbref   owner;                  // Owner under which the entry is indexed.
     bool    IsTimed;                // Is there a waittime time on this entry?
+    bool    IsReady;                // Is it counted as ready in its owner's share?
+    CLinearTimeAbsolute ltaReady;   // When it became ready to run.
+    BQUE_LINK links[QUE_NUM_INDEXES];
 };
 
 class CBitField
@@ -56,6 +56,30 @@ typedef struct cmd_block
     UTF8    cmd[LBUF_SIZE - sizeof(CBLKHDR)];
 } CBLK;
 
+// Input lines wait for dispatch in a chain of chunks.  Each line is stored
+// as its length followed by its text, and a chunk holds as many lines as
+// fit.  A line too long for a standard chunk gets a chunk of its own.
+//
+typedef struct input_chunk ICHUNK;
+typedef struct input_chunk_hdr
+{
+    struct input_chunk *nxt;
+    size_t   nSize;     // Bytes available in data[].
+    size_t   nRead;     // Offset of the next line to dispatch.
+    size_t   nWrite;    // Offset at which the next line is stored.
+} ICHUNKHDR;
+
+typedef struct input_chunk
+{
+    ICHUNKHDR hdr;
+    UTF8      data[INPUT_CHUNK_SIZE - sizeof(ICHUNKHDR)];
+} ICHUNK;
+
+// Buckets for the time input lines wait between arrival and execution:
+// under 1ms, 4ms, 16ms, 64ms, 256ms, 1s, and longer.
+//
+#define COMMAND_LATENCY_BUCKETS 7
+
 #define TBLK_FLAG_LOCKED    0x01
 
 typedef struct text_block TBLOCK;
@@ -109,15 +133,16 @@ struct prog_data
 
 // Telnet Options
 //
-#define TELNET_BINARY   ((unsigned char)'\x00')
-#define TELNET_SGA      ((unsigned char)'\x03')
-#define TELNET_EOR      ((unsigned char)'\x19')
-#define TELNET_NAWS     ((unsigned char)'\x1F')
-#define TELNET_TTYPE    ((unsigned char)'\x18')
-#define TELNET_OLDENV   ((unsigned char)'\x24')
-#define TELNET_ENV      ((unsigned char)'\x27')
-#define TELNET_CHARSET  ((unsigned char)'\x2A')
-#define TELNET_STARTTLS ((unsigned char)'\x2E')
+#define TELNET_BINARY    ((unsigned char)'\x00')
+#define TELNET_SGA       ((unsigned char)'\x03')
+#define TELNET_EOR       ((unsigned char)'\x19')
+#define TELNET_NAWS      ((unsigned char)'\x1F')
+#define TELNET_TTYPE     ((unsigned char)'\x18')
+#define TELNET_OLDENV    ((unsigned char)'\x24')
+#define TELNET_ENV       ((unsigned char)'\x27')
+#define TELNET_CHARSET   ((unsigned char)'\x2A')
+#define TELNET_STARTTLS  ((unsigned char)'\x2E')
+#define TELNET_COMPRESS2 ((unsigned char)'\x56')
 
 // Telnet Option Negotiation States
 //
@@ -151,14 +176,43 @@ struct prog_data
 #define CHARSET_LATIN2          3
 #define CHARSET_UTF8            4
 
+#if defined(UNIX_NETWORKING_EPOLL)
+// Each socket registered with the epoll reactor carries a pointer to one of
+// these so that shovechars() can tell what kind of socket became ready.
+//
+#define EPOLL_KIND_DESC         0
+#define EPOLL_KIND_PORT         1
+#define EPOLL_KIND_SLAVE        2
+#define EPOLL_KIND_STUBSLAVE    3
+#define EPOLL_KIND_TLS          4
+
+typedef struct epoll_reg
+{
+    int     kind;
+    int     iPort;
+    SOCKET  socket;
+    bool    fRegistered;
+    bool    fHangup;    // Peer hung up while input was still queued.
+    UINT32  events;     // Events currently requested from epoll.
+    struct descriptor_data *d;
+} EPOLL_REG;
+#endif // UNIX_NETWORKING_EPOLL
+
 typedef struct descriptor_data DESC;
 struct descriptor_data
 {
   SOCKET socket;
 
+#if defined(UNIX_NETWORKING_EPOLL)
+  EPOLL_REG epoll;
+#endif // UNIX_NETWORKING_EPOLL
+
 #ifdef UNIX_SSL
   SSL *ssl_session;
 #endif
+#if defined(UNIX_SSL_WORKERS)
+  struct tls_conn *tls;   // Session handed to a TLS worker thread.
+#endif // UNIX_SSL_WORKERS
 
 #if defined(WINDOWS_NETWORKING)
   // these are for the Windows NT TCP/IO
@@ -184,13 +238,20 @@ struct descriptor_data
   size_t output_size;
   size_t output_tot;
   size_t output_lost;
+  size_t output_syscalls;
+  size_t output_sent;
+#if defined(UNIX_MCCP)
+  struct mccp_state *mccp;
+  size_t compress_in;
+  size_t compress_out;
+#endif // UNIX_MCCP
   TBLOCK *output_head;
   TBLOCK *output_tail;
   size_t input_size;
   size_t input_tot;
   size_t input_lost;
-  CBLK *input_head;
-  CBLK *input_tail;
+  ICHUNK *input_head;
+  ICHUNK *input_tail;
   CBLK *raw_input;
   UTF8 *raw_input_at;
   size_t        nOption;
@@ -206,6 +267,7 @@ struct descriptor_data
   int width;
   int height;
   int quota;
+  int command_latency[COMMAND_LATENCY_BUCKETS];
   PROG *program_data;
   struct descriptor_data *hashnext;
   struct descriptor_data *next;
@@ -266,7 +328,15 @@ extern void emergency_shutdown(void);
 extern void shutdownsock(DESC *, int);
 extern void SetupPorts(int *pnPorts, PortInfo aPorts[], IntArray *pia, IntArray *piaSSL, const UTF8 *ip_address);
 extern void shovechars(int nPorts, PortInfo aPorts[]);
+#if defined(UNIX_NETWORKING)
+extern void greet_pending_connections(void);
+#endif // UNIX_NETWORKING
 void process_output(DESC *, int);
+#if defined(UNIX_MCCP)
+extern void mccp_stop(DESC *d);
+extern void mccp_free(DESC *d);
+extern void mccp_stop_all(void);
+#endif // UNIX_MCCP
 #if defined(HAVE_WORKING_FORK)
 extern void dump_restart_db(void);
 #endif // HAVE_WORKING_FORK
@@ -295,8 +365,14 @@ extern void queue_write(DESC *, const UTF8 *);
 extern void queue_string(DESC *, const UTF8 *);
 extern void queue_string(DESC *d, const mux_string &s);
 extern void freeqs(DESC *);
+extern TBLOCK *alloc_tblock(void);
+extern void free_tblock(TBLOCK *tp);
+extern void trim_tblocks(void);
+extern void trim_ichunks(void);
+extern void list_output_stats(dbref player);
 extern void welcome_user(DESC *);
-extern void save_command(DESC *, CBLK *);
+extern void save_command(DESC *d, const UTF8 *pCommand, size_t nCommand);
+extern void stop_command_batch(DESC *d);
 extern void announce_disconnect(dbref, DESC *, const UTF8 *);
 extern int boot_by_port(SOCKET port, bool bGod, const UTF8 *message);
 extern void find_oldest(dbref target, DESC *dOldest[2]);
@@ -367,6 +443,9 @@ extern "C" MUX_RESULT DCL_API pipepump(void);
 #ifdef UNIX_SSL
 void CleanUpSSLConnections(void);
 #endif
+#if defined(UNIX_SSL_WORKERS)
+extern void list_tls_stats(dbref player);
+#endif // UNIX_SSL_WORKERS
 
 extern NAMETAB sigactions_nametab[];
 
@@ -374,6 +453,11 @@ extern NAMETAB sigactions_nametab[];
 extern int maxd;
 #endif // UNIX_NETWORKING_SELECT
 
+#if defined(UNIX_NETWORKING_EPOLL)
+extern void epoll_register(DESC *d);
+extern void epoll_update(DESC *d);
+#endif // UNIX_NETWORKING_EPOLL
+
 extern long DebugTotalSockets;
 
 #if defined(WINDOWS_NETWORKING)
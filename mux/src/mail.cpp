@@ -1979,6 +1979,7 @@ static void do_expmail_start(dbref player, UTF8 *arg, UTF8 *subject)
     atr_add_raw(player, A_MAILSUB, subject);
     atr_add_raw(player, A_MAILFLAGS, T("0"));
     atr_clr(player, A_MAILMSG);
+    SnapshotTouch(player);
     Flags2(player) |= PLAYER_MAILS;
     UTF8 *names = make_namelist(player, tolist);
     raw_notify(player, tprintf(T("MAIL: You are sending mail to \xE2\x80\x98%s\xE2\x80\x99."), names));
@@ -4167,6 +4168,7 @@ static void do_expmail_stop(dbref player, int flags)
             free_lbuf(mailflags);
             free_lbuf(mailsub);
 
+            SnapshotTouch(player);
             Flags2(player) &= ~PLAYER_MAILS;
         }
         free_lbuf(pMailMsg);
@@ -4175,6 +4177,7 @@ static void do_expmail_stop(dbref player, int flags)
 
 static void do_expmail_abort(dbref player)
 {
+    SnapshotTouch(player);
     Flags2(player) &= ~PLAYER_MAILS;
     raw_notify(player, T("MAIL: Message aborted."));
 }
@@ -163,6 +163,7 @@ const UTF8 *CGuests::Create(DESC *d)
 
             // Copy flags from guest prototype.
             //
+            SnapshotTouch(guest_player);
             db[guest_player].fs = db[mudconf.guest_char].fs;
 
             // Strip flags, enforce PLAYER type.
@@ -331,6 +332,7 @@ dbref CGuests::MakeGuestChar(void)
     //
     FLAGSET f = db[mudconf.guest_char].fs;
     f.word[FLAG_WORD1] |= TYPE_PLAYER;
+    SnapshotTouch(player);
     db[player].fs = f;
 
     // Strip flags.
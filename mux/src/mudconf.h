@@ -34,6 +34,7 @@ typedef struct confdata CONFDATA;
 struct confdata
 {
     bool    autozone;           // New objects are automatically zoned.
+    bool    cache_mmap;         // Map the page file instead of reading it.
     bool    cache_names;        /* Should object names be cached separately */
     bool    clone_copy_cost;    /* Does @clone copy value? */
     bool    compress_db;        // should we use compress.
@@ -69,6 +70,7 @@ struct confdata
     bool    safe_wipe;          // If yes, SAFE flag must be removed to @wipe.
     bool    safer_passwords;    /* enforce reasonably good password choices? */
     bool    see_own_dark;       /* Do you see your own dark stuff? */
+    bool    snapshot_dump;      // write checkpoints from the main loop.
     bool    space_compress;     /* Convert multiple spaces into one space */
     bool    sweep_dark;         /* Can you sweep dark places? */
     bool    switch_df_all;      /* Should @switch match all by default? */
@@ -78,6 +80,10 @@ struct confdata
     bool    terse_movemsg;      /* Show move msgs (SUCC/LEAVE/etc) if TERSE? */
     bool    trace_topdown;      /* Is TRACE output top-down or bottom-up? */
     bool    use_hostname;       /* true = use machine NAME rather than quad */
+    bool    write_ahead_log;    // Log attribute changes between checkpoints.
+#if defined(UNIX_NETWORKING_EPOLL)
+    bool    epoll_edge_triggered; // Use edge-triggered epoll notifications.
+#endif // UNIX_NETWORKING_EPOLL
     dbref   default_home;       // HOME when home is inaccessable.
     dbref   exit_parent;        // Default parent for new exit objects
     dbref   global_error_obj;   // Object that is used to generate error messages.
@@ -94,6 +100,8 @@ struct confdata
     dbref   toad_recipient;     /* Default @toad recipient. */
 
     int     active_q_chunk;     /* # cmds to run from queue when active */
+    bool    timer_wheel;        // Hold timed tasks on a timing wheel until they are nearly due.
+    bool    queue_fair_share;   // Share the queue among owners by processor time.
     int     cache_pages;        // Size of hash page cache (in pages).
     int     check_interval;     /* interval between db check/cleans in secs */
     int     check_offset;       /* when to perform first check and clean */
@@ -118,6 +126,7 @@ struct confdata
     int     killmax;            /* max cost of kill command */
     int     killmin;            /* default (and minimum) cost of kill cmd */
     int     linkcost;           /* cost of @link command */
+    int     load_threads;       // Threads used to parse the flatfile.
     int     lock_nest_lim;      /* Max nesting of lock evals */
     int     log_info;           /* Info that goes into log entries */
     int     log_options;        /* What gets logged */
@@ -156,6 +165,7 @@ struct confdata
     RLEVEL  def_thing_rx;       /* Default thing RX level */
     RLEVEL  def_thing_tx;       /* Default thing TX level */
 #endif // REALITY_LVLS
+    int     mccp_level;         // zlib level for MCCP2, or 0 to not offer it.
     int     ntfy_nest_lim;      /* Max nesting of notifys */
     int     number_guests;      // number of guest characters allowed.
     int     opencost;           /* cost of @open command */
@@ -189,6 +199,8 @@ struct confdata
     int     zone_nest_lim;      /* Max nesting of zones */
     int     restrict_home;      // Special condition to restrict 'home' command
     int     float_precision;    // Maximum precision of float-to-string conversion.
+    int     regexp_cache_size;  // Max number of compiled regular expressions kept.
+    int     eval_cache_size;    // Max number of softcode programs kept.
     int     lbuf_size;          // LBUF_SIZE accessible to softcode.
 
     unsigned int    max_cache_size; /* Max size of attribute cache */
@@ -202,6 +214,7 @@ struct confdata
     UTF8    ssl_certificate_file[128];      // SSL certificate file (.pem format)
     UTF8    ssl_certificate_key[128];       // SSL certificate private key file (.pem format)
     UTF8    ssl_certificate_password[128];  // SSL certificate private key password
+    int     ssl_threads;                    // Threads which run SSL sessions, or 0 to run them here.
 #endif
 
     UTF8    guest_prefix[32];   /* Prefix for the guest char's name */
@@ -245,6 +258,7 @@ struct confdata
     UTF8    *full_file;         /* display when max users exceeded */
     UTF8    *game_dir;          /* use this game CHashFile DIR file if we need one */
     UTF8    *game_pag;          /* use this game CHashFile PAG file if we need one */
+    UTF8    *game_wal;          // write-ahead log for the PAG file.
     UTF8    *guest_file;        /* display if guest connects */
     UTF8    *indb;              /* database file name */
     UTF8    *log_dir;           /* directory for logging from the cmd line */
@@ -263,7 +277,9 @@ struct confdata
     CLinearTimeDelta rpt_cmdsecs;  /* Reporting Threshhold for time taken by command */
     CLinearTimeDelta max_cmdsecs;  /* Upper Limit for real time taken by command */
     CLinearTimeDelta cache_tick_period; // Minor cycle for cache maintenance.
+    CLinearTimeDelta wal_commit_period; // How often the write-ahead log is committed.
     CLinearTimeDelta timeslice;         // How often do we bump people's cmd quotas?
+    CLinearTimeDelta command_batch_time; // How long one descriptor's queued commands may run at a stretch.
 
     FLAGSET exit_flags;         /* Flags exits start with */
     FLAGSET player_flags;       /* Flags players start with */
@@ -445,6 +461,7 @@ struct statedata
 #if defined(HAVE_WORKING_FORK)
     bool          restarting;   // Are we restarting?
     volatile bool dumping;      // Are we dumping?
+    bool    snapshot;           // Is a checkpoint being written incrementally?
     volatile pid_t dumper;      // PID of dumping process (as returned by fork()).
     volatile pid_t dumped;      // PID of dumping process (as given by SIGCHLD).
     bool    write_protect;      // Write-protect against modifications to the
@@ -539,15 +556,21 @@ struct statedata
     CHashTable channel_htab;    /* Channels hashtable */
     CHashTable command_htab;    /* Commands hashtable */
     CHashTable desc_htab;       /* Socket descriptor hashtable */
+    CHashTable eval_htab;       // Softcode program cache
     CHashTable flags_htab;      /* Flags hashtable */
     CHashTable func_htab;       /* Functions hashtable */
     CHashTable fwdlist_htab;    /* Room forwardlists */
+    CHashTable lock_htab;       // Parsed lock cache
     CHashTable logout_cmd_htab; /* Logged-out commands hashtable (WHO, etc) */
     CHashTable mail_htab;       /* Mail players hashtable */
     CHashTable parent_htab;     /* Parent $-command exclusion */
     CHashTable player_htab;     /* Player name->number hashtable */
     CHashTable powers_htab;     /* Powers hashtable */
+    CHashTable queue_htab[QUE_NUM_INDEXES]; // Queue entries by executor, owner, and semaphore
+    CHashTable queue_share_htab; // Fair-share accounts of queue entry owners
     CHashTable reference_htab;  /* @reference hashtable */
+    CHashTable regexp_htab;     // Compiled regular expression cache
+    CHashTable regexp_owner_htab; // Compiled regular expressions by attribute
     CHashTable ufunc_htab;      /* Local functions hashtable */
     CHashTable vattr_name_htab; /* User attribute names hashtable */
     CHashTable scratch_htab;    /* Multi-purpose scratch hash table */
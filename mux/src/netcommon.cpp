@@ -347,6 +347,172 @@ void clearstrings(DESC *d)
     }
 }
 
+// Output blocks are recycled through a free list rather than going back to
+// the heap every time a descriptor drains its queue.  trim_tblocks() is
+// called periodically and releases whatever the free list holds beyond the
+// most blocks that were in use since the previous trim.
+//
+static TBLOCK *tblock_free_list = nullptr;
+static size_t  tblock_nFree      = 0;
+static size_t  tblock_nInUse     = 0;
+static size_t  tblock_nHighWater = 0;
+static INT64   tblock_nAllocs    = 0;
+static INT64   tblock_nReuses    = 0;
+
+/*! \brief Get an empty output block from the pool.
+ *
+ * \return          TBLOCK or nullptr if the heap is exhausted.
+ */
+
+TBLOCK *alloc_tblock(void)
+{
+    TBLOCK *tp = tblock_free_list;
+    if (nullptr != tp)
+    {
+        tblock_free_list = tp->hdr.nxt;
+        tblock_nFree--;
+        tblock_nReuses++;
+    }
+    else
+    {
+        tp = (TBLOCK *)MEMALLOC(OUTPUT_BLOCK_SIZE);
+        if (nullptr == tp)
+        {
+            return nullptr;
+        }
+        tblock_nAllocs++;
+    }
+
+    tp->hdr.nxt = nullptr;
+    tp->hdr.start = tp->data;
+    tp->hdr.end = tp->data;
+    tp->hdr.nchars = 0;
+    tp->hdr.flags = 0;
+
+    tblock_nInUse++;
+    if (tblock_nHighWater < tblock_nInUse)
+    {
+        tblock_nHighWater = tblock_nInUse;
+    }
+    return tp;
+}
+
+/*! \brief Return an output block to the pool.
+ *
+ * \param tp        TBLOCK no longer on any output queue.
+ * \return          None.
+ */
+
+void free_tblock(TBLOCK *tp)
+{
+    tp->hdr.nxt = tblock_free_list;
+    tblock_free_list = tp;
+    tblock_nFree++;
+    tblock_nInUse--;
+}
+
+/*! \brief Release pooled output blocks above the recent high-water mark.
+ *
+ * \return          None.
+ */
+
+void trim_tblocks(void)
+{
+    size_t nKeep = tblock_nHighWater - tblock_nInUse;
+    while (nKeep < tblock_nFree)
+    {
+        TBLOCK *tp = tblock_free_list;
+        tblock_free_list = tp->hdr.nxt;
+        tblock_nFree--;
+        MEMFREE(tp);
+    }
+    tblock_nHighWater = tblock_nInUse;
+}
+
+// Input chunks are pooled the same way.  Only standard-size chunks go back
+// on the free list.
+//
+static ICHUNK *ichunk_free_list = nullptr;
+static size_t  ichunk_nFree      = 0;
+static size_t  ichunk_nInUse     = 0;
+static size_t  ichunk_nHighWater = 0;
+static INT64   ichunk_nLarge     = 0;
+
+/*! \brief Get an empty input chunk with room for at least nNeeded bytes.
+ *
+ * \param nNeeded   Bytes the caller intends to store.
+ * \return          ICHUNK.
+ */
+
+static ICHUNK *alloc_ichunk(size_t nNeeded)
+{
+    ICHUNK *ic;
+    size_t nSize = sizeof(ic->data);
+    if (nSize < nNeeded)
+    {
+        nSize = nNeeded;
+        ic = (ICHUNK *)MEMALLOC(sizeof(ICHUNKHDR) + nSize);
+        ISOUTOFMEMORY(ic);
+        ichunk_nLarge++;
+    }
+    else if (nullptr != ichunk_free_list)
+    {
+        ic = ichunk_free_list;
+        ichunk_free_list = ic->hdr.nxt;
+        ichunk_nFree--;
+    }
+    else
+    {
+        ic = (ICHUNK *)MEMALLOC(sizeof(ICHUNK));
+        ISOUTOFMEMORY(ic);
+    }
+
+    ic->hdr.nxt = nullptr;
+    ic->hdr.nSize = nSize;
+    ic->hdr.nRead = 0;
+    ic->hdr.nWrite = 0;
+
+    ichunk_nInUse++;
+    if (ichunk_nHighWater < ichunk_nInUse)
+    {
+        ichunk_nHighWater = ichunk_nInUse;
+    }
+    return ic;
+}
+
+static void free_ichunk(ICHUNK *ic)
+{
+    ichunk_nInUse--;
+    if (sizeof(ic->data) == ic->hdr.nSize)
+    {
+        ic->hdr.nxt = ichunk_free_list;
+        ichunk_free_list = ic;
+        ichunk_nFree++;
+    }
+    else
+    {
+        MEMFREE(ic);
+    }
+}
+
+/*! \brief Release pooled input chunks above the recent high-water mark.
+ *
+ * \return          None.
+ */
+
+void trim_ichunks(void)
+{
+    size_t nKeep = ichunk_nHighWater - ichunk_nInUse;
+    while (nKeep < ichunk_nFree)
+    {
+        ICHUNK *ic = ichunk_free_list;
+        ichunk_free_list = ic->hdr.nxt;
+        ichunk_nFree--;
+        MEMFREE(ic);
+    }
+    ichunk_nHighWater = ichunk_nInUse;
+}
+
 /*! \brief Add text to the output queue of the indicated network descriptor
  *         without questions.
  *
@@ -371,15 +537,9 @@ static void add_to_output_queue(DESC *d, const UTF8 *b, size_t n)
     //
     if (nullptr == d->output_head)
     {
-        tp = (TBLOCK *)MEMALLOC(OUTPUT_BLOCK_SIZE);
+        tp = alloc_tblock();
         if (nullptr != tp)
         {
-            tp->hdr.nxt = nullptr;
-            tp->hdr.start = tp->data;
-            tp->hdr.end = tp->data;
-            tp->hdr.nchars = 0;
-            tp->hdr.flags = 0;
-
             d->output_head = tp;
             d->output_tail = tp;
         }
@@ -428,15 +588,9 @@ static void add_to_output_queue(DESC *d, const UTF8 *b, size_t n)
                 n -= left;
             }
 
-            tp = (TBLOCK *)MEMALLOC(OUTPUT_BLOCK_SIZE);
+            tp = alloc_tblock();
             if (nullptr != tp)
             {
-                tp->hdr.nxt = nullptr;
-                tp->hdr.start = tp->data;
-                tp->hdr.end = tp->data;
-                tp->hdr.nchars = 0;
-                tp->hdr.flags = 0;
-
                 d->output_tail->hdr.nxt = tp;
                 d->output_tail = tp;
             }
@@ -523,7 +677,11 @@ void queue_write_LEN(DESC *d, const UTF8 *b, size_t n)
             //      request to something larger.
             //
 #ifdef UNIX_SSL
-            if (d->ssl_session)
+            if (  d->ssl_session
+#if defined(UNIX_SSL_WORKERS)
+               && nullptr == d->tls
+#endif // UNIX_SSL_WORKERS
+               )
             {
                 tp->hdr.flags |= TBLK_FLAG_LOCKED;
             }
@@ -549,7 +707,7 @@ void queue_write_LEN(DESC *d, const UTF8 *b, size_t n)
                 {
                     d->output_tail = nullptr;
                 }
-                MEMFREE(tp);
+                free_tblock(tp);
                 tp = nullptr;
             }
         }
@@ -574,6 +732,12 @@ void queue_write_LEN(DESC *d, const UTF8 *b, size_t n)
         d->bCallProcessOutputLater = true;
     }
 #endif // WINDOWS_NETWORKING
+
+#if defined(UNIX_NETWORKING_EPOLL)
+    // Ask to be told when this output can be written.
+    //
+    epoll_update(d);
+#endif // UNIX_NETWORKING_EPOLL
 }
 
 void queue_write(DESC *d, const UTF8 *b)
@@ -627,6 +791,160 @@ static const UTF8 *encode_iac(const UTF8 *szString)
     return Buffer;
 }
 
+/*! \brief Find how much of a string the single-byte charsets leave alone.
+ *
+ * The conversion tables map printable ASCII, ESC, CR, and LF to themselves
+ * in every charset, and none of them is IAC.  Other control characters
+ * become '?', so they are left to the tables along with everything else.
+ *
+ * \param p   UTF8 text.
+ * \param n   Number of bytes to consider.
+ * \return    Length of the leading run that passes through unchanged.
+ */
+
+static size_t passthrough_span(const UTF8 *p, size_t n)
+{
+    size_t i = 0;
+#if defined(__AVX2__)
+    // As signed bytes, control characters and bytes with the high bit set
+    // are all less than a space.
+    //
+    const __m256i vSpace = _mm256_set1_epi8(0x20);
+    const __m256i vDel   = _mm256_set1_epi8(0x7F);
+    const __m256i vEsc   = _mm256_set1_epi8(0x1B);
+    const __m256i vCR    = _mm256_set1_epi8('\r');
+    const __m256i vLF    = _mm256_set1_epi8('\n');
+    while (i + sizeof(__m256i) <= n)
+    {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+        const __m256i vKeep = _mm256_or_si256(_mm256_cmpeq_epi8(v, vEsc),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, vCR), _mm256_cmpeq_epi8(v, vLF)));
+        const __m256i vStop = _mm256_or_si256(_mm256_andnot_si256(vKeep, _mm256_cmpgt_epi8(vSpace, v)),
+            _mm256_cmpeq_epi8(v, vDel));
+        const unsigned int mask = static_cast<unsigned int>(_mm256_movemask_epi8(vStop));
+        if (0 != mask)
+        {
+            return i + __builtin_ctz(mask);
+        }
+        i += sizeof(__m256i);
+    }
+#endif // __AVX2__
+#if defined(__SSE2__)
+    const __m128i vSpace16 = _mm_set1_epi8(0x20);
+    const __m128i vDel16   = _mm_set1_epi8(0x7F);
+    const __m128i vEsc16   = _mm_set1_epi8(0x1B);
+    const __m128i vCR16    = _mm_set1_epi8('\r');
+    const __m128i vLF16    = _mm_set1_epi8('\n');
+    while (i + sizeof(__m128i) <= n)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+        const __m128i vKeep = _mm_or_si128(_mm_cmpeq_epi8(v, vEsc16),
+            _mm_or_si128(_mm_cmpeq_epi8(v, vCR16), _mm_cmpeq_epi8(v, vLF16)));
+        const __m128i vStop = _mm_or_si128(_mm_andnot_si128(vKeep, _mm_cmplt_epi8(v, vSpace16)),
+            _mm_cmpeq_epi8(v, vDel16));
+        const unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(vStop));
+        if (0 != mask)
+        {
+            return i + __builtin_ctz(mask);
+        }
+        i += sizeof(__m128i);
+    }
+#endif // __SSE2__
+    while (i < n)
+    {
+        const UTF8 ch = p[i];
+        if (  (ch < 0x20 || 0x7F <= ch)
+           && 0x1B != ch
+           && '\r' != ch
+           && '\n' != ch)
+        {
+            break;
+        }
+        i++;
+    }
+    return i;
+}
+
+/*! \brief Convert UTF8 text to the descriptor's charset and escape IAC.
+ *
+ * For the single-byte charsets, this does the work of ConvertToLatin1(),
+ * ConvertToLatin2(), ConvertToCp437(), or ConvertToAscii() followed by
+ * encode_iac() in one pass.  Runs of text that every charset passes through
+ * unchanged are copied whole, and only the remaining code points go through
+ * the translation tables.
+ *
+ * \param d         Network descriptor state.
+ * \param pString   UTF8 text.
+ * \param pn        Length of the result.
+ * \return          Text ready for the output queue.
+ */
+
+static const UTF8 *encode_charset(DESC *d, const UTF8 *pString, size_t *pn)
+{
+    UTF8 (*fpConvert)(const UTF8 *);
+    if (CHARSET_UTF8 == d->encoding)
+    {
+        const UTF8 *q = encode_iac(pString);
+        *pn = strlen((const char *)q);
+        return q;
+    }
+    else if (CHARSET_LATIN1 == d->encoding)
+    {
+        fpConvert = ConvertCodePointToLatin1;
+    }
+    else if (CHARSET_LATIN2 == d->encoding)
+    {
+        fpConvert = ConvertCodePointToLatin2;
+    }
+    else if (CHARSET_CP437 == d->encoding)
+    {
+        fpConvert = ConvertCodePointToCp437;
+    }
+    else // if (CHARSET_ASCII == d->encoding)
+    {
+        fpConvert = ConvertCodePointToAscii;
+    }
+
+    static UTF8 Buffer[2*LBUF_SIZE];
+    UTF8 *q = Buffer;
+    UTF8 *qEnd = Buffer + sizeof(Buffer) - 1;
+    const UTF8 *pEnd = pString + strlen((const char *)pString);
+    while (  pString < pEnd
+          && q < qEnd)
+    {
+        size_t nRun = pEnd - pString;
+        if (static_cast<size_t>(qEnd - q) < nRun)
+        {
+            nRun = qEnd - q;
+        }
+        nRun = passthrough_span(pString, nRun);
+        memcpy(q, pString, nRun);
+        q += nRun;
+        pString += nRun;
+        if (  pEnd <= pString
+           || qEnd <= q)
+        {
+            break;
+        }
+
+        const UTF8 ch = fpConvert(pString);
+        if ('\0' == ch)
+        {
+            break;
+        }
+        pString = utf8_NextCodePoint(pString);
+        *q++ = ch;
+        if (  NVT_IAC == ch
+           && q < qEnd)
+        {
+            *q++ = NVT_IAC;
+        }
+    }
+    *q = '\0';
+    *pn = q - Buffer;
+    return Buffer;
+}
+
 void queue_string(DESC *d, const UTF8 *s)
 {
     const UTF8 *p;
@@ -647,89 +965,176 @@ void queue_string(DESC *d, const UTF8 *s)
         p = strip_color(s);
     }
 
-    const UTF8 *q;
-    if (CHARSET_UTF8 == d->encoding)
-    {
-        q = p;
-    }
-    else
+    size_t n;
+    const UTF8 *q = encode_charset(d, p, &n);
+    queue_write_LEN(d, q, n);
+}
+
+static const UTF8 *render_string(DESC *d, const mux_string &s, size_t *pn)
+{
+    const UTF8 *p = s.export_TextConverted((d->flags & DS_CONNECTED) && Ansi(d->player), NoBleed(d->player), Color256(d->player), Html(d->player));
+    return encode_charset(d, p, pn);
+}
+
+// While a broadcast is in progress, queue_string() keeps the bytes it
+// produced for each distinct message and output profile, so a message fanned
+// out to a room or channel is converted once per combination of color,
+// HTML, and charset instead of once per descriptor.  The message text is
+// compared in full, so recipients whose copy differs (NOSPOOF, prefixes) just
+// miss.
+//
+#define RENDER_CACHE_SIZE 8
+
+typedef struct
+{
+    mux_string *psSource;
+    int         iProfile;
+    UTF8       *pRendered;
+    size_t      nRendered;
+} RENDER_ENTRY;
+
+static RENDER_ENTRY render_cache[RENDER_CACHE_SIZE];
+static int   render_nEntries = 0;
+static int   render_iNext    = 0;
+static int   render_nDepth   = 0;
+static INT64 render_nHits    = 0;
+static INT64 render_nMisses  = 0;
+
+static int output_profile(DESC *d)
+{
+    int iProfile = d->encoding << 4;
+    if (  (d->flags & DS_CONNECTED)
+       && Ansi(d->player))
     {
-        if (CHARSET_LATIN1 == d->encoding)
-        {
-            q = ConvertToLatin1(p);
-        }
-        else if (CHARSET_LATIN2 == d->encoding)
-        {
-            q = ConvertToLatin2(p);
-        }
-        else if (CHARSET_CP437 == d->encoding)
+        if (Html(d->player))
         {
-            q = ConvertToCp437(p);
+            iProfile |= 0x9;
         }
-        else // if (CHARSET_ASCII == d->encoding)
+        else
         {
-            q = ConvertToAscii(p);
+            iProfile |= 0x1;
+            if (NoBleed(d->player))
+            {
+                iProfile |= 0x2;
+            }
+            if (Color256(d->player))
+            {
+                iProfile |= 0x4;
+            }
         }
     }
+    return iProfile;
+}
+
+/*! \brief Start sharing rendered output among the recipients of a message.
+ *
+ * Calls nest.  The cache is emptied when the outermost broadcast ends.
+ *
+ * \return          None.
+ */
+
+void begin_broadcast(void)
+{
+    render_nDepth++;
+}
+
+/*! \brief Finish a broadcast started with begin_broadcast().
+ *
+ * \return          None.
+ */
+
+void end_broadcast(void)
+{
+    render_nDepth--;
+    if (0 < render_nDepth)
+    {
+        return;
+    }
 
-    q = encode_iac(q);
-    queue_write(d, q);
+    for (int i = 0; i < render_nEntries; i++)
+    {
+        delete render_cache[i].psSource;
+        render_cache[i].psSource = nullptr;
+        MEMFREE(render_cache[i].pRendered);
+        render_cache[i].pRendered = nullptr;
+    }
+    render_nEntries = 0;
+    render_iNext = 0;
 }
 
 void queue_string(DESC *d, const mux_string &s)
 {
-    const UTF8 *p = s.export_TextConverted((d->flags & DS_CONNECTED) && Ansi(d->player), NoBleed(d->player), Color256(d->player), Html(d->player));
-
-    const UTF8 *q;
-    if (CHARSET_UTF8 == d->encoding)
+    if (0 == render_nDepth)
     {
-        q = p;
+        size_t n;
+        const UTF8 *q = render_string(d, s, &n);
+        queue_write_LEN(d, q, n);
+        return;
     }
-    else
+
+    int iProfile = output_profile(d);
+    for (int i = 0; i < render_nEntries; i++)
     {
-        if (CHARSET_LATIN1 == d->encoding)
-        {
-            q = ConvertToLatin1(p);
-        }
-        else if (CHARSET_LATIN2 == d->encoding)
-        {
-            q = ConvertToLatin2(p);
-        }
-        else if (CHARSET_CP437 == d->encoding)
-        {
-            q = ConvertToCp437(p);
-        }
-        else // if (CHARSET_ASCII == d->encoding)
+        RENDER_ENTRY *pe = &render_cache[i];
+        if (  pe->iProfile == iProfile
+           && pe->psSource->equal(s))
         {
-            q = ConvertToAscii(p);
+            render_nHits++;
+            queue_write_LEN(d, pe->pRendered, pe->nRendered);
+            return;
         }
     }
+    render_nMisses++;
+
+    size_t n;
+    const UTF8 *q = render_string(d, s, &n);
+
+    RENDER_ENTRY *pe = &render_cache[render_iNext];
+    if (render_nEntries < RENDER_CACHE_SIZE)
+    {
+        render_nEntries++;
+    }
+    else
+    {
+        delete pe->psSource;
+        MEMFREE(pe->pRendered);
+    }
+    render_iNext = (render_iNext + 1) % RENDER_CACHE_SIZE;
 
-    q = encode_iac(q);
-    queue_write(d, q);
+    pe->psSource = new mux_string(s);
+    pe->iProfile = iProfile;
+    pe->pRendered = (UTF8 *)MEMALLOC(n+1);
+    ISOUTOFMEMORY(pe->pRendered);
+    memcpy(pe->pRendered, q, n+1);
+    pe->nRendered = n;
+
+    queue_write_LEN(d, q, n);
 }
 
 void freeqs(DESC *d)
 {
     TBLOCK *tb, *tnext;
-    CBLK *cb, *cnext;
+    ICHUNK *ic, *icnext;
 
     tb = d->output_head;
     while (tb)
     {
         tnext = tb->hdr.nxt;
-        MEMFREE(tb);
+        free_tblock(tb);
         tb = tnext;
     }
     d->output_head = nullptr;
     d->output_tail = nullptr;
+#if defined(UNIX_MCCP)
+    mccp_free(d);
+#endif // UNIX_MCCP
 
-    cb = d->input_head;
-    while (cb)
+    ic = d->input_head;
+    while (ic)
     {
-        cnext = (CBLK *) cb->hdr.nxt;
-        free_lbuf(cb);
-        cb = cnext;
+        icnext = ic->hdr.nxt;
+        free_ichunk(ic);
+        ic = icnext;
     }
 
     d->input_head = nullptr;
@@ -829,22 +1234,55 @@ void welcome_user(DESC *d)
     }
 }
 
-void save_command(DESC *d, CBLK *command)
+/*! \brief Append a line of input to the descriptor's command queue.
+ *
+ * The line is copied, so the caller may reuse its buffer.
+ *
+ * \param d         Network descriptor state.
+ * \param pCommand  Line of input, not necessarily terminated.
+ * \param nCommand  Length of line in bytes.
+ * \return          None.
+ */
+
+// Each line in an input chunk is preceded by its length and arrival time.
+//
+typedef struct
 {
-    command->hdr.nxt = nullptr;
-    if (d->input_tail == nullptr)
-    {
-        d->input_head = command;
+    size_t nCommand;
+    INT64  tQueued;
+} ILINEHDR;
 
-        // We have added our first command to an empty list. Go process it later.
-        //
-        scheduler.DeferImmediateTask(PRIORITY_SYSTEM, Task_ProcessCommand, d, 0);
-    }
-    else
+void save_command(DESC *d, const UTF8 *pCommand, size_t nCommand)
+{
+    CLinearTimeAbsolute ltaNow;
+    ltaNow.GetUTC();
+    ILINEHDR lh;
+    lh.nCommand = nCommand;
+    lh.tQueued = ltaNow.Return100ns();
+
+    const size_t nNeeded = sizeof(lh) + nCommand;
+    ICHUNK *ic = d->input_tail;
+    if (  nullptr == ic
+       || ic->hdr.nSize - ic->hdr.nWrite < nNeeded)
     {
-        d->input_tail->hdr.nxt = command;
+        ic = alloc_ichunk(nNeeded);
+        if (nullptr == d->input_tail)
+        {
+            d->input_head = ic;
+
+            // We have added our first command to an empty list. Go process it later.
+            //
+            scheduler.DeferImmediateTask(PRIORITY_SYSTEM, Task_ProcessCommand, d, 0);
+        }
+        else
+        {
+            d->input_tail->hdr.nxt = ic;
+        }
+        d->input_tail = ic;
     }
-    d->input_tail = command;
+    memcpy(ic->data + ic->hdr.nWrite, &lh, sizeof(lh));
+    memcpy(ic->data + ic->hdr.nWrite + sizeof(lh), pCommand, nCommand);
+    ic->hdr.nWrite += nNeeded;
 }
 
 static void set_userstring(UTF8 **userstring, const UTF8 *command)
@@ -1070,6 +1508,7 @@ static void announce_connect(dbref player, DESC *d)
     s_Flags(player, FLAG_WORD2, Flags2(player) & ~VACATION);
     if (Guest(player))
     {
+        SnapshotTouch(player);
         db[player].fs.word[FLAG_WORD1] &= ~DARK;
     }
 
@@ -1379,11 +1818,13 @@ void announce_disconnect(dbref player, DESC *d, const UTF8 *reason)
         if (d->flags & DS_AUTODARK)
         {
             d->flags &= ~DS_AUTODARK;
+            SnapshotTouch(player);
             db[player].fs.word[FLAG_WORD1] &= ~DARK;
         }
 
         if (Guest(player))
         {
+            SnapshotTouch(player);
             db[player].fs.word[FLAG_WORD1] |= DARK;
             halt_que(NOTHING, player);
         }
@@ -1677,6 +2118,7 @@ void check_idle(void)
                     }
                     if (!bFound)
                     {
+                        SnapshotTouch(d->player);
                         db[d->player].fs.word[FLAG_WORD1] |= DARK;
                         DESC_ITER_PLAYER(d->player, d1)
                         {
@@ -2520,6 +2962,7 @@ static bool check_connect(DESC *d, UTF8 *msg)
                && (  RealWizard(player)
                   || God(player)))
             {
+                SnapshotTouch(player);
                 db[player].fs.word[FLAG_WORD1] |= DARK;
             }
 
@@ -3318,53 +3761,151 @@ void logged_out0(dbref executor, dbref caller, dbref enactor, int eval, int key)
     logged_out1(executor, caller, enactor, 0, key, (UTF8 *)"", nullptr, 0);
 }
 
+// The descriptor whose commands Task_ProcessCommand() is running, or nullptr
+// if the descriptor was shut down by one of them.
+//
+static DESC *command_batch_desc = nullptr;
+
+/*! \brief Note that a descriptor is going away.
+ *
+ * Task_ProcessCommand() must not touch it after the current command.
+ *
+ * \param d         Network descriptor state.
+ * \return          None.
+ */
+
+void stop_command_batch(DESC *d)
+{
+    if (command_batch_desc == d)
+    {
+        command_batch_desc = nullptr;
+    }
+}
+
+static void record_command_latency(DESC *d, const CLinearTimeDelta &ltdWait)
+{
+    static const INT64 aLimit[COMMAND_LATENCY_BUCKETS - 1] =
+    {
+        1 * FACTOR_100NS_PER_MILLISECOND,
+        4 * FACTOR_100NS_PER_MILLISECOND,
+        16 * FACTOR_100NS_PER_MILLISECOND,
+        64 * FACTOR_100NS_PER_MILLISECOND,
+        256 * FACTOR_100NS_PER_MILLISECOND,
+        FACTOR_100NS_PER_SECOND
+    };
+
+    CLinearTimeDelta ltd = ltdWait;
+    const INT64 t = ltd.Return100ns();
+    int i = 0;
+    while (  i < COMMAND_LATENCY_BUCKETS - 1
+          && aLimit[i] <= t)
+    {
+        i++;
+    }
+    d->command_latency[i]++;
+}
+
+// Runs the descriptor's queued commands until the queue is empty, its quota
+// is used up, or command_batch_time has passed.  Anything left waits behind
+// other descriptors' tasks, so one busy descriptor cannot starve the rest.
+//
 void Task_ProcessCommand(void *arg_voidptr, int arg_iInteger)
 {
     UNUSED_PARAMETER(arg_iInteger);
 
     DESC *d = (DESC *)arg_voidptr;
-    if (d)
+    if (  nullptr == d
+       || nullptr == d->input_head)
     {
-        CBLK *t = d->input_head;
-        if (t)
+        return;
+    }
+
+    if (d->quota <= 0)
+    {
+        // Don't bother looking for more quota until at least this much time has past.
+        //
+        CLinearTimeAbsolute lsaWhen;
+        lsaWhen.GetUTC();
+
+        scheduler.DeferTask(lsaWhen + mudconf.timeslice, PRIORITY_SYSTEM, Task_ProcessCommand, d, 0);
+        return;
+    }
+
+    CLinearTimeAbsolute ltaNow;
+    ltaNow.GetUTC();
+    const CLinearTimeAbsolute ltaStop = ltaNow + mudconf.command_batch_time;
+
+    command_batch_desc = d;
+    for (;;)
+    {
+        d->quota--;
+
+        // The command becomes an lbuf only now that it is about to run.
+        //
+        ICHUNK *ic = d->input_head;
+        ILINEHDR lh;
+        memcpy(&lh, ic->data + ic->hdr.nRead, sizeof(lh));
+        UTF8 *cmd = alloc_lbuf("Task_ProcessCommand");
+        memcpy(cmd, ic->data + ic->hdr.nRead + sizeof(lh), lh.nCommand);
+        cmd[lh.nCommand] = '\0';
+        ic->hdr.nRead += sizeof(lh) + lh.nCommand;
+        if (ic->hdr.nRead == ic->hdr.nWrite)
         {
-            if (d->quota > 0)
-            {
-                d->quota--;
-                d->input_head = (CBLK *) t->hdr.nxt;
-                if (d->input_head)
-                {
-                    // There are still commands to process, so schedule another looksee.
-                    //
-                    scheduler.DeferImmediateTask(PRIORITY_SYSTEM, Task_ProcessCommand, d, 0);
-                }
-                else
-                {
-                    d->input_tail = nullptr;
-                }
-                d->input_size -= strlen((char *)t->cmd);
-                d->last_time.GetUTC();
-                if (d->program_data != nullptr)
-                {
-                    handle_prog(d, t->cmd);
-                }
-                else
-                {
-                    do_command(d, t->cmd);
-                }
-                free_lbuf(t);
-            }
-            else
-            {
-                // Don't bother looking for more quota until at least this much time has past.
-                //
-                CLinearTimeAbsolute lsaWhen;
-                lsaWhen.GetUTC();
+            d->input_head = ic->hdr.nxt;
+            free_ichunk(ic);
+            ic = nullptr;
+        }
 
-                scheduler.DeferTask(lsaWhen + mudconf.timeslice, PRIORITY_SYSTEM, Task_ProcessCommand, d, 0);
-            }
+        if (nullptr == d->input_head)
+        {
+            d->input_tail = nullptr;
+#if defined(UNIX_NETWORKING_EPOLL)
+
+            // The input queue has drained, so resume reading.
+            //
+            epoll_update(d);
+#endif // UNIX_NETWORKING_EPOLL
+        }
+
+        CLinearTimeAbsolute ltaQueued;
+        ltaQueued.Set100ns(lh.tQueued);
+        record_command_latency(d, ltaNow - ltaQueued);
+
+        d->input_size -= lh.nCommand;
+        d->last_time = ltaNow;
+        if (d->program_data != nullptr)
+        {
+            handle_prog(d, cmd);
+        }
+        else
+        {
+            do_command(d, cmd);
+        }
+        free_lbuf(cmd);
+
+        if (command_batch_desc != d)
+        {
+            // The command closed this descriptor.
+            //
+            return;
+        }
+
+        ltaNow.GetUTC();
+        if (  nullptr == d->input_head
+           || d->quota <= 0
+           || ltaStop <= ltaNow)
+        {
+            break;
         }
     }
+    command_batch_desc = nullptr;
+
+    if (nullptr != d->input_head)
+    {
+        // There are still commands to process, so schedule another looksee.
+        //
+        scheduler.DeferImmediateTask(PRIORITY_SYSTEM, Task_ProcessCommand, d, 0);
+    }
 }
 
 /* ---------------------------------------------------------------------------
@@ -3376,6 +3917,78 @@ void list_siteinfo(dbref player)
     mudstate.access_list.listinfo(player);
 }
 
+/* ---------------------------------------------------------------------------
+ * list_output_stats: Show the output block pool and per-descriptor write
+ * counters for @list process.
+ */
+
+void list_output_stats(dbref player)
+{
+    raw_notify(player, tprintf(T("Out blocks:  %10d in use %10d free   %10d peak"),
+        static_cast<int>(tblock_nInUse), static_cast<int>(tblock_nFree),
+        static_cast<int>(tblock_nHighWater)));
+    UTF8 aFirst[I64BUF_SIZE];
+    UTF8 aSecond[I64BUF_SIZE];
+    mux_i64toa(tblock_nAllocs, aFirst);
+    mux_i64toa(tblock_nReuses, aSecond);
+    raw_notify(player, tprintf(T("Out allocs:  %10s heap   %10s reused"), aFirst, aSecond));
+    mux_i64toa(ichunk_nLarge, aFirst);
+    raw_notify(player, tprintf(T("In chunks:   %10d in use %10d free   %10d peak   %s large"),
+        static_cast<int>(ichunk_nInUse), static_cast<int>(ichunk_nFree),
+        static_cast<int>(ichunk_nHighWater), aFirst));
+    mux_i64toa(render_nHits, aFirst);
+    mux_i64toa(render_nMisses, aSecond);
+    raw_notify(player, tprintf(T("Renders:     %10s shared %10s converted"), aFirst, aSecond));
+
+    raw_notify(player, T("Port     Writes      Bytes  Bytes/Write  Player"));
+    DESC *d;
+    DESC_ITER_ALL(d)
+    {
+        size_t nAverage = (0 < d->output_syscalls) ? d->output_sent / d->output_syscalls : 0;
+        raw_notify(player, tprintf(T("%4d %10d %10d %12d  %s"),
+            static_cast<int>(d->socket), static_cast<int>(d->output_syscalls),
+            static_cast<int>(d->output_sent), static_cast<int>(nAverage),
+            (d->flags & DS_CONNECTED) ? Moniker(d->player) : T("<unconnected>")));
+    }
+
+    // How long input lines waited between arrival and execution.
+    //
+    raw_notify(player, T("Port    <1ms    <4ms   <16ms   <64ms  <256ms     <1s    >=1s  Player"));
+    DESC_ITER_ALL(d)
+    {
+        const int *a = d->command_latency;
+        raw_notify(player, tprintf(T("%4d %7d %7d %7d %7d %7d %7d %7d  %s"),
+            static_cast<int>(d->socket), a[0], a[1], a[2], a[3], a[4], a[5], a[6],
+            (d->flags & DS_CONNECTED) ? Moniker(d->player) : T("<unconnected>")));
+    }
+#if defined(UNIX_MCCP)
+
+    bool bHeader = false;
+    DESC_ITER_ALL(d)
+    {
+        if (0 == d->compress_in)
+        {
+            continue;
+        }
+        if (!bHeader)
+        {
+            raw_notify(player, T("Port  Uncompressed  Compressed  Ratio  Player"));
+            bHeader = true;
+        }
+        UTF8 aIn[I64BUF_SIZE], aOut[I64BUF_SIZE];
+        mux_i64toa(d->compress_in, aIn);
+        mux_i64toa(d->compress_out, aOut);
+        raw_notify(player, tprintf(T("%4d  %12s  %10s  %4d%%  %s"),
+            static_cast<int>(d->socket), aIn, aOut,
+            static_cast<int>((100 * d->compress_out) / d->compress_in),
+            (d->flags & DS_CONNECTED) ? Moniker(d->player) : T("<unconnected>")));
+    }
+#endif // UNIX_MCCP
+#if defined(UNIX_SSL_WORKERS)
+    list_tls_stats(player);
+#endif // UNIX_SSL_WORKERS
+}
+
 /* ---------------------------------------------------------------------------
  * make_ulist: Make a list of connected user numbers for the LWHO function.
  */
@@ -501,6 +501,7 @@ dbref create_obj(dbref player, int objtype, const UTF8 *name, int cost)
         s_Zone(obj, NOTHING);
     }
     f.word[FLAG_WORD1] |= objtype;
+    SnapshotTouch(obj);
     db[obj].fs = f;
     s_Owner(obj, (self_owned ? obj : owner));
     s_Pennies(obj, value);
@@ -884,6 +885,7 @@ static void purge_going(void)
                 }
                 log_text(T("GOING object doesn\xE2\x80\x99t remember its destroyer. GOING reset."));
                 ENDLOG;
+                SnapshotTouch(i);
                 db[i].fs.word[FLAG_WORD1] &= ~GOING;
             }
             else
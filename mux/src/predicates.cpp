@@ -127,12 +127,7 @@ bool could_doit(dbref player, dbref thing, int locknum)
         return true;
     }
 
-    dbref aowner;
-    int   aflags;
-    UTF8 *key = atr_get("could_doit.134", thing, locknum, &aowner, &aflags);
-    bool doit = eval_boolexp_atr(player, thing, thing, key);
-    free_lbuf(key);
-    return doit;
+    return eval_boolexp_lock(player, thing, thing, locknum);
 }
 
 bool can_see(dbref player, dbref thing, bool can_see_loc)
@@ -1599,6 +1594,13 @@ void do_restart(dbref executor, dbref caller, dbref enactor, int eval, int key)
         return;
     }
 
+#if defined(UNIX_NETWORKING)
+    // Connections which have been accepted but not yet greeted would have no
+    // descriptor to carry across the restart.
+    //
+    greet_pending_connections();
+#endif // UNIX_NETWORKING
+
 #ifdef UNIX_SSL
     raw_broadcast(0, T("GAME: Restart by %s, please wait.  (All SSL connections will be dropped.)"), Moniker(Owner(executor)));
 #else
@@ -1609,6 +1611,9 @@ void do_restart(dbref executor, dbref caller, dbref enactor, int eval, int key)
     log_name(executor);
     ENDLOG;
 
+#if defined(UNIX_MCCP)
+    mccp_stop_all();
+#endif // UNIX_MCCP
 #ifdef UNIX_SSL
     CleanUpSSLConnections();
 #endif
@@ -1625,6 +1630,7 @@ void do_restart(dbref executor, dbref caller, dbref enactor, int eval, int key)
 #endif // STUB_SLAVE
     final_modules();
 
+    dump_snapshot_abandon();
 #ifndef MEMORY_BASED
     al_store();
 #endif
@@ -1692,6 +1698,7 @@ void do_backup(dbref executor, dbref caller, dbref enactor, int eval, int key)
     }
 #endif // HAVE_WORKING_FORK
 
+    dump_snapshot_abandon();
     raw_broadcast(0, T("GAME: Backing up database. Please wait."));
     STARTLOG(LOG_ALWAYS, "WIZ", "BACK");
     log_text(T("Backup by "));
@@ -141,7 +141,7 @@ void do_chzone
 
     // Everything is okay, do the change.
     //
-    db[thing].zone = zone;
+    s_Zone(thing, zone);
     if (!isPlayer(thing))
     {
         // If the object is a player, resetting these flags is rather
@@ -152,8 +152,8 @@ void do_chzone
 
         // Wipe out all powers.
         //
-        Powers(thing) = 0;
-        Powers2(thing) = 0;
+        s_Powers(thing, 0);
+        s_Powers2(thing, 0);
     }
     notify(executor, T("Zone changed."));
 }
@@ -799,6 +799,7 @@ void SetClearFlags
     FLAG aSetFlags[3]
 )
 {
+    SnapshotTouch(thing);
     int j;
     for (j = FLAG_WORD1; j <= FLAG_WORD3; j++)
     {
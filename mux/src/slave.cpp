@@ -1,11 +1,22 @@
 /*! \file slave.cpp
  * \brief This slave does iptoname conversions.
  *
- * The philosophy is to keep this program as simple/small as possible.  It
- * routinely performs non-vfork forks()s, so the conventional wisdom is that
- * the smaller it is, the faster it goes.  However, with modern memory
- * management support (including copy on reference paging), size is probably
- * not the issue it once was.
+ * The game writes one numeric address per request, and the slave answers
+ * with the address followed by its host name, or followed by the address
+ * again if no name can be found.
+ *
+ * Rather than fork()ing a child to sit in a blocking resolver call for each
+ * request, the slave sends PTR queries straight to the name servers listed
+ * in resolv.conf and waits for all of them at once.  Answers are cached for
+ * as long as the name servers say they are good, and failures are cached
+ * for a shorter time, so a storm of connections from the same few sites
+ * costs one query per site.  A request for an address which is already
+ * being looked up simply waits for that query.
+ *
+ * The name servers may be given on the command line instead, which is how
+ * testcases/tools/ResolverTest runs the slave against a stub:
+ *
+ *     slave [-s address[:port]] ...
  */
 
 #include "autoconf.h"
@@ -27,21 +38,94 @@
 #include <sys/ioctl.h>
 #endif // HAVE_SYS_IOCTL_H
 
+#include <ctype.h>
 #include <signal.h>
 #include "slave.h"
 #ifdef HAVE_ARPA_INET_H
 #include <arpa/inet.h>
 #endif // HAVE_ARPA_INET_H
 
-#ifdef _SGI_SOURCE
-#define CAST_SIGNAL_FUNC (SIG_PF)
-#else
-#define CAST_SIGNAL_FUNC
+pid_t parent_pid;
+
+#define MAX_STRING       1000
+#define MAX_NAME         256
+#define MAX_ADDRESS      64
+#define MAX_SERVERS      3
+#define MAX_QUERIES      256
+#define MAX_PACKET       4096
+#define HASH_SIZE        4096
+#define CACHE_SIZE       16384
+
+#define QUERY_TIMEOUT    2000   // Milliseconds before asking again.
+#define QUERY_ATTEMPTS   2      // Times each server is asked.
+
+#define MIN_TTL          60     // Shortest time an answer is kept.
+#define MAX_TTL          86400  // Longest time an answer is kept.
+#define MAX_NEGATIVE_TTL 3600   // Longest time a missing name is remembered.
+#define NEGATIVE_TTL     300    // When the server does not say how long.
+#define FAILURE_TTL      60     // After a timeout or a server failure.
+
+#define DNS_TYPE_PTR     12
+#define DNS_TYPE_SOA     6
+#define DNS_CLASS_IN     1
+#define DNS_RCODE_NXDOMAIN 3
+
+struct name_server
+{
+    union
+    {
+        struct sockaddr     sa;
+        struct sockaddr_in  sin;
+#if defined(HAVE_SOCKADDR_IN6)
+        struct sockaddr_in6 sin6;
 #endif
+    } u;
+    socklen_t len;
+};
 
-pid_t parent_pid;
+struct dns_query;
 
-#define MAX_STRING 1000
+// A cache entry.  An entry is waiting when its lookup is queued or in
+// flight, and it is otherwise answered until it expires.  Entries from
+// the hosts file never expire.
+//
+struct name_entry
+{
+    char        addr[MAX_ADDRESS];
+    char        name[MAX_NAME];     // Empty for a failed lookup.
+    time_t      expires;
+    bool        permanent;
+    bool        waiting;
+    name_entry *next;               // Hash chain.
+    name_entry *pNextQueued;
+};
+
+struct dns_query
+{
+    name_entry   *e;
+    int           socket;
+    UINT16        id;
+    int           iServer;
+    int           nTries;
+    INT64         deadline;
+    size_t        nQuestion;        // Length of the question section.
+    size_t        nPacket;
+    unsigned char aPacket[512];
+};
+
+static name_server  aServers[MAX_SERVERS];
+static int          nServers = 0;
+
+static name_entry  *aHash[HASH_SIZE];
+static int          nEntries = 0;
+
+static dns_query    aQueries[MAX_QUERIES];
+static int          nQueries = 0;
+
+static name_entry  *pQueueHead = nullptr;
+static name_entry  *pQueueTail = nullptr;
+
+static int          fdRandom = -1;
 
 //
 // copy a string, returning pointer to the null terminator of dest
@@ -56,71 +140,126 @@ char *mux_stpcpy(char *dest, const char *src)
     return (dest);
 }
 
-void child_timeout_signal(int iSig)
+static INT64 now_msec(void)
 {
-    exit(1);
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    return static_cast<INT64>(tv.tv_sec) * 1000 + tv.tv_usec / 1000;
 }
 
-int query(char *ip)
+static UINT16 random_id(void)
 {
-    const char *pHName = ip;
+    unsigned char buf[2];
+    if (  fdRandom < 0
+       || read(fdRandom, buf, sizeof(buf)) != sizeof(buf))
+    {
+        return static_cast<UINT16>(rand() & 0xFFFF);
+    }
+    return static_cast<UINT16>((buf[0] << 8) | buf[1]);
+}
 
-#if defined(HAVE_GETADDRINFO) && defined(HAVE_GETNAMEINFO)
+static unsigned int hash_address(const char *addr)
+{
+    unsigned int h = 2166136261U;
+    while (*addr)
+    {
+        h = (h ^ static_cast<unsigned char>(*addr++)) * 16777619U;
+    }
+    return h & (HASH_SIZE - 1);
+}
 
-    // Let getaddrinfo() fill out the sockinfo structure for us.
-    //
-    struct addrinfo hints;
-    memset(&hints, 0, sizeof(hints));
-    hints.ai_family   = AF_UNSPEC;
-    hints.ai_socktype = SOCK_STREAM;
-    hints.ai_protocol = IPPROTO_TCP;
-    hints.ai_flags = AI_ADDRCONFIG;
+static name_entry *find_entry(const char *addr)
+{
+    for (name_entry *e = aHash[hash_address(addr)]; nullptr != e; e = e->next)
+    {
+        if (0 == strcmp(e->addr, addr))
+        {
+            return e;
+        }
+    }
+    return nullptr;
+}
 
-    struct addrinfo *servinfo;
-    char host[MAX_STRING];
-    if (0 == getaddrinfo(ip, nullptr, &hints, &servinfo))
+static void remove_entry(name_entry *e)
+{
+    name_entry **pp = &aHash[hash_address(e->addr)];
+    while (*pp != e)
+    {
+        pp = &(*pp)->next;
+    }
+    *pp = e->next;
+    free(e);
+    nEntries--;
+}
+
+// Make room in a full cache by dropping expired entries, or failing that,
+// the entry closest to expiring.
+//
+static void trim_cache(time_t now)
+{
+    name_entry *pOldest = nullptr;
+    for (int i = 0; i < HASH_SIZE; i++)
     {
-        for (struct addrinfo *p = servinfo; nullptr != p; p = p->ai_next)
+        name_entry *e = aHash[i];
+        while (nullptr != e)
         {
-            if (0 == getnameinfo(p->ai_addr, p->ai_addrlen, host, sizeof(host), nullptr, 0, NI_NUMERICSERV))
+            name_entry *next = e->next;
+            if (  !e->permanent
+               && !e->waiting)
             {
-                pHName = host;
-                break;
+                if (e->expires <= now)
+                {
+                    remove_entry(e);
+                }
+                else if (  nullptr == pOldest
+                        || e->expires < pOldest->expires)
+                {
+                    pOldest = e;
+                }
             }
+            e = next;
         }
-        freeaddrinfo(servinfo);
     }
 
-#else
-
-#ifndef INADDR_NONE
-#define INADDR_NONE ((in_addr_t)-1)
-#endif
+    if (  CACHE_SIZE <= nEntries
+       && nullptr != pOldest)
+    {
+        remove_entry(pOldest);
+    }
+}
 
-    in_addr_t addr = inet_addr(ip);
-    if (INADDR_NONE == addr)
+static name_entry *add_entry(const char *addr, time_t now)
+{
+    if (CACHE_SIZE <= nEntries)
     {
-        return -1;
+        trim_cache(now);
     }
 
-#if defined(HAVE_GETHOSTBYADDR)
-    struct hostent *hp = gethostbyaddr((char *) &addr, sizeof(addr), AF_INET);
-    if (  nullptr != hp
-       && strlen(hp->h_name) < MAX_STRING)
+    name_entry *e = static_cast<name_entry *>(malloc(sizeof(name_entry)));
+    if (nullptr == e)
     {
-        pHName = hp->h_name;
+        return nullptr;
     }
-#endif
-#endif
+    memset(e, 0, sizeof(name_entry));
+    strncpy(e->addr, addr, sizeof(e->addr) - 1);
+
+    unsigned int h = hash_address(addr);
+    e->next = aHash[h];
+    aHash[h] = e;
+    nEntries++;
+    return e;
+}
 
+static int reply(const char *addr, const char *name)
+{
     char buf[MAX_STRING * 2];
-    char *p = mux_stpcpy(buf, ip);
+    char *p = mux_stpcpy(buf, addr);
     *p++ = ' ';
-    p = mux_stpcpy(p, pHName);
+    p = mux_stpcpy(p, ('\0' != name[0]) ? name : addr);
     *p++ = '\n';
-    *p++ = '\0';
+    *p = '\0';
 
-    size_t len = strlen(buf);
+    size_t len = p - buf;
     ssize_t written = write(1, buf, len);
     if (  written < 0
        || len != (size_t)written)
@@ -130,52 +269,574 @@ int query(char *ip)
     return 0;
 }
 
-void alarm_signal(int iSig)
+// Build the PTR name for an address: 4.3.2.1.in-addr.arpa, or 32 reversed
+// nibbles and ip6.arpa.  Returns the length of the name in DNS wire format,
+// or 0 if this is not a numeric address.
+//
+static size_t encode_ptr_name(const char *addr, unsigned char *p)
 {
-    struct itimerval itime;
-    struct timeval interval;
+    unsigned char aBytes[16];
+    unsigned char *q = p;
+    struct in_addr a4;
+    if (1 == inet_pton(AF_INET, addr, &a4))
+    {
+        memcpy(aBytes, &a4, 4);
+        for (int i = 3; 0 <= i; i--)
+        {
+            char label[4];
+            int n = snprintf(label, sizeof(label), "%u", aBytes[i]);
+            *q++ = static_cast<unsigned char>(n);
+            memcpy(q, label, n);
+            q += n;
+        }
+        memcpy(q, "\007in-addr\004arpa", 14);
+        return (q - p) + 14;
+    }
 
-    if (getppid() != parent_pid)
+#if defined(HAVE_IN6_ADDR)
+    struct in6_addr a6;
+    if (1 == inet_pton(AF_INET6, addr, &a6))
     {
-        exit(1);
+        memcpy(aBytes, &a6, 16);
+
+        // Look up IPv4-mapped addresses under in-addr.arpa.
+        //
+        static const unsigned char aMapped[12] =
+            { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xFF, 0xFF };
+        if (0 == memcmp(aBytes, aMapped, 12))
+        {
+            char buf[MAX_ADDRESS];
+            snprintf(buf, sizeof(buf), "%u.%u.%u.%u", aBytes[12], aBytes[13],
+                aBytes[14], aBytes[15]);
+            return encode_ptr_name(buf, p);
+        }
+
+        static const char aHex[] = "0123456789abcdef";
+        for (int i = 15; 0 <= i; i--)
+        {
+            *q++ = 1;
+            *q++ = aHex[aBytes[i] & 0x0F];
+            *q++ = 1;
+            *q++ = aHex[aBytes[i] >> 4];
+        }
+        memcpy(q, "\003ip6\004arpa", 10);
+        return (q - p) + 10;
+    }
+#endif // HAVE_IN6_ADDR
+
+    return 0;
+}
+
+// Step over a possibly-compressed name.  Returns the offset just past it, or
+// 0 if it runs off the end of the packet.
+//
+static size_t skip_name(const unsigned char *pkt, size_t n, size_t i)
+{
+    while (i < n)
+    {
+        unsigned char c = pkt[i];
+        if (0 == c)
+        {
+            return i + 1;
+        }
+        else if (0xC0 == (c & 0xC0))
+        {
+            return (i + 2 <= n) ? i + 2 : 0;
+        }
+        else if (0 != (c & 0xC0))
+        {
+            return 0;
+        }
+        i += 1 + c;
     }
+    return 0;
+}
 
-    signal(SIGALRM, CAST_SIGNAL_FUNC alarm_signal);
-    interval.tv_sec = 120;  // 2 minutes.
-    interval.tv_usec = 0;
-    itime.it_interval = interval;
-    itime.it_value = interval;
-    setitimer(ITIMER_REAL, &itime, 0);
+// Expand a possibly-compressed name into dotted text without the trailing
+// dot.  Only letters, digits, hyphens, and underscores are accepted, since
+// the name ends up in logs and in attributes.
+//
+static bool decode_name(const unsigned char *pkt, size_t n, size_t i, char *name)
+{
+    size_t nName = 0;
+    int nJumps = 0;
+    while (i < n)
+    {
+        unsigned char c = pkt[i];
+        if (0 == c)
+        {
+            name[nName] = '\0';
+            return 0 < nName;
+        }
+        else if (0xC0 == (c & 0xC0))
+        {
+            if (  n <= i + 1
+               || 32 < ++nJumps)
+            {
+                return false;
+            }
+            i = ((c & 0x3F) << 8) | pkt[i + 1];
+            continue;
+        }
+        else if (  0 != (c & 0xC0)
+                || n < i + 1 + c
+                || MAX_NAME - 2 < nName + c + 1)
+        {
+            return false;
+        }
+
+        if (0 < nName)
+        {
+            name[nName++] = '.';
+        }
+        for (size_t j = 1; j <= c; j++)
+        {
+            unsigned char ch = pkt[i + j];
+            if (  !isalnum(ch)
+               && '-' != ch
+               && '_' != ch)
+            {
+                return false;
+            }
+            name[nName++] = static_cast<char>(ch);
+        }
+        i += 1 + c;
+    }
+    return false;
 }
 
-#define MAX_CHILDREN 20
-volatile int nChildrenStarted = 0;
-volatile int nChildrenEndedSIGCHLD = 0;
-volatile int nChildrenEndedMain = 0;
+static UINT32 get32(const unsigned char *p)
+{
+    return (static_cast<UINT32>(p[0]) << 24) | (static_cast<UINT32>(p[1]) << 16)
+         | (static_cast<UINT32>(p[2]) << 8) | static_cast<UINT32>(p[3]);
+}
 
-void child_signal(int iSig)
+static void finish_query(dns_query *q, const char *name, UINT32 ttl);
+static bool start_query(dns_query *q);
+
+static void send_query(dns_query *q)
 {
-    // Collect the children.
+    if (0 <= q->socket)
+    {
+        close(q->socket);
+        q->socket = -1;
+    }
+
+    // A fresh socket for each attempt gets a fresh source port from the
+    // kernel, which together with the random id makes answers hard to forge.
     //
-    while (waitpid(0, nullptr, WNOHANG) > 0)
+    name_server *ns = &aServers[q->iServer];
+    q->socket = socket(ns->u.sa.sa_family, SOCK_DGRAM, 0);
+    if (  0 <= q->socket
+       && (  FD_SETSIZE <= q->socket
+          || connect(q->socket, &ns->u.sa, ns->len) < 0))
+    {
+        close(q->socket);
+        q->socket = -1;
+    }
+    if (q->socket < 0)
+    {
+        q->deadline = 0;
+        return;
+    }
+
+    q->id = random_id();
+    q->aPacket[0] = static_cast<unsigned char>(q->id >> 8);
+    q->aPacket[1] = static_cast<unsigned char>(q->id);
+    send(q->socket, q->aPacket, q->nPacket, 0);
+    q->deadline = now_msec() + QUERY_TIMEOUT;
+}
+
+static bool start_query(dns_query *q)
+{
+    unsigned char *p = q->aPacket;
+    memset(p, 0, 12);
+    p[2] = 0x01;   // Recursion desired.
+    p[5] = 1;      // One question.
+
+    size_t nName = encode_ptr_name(q->e->addr, p + 12);
+    if (0 == nName)
     {
-        int nChildren = nChildrenStarted - nChildrenEndedSIGCHLD
-            - nChildrenEndedMain;
-        if (0 < nChildren)
+        return false;
+    }
+    p += 12 + nName;
+    *p++ = 0;
+    *p++ = DNS_TYPE_PTR;
+    *p++ = 0;
+    *p++ = DNS_CLASS_IN;
+    q->nQuestion = nName + 4;
+    q->nPacket = 12 + q->nQuestion;
+
+    q->socket = -1;
+    q->iServer = 0;
+    q->nTries = 1;
+    send_query(q);
+    return true;
+}
+
+// Try the next server, or give up once each has been asked enough times.
+//
+static void retry_query(dns_query *q)
+{
+    if (nServers * QUERY_ATTEMPTS <= q->nTries)
+    {
+        finish_query(q, "", FAILURE_TTL);
+        return;
+    }
+    q->nTries++;
+    q->iServer = (q->iServer + 1) % nServers;
+    send_query(q);
+}
+
+// Servers may change the case of the name in the question they echo back.
+//
+static bool same_question(const unsigned char *p, const unsigned char *q, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        if (tolower(p[i]) != tolower(q[i]))
         {
-            nChildrenEndedSIGCHLD++;
+            return false;
         }
     }
+    return true;
+}
 
-    signal(SIGCHLD, CAST_SIGNAL_FUNC child_signal);
+// Match an answer to the question and pull out the name and how long to
+// keep it.  Returns false for packets which are not the answer to this
+// query.
+//
+static bool parse_answer(dns_query *q, const unsigned char *pkt, size_t n)
+{
+    if (  n < q->nPacket
+       || pkt[0] != q->aPacket[0]
+       || pkt[1] != q->aPacket[1]
+       || 0 == (pkt[2] & 0x80)
+       || 0 != (pkt[2] & 0x78)
+       || 0 != pkt[4]
+       || 1 != pkt[5]
+       || !same_question(pkt + 12, q->aPacket + 12, q->nQuestion))
+    {
+        return false;
+    }
+
+    int rcode = pkt[3] & 0x0F;
+    if (  0 != (pkt[2] & 0x02)
+       || (  0 != rcode
+          && DNS_RCODE_NXDOMAIN != rcode))
+    {
+        // Truncated, or the server failed.
+        //
+        finish_query(q, "", FAILURE_TTL);
+        return true;
+    }
+
+    size_t nAnswers   = (pkt[6] << 8) | pkt[7];
+    size_t nAuthority = (pkt[8] << 8) | pkt[9];
+    size_t i = q->nPacket;
+
+    for (size_t k = 0; k < nAnswers + nAuthority; k++)
+    {
+        i = skip_name(pkt, n, i);
+        if (  0 == i
+           || n < i + 10)
+        {
+            break;
+        }
+        unsigned int type  = (pkt[i] << 8) | pkt[i + 1];
+        unsigned int cls   = (pkt[i + 2] << 8) | pkt[i + 3];
+        UINT32       ttl   = get32(pkt + i + 4);
+        size_t       nData = (pkt[i + 8] << 8) | pkt[i + 9];
+        i += 10;
+        if (n < i + nData)
+        {
+            break;
+        }
+
+        char name[MAX_NAME];
+        if (  k < nAnswers
+           && DNS_TYPE_PTR == type
+           && DNS_CLASS_IN == cls
+           && decode_name(pkt, n, i, name))
+        {
+            finish_query(q, name, ttl);
+            return true;
+        }
+        else if (  nAnswers <= k
+                && DNS_TYPE_SOA == type)
+        {
+            // The negative answer lasts for the smaller of the SOA record's
+            // own lifetime and its minimum field.
+            //
+            size_t j = skip_name(pkt, i + nData, i);
+            j = (0 == j) ? 0 : skip_name(pkt, i + nData, j);
+            if (  0 != j
+               && j + 20 <= i + nData)
+            {
+                UINT32 minimum = get32(pkt + j + 16);
+                ttl = (minimum < ttl) ? minimum : ttl;
+                finish_query(q, "", (MAX_NEGATIVE_TTL < ttl) ? MAX_NEGATIVE_TTL : ttl);
+                return true;
+            }
+        }
+        i += nData;
+    }
+
+    finish_query(q, "", NEGATIVE_TTL);
+    return true;
 }
 
-int main(int argc, char *argv[])
+static void queue_entry(name_entry *e)
+{
+    e->waiting = true;
+    e->pNextQueued = nullptr;
+    if (nullptr == pQueueTail)
+    {
+        pQueueHead = e;
+    }
+    else
+    {
+        pQueueTail->pNextQueued = e;
+    }
+    pQueueTail = e;
+}
+
+// Start queued lookups while there are free query slots.
+//
+static void run_queue(void)
+{
+    while (  nullptr != pQueueHead
+          && nQueries < MAX_QUERIES)
+    {
+        name_entry *e = pQueueHead;
+        pQueueHead = e->pNextQueued;
+        if (nullptr == pQueueHead)
+        {
+            pQueueTail = nullptr;
+        }
+
+        dns_query *q = &aQueries[nQueries];
+        memset(q, 0, sizeof(dns_query));
+        q->e = e;
+        nQueries++;
+        if (!start_query(q))
+        {
+            finish_query(q, "", FAILURE_TTL);
+        }
+    }
+}
+
+static void finish_query(dns_query *q, const char *name, UINT32 ttl)
+{
+    name_entry *e = q->e;
+    if (MAX_TTL < ttl)
+    {
+        ttl = MAX_TTL;
+    }
+    else if (ttl < MIN_TTL)
+    {
+        ttl = MIN_TTL;
+    }
+    strncpy(e->name, name, sizeof(e->name) - 1);
+    e->name[sizeof(e->name) - 1] = '\0';
+    e->expires = time(nullptr) + ttl;
+    e->waiting = false;
+    reply(e->addr, e->name);
+
+    if (0 <= q->socket)
+    {
+        close(q->socket);
+    }
+
+    // Keep the active queries packed at the front of the array.
+    //
+    nQueries--;
+    if (q != &aQueries[nQueries])
+    {
+        *q = aQueries[nQueries];
+    }
+}
+
+static void request(const char *addr)
+{
+    time_t now = time(nullptr);
+    name_entry *e = find_entry(addr);
+    if (nullptr != e)
+    {
+        if (e->waiting)
+        {
+            // The answer to the earlier request serves this one, too.
+            //
+            return;
+        }
+        else if (  e->permanent
+                || now < e->expires)
+        {
+            reply(e->addr, e->name);
+            return;
+        }
+    }
+    else
+    {
+        e = add_entry(addr, now);
+        if (nullptr == e)
+        {
+            reply(addr, "");
+            return;
+        }
+    }
+    queue_entry(e);
+    run_queue();
+}
+
+static void add_server(const char *arg)
 {
-    char arg[MAX_STRING];
-    int len;
-    pid_t child;
+    if (MAX_SERVERS <= nServers)
+    {
+        return;
+    }
 
+    // Accept address, address:port, or [address]:port.
+    //
+    char host[MAX_ADDRESS];
+    unsigned short port = 53;
+    const char *pColon = strrchr(arg, ':');
+    if ('[' == arg[0])
+    {
+        const char *pEnd = strchr(arg, ']');
+        if (  nullptr == pEnd
+           || MAX_ADDRESS <= pEnd - arg)
+        {
+            return;
+        }
+        memcpy(host, arg + 1, pEnd - arg - 1);
+        host[pEnd - arg - 1] = '\0';
+        if (':' == pEnd[1])
+        {
+            port = static_cast<unsigned short>(atoi(pEnd + 2));
+        }
+    }
+    else if (  nullptr != pColon
+            && strchr(arg, ':') == pColon)
+    {
+        if (MAX_ADDRESS <= pColon - arg)
+        {
+            return;
+        }
+        memcpy(host, arg, pColon - arg);
+        host[pColon - arg] = '\0';
+        port = static_cast<unsigned short>(atoi(pColon + 1));
+    }
+    else
+    {
+        strncpy(host, arg, sizeof(host) - 1);
+        host[sizeof(host) - 1] = '\0';
+    }
+
+    name_server *ns = &aServers[nServers];
+    memset(ns, 0, sizeof(name_server));
+    if (1 == inet_pton(AF_INET, host, &ns->u.sin.sin_addr))
+    {
+        ns->u.sin.sin_family = AF_INET;
+        ns->u.sin.sin_port = htons(port);
+        ns->len = sizeof(ns->u.sin);
+        nServers++;
+    }
+#if defined(HAVE_SOCKADDR_IN6)
+    else if (1 == inet_pton(AF_INET6, host, &ns->u.sin6.sin6_addr))
+    {
+        ns->u.sin6.sin6_family = AF_INET6;
+        ns->u.sin6.sin6_port = htons(port);
+        ns->len = sizeof(ns->u.sin6);
+        nServers++;
+    }
+#endif // HAVE_SOCKADDR_IN6
+}
+
+static void read_resolv_conf(void)
+{
+    FILE *fp = fopen("/etc/resolv.conf", "r");
+    if (nullptr != fp)
+    {
+        char line[MAX_STRING];
+        while (nullptr != fgets(line, sizeof(line), fp))
+        {
+            char server[MAX_STRING];
+            if (1 == sscanf(line, "nameserver %999s", server))
+            {
+                add_server(server);
+            }
+        }
+        fclose(fp);
+    }
+
+    if (0 == nServers)
+    {
+        add_server("127.0.0.1");
+    }
+}
+
+// Seed the cache with the names in the hosts file as the system resolver
+// would find them.  The first name for an address wins.
+//
+static void read_hosts(void)
+{
+    FILE *fp = fopen("/etc/hosts", "r");
+    if (nullptr == fp)
+    {
+        return;
+    }
+
+    char line[MAX_STRING];
+    while (nullptr != fgets(line, sizeof(line), fp))
+    {
+        char *pHash = strchr(line, '#');
+        if (nullptr != pHash)
+        {
+            *pHash = '\0';
+        }
+
+        char addr[MAX_STRING], name[MAX_STRING];
+        if (2 != sscanf(line, "%999s %999s", addr, name))
+        {
+            continue;
+        }
+
+        // Store the address in the same form the game writes it.
+        //
+        unsigned char aBytes[16];
+        char canon[MAX_ADDRESS];
+        if (1 == inet_pton(AF_INET, addr, aBytes))
+        {
+            inet_ntop(AF_INET, aBytes, canon, sizeof(canon));
+        }
+#if defined(HAVE_IN6_ADDR)
+        else if (1 == inet_pton(AF_INET6, addr, aBytes))
+        {
+            inet_ntop(AF_INET6, aBytes, canon, sizeof(canon));
+        }
+#endif // HAVE_IN6_ADDR
+        else
+        {
+            continue;
+        }
+
+        if (  strlen(name) < MAX_NAME
+           && nullptr == find_entry(canon))
+        {
+            name_entry *e = add_entry(canon, 0);
+            if (nullptr != e)
+            {
+                strcpy(e->name, name);
+                e->permanent = true;
+            }
+        }
+    }
+    fclose(fp);
+}
+
+int main(int argc, char *argv[])
+{
     parent_pid = getppid();
     if (parent_pid == 1)
     {
@@ -185,71 +846,145 @@ int main(int argc, char *argv[])
         exit(1);
     }
 
-    alarm_signal(SIGALRM);
-    signal(SIGCHLD, CAST_SIGNAL_FUNC child_signal);
+    for (int i = 1; i < argc; i++)
+    {
+        if (  0 == strcmp(argv[i], "-s")
+           && i + 1 < argc)
+        {
+            add_server(argv[++i]);
+        }
+    }
+    if (0 == nServers)
+    {
+        read_resolv_conf();
+    }
+    read_hosts();
+
+    fdRandom = open("/dev/urandom", O_RDONLY);
+    srand(static_cast<unsigned int>(time(nullptr) ^ getpid()));
     signal(SIGPIPE, SIG_DFL);
 
     for (;;)
     {
-        len = read(0, arg, MAX_STRING - 1);
-        if (len == 0)
+        // Exit if the game has gone away.
+        //
+        if (getppid() != parent_pid)
         {
-            break;
+            exit(1);
         }
 
-        if (len < 0)
+        fd_set input_set;
+        FD_ZERO(&input_set);
+        FD_SET(0, &input_set);
+        int maxfd = 0;
+
+        INT64 now = now_msec();
+        INT64 wake = now + 60000;
+        for (int i = 0; i < nQueries; i++)
         {
-            if (errno == EINTR)
+            dns_query *q = &aQueries[i];
+            if (0 <= q->socket)
             {
-                errno = 0;
-                continue;
+                FD_SET(q->socket, &input_set);
+                if (maxfd < q->socket)
+                {
+                    maxfd = q->socket;
+                }
+            }
+            if (q->deadline < wake)
+            {
+                wake = q->deadline;
             }
-            break;
         }
-        arg[len] = '\0';
 
-        child = fork();
-        switch (child)
-        {
-        case -1:
-            exit(1);
-            break;
+        struct timeval timeout;
+        INT64 wait = (now < wake) ? wake - now : 0;
+        timeout.tv_sec  = static_cast<time_t>(wait / 1000);
+        timeout.tv_usec = static_cast<long>((wait % 1000) * 1000);
 
-        case 0: // child.
+        int found = select(maxfd + 1, &input_set, nullptr, nullptr, &timeout);
+        if (found < 0)
+        {
+            if (errno == EINTR)
             {
-                // We don't want to try this for more than 5 minutes.
-                //
-                struct itimerval itime;
-                struct timeval interval;
-
-                interval.tv_sec = 300;  // 5 minutes.
-                interval.tv_usec = 0;
-                itime.it_interval = interval;
-                itime.it_value = interval;
-                signal(SIGALRM, CAST_SIGNAL_FUNC child_timeout_signal);
-                setitimer(ITIMER_REAL, &itime, 0);
+                continue;
             }
-            exit(query(arg) != 0);
             break;
         }
 
-        if (child > 0)
+        // Answers.  Finishing a query moves the last one into its slot, so
+        // the same slot is looked at again.
+        //
+        now = now_msec();
+        for (int i = 0; i < nQueries; )
         {
-            nChildrenStarted++;
+            dns_query *q = &aQueries[i];
+            if (  0 <= q->socket
+               && FD_ISSET(q->socket, &input_set))
+            {
+                FD_CLR(q->socket, &input_set);
+                unsigned char pkt[MAX_PACKET];
+                ssize_t n = recv(q->socket, pkt, sizeof(pkt), 0);
+                if (  0 < n
+                   && parse_answer(q, pkt, static_cast<size_t>(n)))
+                {
+                    continue;
+                }
+                else if (n < 0)
+                {
+                    // Most likely an ICMP port unreachable from a server
+                    // which is not there.
+                    //
+                    retry_query(q);
+                    continue;
+                }
+            }
+            else if (q->deadline <= now)
+            {
+                retry_query(q);
+                continue;
+            }
+            i++;
         }
 
-        int nChildren = nChildrenStarted - nChildrenEndedSIGCHLD
-            - nChildrenEndedMain;
-
-        // Collect the children.
+        // Requests.  Each datagram normally carries one address, but accept
+        // several lines in case the requests arrive over a stream.
         //
-        while (waitpid(0, nullptr, (nChildren < MAX_CHILDREN) ? WNOHANG : 0) > 0)
+        if (FD_ISSET(0, &input_set))
         {
-            if (0 < nChildren)
+            char arg[MAX_STRING];
+            int len = read(0, arg, MAX_STRING - 1);
+            if (len == 0)
+            {
+                break;
+            }
+            else if (len < 0)
+            {
+                if (errno != EINTR)
+                {
+                    break;
+                }
+                errno = 0;
+            }
+            else
             {
-                nChildrenEndedMain++;
+                arg[len] = '\0';
+                char *p = arg;
+                while ('\0' != *p)
+                {
+                    char *pEnd = p + strcspn(p, "\r\n");
+                    char chEnd = *pEnd;
+                    *pEnd = '\0';
+                    if (  '\0' != *p
+                       && strlen(p) < MAX_ADDRESS)
+                    {
+                        request(p);
+                    }
+                    p = ('\0' != chEnd) ? pEnd + 1 : pEnd;
+                }
             }
         }
+        run_queue();
     }
     exit(0);
 }
@@ -732,6 +732,60 @@ const int g_trimoffset[4][4] =
     { 3, 2, 1, 0 }
 };
 
+/*! \brief Convert one UTF8 code point to ASCII.
+ *
+ * \param pCodePoint   UTF8 code point.
+ * \return             Equivalent ASCII character, or '?' if there is none.
+ */
+
+UTF8 ConvertCodePointToAscii(const UTF8 *pCodePoint)
+{
+    const UTF8 *p = pCodePoint;
+    int iState = TR_ASCII_START_STATE;
+    do
+    {
+        unsigned char ch = *p++;
+        unsigned char iColumn = tr_ascii_itt[(unsigned char)ch];
+        unsigned short iOffset = tr_ascii_sot[iState];
+        for (;;)
+        {
+            int y = tr_ascii_sbt[iOffset];
+            if (y < 128)
+            {
+                // RUN phrase.
+                //
+                if (iColumn < y)
+                {
+                    iState = tr_ascii_sbt[iOffset+1];
+                    break;
+                }
+                else
+                {
+                    iColumn = static_cast<unsigned char>(iColumn - y);
+                    iOffset += 2;
+                }
+            }
+            else
+            {
+                // COPY phrase.
+                //
+                y = 256-y;
+                if (iColumn < y)
+                {
+                    iState = tr_ascii_sbt[iOffset+iColumn+1];
+                    break;
+                }
+                else
+                {
+                    iColumn = static_cast<unsigned char>(iColumn - y);
+                    iOffset = static_cast<unsigned short>(iOffset + y + 1);
+                }
+            }
+        }
+    } while (iState < TR_ASCII_ACCEPTING_STATES_START);
+    return (UTF8)(iState - TR_ASCII_ACCEPTING_STATES_START);
+}
+
 /*! \brief Convert UTF8 to ASCII with '?' for all unsupported characters.
  *
  * \param pString   UTF8 string.
@@ -745,54 +799,65 @@ const UTF8 *ConvertToAscii(const UTF8 *pString)
 
     while ('\0' != *pString)
     {
-        const UTF8 *p = pString;
-        int iState = TR_ASCII_START_STATE;
-        do
+        *q++ = ConvertCodePointToAscii(pString);
+        pString = utf8_NextCodePoint(pString);
+    }
+    *q = '\0';
+    return buffer;
+}
+
+/*! \brief Convert one UTF8 code point to cp437.
+ *
+ * \param pCodePoint   UTF8 code point.
+ * \return             Equivalent cp437 character, or '?' if there is none.
+ */
+
+UTF8 ConvertCodePointToCp437(const UTF8 *pCodePoint)
+{
+    const UTF8 *p = pCodePoint;
+    int iState = TR_CP437_START_STATE;
+    do
+    {
+        unsigned char ch = *p++;
+        unsigned char iColumn = tr_cp437_itt[(unsigned char)ch];
+        unsigned short iOffset = tr_cp437_sot[iState];
+        for (;;)
         {
-            unsigned char ch = *p++;
-            unsigned char iColumn = tr_ascii_itt[(unsigned char)ch];
-            unsigned short iOffset = tr_ascii_sot[iState];
-            for (;;)
+            int y = tr_cp437_sbt[iOffset];
+            if (y < 128)
             {
-                int y = tr_ascii_sbt[iOffset];
-                if (y < 128)
+                // RUN phrase.
+                //
+                if (iColumn < y)
                 {
-                    // RUN phrase.
-                    //
-                    if (iColumn < y)
-                    {
-                        iState = tr_ascii_sbt[iOffset+1];
-                        break;
-                    }
-                    else
-                    {
-                        iColumn = static_cast<unsigned char>(iColumn - y);
-                        iOffset += 2;
-                    }
+                    iState = tr_cp437_sbt[iOffset+1];
+                    break;
                 }
                 else
                 {
-                    // COPY phrase.
-                    //
-                    y = 256-y;
-                    if (iColumn < y)
-                    {
-                        iState = tr_ascii_sbt[iOffset+iColumn+1];
-                        break;
-                    }
-                    else
-                    {
-                        iColumn = static_cast<unsigned char>(iColumn - y);
-                        iOffset = static_cast<unsigned short>(iOffset + y + 1);
-                    }
+                    iColumn = static_cast<unsigned char>(iColumn - y);
+                    iOffset += 2;
                 }
             }
-        } while (iState < TR_ASCII_ACCEPTING_STATES_START);
-        *q++ = (char)(iState - TR_ASCII_ACCEPTING_STATES_START);
-        pString = utf8_NextCodePoint(pString);
-    }
-    *q = '\0';
-    return buffer;
+            else
+            {
+                // COPY phrase.
+                //
+                y = 256-y;
+                if (iColumn < y)
+                {
+                    iState = tr_cp437_sbt[iOffset+iColumn+1];
+                    break;
+                }
+                else
+                {
+                    iColumn = static_cast<unsigned char>(iColumn - y);
+                    iOffset = static_cast<unsigned short>(iOffset + y + 1);
+                }
+            }
+        }
+    } while (iState < TR_CP437_ACCEPTING_STATES_START);
+    return (UTF8)(iState - TR_CP437_ACCEPTING_STATES_START);
 }
 
 /*! \brief Convert UTF8 to cp437 with '?' for all unsupported characters.
@@ -809,54 +874,65 @@ const UTF8 *ConvertToCp437(const UTF8 *pString)
     while (  '\0' != *pString
           && q < buffer + sizeof(buffer) - 1)
     {
-        const UTF8 *p = pString;
-        int iState = TR_CP437_START_STATE;
-        do
+        *q++ = ConvertCodePointToCp437(pString);
+        pString = utf8_NextCodePoint(pString);
+    }
+    *q = '\0';
+    return buffer;
+}
+
+/*! \brief Convert one UTF8 code point to latin1.
+ *
+ * \param pCodePoint   UTF8 code point.
+ * \return             Equivalent latin1 character, or '?' if there is none.
+ */
+
+UTF8 ConvertCodePointToLatin1(const UTF8 *pCodePoint)
+{
+    const UTF8 *p = pCodePoint;
+    int iState = TR_LATIN1_START_STATE;
+    do
+    {
+        unsigned char ch = *p++;
+        unsigned char iColumn = tr_latin1_itt[(unsigned char)ch];
+        unsigned short iOffset = tr_latin1_sot[iState];
+        for (;;)
         {
-            UTF8 ch = *p++;
-            unsigned char iColumn = tr_cp437_itt[(unsigned char)ch];
-            unsigned short iOffset = tr_cp437_sot[iState];
-            for (;;)
+            int y = tr_latin1_sbt[iOffset];
+            if (y < 128)
             {
-                int y = tr_cp437_sbt[iOffset];
-                if (y < 128)
+                // RUN phrase.
+                //
+                if (iColumn < y)
                 {
-                    // RUN phrase.
-                    //
-                    if (iColumn < y)
-                    {
-                        iState = tr_cp437_sbt[iOffset+1];
-                        break;
-                    }
-                    else
-                    {
-                        iColumn = static_cast<unsigned char>(iColumn - y);
-                        iOffset += 2;
-                    }
+                    iState = tr_latin1_sbt[iOffset+1];
+                    break;
                 }
                 else
                 {
-                    // COPY phrase.
-                    //
-                    y = 256-y;
-                    if (iColumn < y)
-                    {
-                        iState = tr_cp437_sbt[iOffset+iColumn+1];
-                        break;
-                    }
-                    else
-                    {
-                        iColumn = static_cast<unsigned char>(iColumn - y);
-                        iOffset = static_cast<unsigned short>(iOffset + y + 1);
-                    }
+                    iColumn = static_cast<unsigned char>(iColumn - y);
+                    iOffset += 2;
                 }
             }
-        } while (iState < TR_CP437_ACCEPTING_STATES_START);
-        *q++ = (char)(iState - TR_CP437_ACCEPTING_STATES_START);
-        pString = utf8_NextCodePoint(pString);
-    }
-    *q = '\0';
-    return buffer;
+            else
+            {
+                // COPY phrase.
+                //
+                y = 256-y;
+                if (iColumn < y)
+                {
+                    iState = tr_latin1_sbt[iOffset+iColumn+1];
+                    break;
+                }
+                else
+                {
+                    iColumn = static_cast<unsigned char>(iColumn - y);
+                    iOffset = static_cast<unsigned short>(iOffset + y + 1);
+                }
+            }
+        }
+    } while (iState < TR_LATIN1_ACCEPTING_STATES_START);
+    return (UTF8)(iState - TR_LATIN1_ACCEPTING_STATES_START);
 }
 
 /*! \brief Convert UTF8 to latin1 with '?' for all unsupported characters.
@@ -873,54 +949,65 @@ const UTF8 *ConvertToLatin1(const UTF8 *pString)
     while (  '\0' != *pString
           && q < buffer + sizeof(buffer) - 1)
     {
-        const UTF8 *p = pString;
-        int iState = TR_LATIN1_START_STATE;
-        do
+        *q++ = ConvertCodePointToLatin1(pString);
+        pString = utf8_NextCodePoint(pString);
+    }
+    *q = '\0';
+    return buffer;
+}
+
+/*! \brief Convert one UTF8 code point to latin2.
+ *
+ * \param pCodePoint   UTF8 code point.
+ * \return             Equivalent latin2 character, or '?' if there is none.
+ */
+
+UTF8 ConvertCodePointToLatin2(const UTF8 *pCodePoint)
+{
+    const UTF8 *p = pCodePoint;
+    int iState = TR_LATIN2_START_STATE;
+    do
+    {
+        unsigned char ch = *p++;
+        unsigned char iColumn = tr_latin2_itt[(unsigned char)ch];
+        unsigned short iOffset = tr_latin2_sot[iState];
+        for (;;)
         {
-            UTF8 ch = *p++;
-            unsigned char iColumn = tr_latin1_itt[(unsigned char)ch];
-            unsigned short iOffset = tr_latin1_sot[iState];
-            for (;;)
+            int y = tr_latin2_sbt[iOffset];
+            if (y < 128)
             {
-                int y = tr_latin1_sbt[iOffset];
-                if (y < 128)
+                // RUN phrase.
+                //
+                if (iColumn < y)
                 {
-                    // RUN phrase.
-                    //
-                    if (iColumn < y)
-                    {
-                        iState = tr_latin1_sbt[iOffset+1];
-                        break;
-                    }
-                    else
-                    {
-                        iColumn = static_cast<unsigned char>(iColumn - y);
-                        iOffset += 2;
-                    }
+                    iState = tr_latin2_sbt[iOffset+1];
+                    break;
                 }
                 else
                 {
-                    // COPY phrase.
-                    //
-                    y = 256-y;
-                    if (iColumn < y)
-                    {
-                        iState = tr_latin1_sbt[iOffset+iColumn+1];
-                        break;
-                    }
-                    else
-                    {
-                        iColumn = static_cast<unsigned char>(iColumn - y);
-                        iOffset = static_cast<unsigned short>(iOffset + y + 1);
-                    }
+                    iColumn = static_cast<unsigned char>(iColumn - y);
+                    iOffset += 2;
                 }
             }
-        } while (iState < TR_LATIN1_ACCEPTING_STATES_START);
-        *q++ = (char)(iState - TR_LATIN1_ACCEPTING_STATES_START);
-        pString = utf8_NextCodePoint(pString);
-    }
-    *q = '\0';
-    return buffer;
+            else
+            {
+                // COPY phrase.
+                //
+                y = 256-y;
+                if (iColumn < y)
+                {
+                    iState = tr_latin2_sbt[iOffset+iColumn+1];
+                    break;
+                }
+                else
+                {
+                    iColumn = static_cast<unsigned char>(iColumn - y);
+                    iOffset = static_cast<unsigned short>(iOffset + y + 1);
+                }
+            }
+        }
+    } while (iState < TR_LATIN2_ACCEPTING_STATES_START);
+    return (UTF8)(iState - TR_LATIN2_ACCEPTING_STATES_START);
 }
 
 /*! \brief Convert UTF8 to latin2 with '?' for all unsupported characters.
@@ -937,50 +1024,7 @@ const UTF8 *ConvertToLatin2(const UTF8 *pString)
     while (  '\0' != *pString
           && q < buffer + sizeof(buffer) - 1)
     {
-        const UTF8 *p = pString;
-        int iState = TR_LATIN2_START_STATE;
-        do
-        {
-            UTF8 ch = *p++;
-            unsigned char iColumn = tr_latin2_itt[(unsigned char)ch];
-            unsigned short iOffset = tr_latin2_sot[iState];
-            for (;;)
-            {
-                int y = tr_latin2_sbt[iOffset];
-                if (y < 128)
-                {
-                    // RUN phrase.
-                    //
-                    if (iColumn < y)
-                    {
-                        iState = tr_latin2_sbt[iOffset+1];
-                        break;
-                    }
-                    else
-                    {
-                        iColumn = static_cast<unsigned char>(iColumn - y);
-                        iOffset += 2;
-                    }
-                }
-                else
-                {
-                    // COPY phrase.
-                    //
-                    y = 256-y;
-                    if (iColumn < y)
-                    {
-                        iState = tr_latin2_sbt[iOffset+iColumn+1];
-                        break;
-                    }
-                    else
-                    {
-                        iColumn = static_cast<unsigned char>(iColumn - y);
-                        iOffset = static_cast<unsigned short>(iOffset + y + 1);
-                    }
-                }
-            }
-        } while (iState < TR_LATIN2_ACCEPTING_STATES_START);
-        *q++ = (char)(iState - TR_LATIN2_ACCEPTING_STATES_START);
+        *q++ = ConvertCodePointToLatin2(pString);
         pString = utf8_NextCodePoint(pString);
     }
     *q = '\0';
@@ -7813,6 +7857,44 @@ bool mux_string::compare_Char(const mux_cursor &i, const mux_string &sStr) const
            && 0 == memcmp(m_autf + i.m_byte, sStr.m_autf, sStr.m_iLast.m_byte));
 }
 
+/*! \brief Compares text and color with another string.
+ *
+ * \param sStr  String to compare against.
+ * \return      true if both strings have the same code points and colors.
+ */
+
+bool mux_string::equal(const mux_string &sStr) const
+{
+    if (  !(m_iLast == sStr.m_iLast)
+       || 0 != memcmp(m_autf, sStr.m_autf, m_iLast.m_byte))
+    {
+        return false;
+    }
+
+    if (  0 != m_ncs
+       && 0 != sStr.m_ncs)
+    {
+        return (0 == memcmp(m_pcs, sStr.m_pcs, m_iLast.m_point * sizeof(m_pcs[0])));
+    }
+
+    // At most one of the strings carries color, so the other is CS_NORMAL
+    // throughout.
+    //
+    const ColorState *pcs = (0 != m_ncs) ? m_pcs : sStr.m_pcs;
+    if (  0 != m_ncs
+       || 0 != sStr.m_ncs)
+    {
+        for (size_t i = 0; i < m_iLast.m_point; i++)
+        {
+            if (CS_NORMAL != pcs[i])
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
 /*! \brief Removes a specified set of characters from string.
  *
  * \param pStripSet Pointer to string of characters to remove.
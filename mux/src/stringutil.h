@@ -651,18 +651,22 @@ inline bool mux_iskatakana(__in const unsigned char *p)
 
 // utf/tr_utf8_ascii.txt
 //
+UTF8 ConvertCodePointToAscii(__in const UTF8 *pCodePoint);
 const UTF8 *ConvertToAscii(__in const UTF8 *pString);
 
 // utf/tr_utf8_cp437.txt
 //
+UTF8 ConvertCodePointToCp437(__in const UTF8 *pCodePoint);
 const UTF8 *ConvertToCp437(__in const UTF8 *pString);
 
 // utf/tr_utf8_latin1.txt
 //
+UTF8 ConvertCodePointToLatin1(__in const UTF8 *pCodePoint);
 const UTF8 *ConvertToLatin1(__in const UTF8 *pString);
 
 // utf/tr_utf8_latin2.txt
 //
+UTF8 ConvertCodePointToLatin2(__in const UTF8 *pCodePoint);
 const UTF8 *ConvertToLatin2(__in const UTF8 *pString);
 
 // utf/tr_widths.txt
@@ -2023,6 +2027,7 @@ public:
     void set_Char(size_t n, const UTF8 cChar); // Deprecated.
     void set_Color(size_t n, ColorState csColor);
     bool compare_Char(const mux_cursor &i, const mux_string &sStr) const;
+    bool equal(const mux_string &sStr) const;
     void strip
     (
         const UTF8 *pStripSet,
@@ -410,7 +410,8 @@ bool CHashPage::Allocate(unsigned int nPageSize)
     if (m_nPageSize) return false;
 
     m_nPageSize = nPageSize;
-    m_pPage = new unsigned char[nPageSize];
+    m_pBuffer = new unsigned char[nPageSize];
+    m_pPage = m_pBuffer;
     if (m_pPage)
     {
         return true;
@@ -422,15 +423,17 @@ CHashPage::CHashPage(void)
 {
     m_nPageSize = 0;
     m_pPage = 0;
+    m_pBuffer = 0;
 }
 
 CHashPage::~CHashPage(void)
 {
-    if (m_pPage)
+    if (m_pBuffer)
     {
-        delete [] m_pPage;
-        m_pPage = 0;
+        delete [] m_pBuffer;
+        m_pBuffer = 0;
     }
+    m_pPage = 0;
 }
 
 // GetStats
@@ -1236,6 +1239,54 @@ bool CHashPage::ReadPage(HANDLE hFile, HF_FILEOFFSET oWhere)
 }
 #endif // UNIX_FILES
 
+#if defined(UNIX_FILES_MMAP)
+// MapPage
+//
+// Point this page at a page-sized view of a mapped page file instead of at
+// its own buffer.  Records are then read in place, and the OS page cache
+// does the caching.
+//
+void CHashPage::MapPage(unsigned char *pMapped)
+{
+    m_pPage = pMapped;
+    SetFixedPointers();
+    SetVariablePointers();
+}
+
+// UnmapPage
+//
+// Return to the page's own buffer. Before a mapped page is modified, it is
+// copied into its buffer so that the mapping only ever sees whole,
+// checksummed pages written back by WriteMappedPage.
+//
+void CHashPage::UnmapPage(bool bKeepContents)
+{
+    if (m_pPage != m_pBuffer)
+    {
+        if (bKeepContents)
+        {
+            memcpy(m_pBuffer, m_pPage, m_nPageSize);
+        }
+        m_pPage = m_pBuffer;
+        SetFixedPointers();
+        if (bKeepContents)
+        {
+            SetVariablePointers();
+        }
+    }
+}
+
+bool CHashPage::WriteMappedPage(unsigned char *pMapped)
+{
+    cs_dbwrites++;
+    if (m_pPage != pMapped)
+    {
+        memcpy(pMapped, m_pPage, m_nPageSize);
+    }
+    return true;
+}
+#endif // UNIX_FILES_MMAP
+
 #endif // MEMORY_BASED
 
 UINT32 CHashPage::GetDepth(void)
@@ -1281,8 +1332,10 @@ bool CHashPage::Defrag(HP_HEAPLENGTH nExtra)
         // Swap buffers.
         //
         unsigned char *tmp;
-        tmp = hpNew->m_pPage;
-        hpNew->m_pPage = m_pPage;
+        tmp = hpNew->m_pBuffer;
+        hpNew->m_pBuffer = m_pBuffer;
+        hpNew->m_pPage = m_pBuffer;
+        m_pBuffer = tmp;
         m_pPage = tmp;
 
         SetFixedPointers();
@@ -1341,6 +1394,9 @@ CHashFile::CHashFile(void)
     SeedRandomNumberGenerator();
     m_Cache = nullptr;
     m_nCache = 0;
+#if defined(UNIX_FILES_MMAP)
+    m_bMapped = false;
+#endif // UNIX_FILES_MMAP
     Init();
 }
 
@@ -1359,8 +1415,102 @@ void CHashFile::Init(void)
     m_hpCacheLookup = nullptr;
     iCache = 0;
     m_iLastFlushed = 0;
+#if defined(UNIX_FILES_MMAP)
+    m_pMap = nullptr;
+    m_nMap = 0;
+    m_oFileSize = 0;
+    m_oDirtyLow = 0;
+    m_oDirtyHigh = 0;
+#endif // UNIX_FILES_MMAP
 }
 
+#if defined(UNIX_FILES_MMAP)
+// MapFile
+//
+// Make sure the page file is at least oEnd bytes long and that the mapping
+// covers it.  Address space is reserved for twice what is needed, so the
+// mapping only moves occasionally as the file grows.  Only the part of the
+// mapping inside the file is ever touched.
+//
+bool CHashFile::MapFile(HF_FILEOFFSET oEnd)
+{
+    if (m_oFileSize < oEnd)
+    {
+        if (0 != ftruncate(m_hPageFile, oEnd))
+        {
+            Log.tinyprintf(T("CHashFile::MapFile - ftruncate error %u." ENDLINE), errno);
+            return false;
+        }
+        m_oFileSize = oEnd;
+    }
+
+    if (oEnd <= m_nMap)
+    {
+        return true;
+    }
+
+    size_t nMap = 2*static_cast<size_t>(oEnd);
+    if (nMap < 64*HF_SIZEOF_PAGE)
+    {
+        nMap = 64*HF_SIZEOF_PAGE;
+    }
+    size_t nSysPage = static_cast<size_t>(getpagesize());
+    nMap = ((nMap + nSysPage - 1)/nSysPage)*nSysPage;
+
+    void *pMap = mmap(nullptr, nMap, PROT_READ|PROT_WRITE, MAP_SHARED,
+        m_hPageFile, 0);
+    if (MAP_FAILED == pMap)
+    {
+        Log.tinyprintf(T("CHashFile::MapFile - mmap error %u." ENDLINE), errno);
+        return false;
+    }
+
+    // Cached pages which are viewing the old mapping must follow it.
+    //
+    for (int i = 0; i < m_nCache; i++)
+    {
+        if (m_Cache[i].m_hp.IsMapped())
+        {
+            if (HF_CACHE_EMPTY == m_Cache[i].m_iState)
+            {
+                m_Cache[i].m_hp.UnmapPage(false);
+            }
+            else
+            {
+                m_Cache[i].m_hp.MapPage(static_cast<unsigned char *>(pMap) + m_Cache[i].m_o);
+            }
+        }
+    }
+
+    if (nullptr != m_pMap)
+    {
+        munmap(m_pMap, m_nMap);
+    }
+    m_pMap = static_cast<unsigned char *>(pMap);
+    m_nMap = nMap;
+    return true;
+}
+
+void CHashFile::UnmapFile(void)
+{
+    for (int i = 0; i < m_nCache; i++)
+    {
+        if (m_Cache[i].m_hp.IsMapped())
+        {
+            m_Cache[i].m_hp.UnmapPage(false);
+            m_Cache[i].m_iState = HF_CACHE_EMPTY;
+        }
+    }
+
+    if (nullptr != m_pMap)
+    {
+        munmap(m_pMap, m_nMap);
+        m_pMap = nullptr;
+        m_nMap = 0;
+    }
+}
+#endif // UNIX_FILES_MMAP
+
 #if defined(WINDOWS_FILES)
 void CHashFile::WriteDirectory(void)
 {
@@ -1669,11 +1819,16 @@ void CHashFile::InitCache(int nCachePages)
     m_iOldest = 0;
 }
 
-int CHashFile::Open(const UTF8 *szDirFile, const UTF8 *szPageFile, int nCachePages)
+int CHashFile::Open(const UTF8 *szDirFile, const UTF8 *szPageFile, int nCachePages, bool bMapped)
 {
     CloseAll();
     FinalCache();
     InitCache(nCachePages);
+#if defined(UNIX_FILES_MMAP)
+    m_bMapped = bMapped;
+#else
+    UNUSED_PARAMETER(bMapped);
+#endif // UNIX_FILES_MMAP
 
     // First let's try to open the page file. This is the more important file.
     //
@@ -1741,6 +1896,16 @@ int CHashFile::Open(const UTF8 *szDirFile, const UTF8 *szPageFile, int nCachePag
         return HF_OPEN_STATUS_ERROR;
     }
 
+#if defined(UNIX_FILES_MMAP)
+    m_oFileSize = oEndOfFile;
+    if (  m_bMapped
+       && !MapFile(oEndOfFile))
+    {
+        Log.WriteString(T("CHashFile::Open - Could not map the page file. Using read and write instead." ENDLINE));
+        m_bMapped = false;
+    }
+#endif // UNIX_FILES_MMAP
+
     // Now that the page file appears valid so far, let's see if the directory
     // file is there. This file is not strictly necessary, we can rebuild it.
     // However, having it helps us to open faster.
@@ -1798,6 +1963,24 @@ int CHashFile::Open(const UTF8 *szDirFile, const UTF8 *szPageFile, int nCachePag
 }
 
 void CHashFile::Sync(void)
+{
+    bool bWait = false;
+#ifdef DO_COMMIT
+    bWait = !mudstate.bStandAlone;
+#endif // DO_COMMIT
+    Flush(bWait);
+    if (bWait)
+    {
+        Commit();
+    }
+}
+
+// Flush
+//
+// Hands every dirty page to the OS.  With bWait, a mapped page file is also
+// waited on, but Commit() is still needed for the page and directory files.
+//
+void CHashFile::Flush(bool bWait)
 {
 #if defined(WINDOWS_FILES)
     if (INVALID_HANDLE_VALUE != m_hPageFile)
@@ -1819,32 +2002,55 @@ void CHashFile::Sync(void)
             Log.WriteString(T("CHashFile::Sync. Could not flush all the pages. DB DAMAGE." ENDLINE));
         }
 
-#ifdef DO_COMMIT
-        if (!mudstate.bStandAlone)
+#if defined(UNIX_FILES_MMAP)
+        // Only the range of the mapping written since the last Sync() needs
+        // to be pushed out.
+        //
+        if (  m_bMapped
+           && m_oDirtyLow < m_oDirtyHigh)
         {
-#if defined(WINDOWS_FILES)
-            FlushFileBuffers(m_hPageFile);
-#elif defined(UNIX_FILES)
-            fsync(m_hPageFile);
-#endif // UNIX_FILES
+            HF_FILEOFFSET oLow = m_oDirtyLow - (m_oDirtyLow % getpagesize());
+            if (0 != msync(m_pMap + oLow, m_oDirtyHigh - oLow, bWait ? MS_SYNC : MS_ASYNC))
+            {
+                Log.tinyprintf(T("CHashFile::Sync - msync error %u." ENDLINE), errno);
+            }
+            m_oDirtyLow = m_oDirtyHigh = 0;
         }
-#endif // DO_COMMIT
+#endif // UNIX_FILES_MMAP
     }
-#ifdef DO_COMMIT
+#if !defined(UNIX_FILES_MMAP)
+    UNUSED_PARAMETER(bWait);
+#endif // !UNIX_FILES_MMAP
+}
+
+// Commit
+//
+// Waits for everything Flush() handed to the OS to reach the disk.  It only
+// uses the file handles, so the write-ahead log's writer thread calls it
+// while the game goes on changing pages.  The pages it catches are covered
+// by the log until the next checkpoint.
+//
+void CHashFile::Commit(void)
+{
 #if defined(WINDOWS_FILES)
-    if (  INVALID_HANDLE_VALUE != m_hDirFile
-#elif defined(UNIX_FILES)
-    if (  MUX_OPEN_INVALID_HANDLE_VALUE != m_hDirFile
-#endif // UNIX_FILES
-       && !mudstate.bStandAlone)
+    if (INVALID_HANDLE_VALUE != m_hPageFile)
+    {
+        FlushFileBuffers(m_hPageFile);
+    }
+    if (INVALID_HANDLE_VALUE != m_hDirFile)
     {
-#if defined(WINDOWS_FILES)
         FlushFileBuffers(m_hDirFile);
+    }
 #elif defined(UNIX_FILES)
+    if (MUX_OPEN_INVALID_HANDLE_VALUE != m_hPageFile)
+    {
+        fsync(m_hPageFile);
+    }
+    if (MUX_OPEN_INVALID_HANDLE_VALUE != m_hDirFile)
+    {
         fsync(m_hDirFile);
-#endif // UNIX_FILES
     }
-#endif // DO_COMMIT
+#endif // UNIX_FILES
 }
 
 void CHashFile::CloseAll(void)
@@ -1866,6 +2072,9 @@ void CHashFile::CloseAll(void)
             delete [] m_hpCacheLookup;
             m_hpCacheLookup = nullptr;
         }
+#if defined(UNIX_FILES_MMAP)
+        UnmapFile();
+#endif // UNIX_FILES_MMAP
 
 #if defined(WINDOWS_FILES)
         CloseHandle(m_hPageFile);
@@ -1931,6 +2140,9 @@ bool CHashFile::Insert(HP_HEAPLENGTH nRecord, UINT32 nHash, void *pRecord)
                 iFileDir, nStart, nEnd);
             return false;
         }
+#if defined(UNIX_FILES_MMAP)
+        m_Cache[iCache].m_hp.UnmapPage(true);
+#endif // UNIX_FILES_MMAP
         int errInserted = m_Cache[iCache].m_hp.Insert(nRecord, nHash, pRecord);
         if (IS_HP_SUCCESS(errInserted))
         {
@@ -2213,6 +2425,9 @@ void CHashFile::Copy(UINT32 iDir, HP_PHEAPLENGTH pnRecord, void *pRecord)
 void CHashFile::Remove(UINT32 iDir)
 {
     cs_dels++;
+#if defined(UNIX_FILES_MMAP)
+    m_Cache[iCache].m_hp.UnmapPage(true);
+#endif // UNIX_FILES_MMAP
     m_Cache[iCache].m_hp.HeapFree(iDir);
     m_Cache[iCache].m_iState = HF_CACHE_UNPROTECTED;
 }
@@ -2227,6 +2442,35 @@ bool CHashFile::FlushCache(int iCache)
 #endif // HP_PROTECTION
 
     case HF_CACHE_UNWRITTEN:
+#if defined(UNIX_FILES_MMAP)
+        if (m_bMapped)
+        {
+            HF_FILEOFFSET oPage = m_Cache[iCache].m_o;
+            if (  MapFile(oPage + HF_SIZEOF_PAGE)
+               && m_Cache[iCache].m_hp.WriteMappedPage(m_pMap + oPage))
+            {
+                if (m_oDirtyHigh <= m_oDirtyLow)
+                {
+                    m_oDirtyLow = oPage;
+                    m_oDirtyHigh = oPage + HF_SIZEOF_PAGE;
+                }
+                else if (oPage < m_oDirtyLow)
+                {
+                    m_oDirtyLow = oPage;
+                }
+                else if (m_oDirtyHigh < oPage + HF_SIZEOF_PAGE)
+                {
+                    m_oDirtyHigh = oPage + HF_SIZEOF_PAGE;
+                }
+                m_Cache[iCache].m_iState = HF_CACHE_CLEAN;
+            }
+            else
+            {
+                return false;
+            }
+            break;
+        }
+#endif // UNIX_FILES_MMAP
         if (m_Cache[iCache].m_hp.WritePage(m_hPageFile, m_Cache[iCache].m_o))
         {
             m_Cache[iCache].m_iState = HF_CACHE_CLEAN;
@@ -2271,6 +2515,9 @@ int CHashFile::AllocateEmptyPage(int nSafe, int Safe[])
                 }
                 m_Cache[i].m_iState = HF_CACHE_EMPTY;
             }
+#if defined(UNIX_FILES_MMAP)
+            m_Cache[i].m_hp.UnmapPage(false);
+#endif // UNIX_FILES_MMAP
             return i;
         }
     }
@@ -2358,7 +2605,23 @@ int CHashFile::ReadCache(UINT32 iFileDir, int *phits)
 
     if ((iCache = AllocateEmptyPage(0, nullptr)) >= 0)
     {
-        if (m_Cache[iCache].m_hp.ReadPage(m_hPageFile, oPage))
+        bool bRead;
+#if defined(UNIX_FILES_MMAP)
+        if (  m_bMapped
+           && oPage + HF_SIZEOF_PAGE <= m_oFileSize)
+        {
+            // View the page in place. The OS does the caching.
+            //
+            cs_dbreads++;
+            m_Cache[iCache].m_hp.MapPage(m_pMap + oPage);
+            bRead = true;
+        }
+        else
+#endif // UNIX_FILES_MMAP
+        {
+            bRead = m_Cache[iCache].m_hp.ReadPage(m_hPageFile, oPage);
+        }
+        if (bRead)
         {
             //if (m_Cache[i].m_hp.Validate())
             //{
@@ -120,6 +120,7 @@ class CHashPage
 {
 private:
     unsigned char  *m_pPage;
+    unsigned char  *m_pBuffer;
     unsigned int    m_nPageSize;
     HP_PHEADER      m_pHeader;
     HP_PHEAPOFFSET  m_pDirectory;
@@ -168,6 +169,12 @@ public:
 #if !defined(MEMORY_BASED)
     bool WritePage(HANDLE hFile, HF_FILEOFFSET oWhere);
     bool ReadPage(HANDLE hFile, HF_FILEOFFSET oWhere);
+#if defined(UNIX_FILES_MMAP)
+    void MapPage(unsigned char *pMapped);
+    void UnmapPage(bool bKeepContents);
+    bool IsMapped(void) { return m_pPage != m_pBuffer; }
+    bool WriteMappedPage(unsigned char *pMapped);
+#endif // UNIX_FILES_MMAP
 #endif // MEMORY_BASED
 
     UINT32 GetDepth(void);
@@ -212,6 +219,17 @@ private:
     HF_CACHE        *m_Cache;
     int             m_nCache;
     HF_PFILEOFFSET  m_pDir;
+#if defined(UNIX_FILES_MMAP)
+    bool            m_bMapped;
+    unsigned char  *m_pMap;
+    size_t          m_nMap;
+    HF_FILEOFFSET   m_oFileSize;
+    HF_FILEOFFSET   m_oDirtyLow;
+    HF_FILEOFFSET   m_oDirtyHigh;
+
+    bool MapFile(HF_FILEOFFSET oEnd);
+    void UnmapFile(void);
+#endif // UNIX_FILES_MMAP
     bool DoubleDirectory(void);
 
     int AllocateEmptyPage(int nSafe, int Safe[]);
@@ -234,7 +252,7 @@ public:
 #define HF_OPEN_STATUS_ERROR -1
 #define HF_OPEN_STATUS_NEW    0
 #define HF_OPEN_STATUS_OLD    1
-    int Open(const UTF8 *szDirFile, const UTF8 *szPageFile, int nCachePages);
+    int Open(const UTF8 *szDirFile, const UTF8 *szPageFile, int nCachePages, bool bMapped);
     bool Insert(HP_HEAPLENGTH nRecord, UINT32 nHash, void *pRecord);
     UINT32 FindFirstKey(UINT32 nHash);
     UINT32 FindNextKey(UINT32 iDir, UINT32 nHash);
@@ -242,6 +260,8 @@ public:
     void Remove(UINT32 iDir);
     void CloseAll(void);
     void Sync(void);
+    void Flush(bool bWait);
+    void Commit(void);
     void Tick(void);
     ~CHashFile(void);
 };
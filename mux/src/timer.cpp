@@ -70,6 +70,11 @@ void dispatch_DatabaseDump(void *pUnused, int iUnused)
         }
         else
 #endif // HAVE_WORKING_FORK
+        if (mudstate.snapshot)
+        {
+            nNextTimeInSeconds = 20;
+        }
+        else
         {
             fork_and_dump(0);
         }
@@ -86,6 +91,28 @@ void dispatch_DatabaseDump(void *pUnused, int iUnused)
     scheduler.DeferTask(mudstate.dump_counter, PRIORITY_SYSTEM, dispatch_DatabaseDump, 0, 0);
 }
 
+// Incremental Checkpoint Task routine.
+//
+void dispatch_DatabaseSnapshot(void *pUnused, int iUnused)
+{
+    UNUSED_PARAMETER(pUnused);
+    UNUSED_PARAMETER(iUnused);
+
+    const UTF8 *cmdsave = mudstate.debug_cmd;
+    mudstate.debug_cmd = T("< snapshot >");
+    if (!dump_snapshot_continue())
+    {
+        // Schedule the next slice in the future rather than immediately, so
+        // that the network and other tasks run in between.
+        //
+        CLinearTimeAbsolute ltaNextTime;
+        ltaNextTime.GetUTC();
+        ltaNextTime += time_5ms;
+        scheduler.DeferTask(ltaNextTime, PRIORITY_SYSTEM, dispatch_DatabaseSnapshot, 0, 0);
+    }
+    mudstate.debug_cmd = cmdsave;
+}
+
 // Idle Check Task routine.
 //
 void dispatch_IdleCheck(void *pUnused, int iUnused)
@@ -101,6 +128,12 @@ void dispatch_IdleCheck(void *pUnused, int iUnused)
         mudstate.debug_cmd = cmdsave;
     }
 
+    // Give back output blocks and input chunks the network has not needed
+    // since last time.
+    //
+    trim_tblocks();
+    trim_ichunks();
+
     // Schedule ourselves again.
     //
     CLinearTimeAbsolute ltaNow;
@@ -189,6 +222,31 @@ void dispatch_CacheTick(void *pUnused, int iUnused)
     scheduler.DeferTask(ltaNextTime, PRIORITY_SYSTEM, dispatch_CacheTick, 0, 0);
     mudstate.debug_cmd = cmdsave;
 }
+
+void dispatch_WalCommit(void *pUnused, int iUnused)
+{
+    UNUSED_PARAMETER(pUnused);
+    UNUSED_PARAMETER(iUnused);
+
+    const UTF8 *cmdsave = mudstate.debug_cmd;
+    mudstate.debug_cmd = T("< walcommit >");
+
+    CLinearTimeDelta ltd = 0;
+    if (mudconf.wal_commit_period <= ltd)
+    {
+        mudconf.wal_commit_period.SetMilliseconds(100);
+    }
+
+    cache_wal_commit();
+
+    // Schedule ourselves again.
+    //
+    CLinearTimeAbsolute ltaNextTime;
+    ltaNextTime.GetUTC();
+    ltaNextTime += mudconf.wal_commit_period;
+    scheduler.DeferTask(ltaNextTime, PRIORITY_SYSTEM, dispatch_WalCommit, 0, 0);
+    mudstate.debug_cmd = cmdsave;
+}
 #endif // !MEMORY_BASED
 
 #if 0
@@ -221,6 +279,10 @@ void init_timer(void)
     CLinearTimeAbsolute ltaNow;
     ltaNow.GetUTC();
 
+    // Queue entries are given their fair-share tags as they become ready.
+    //
+    scheduler.SetReadyHook(que_ready);
+
     // Setup re-occuring Free List Reconstruction task.
     //
     CLinearTimeDelta ltd;
@@ -265,6 +327,18 @@ void init_timer(void)
     }
     scheduler.DeferTask(ltaNow+mudconf.cache_tick_period, PRIORITY_SYSTEM,
         dispatch_CacheTick, 0, 0);
+
+    // Setup re-occuring write-ahead log group commit task.
+    //
+    if (mudconf.write_ahead_log)
+    {
+        if (mudconf.wal_commit_period <= ltd)
+        {
+            mudconf.wal_commit_period.SetMilliseconds(100);
+        }
+        scheduler.DeferTask(ltaNow+mudconf.wal_commit_period, PRIORITY_SYSTEM,
+            dispatch_WalCommit, 0, 0);
+    }
 #endif // !MEMORY_BASED
 
 #if 0
@@ -373,6 +447,7 @@ bool CTaskHeap::Insert(PTASK_RECORD pTask, SCHCMP *pfCompare)
     pTask->m_iVisitedMark = m_iVisitedMark-1;
 
     m_pHeap[m_nCurrent] = pTask;
+    pTask->m_iHeapIndex = m_nCurrent;
     m_nCurrent++;
     SiftUp(m_nCurrent-1, pfCompare);
     return true;
@@ -467,11 +542,53 @@ void CTaskHeap::CancelTask(FTASK *fpTask, void *arg_voidptr, int arg_Integer)
     }
 }
 
+// The position kept in each record lets a caller that holds on to a task
+// find it again without searching the heap.
+//
+bool CTaskHeap::Contains(PTASK_RECORD pTask)
+{
+    int i = pTask->m_iHeapIndex;
+    return (  0 <= i
+           && i < m_nCurrent
+           && m_pHeap[i] == pTask);
+}
+
+bool CTaskHeap::RemoveTask(PTASK_RECORD pTask, SCHCMP *pfCompare)
+{
+    if (!Contains(pTask))
+    {
+        return false;
+    }
+    Remove(pTask->m_iHeapIndex, pfCompare);
+    return true;
+}
+
+bool CTaskHeap::UpdateTask(PTASK_RECORD pTask, SCHCMP *pfCompare)
+{
+    if (!Contains(pTask))
+    {
+        return false;
+    }
+    Update(pTask->m_iHeapIndex, pfCompare);
+    return true;
+}
+
 static int ComparePriority(PTASK_RECORD pTaskA, PTASK_RECORD pTaskB)
 {
     int i = (pTaskA->iPriority) - (pTaskB->iPriority);
     if (i == 0)
     {
+        // Within a priority, the ready hook's share tags come first.
+        //
+        if (pTaskA->m_iShare < pTaskB->m_iShare)
+        {
+            return -1;
+        }
+        else if (pTaskA->m_iShare > pTaskB->m_iShare)
+        {
+            return 1;
+        }
+
         // Must subtract so that ticket rollover is handled properly.
         //
         return  (pTaskA->m_Ticket) - (pTaskB->m_Ticket);
@@ -479,6 +596,11 @@ static int ComparePriority(PTASK_RECORD pTaskA, PTASK_RECORD pTaskB)
     return i;
 }
 
+static int CompareTicket(PTASK_RECORD pTaskA, PTASK_RECORD pTaskB)
+{
+    return  (pTaskA->m_Ticket) - (pTaskB->m_Ticket);
+}
+
 static int CompareWhen(PTASK_RECORD pTaskA, PTASK_RECORD pTaskB)
 {
     // Can't simply subtract because comparing involves a truncation cast.
@@ -499,11 +621,11 @@ static int CompareWhen(PTASK_RECORD pTaskA, PTASK_RECORD pTaskB)
     }
 }
 
-void CScheduler::DeferTask(const CLinearTimeAbsolute& ltaWhen, int iPriority,
+PTASK_RECORD CScheduler::DeferTask(const CLinearTimeAbsolute& ltaWhen, int iPriority,
                            FTASK *fpTask, void *arg_voidptr, int arg_Integer)
 {
     PTASK_RECORD pTask = new TASK_RECORD;
-    if (!pTask) return;
+    if (!pTask) return nullptr;
 
     pTask->ltaWhen = ltaWhen;
     pTask->iPriority = iPriority;
@@ -511,19 +633,26 @@ void CScheduler::DeferTask(const CLinearTimeAbsolute& ltaWhen, int iPriority,
     pTask->arg_voidptr = arg_voidptr;
     pTask->arg_Integer = arg_Integer;
     pTask->m_Ticket = m_Ticket++;
+    pTask->m_iShare = 0;
+    pTask->m_iHeapIndex = -1;
+    pTask->m_iWheelSlot = -1;
+    pTask->m_iVisitedMark = m_iWheelVisitedMark-1;
 
-    // Must add to the WhenHeap so that network is still serviced.
+    // Must add to the WhenHeap (or the wheel which feeds it) so that
+    // network is still serviced.
     //
-    if (!m_WhenHeap.Insert(pTask, CompareWhen))
+    if (!Schedule(pTask))
     {
         delete pTask;
+        return nullptr;
     }
+    return pTask;
 }
 
-void CScheduler::DeferImmediateTask(int iPriority, FTASK *fpTask, void *arg_voidptr, int arg_Integer)
+PTASK_RECORD CScheduler::DeferImmediateTask(int iPriority, FTASK *fpTask, void *arg_voidptr, int arg_Integer)
 {
     PTASK_RECORD pTask = new TASK_RECORD;
-    if (!pTask) return;
+    if (!pTask) return nullptr;
 
     //pTask->ltaWhen = ltaWhen;
     pTask->iPriority = iPriority;
@@ -531,24 +660,103 @@ void CScheduler::DeferImmediateTask(int iPriority, FTASK *fpTask, void *arg_void
     pTask->arg_voidptr = arg_voidptr;
     pTask->arg_Integer = arg_Integer;
     pTask->m_Ticket = m_Ticket++;
+    pTask->m_iShare = 0;
+    pTask->m_iHeapIndex = -1;
+    pTask->m_iWheelSlot = -1;
 
     // Must add to the WhenHeap so that network is still serviced.
     //
     if (!m_WhenHeap.Insert(pTask, CompareWhen))
     {
         delete pTask;
+        return nullptr;
     }
+    return pTask;
 }
 
 void CScheduler::CancelTask(FTASK *fpTask, void *arg_voidptr, int arg_Integer)
 {
     m_WhenHeap.CancelTask(fpTask, arg_voidptr, arg_Integer);
     m_PriorityHeap.CancelTask(fpTask, arg_voidptr, arg_Integer);
+
+    // Cancelled tasks on the wheel are discarded once they reach the
+    // WhenHeap.
+    //
+    for (int i = 0; i < WHEEL_SLOTS; i++)
+    {
+        for (PTASK_RECORD p = m_aWheel[i]; nullptr != p; p = p->m_pWheelNext)
+        {
+            if (  p->fpTask == fpTask
+               && p->arg_voidptr == arg_voidptr
+               && p->arg_Integer == arg_Integer)
+            {
+                p->fpTask = nullptr;
+            }
+        }
+    }
+}
+
+// Unlike the search above, this removes and frees a task returned by
+// DeferTask() or DeferImmediateTask() right away.  The task must not be
+// the one currently running.
+//
+void CScheduler::CancelTask(PTASK_RECORD pTask)
+{
+    if (0 <= pTask->m_iWheelSlot)
+    {
+        WheelRemove(pTask);
+        delete pTask;
+    }
+    else if (  m_WhenHeap.RemoveTask(pTask, CompareWhen)
+            || m_PriorityHeap.RemoveTask(pTask, ComparePriority))
+    {
+        delete pTask;
+    }
+}
+
+// Call after changing the time or priority of a pending task.
+//
+void CScheduler::UpdateTask(PTASK_RECORD pTask)
+{
+    if (0 <= pTask->m_iWheelSlot)
+    {
+        WheelRemove(pTask);
+        if (!Schedule(pTask))
+        {
+            delete pTask;
+        }
+    }
+    else if (!m_WhenHeap.UpdateTask(pTask, CompareWhen))
+    {
+        m_PriorityHeap.UpdateTask(pTask, ComparePriority);
+    }
+}
+
+// Orders two pending tasks the way TraverseOrdered() visits them: tasks
+// already on the PriorityHeap by priority, then the rest by time.
+//
+int CScheduler::CompareOrdered(PTASK_RECORD pTaskA, PTASK_RECORD pTaskB)
+{
+    bool bReadyA = m_PriorityHeap.Contains(pTaskA);
+    bool bReadyB = m_PriorityHeap.Contains(pTaskB);
+    if (bReadyA != bReadyB)
+    {
+        return bReadyA ? -1 : 1;
+    }
+    else if (bReadyA)
+    {
+        return ComparePriority(pTaskA, pTaskB);
+    }
+    return CompareWhen(pTaskA, pTaskB);
 }
 
 void CScheduler::ReadyTasks(const CLinearTimeAbsolute& ltaNow)
 {
+    TurnWheel(ltaNow);
+
     // Move ready-to-run tasks off the WhenHeap and onto the PriorityHeap.
+    // With a ready hook, they pass through the ReadyHeap first so that the
+    // hook sees them in the order they were scheduled.
     //
     PTASK_RECORD pTask = m_WhenHeap.PeekAtTopmost();
     while (  pTask
@@ -558,13 +766,25 @@ void CScheduler::ReadyTasks(const CLinearTimeAbsolute& ltaNow)
         if (pTask)
         {
             if (  nullptr == pTask->fpTask
-               || !m_PriorityHeap.Insert(pTask, ComparePriority))
+               || (  nullptr == m_pfReady
+                  && !m_PriorityHeap.Insert(pTask, ComparePriority))
+               || (  nullptr != m_pfReady
+                  && !m_ReadyHeap.Insert(pTask, CompareTicket)))
             {
                 delete pTask;
             }
         }
         pTask = m_WhenHeap.PeekAtTopmost();
     }
+
+    while (nullptr != (pTask = m_ReadyHeap.RemoveTopmost(CompareTicket)))
+    {
+        m_pfReady(pTask);
+        if (!m_PriorityHeap.Insert(pTask, ComparePriority))
+        {
+            delete pTask;
+        }
+    }
 }
 
 int CScheduler::RunTasks(const CLinearTimeAbsolute& ltaNow)
@@ -610,6 +830,15 @@ int CScheduler::RunTasks(int iCount)
     return nTasks;
 }
 
+// IsReady: Whether a pending task is on the PriorityHeap.  A change to its
+// priority there does not pass through the ready hook, so the caller must
+// call the hook itself.
+//
+bool CScheduler::IsReady(PTASK_RECORD pTask)
+{
+    return m_PriorityHeap.Contains(pTask);
+}
+
 int CScheduler::RunAllTasks(void)
 {
     int nTotalTasks = 0;
@@ -640,13 +869,28 @@ bool CScheduler::WhenNext(CLinearTimeAbsolute  *ltaWhen)
 
     // Check the When Queue next.
     //
+    bool bFound = false;
     pTask = m_WhenHeap.PeekAtTopmost();
     if (pTask)
     {
         *ltaWhen = pTask->ltaWhen;
-        return true;
+        bFound = true;
     }
-    return false;
+
+    // The wheel must turn a second before its next tasks are due.
+    //
+    if (0 < m_nWheelTasks)
+    {
+        CLinearTimeAbsolute ltaTurn;
+        ltaTurn.Set100ns((WheelNextSecond() - 1) * FACTOR_100NS_PER_SECOND);
+        if (  !bFound
+           || ltaTurn < *ltaWhen)
+        {
+            *ltaWhen = ltaTurn;
+            bFound = true;
+        }
+    }
+    return bFound;
 }
 
 #define HEAP_LEFT_CHILD(x) (2*(x)+1)
@@ -674,10 +918,12 @@ void CTaskHeap::SiftDown(int iSubRoot, SCHCMP *pfCompare)
             break;
 
         m_pHeap[parent] = m_pHeap[child];
+        m_pHeap[parent]->m_iHeapIndex = parent;
         parent = child;
         child = HEAP_LEFT_CHILD(parent);
     }
     m_pHeap[parent] = Ref;
+    Ref->m_iHeapIndex = parent;
 }
 
 void CTaskHeap::SiftUp(int child, SCHCMP *pfCompare)
@@ -692,6 +938,8 @@ void CTaskHeap::SiftUp(int child, SCHCMP *pfCompare)
         Tmp = m_pHeap[child];
         m_pHeap[child] = m_pHeap[parent];
         m_pHeap[parent] = Tmp;
+        m_pHeap[child]->m_iHeapIndex = child;
+        Tmp->m_iHeapIndex = parent;
 
         child = parent;
     }
@@ -702,11 +950,15 @@ PTASK_RECORD CTaskHeap::Remove(int iNode, SCHCMP *pfCompare)
     if (iNode < 0 || m_nCurrent <= iNode) return nullptr;
 
     PTASK_RECORD pTask = m_pHeap[iNode];
+    pTask->m_iHeapIndex = -1;
 
     m_nCurrent--;
-    m_pHeap[iNode] = m_pHeap[m_nCurrent];
-    SiftDown(iNode, pfCompare);
-    SiftUp(iNode, pfCompare);
+    if (iNode < m_nCurrent)
+    {
+        m_pHeap[iNode] = m_pHeap[m_nCurrent];
+        SiftDown(iNode, pfCompare);
+        SiftUp(iNode, pfCompare);
+    }
 
     return pTask;
 }
@@ -724,16 +976,335 @@ void CTaskHeap::Update(int iNode, SCHCMP *pfCompare)
 
 void CScheduler::TraverseUnordered(SCHLOOK *pfLook)
 {
-    if (m_WhenHeap.TraverseUnordered(pfLook, CompareWhen))
+    if (  m_WhenHeap.TraverseUnordered(pfLook, CompareWhen)
+       && TraverseWheel(pfLook))
     {
         m_PriorityHeap.TraverseUnordered(pfLook, ComparePriority);
     }
 }
 
+// Tasks on the wheel are visited in time order together with those on
+// the WhenHeap.
+//
+static SCHLOOK      *Merge_pfLook;
+static PTASK_RECORD *Merge_aWheel;
+static int           Merge_nWheel;
+static int           Merge_iWheel;
+static bool          Merge_bDone;
+
+static int CompareWhenSort(const void *pA, const void *pB)
+{
+    return CompareWhen(*(const PTASK_RECORD *)pA, *(const PTASK_RECORD *)pB);
+}
+
+static int CallBack_MergeWheel(PTASK_RECORD p)
+{
+    while (  Merge_iWheel < Merge_nWheel
+          && CompareWhen(Merge_aWheel[Merge_iWheel], p) < 0)
+    {
+        if (IU_DONE == Merge_pfLook(Merge_aWheel[Merge_iWheel++]))
+        {
+            Merge_bDone = true;
+            return IU_DONE;
+        }
+    }
+
+    if (IU_DONE == Merge_pfLook(p))
+    {
+        Merge_bDone = true;
+        return IU_DONE;
+    }
+    return IU_NEXT_TASK;
+}
+
 void CScheduler::TraverseOrdered(SCHLOOK *pfLook)
 {
     m_PriorityHeap.TraverseOrdered(pfLook, ComparePriority);
-    m_WhenHeap.TraverseOrdered(pfLook, CompareWhen);
+    if (0 == m_nWheelTasks)
+    {
+        m_WhenHeap.TraverseOrdered(pfLook, CompareWhen);
+        return;
+    }
+
+    PTASK_RECORD *aWheel = (PTASK_RECORD *)MEMALLOC(m_nWheelTasks * sizeof(PTASK_RECORD));
+    ISOUTOFMEMORY(aWheel);
+
+    int nWheel = 0;
+    for (int i = 0; i < WHEEL_SLOTS; i++)
+    {
+        for (PTASK_RECORD p = m_aWheel[i]; nullptr != p; p = p->m_pWheelNext)
+        {
+            aWheel[nWheel++] = p;
+        }
+    }
+    qsort(aWheel, nWheel, sizeof(PTASK_RECORD), CompareWhenSort);
+
+    Merge_pfLook = pfLook;
+    Merge_aWheel = aWheel;
+    Merge_nWheel = nWheel;
+    Merge_iWheel = 0;
+    Merge_bDone  = false;
+    m_WhenHeap.TraverseOrdered(CallBack_MergeWheel, CompareWhen);
+    while (  !Merge_bDone
+          && Merge_iWheel < Merge_nWheel)
+    {
+        if (IU_DONE == pfLook(aWheel[Merge_iWheel++]))
+        {
+            break;
+        }
+    }
+    Merge_pfLook = nullptr;
+    Merge_aWheel = nullptr;
+    MEMFREE(aWheel);
+}
+
+// ---------------------------------------------------------------------------
+// The timing wheel.
+//
+// Most timed tasks are @waits and semaphore timeouts whole seconds away.
+// Rather than sift each one into the WhenHeap, they are dropped into a
+// slot for their second, or for their block of seconds if that is further
+// off.  As the wheel turns, a block's slot is spread over the level below
+// when the block begins, and the tasks for each second are moved to the
+// WhenHeap one second before they are due.  The WhenHeap still decides the
+// order of tasks within the same second, so m_Ticket order is kept.
+//
+static const int aWheelShift[WHEEL_LEVELS+1] = { 0, 8, 14, 20, 26 };
+static const int aWheelBase[WHEEL_LEVELS]    = { 0, 256, 256+64, 256+128 };
+
+CScheduler::CScheduler(void)
+{
+    m_Ticket = 0;
+    m_minPriority = PRIORITY_CF_DEQUEUE_ENABLED;
+    m_pfReady = nullptr;
+    for (int i = 0; i < WHEEL_SLOTS; i++)
+    {
+        m_aWheel[i] = nullptr;
+    }
+    m_nWheelSecond = 0;
+    m_nWheelTasks = 0;
+    m_iWheelVisitedMark = 0;
+}
+
+CScheduler::~CScheduler(void)
+{
+    for (int i = 0; i < WHEEL_SLOTS; i++)
+    {
+        PTASK_RECORD p = m_aWheel[i];
+        while (nullptr != p)
+        {
+            PTASK_RECORD pNext = p->m_pWheelNext;
+            delete p;
+            p = pNext;
+        }
+        m_aWheel[i] = nullptr;
+    }
+}
+
+// Puts a new or moved task on the wheel or, if it is due soon, too far
+// off, or the wheel is turned off (timer_wheel), on the WhenHeap.
+//
+bool CScheduler::Schedule(PTASK_RECORD pTask)
+{
+    if (  mudconf.timer_wheel
+       && WheelInsert(pTask))
+    {
+        return true;
+    }
+    return m_WhenHeap.Insert(pTask, CompareWhen);
+}
+
+bool CScheduler::WheelInsert(PTASK_RECORD pTask)
+{
+    INT64 nSecond = pTask->ltaWhen.Return100ns() / FACTOR_100NS_PER_SECOND;
+    if (nSecond <= m_nWheelSecond)
+    {
+        return false;
+    }
+
+    // Use the lowest level whose current block contains the second.
+    //
+    for (int i = 0; i < WHEEL_LEVELS; i++)
+    {
+        if ((nSecond >> aWheelShift[i+1]) == (m_nWheelSecond >> aWheelShift[i+1]))
+        {
+            INT64 nMask = (INT64(1) << (aWheelShift[i+1] - aWheelShift[i])) - 1;
+            int iSlot = aWheelBase[i] + static_cast<int>((nSecond >> aWheelShift[i]) & nMask);
+
+            pTask->m_iWheelSlot = iSlot;
+            pTask->m_pWheelPrev = nullptr;
+            pTask->m_pWheelNext = m_aWheel[iSlot];
+            if (nullptr != m_aWheel[iSlot])
+            {
+                m_aWheel[iSlot]->m_pWheelPrev = pTask;
+            }
+            m_aWheel[iSlot] = pTask;
+            m_nWheelTasks++;
+            return true;
+        }
+    }
+    return false;
+}
+
+void CScheduler::WheelRemove(PTASK_RECORD pTask)
+{
+    if (nullptr != pTask->m_pWheelNext)
+    {
+        pTask->m_pWheelNext->m_pWheelPrev = pTask->m_pWheelPrev;
+    }
+    if (nullptr != pTask->m_pWheelPrev)
+    {
+        pTask->m_pWheelPrev->m_pWheelNext = pTask->m_pWheelNext;
+    }
+    else
+    {
+        m_aWheel[pTask->m_iWheelSlot] = pTask->m_pWheelNext;
+    }
+    pTask->m_pWheelNext = nullptr;
+    pTask->m_pWheelPrev = nullptr;
+    pTask->m_iWheelSlot = -1;
+    m_nWheelTasks--;
+}
+
+// Places each task of a slot again relative to the current second.
+//
+void CScheduler::WheelEmptySlot(int iSlot)
+{
+    PTASK_RECORD p = m_aWheel[iSlot];
+    m_aWheel[iSlot] = nullptr;
+    while (nullptr != p)
+    {
+        PTASK_RECORD pNext = p->m_pWheelNext;
+        p->m_pWheelNext = nullptr;
+        p->m_pWheelPrev = nullptr;
+        p->m_iWheelSlot = -1;
+        m_nWheelTasks--;
+        if (!Schedule(p))
+        {
+            delete p;
+        }
+        p = pNext;
+    }
+}
+
+void CScheduler::TurnWheel(const CLinearTimeAbsolute& ltaNow)
+{
+    CLinearTimeAbsolute lta = ltaNow;
+    INT64 nTarget = lta.Return100ns() / FACTOR_100NS_PER_SECOND + 1;
+    if (nTarget <= m_nWheelSecond)
+    {
+        return;
+    }
+
+    if (  0 < m_nWheelTasks
+       && (INT64(1) << aWheelShift[2]) < nTarget - m_nWheelSecond)
+    {
+        // After a long pause or a jump in the clock, it is quicker to
+        // place every task again than to turn the wheel a second at a
+        // time.
+        //
+        m_nWheelSecond = nTarget;
+        for (int i = 0; i < WHEEL_SLOTS; i++)
+        {
+            WheelEmptySlot(i);
+        }
+        return;
+    }
+
+    while (  0 < m_nWheelTasks
+          && m_nWheelSecond < nTarget)
+    {
+        m_nWheelSecond++;
+        for (int i = WHEEL_LEVELS-1; 0 < i; i--)
+        {
+            if (0 == (m_nWheelSecond & ((INT64(1) << aWheelShift[i]) - 1)))
+            {
+                INT64 nMask = (INT64(1) << (aWheelShift[i+1] - aWheelShift[i])) - 1;
+                WheelEmptySlot(aWheelBase[i] + static_cast<int>((m_nWheelSecond >> aWheelShift[i]) & nMask));
+            }
+        }
+        WheelEmptySlot(static_cast<int>(m_nWheelSecond & 255));
+    }
+
+    if (m_nWheelSecond < nTarget)
+    {
+        m_nWheelSecond = nTarget;
+    }
+}
+
+// Returns the next second with tasks on level 0, or the start of the next
+// block, where the level above must be spread out.
+//
+INT64 CScheduler::WheelNextSecond(void)
+{
+    INT64 nBlockEnd = m_nWheelSecond | 255;
+    for (INT64 n = m_nWheelSecond + 1; n <= nBlockEnd; n++)
+    {
+        if (nullptr != m_aWheel[n & 255])
+        {
+            return n;
+        }
+    }
+    return nBlockEnd + 1;
+}
+
+// Like CTaskHeap::TraverseUnordered(), this visits every task on the wheel
+// once even if tasks are moved or removed along the way.
+//
+int CScheduler::TraverseWheel(SCHLOOK *pfLook)
+{
+    m_iWheelVisitedMark++;
+    if (m_iWheelVisitedMark == 0)
+    {
+        for (int i = 0; i < WHEEL_SLOTS; i++)
+        {
+            for (PTASK_RECORD p = m_aWheel[i]; nullptr != p; p = p->m_pWheelNext)
+            {
+                p->m_iVisitedMark = m_iWheelVisitedMark;
+            }
+        }
+        m_iWheelVisitedMark++;
+    }
+
+    bool bUnvisitedRecords;
+    do
+    {
+        bUnvisitedRecords = false;
+        for (int i = 0; i < WHEEL_SLOTS; i++)
+        {
+            PTASK_RECORD p = m_aWheel[i];
+            while (nullptr != p)
+            {
+                PTASK_RECORD pNext = p->m_pWheelNext;
+                if (p->m_iVisitedMark != m_iWheelVisitedMark)
+                {
+                    bUnvisitedRecords = true;
+                    p->m_iVisitedMark = m_iWheelVisitedMark;
+
+                    int cmd = pfLook(p);
+                    switch (cmd)
+                    {
+                    case IU_REMOVE_TASK:
+                        WheelRemove(p);
+                        break;
+
+                    case IU_DONE:
+                        return false;
+
+                    case IU_UPDATE_TASK:
+                        WheelRemove(p);
+                        if (!Schedule(p))
+                        {
+                            delete p;
+                        }
+                        break;
+                    }
+                }
+                p = pNext;
+            }
+        }
+    } while (bUnvisitedRecords);
+    return true;
 }
 
 // The following guarantees that in spite of any changes to the heap
@@ -823,6 +1394,7 @@ void CTaskHeap::Sort(SCHCMP *pfCompare)
     {
         PTASK_RECORD p = m_pHeap[m_nCurrent];
         m_pHeap[m_nCurrent] = m_pHeap[0];
+        m_pHeap[m_nCurrent]->m_iHeapIndex = m_nCurrent;
         m_pHeap[0] = p;
         SiftDown(0, pfCompare);
     }
@@ -835,6 +1407,7 @@ void CTaskHeap::Remake(SCHCMP *pfCompare)
     m_nCurrent = 0;
     while (s_nCurrent--)
     {
+        m_pHeap[m_nCurrent]->m_iHeapIndex = m_nCurrent;
         m_nCurrent++;
         SiftUp(m_nCurrent-1, pfCompare);
     }
@@ -849,4 +1422,5 @@ void CScheduler::Shrink(void)
 {
     m_WhenHeap.Shrink();
     m_PriorityHeap.Shrink();
+    m_ReadyHeap.Shrink();
 }
@@ -614,6 +614,11 @@ void do_dbclean(dbref executor, dbref caller, dbref enactor, int eval, int key)
         return;
     }
 #endif // HAVE_WORKING_FORK
+    if (mudstate.snapshot)
+    {
+        notify(executor, T("Dumping in progress. Try again later."));
+        return;
+    }
 #ifndef MEMORY_BASED
     // Save cached modified attribute list
     //
@@ -627,6 +632,7 @@ void do_dbclean(dbref executor, dbref caller, dbref enactor, int eval, int key)
     int cVAttributes = dbclean_RemoveStaleAttributeNames();
     notify(executor, T("Renumbering and compacting attribute numbers..."));
     dbclean_RenumberAttributes(cVAttributes);
+    lock_cache_flush();
     notify(executor, tprintf(T("Next Attribute number to allocate: %d"), mudstate.attr_next));
     notify(executor, T("Checking Integrity of the attribute data structures..."));
     dbclean_IntegrityChecking(executor);
@@ -635,6 +641,8 @@ void do_dbclean(dbref executor, dbref caller, dbref enactor, int eval, int key)
 
 void vattr_delete_LEN(UTF8 *pName, size_t nName)
 {
+    lock_cache_flush();
+
     // Delete from hashtable.
     //
     UINT32 nHash = HASH_ProcessBuffer(0, pName, nName);
@@ -659,6 +667,8 @@ void vattr_delete_LEN(UTF8 *pName, size_t nName)
 
 ATTR *vattr_rename_LEN(UTF8 *pOldName, size_t nOldName, UTF8 *pNewName, size_t nNewName)
 {
+    lock_cache_flush();
+
     // Find and Delete old name from hashtable.
     //
     UINT32 nHash = HASH_ProcessBuffer(0, pOldName, nOldName);
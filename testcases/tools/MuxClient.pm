@@ -0,0 +1,165 @@
+#
+#	MuxClient.pm - Connections to a game for the benchmarks in this
+#	directory.
+#
+#	A MuxClient is one loopback connection to the game.  What the game
+#	sends is collected as it is read, and wait_for() consumes it through
+#	the first match, so a marker sent with 'think' can be waited for
+#	without being confused by earlier output.  The benchmarks keep only
+#	their own measurement logic.
+#
+#	Run the benchmarks against a scratch game, not a live one.  wizard()
+#	lifts the command quota with @admin, and most of them also lift the
+#	queue limit or change other parameters, create objects and players,
+#	and leave the queue full while they run.
+#
+#	    use FindBin;
+#	    use lib $FindBin::Bin;
+#	    use MuxClient;
+#
+#	    my $wiz = MuxClient->wizard($port, $password);
+#	    $wiz->send_lines('@dump', 'think DUMPED');
+#	    $wiz->wait_for(qr/DUMPED/, 60) or die "The dump did not finish.\n";
+#
+package MuxClient;
+
+use strict;
+use IO::Socket::INET;
+use IO::Select;
+use Socket qw(IPPROTO_TCP TCP_NODELAY);
+use Time::HiRes qw(time);
+
+# Open a connection, and if a name and password are given, log in.
+#
+sub new
+{
+    my ($class, $port, $who, $password) = @_;
+    my $s = IO::Socket::INET->new(PeerAddr => '127.0.0.1', PeerPort => $port, Proto => 'tcp')
+        or die "connect: $!\n";
+    binmode($s);
+    $s->autoflush(1);
+    setsockopt($s, IPPROTO_TCP, TCP_NODELAY, 1);
+    my $self = bless({ s => $s, sel => IO::Select->new($s), text => '' }, $class);
+    $self->send_lines("connect $who $password") if (defined($who));
+    return $self;
+}
+
+# Log in as the wizard, lift the command quota so that timings are not
+# throttled, apply any other @admin settings given as 'param=value', and
+# wait until all of that has been done.
+#
+sub wizard
+{
+    my ($class, $port, $password, @admin) = @_;
+    my $self = $class->new($port, 'wizard', $password);
+    $self->send_lines('@admin command_quota_max=1000000', '@admin command_quota_increment=1000000',
+        map({ "\@admin $_" } @admin), 'think MUXCLIENT[add(1,1)]READY');
+    $self->wait_for(qr/MUXCLIENT2READY/, 10) or die "Could not log in as the wizard.\n";
+    return $self;
+}
+
+sub socket
+{
+    my ($self) = @_;
+    return $self->{s};
+}
+
+sub send_lines
+{
+    my $self = shift;
+    my $s = $self->{s};
+    print $s join('', map { "$_\r\n" } @_);
+}
+
+# Add whatever the game has sent to what was already collected, waiting up
+# to the given number of seconds for something to arrive.  Returns false
+# once the game has closed the connection.
+#
+sub read
+{
+    my ($self, $seconds) = @_;
+    return 1 unless ($self->{sel}->can_read($seconds));
+    my $buf;
+    my $n = sysread($self->{s}, $buf, 65536);
+    return 0 unless ($n);
+    $self->{text} .= $buf;
+    return 1;
+}
+
+# Wait up to the given number of seconds for output matching the pattern.
+# Returns the output through the match, which is consumed, or undef.  With
+# no time given, only what has already arrived is looked at.
+#
+sub wait_for
+{
+    my ($self, $pattern, $seconds) = @_;
+    my $end = time() + $seconds;
+    for (;;)
+    {
+        my $left = $end - time();
+        my $bOpen = $self->read((0.01 < $left) ? 0.01 : ((0 < $left) ? $left : 0));
+        if ($self->{text} =~ $pattern)
+        {
+            my $seen = $` . $&;
+            $self->{text} = $';
+            return $seen;
+        }
+        last if (!$bOpen || $left <= 0);
+    }
+    return undef;
+}
+
+# Read for the given number of seconds and discard everything collected.
+# Returns what was discarded.
+#
+sub drain
+{
+    my ($self, $seconds) = @_;
+    my $end = time() + $seconds;
+    while (  $self->read((0 < $seconds) ? 0.01 : 0)
+          && time() < $end)
+    {
+    }
+    my $text = $self->{text};
+    $self->{text} = '';
+    return $text;
+}
+
+# Queue a command for each of 0 through $n - 1 (as ##) with @dolist, a
+# thousand to a line, and send the given line after them.  The entries
+# belong to whoever this connection is logged in as, or if an object is
+# given, the object is forced to queue them so that they are its own.
+#
+sub queue_dolist
+{
+    my ($self, $n, $command, $after, $object) = @_;
+    my @lines;
+    for (my $i = 0; $i < $n; $i += 1000)
+    {
+        my $last = ($n < $i + 1000) ? $n - 1 : $i + 999;
+        my $line = "\@dolist lnum($i,$last)=$command";
+        push(@lines, defined($object) ? "\@force $object=$line" : $line);
+    }
+    push(@lines, $after) if (defined($after));
+    $self->send_lines(@lines);
+}
+
+# Drain several connections at once.
+#
+sub drain_all
+{
+    my ($seconds, @clients) = @_;
+    my %clients = map { (fileno($_->{s}) => $_) } @clients;
+    my $sel = IO::Select->new(map { $_->{s} } @clients);
+    my $end = time() + $seconds;
+    do
+    {
+        foreach my $s ($sel->can_read(0.1))
+        {
+            $clients{fileno($s)}->read(0);
+        }
+    } while (time() < $end);
+    $_->{text} = '' foreach (@clients);
+}
+
+1;